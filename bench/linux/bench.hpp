@@ -0,0 +1,108 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_BENCH_H_
+#define SHARAKU_BENCH_H_
+
+#include <stddef.h>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+//-----------------------------------------------------------------------------
+// ベンチマーク共通処理
+//  各ベンチマークは要素数n(state.range(0))の配列に対して演算を行い、
+//  1要素当たりの処理時間をtime_per_op(秒)として出力する。
+
+// 計測する要素数(1, 64, 4K, 1M)
+static inline void
+sharaku_bench_sizes(benchmark::internal::Benchmark *b)
+{
+	b->Arg(1)->Arg(64)->Arg(4 << 10)->Arg(1 << 20);
+}
+
+// 処理要素数と1要素当たりの処理時間を設定する
+static inline void
+sharaku_bench_counters(benchmark::State& state, size_t n)
+{
+	state.SetItemsProcessed(state.iterations() * n);
+	state.counters["time_per_op"] = benchmark::Counter(
+		(double)n,
+		benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+// x, y, zを持つ型(vector3, position3, rotation3)の入力データを作成する
+template <class T>
+static std::vector<T>
+sharaku_bench_data(size_t n, float seed)
+{
+	std::vector<T> v(n);
+	for (size_t i = 0; i < n; i++) {
+		v[i](seed + (float)(i % 97), seed - (float)(i % 89), seed * (float)(i % 13));
+	}
+	return v;
+}
+
+// r[i] = f(a[i], b[i])
+template <class R, class A, class B, class F>
+static void
+sharaku_bench_binary(benchmark::State& state, F f)
+{
+	const size_t n = state.range(0);
+	std::vector<A> a = sharaku_bench_data<A>(n, 1.5f);
+	std::vector<B> b = sharaku_bench_data<B>(n, 0.25f);
+	std::vector<R> r(n);
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			r[i] = f(a[i], b[i]);
+		}
+		benchmark::DoNotOptimize(r.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+
+// f(a[i], b[i]) (a[i]を更新する)
+template <class A, class B, class F>
+static void
+sharaku_bench_update(benchmark::State& state, F f)
+{
+	const size_t n = state.range(0);
+	std::vector<A> a = sharaku_bench_data<A>(n, 1.5f);
+	std::vector<B> b = sharaku_bench_data<B>(n, 0.25f);
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			f(a[i], b[i]);
+		}
+		benchmark::DoNotOptimize(a.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+
+
+#endif // SHARAKU_BENCH_H_
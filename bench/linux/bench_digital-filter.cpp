@@ -0,0 +1,381 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/digital-filter.hpp>
+#include <algorithm>
+#include "bench.hpp"
+
+// n個のlow_pass_filterにそれぞれ1サンプル入力する
+static void
+BM_low_pass_filter_update(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<low_pass_filter> f(n, low_pass_filter(0.1f));
+	std::vector<float> x(n);
+	for (size_t i = 0; i < n; i++) {
+		x[i] = (float)(i % 113);
+	}
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			f[i] += x[i];
+		}
+		benchmark::DoNotOptimize(f.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_low_pass_filter_update)->Apply(sharaku_bench_sizes);
+
+//-----------------------------------------------------------------------------
+// Nチャネルのフレーム入力
+//  low_pass_filterをN個並べた場合と、low_pass_filter_bank<N>の比較
+
+template <size_t N>
+static void
+BM_low_pass_filter_separate(benchmark::State& state)
+{
+	std::vector<low_pass_filter> f(N, low_pass_filter(0.1f));
+	std::vector<float> frame(N, 1.0f);
+
+	for (auto _ : state) {
+		for (size_t ch = 0; ch < N; ch++) {
+			f[ch] += frame[ch];
+		}
+		benchmark::DoNotOptimize(f.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, N);
+}
+BENCHMARK_TEMPLATE(BM_low_pass_filter_separate, 16);
+BENCHMARK_TEMPLATE(BM_low_pass_filter_separate, 256);
+BENCHMARK_TEMPLATE(BM_low_pass_filter_separate, 1024);
+
+template <size_t N>
+static void
+BM_low_pass_filter_bank(benchmark::State& state)
+{
+	low_pass_filter_bank<N> bank(0.1f);
+	std::vector<float> frame(N, 1.0f);
+
+	for (auto _ : state) {
+		bank += frame.data();
+		benchmark::DoNotOptimize(&bank);
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, N);
+}
+BENCHMARK_TEMPLATE(BM_low_pass_filter_bank, 16);
+BENCHMARK_TEMPLATE(BM_low_pass_filter_bank, 256);
+BENCHMARK_TEMPLATE(BM_low_pass_filter_bank, 1024);
+
+// 64フレームのブロック入力
+template <size_t N>
+static void
+BM_low_pass_filter_bank_block(benchmark::State& state)
+{
+	const size_t M = 64;
+	low_pass_filter_bank<N> bank(0.1f);
+	std::vector<float> in(N * M, 1.0f), out(N * M);
+
+	for (auto _ : state) {
+		bank.process(in.data(), out.data(), M);
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, N * M);
+}
+BENCHMARK_TEMPLATE(BM_low_pass_filter_bank_block, 16);
+BENCHMARK_TEMPLATE(BM_low_pass_filter_bank_block, 256);
+
+//-----------------------------------------------------------------------------
+// 4次ローパスの比較(1チャネル当たりのサンプル数/秒)
+//  low_pass_filterを4段直列にした場合と、biquad 2段(4次Butterworth)
+
+// low_pass_filterを4段直列にしてn要素の信号を通す
+static void
+BM_low_pass_filter_chain4(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	low_pass_filter f0(0.1f), f1(0.1f), f2(0.1f), f3(0.1f);
+	std::vector<float> in(n), out(n);
+	for (size_t i = 0; i < n; i++) {
+		in[i] = (float)(i % 113);
+	}
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			out[i] = f3 + (f2 + (f1 + (f0 + in[i])));
+		}
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_low_pass_filter_chain4)->Apply(sharaku_bench_sizes);
+
+// 4次Butterworthローパスでn要素の信号を処理する
+static void
+BM_biquad_filter_4th(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	biquad_coef sos[2];
+	sharaku_butterworth_lowpass(sos, 4, 50.0, 1000.0);
+	biquad_filter<2> f(sos);
+	std::vector<float> in(n), out(n);
+	for (size_t i = 0; i < n; i++) {
+		in[i] = (float)(i % 113);
+	}
+
+	for (auto _ : state) {
+		f.process(in.data(), out.data(), n);
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_biquad_filter_4th)->Apply(sharaku_bench_sizes);
+
+// Nチャネルの4次Butterworthローパスで64フレームを処理する
+template <size_t N>
+static void
+BM_biquad_filter_bank_4th(benchmark::State& state)
+{
+	const size_t M = 64;
+	biquad_coef sos[2];
+	sharaku_butterworth_lowpass(sos, 4, 50.0, 1000.0);
+	static biquad_filter_bank<N, 2> bank(sos);
+	std::vector<float> in(N * M, 1.0f), out(N * M);
+
+	for (auto _ : state) {
+		bank.process(in.data(), out.data(), M);
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, N * M);
+}
+BENCHMARK_TEMPLATE(BM_biquad_filter_bank_4th, 16);
+BENCHMARK_TEMPLATE(BM_biquad_filter_bank_4th, 256);
+
+//-----------------------------------------------------------------------------
+// FIRフィルタ(タップ数32/128/512)
+//  剰余による循環バッファを逐次積和する単純な実装と、fir_filter<T>の比較
+
+// 4096サンプルを単純な実装で処理する
+template <size_t T>
+static void
+BM_fir_naive(benchmark::State& state)
+{
+	const size_t n = 4096;
+	std::vector<float> h(T), hist(T, 0.0f), in(n), out(n);
+	sharaku_fir_lowpass(h.data(), T, 50.0, 1000.0);
+	for (size_t i = 0; i < n; i++) {
+		in[i] = (float)(i % 113);
+	}
+	size_t pos = 0;
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			hist[pos] = in[i];
+			float y = 0.0f;
+			for (size_t k = 0; k < T; k++) {
+				y += h[k] * hist[(pos + T - k) % T];
+			}
+			pos = (pos + 1) % T;
+			out[i] = y;
+		}
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK_TEMPLATE(BM_fir_naive, 32);
+BENCHMARK_TEMPLATE(BM_fir_naive, 128);
+BENCHMARK_TEMPLATE(BM_fir_naive, 512);
+
+// 4096サンプルをfir_filter<T>のブロック入力で処理する
+template <size_t T>
+static void
+BM_fir_filter_block(benchmark::State& state)
+{
+	const size_t n = 4096;
+	std::vector<float> h(T), in(n), out(n);
+	sharaku_fir_lowpass(h.data(), T, 50.0, 1000.0);
+	static fir_filter<T> f(h.data());
+	for (size_t i = 0; i < n; i++) {
+		in[i] = (float)(i % 113);
+	}
+
+	for (auto _ : state) {
+		f.process(in.data(), out.data(), n);
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK_TEMPLATE(BM_fir_filter_block, 32);
+BENCHMARK_TEMPLATE(BM_fir_filter_block, 128);
+BENCHMARK_TEMPLATE(BM_fir_filter_block, 512);
+
+// 4096サンプルをfir_filter<T>に1サンプルずつ入力する
+template <size_t T>
+static void
+BM_fir_filter_sample(benchmark::State& state)
+{
+	const size_t n = 4096;
+	std::vector<float> h(T), in(n), out(n);
+	sharaku_fir_lowpass(h.data(), T, 50.0, 1000.0);
+	static fir_filter<T> f(h.data());
+	for (size_t i = 0; i < n; i++) {
+		in[i] = (float)(i % 113);
+	}
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			out[i] = f + in[i];
+		}
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK_TEMPLATE(BM_fir_filter_sample, 32);
+BENCHMARK_TEMPLATE(BM_fir_filter_sample, 128);
+BENCHMARK_TEMPLATE(BM_fir_filter_sample, 512);
+
+//-----------------------------------------------------------------------------
+// 移動平均・メディアンフィルタ(窓幅5/32/256/1024)
+//  1サンプルごとに窓全体を走査する単純な実装と、
+//  moving_average<W>/median_filter<W>の比較
+
+// 移動平均・メディアンフィルタの入力データ
+static std::vector<float>
+sharaku_bench_window_data(size_t n)
+{
+	std::vector<float> in(n);
+	for (size_t i = 0; i < n; i++) {
+		in[i] = (float)((i * 37) % 101) + (float)(i % 7) * 0.25f;
+	}
+	return in;
+}
+
+// 4096サンプルの移動平均を窓全体の総和で求める
+template <size_t W>
+static void
+BM_moving_average_naive(benchmark::State& state)
+{
+	const size_t n = 4096;
+	std::vector<float> in = sharaku_bench_window_data(n), hist(W, 0.0f), out(n);
+	size_t pos = 0;
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			hist[pos] = in[i];
+			pos = (pos + 1 == W) ? 0 : pos + 1;
+			float sum = 0.0f;
+			for (size_t k = 0; k < W; k++) {
+				sum += hist[k];
+			}
+			out[i] = sum / (float)W;
+		}
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK_TEMPLATE(BM_moving_average_naive, 5);
+BENCHMARK_TEMPLATE(BM_moving_average_naive, 32);
+BENCHMARK_TEMPLATE(BM_moving_average_naive, 256);
+BENCHMARK_TEMPLATE(BM_moving_average_naive, 1024);
+
+// 4096サンプルをmoving_average<W>で処理する
+template <size_t W>
+static void
+BM_moving_average(benchmark::State& state)
+{
+	const size_t n = 4096;
+	std::vector<float> in = sharaku_bench_window_data(n), out(n);
+	static moving_average<W> f;
+
+	for (auto _ : state) {
+		f.process(in.data(), out.data(), n);
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK_TEMPLATE(BM_moving_average, 5);
+BENCHMARK_TEMPLATE(BM_moving_average, 32);
+BENCHMARK_TEMPLATE(BM_moving_average, 256);
+BENCHMARK_TEMPLATE(BM_moving_average, 1024);
+
+// 4096サンプルの中央値を窓のコピーとnth_elementで求める
+template <size_t W>
+static void
+BM_median_naive(benchmark::State& state)
+{
+	const size_t n = 4096;
+	std::vector<float> in = sharaku_bench_window_data(n), hist(W, 0.0f), tmp(W), out(n);
+	size_t pos = 0;
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			hist[pos] = in[i];
+			pos = (pos + 1 == W) ? 0 : pos + 1;
+			tmp = hist;
+			std::nth_element(tmp.begin(), tmp.begin() + W / 2, tmp.end());
+			out[i] = tmp[W / 2];
+		}
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK_TEMPLATE(BM_median_naive, 5);
+BENCHMARK_TEMPLATE(BM_median_naive, 32);
+BENCHMARK_TEMPLATE(BM_median_naive, 256);
+BENCHMARK_TEMPLATE(BM_median_naive, 1024);
+
+// 4096サンプルをmedian_filter<W>で処理する
+template <size_t W>
+static void
+BM_median_filter(benchmark::State& state)
+{
+	const size_t n = 4096;
+	std::vector<float> in = sharaku_bench_window_data(n), out(n);
+	static median_filter<W> f;
+
+	for (auto _ : state) {
+		f.process(in.data(), out.data(), n);
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK_TEMPLATE(BM_median_filter, 5);
+BENCHMARK_TEMPLATE(BM_median_filter, 32);
+BENCHMARK_TEMPLATE(BM_median_filter, 256);
+BENCHMARK_TEMPLATE(BM_median_filter, 1024);
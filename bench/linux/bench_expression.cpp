@@ -0,0 +1,141 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/expression.hpp>
+#include <libsharaku/type/position.hpp>
+#include "bench.hpp"
+
+//-----------------------------------------------------------------------------
+// 4項の式 r = p + a - b + c の評価
+//  traffic は1回の評価で読み書きする配列のbyte数(1要素12byte)
+//  - 1演算ずつ評価: 3演算 * (読み込み2 + 書き出し1) = 9配列分
+//  - 式テンプレート: 読み込み4 + 書き出し1 = 5配列分
+
+static void
+sharaku_bench_traffic(benchmark::State& state, size_t n, size_t arrays)
+{
+	sharaku_bench_counters(state, n);
+	state.SetBytesProcessed(state.iterations() * n * sizeof(vector3) * arrays);
+	state.counters["traffic"] = (double)(n * sizeof(vector3) * arrays);
+}
+
+// 配列の要素ごとに今の演算子で評価する(1パス、要素単位)
+static void
+BM_expr_aos_operator(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> p = sharaku_bench_data<position3>(n, 1.5f);
+	std::vector<vector3> a = sharaku_bench_data<vector3>(n, 0.25f);
+	std::vector<vector3> b = sharaku_bench_data<vector3>(n, -2.0f);
+	std::vector<vector3> c = sharaku_bench_data<vector3>(n, 3.0f);
+	std::vector<position3> r(n);
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			r[i] = p[i] + a[i] - b[i] + c[i];
+		}
+		benchmark::DoNotOptimize(r.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_traffic(state, n, 5);
+}
+BENCHMARK(BM_expr_aos_operator)->Arg(4 << 10)->Arg(1 << 20);
+
+// 配列の式テンプレート
+static void
+BM_expr_aos_fused(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> p = sharaku_bench_data<position3>(n, 1.5f);
+	std::vector<vector3> a = sharaku_bench_data<vector3>(n, 0.25f);
+	std::vector<vector3> b = sharaku_bench_data<vector3>(n, -2.0f);
+	std::vector<vector3> c = sharaku_bench_data<vector3>(n, 3.0f);
+	std::vector<position3> r(n);
+
+	for (auto _ : state) {
+		sharaku_eval(r.data(), sharaku_expr(p.data(), n) + sharaku_expr(a.data(), n) -
+				       sharaku_expr(b.data(), n) + sharaku_expr(c.data(), n));
+		benchmark::DoNotOptimize(r.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_traffic(state, n, 5);
+}
+BENCHMARK(BM_expr_aos_fused)->Arg(4 << 10)->Arg(1 << 20);
+
+// vector3_soaの一括演算を1演算ずつ行う(中間結果を一時領域に書き出す)
+static void
+BM_expr_soa_temporary(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<vector3> src = sharaku_bench_data<vector3>(n, 1.5f);
+	vector3_soa p(src.data(), n), a(src.data(), n), b(src.data(), n), c(src.data(), n);
+	vector3_soa t0(n), t1(n), r(n);
+
+	for (auto _ : state) {
+		vector3_soa::add(t0, p, a);
+		vector3_soa::sub(t1, t0, b);
+		vector3_soa::add(r, t1, c);
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_traffic(state, n, 9);
+}
+BENCHMARK(BM_expr_soa_temporary)->Arg(4 << 10)->Arg(1 << 20);
+
+// vector3_soaの一括演算を1演算ずつ行う(結果の領域で累積する)
+static void
+BM_expr_soa_in_place(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<vector3> src = sharaku_bench_data<vector3>(n, 1.5f);
+	vector3_soa p(src.data(), n), a(src.data(), n), b(src.data(), n), c(src.data(), n);
+	vector3_soa r(n);
+
+	for (auto _ : state) {
+		vector3_soa::add(r, p, a);
+		r -= b;
+		r += c;
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_traffic(state, n, 9);
+}
+BENCHMARK(BM_expr_soa_in_place)->Arg(4 << 10)->Arg(1 << 20);
+
+// vector3_soaの式テンプレート
+static void
+BM_expr_soa_fused(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<vector3> src = sharaku_bench_data<vector3>(n, 1.5f);
+	vector3_soa p(src.data(), n), a(src.data(), n), b(src.data(), n), c(src.data(), n);
+	vector3_soa r(n);
+
+	for (auto _ : state) {
+		sharaku_eval(r, p + a - b + c);
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_traffic(state, n, 5);
+}
+BENCHMARK(BM_expr_soa_fused)->Arg(4 << 10)->Arg(1 << 20);
@@ -0,0 +1,113 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/fixed.hpp>
+#include <libsharaku/type/vector.hpp>
+#include <libsharaku/type/pid.hpp>
+#include <libsharaku/type/digital-filter.hpp>
+#include "bench.hpp"
+
+//-----------------------------------------------------------------------------
+// スカラ型(float, double, q16_16)ごとの比較
+//  FPUのないターゲット向けにクロスビルドした場合、floatはソフトウェア
+//  浮動小数点となり、q16_16は整数演算のみで処理される。
+
+// n個のpidをそれぞれ1ステップ進める
+template <class T>
+static void
+BM_basic_pid_step(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<basic_pid<T>> loops(n, basic_pid<T>(T(1.2f), T(0.01f), T(0.3f)));
+	std::vector<int32_t> now(n), target(n);
+	std::vector<T> u(n);
+	for (size_t i = 0; i < n; i++) {
+		now[i] = (int32_t)(i % 101);
+		target[i] = (int32_t)(i % 37);
+	}
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			u[i] = loops[i](T(1), now[i], target[i]);
+		}
+		benchmark::DoNotOptimize(u.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK_TEMPLATE(BM_basic_pid_step, float)->Apply(sharaku_bench_sizes);
+BENCHMARK_TEMPLATE(BM_basic_pid_step, double)->Apply(sharaku_bench_sizes);
+BENCHMARK_TEMPLATE(BM_basic_pid_step, q16_16)->Apply(sharaku_bench_sizes);
+
+// n要素の信号をローパスフィルタに通す
+template <class T>
+static void
+BM_basic_low_pass_filter(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	basic_low_pass_filter<T> lpf(T(0.25f));
+	std::vector<T> in(n);
+	for (size_t i = 0; i < n; i++) {
+		in[i] = T((int32_t)(i % 200) - 100);
+	}
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			lpf += in[i];
+		}
+		benchmark::DoNotOptimize((T)lpf);
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK_TEMPLATE(BM_basic_low_pass_filter, float)->Apply(sharaku_bench_sizes);
+BENCHMARK_TEMPLATE(BM_basic_low_pass_filter, double)->Apply(sharaku_bench_sizes);
+BENCHMARK_TEMPLATE(BM_basic_low_pass_filter, q16_16)->Apply(sharaku_bench_sizes);
+
+// r[i] = a[i] + b[i]
+template <class T>
+static void
+BM_basic_vector3_add(benchmark::State& state)
+{
+	typedef basic_vector3<T>	V;
+	const size_t n = state.range(0);
+	std::vector<V> a(n), b(n), r(n);
+	for (size_t i = 0; i < n; i++) {
+		a[i](T((int32_t)(i % 97)), T(1.5f), T(-2));
+		b[i](T(0.25f), T((int32_t)(i % 89)), T(3));
+	}
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			r[i] = a[i] + b[i];
+		}
+		benchmark::DoNotOptimize(r.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK_TEMPLATE(BM_basic_vector3_add, float)->Apply(sharaku_bench_sizes);
+BENCHMARK_TEMPLATE(BM_basic_vector3_add, double)->Apply(sharaku_bench_sizes);
+BENCHMARK_TEMPLATE(BM_basic_vector3_add, q16_16)->Apply(sharaku_bench_sizes);
@@ -0,0 +1,180 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/geometry.hpp>
+#include "bench.hpp"
+
+//-----------------------------------------------------------------------------
+// 1要素版を要素ごとに呼び出す場合
+
+static void
+BM_geometry_dot(benchmark::State& state)
+{
+	sharaku_bench_binary<float, vector3, vector3>(state,
+		[](const vector3& a, const vector3& b) { return sharaku_dot(a, b); });
+}
+BENCHMARK(BM_geometry_dot)->Apply(sharaku_bench_sizes);
+
+static void
+BM_geometry_cross(benchmark::State& state)
+{
+	sharaku_bench_binary<vector3, vector3, vector3>(state,
+		[](const vector3& a, const vector3& b) { return sharaku_cross(a, b); });
+}
+BENCHMARK(BM_geometry_cross)->Apply(sharaku_bench_sizes);
+
+static void
+BM_geometry_length(benchmark::State& state)
+{
+	sharaku_bench_binary<float, vector3, vector3>(state,
+		[](const vector3& a, const vector3&) { return sharaku_length(a); });
+}
+BENCHMARK(BM_geometry_length)->Apply(sharaku_bench_sizes);
+
+static void
+BM_geometry_length_fast(benchmark::State& state)
+{
+	sharaku_bench_binary<float, vector3, vector3>(state,
+		[](const vector3& a, const vector3&) { return sharaku_length_fast(a); });
+}
+BENCHMARK(BM_geometry_length_fast)->Apply(sharaku_bench_sizes);
+
+static void
+BM_geometry_normalize(benchmark::State& state)
+{
+	sharaku_bench_binary<vector3, vector3, vector3>(state,
+		[](const vector3& a, const vector3&) { return sharaku_normalize(a); });
+}
+BENCHMARK(BM_geometry_normalize)->Apply(sharaku_bench_sizes);
+
+static void
+BM_geometry_normalize_fast(benchmark::State& state)
+{
+	sharaku_bench_binary<vector3, vector3, vector3>(state,
+		[](const vector3& a, const vector3&) { return sharaku_normalize_fast(a); });
+}
+BENCHMARK(BM_geometry_normalize_fast)->Apply(sharaku_bench_sizes);
+
+static void
+BM_geometry_distance(benchmark::State& state)
+{
+	sharaku_bench_binary<float, position3, position3>(state,
+		[](const position3& a, const position3& b) { return sharaku_distance(a, b); });
+}
+BENCHMARK(BM_geometry_distance)->Apply(sharaku_bench_sizes);
+
+static void
+BM_geometry_distance_fast(benchmark::State& state)
+{
+	sharaku_bench_binary<float, position3, position3>(state,
+		[](const position3& a, const position3& b) { return sharaku_distance_fast(a, b); });
+}
+BENCHMARK(BM_geometry_distance_fast)->Apply(sharaku_bench_sizes);
+
+//-----------------------------------------------------------------------------
+// 配列版
+//  r = f(a, b, n) をn要素の配列に対して1回呼び出す
+
+template <class R, class A, class B, class F>
+static void
+sharaku_bench_batch(benchmark::State& state, F f)
+{
+	const size_t n = state.range(0);
+	std::vector<A> a = sharaku_bench_data<A>(n, 1.5f);
+	std::vector<B> b = sharaku_bench_data<B>(n, 0.25f);
+	std::vector<R> r(n);
+
+	for (auto _ : state) {
+		f(r.data(), a.data(), b.data(), n);
+		benchmark::DoNotOptimize(r.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+
+static void
+BM_geometry_batch_dot(benchmark::State& state)
+{
+	sharaku_bench_batch<float, vector3, vector3>(state,
+		[](float *r, const vector3 *a, const vector3 *b, size_t n) { sharaku_dot(r, a, b, n); });
+}
+BENCHMARK(BM_geometry_batch_dot)->Apply(sharaku_bench_sizes);
+
+static void
+BM_geometry_batch_cross(benchmark::State& state)
+{
+	sharaku_bench_batch<vector3, vector3, vector3>(state,
+		[](vector3 *r, const vector3 *a, const vector3 *b, size_t n) { sharaku_cross(r, a, b, n); });
+}
+BENCHMARK(BM_geometry_batch_cross)->Apply(sharaku_bench_sizes);
+
+static void
+BM_geometry_batch_length(benchmark::State& state)
+{
+	sharaku_bench_batch<float, vector3, vector3>(state,
+		[](float *r, const vector3 *a, const vector3 *, size_t n) { sharaku_length(r, a, n); });
+}
+BENCHMARK(BM_geometry_batch_length)->Apply(sharaku_bench_sizes);
+
+static void
+BM_geometry_batch_length_fast(benchmark::State& state)
+{
+	sharaku_bench_batch<float, vector3, vector3>(state,
+		[](float *r, const vector3 *a, const vector3 *, size_t n) { sharaku_length_fast(r, a, n); });
+}
+BENCHMARK(BM_geometry_batch_length_fast)->Apply(sharaku_bench_sizes);
+
+static void
+BM_geometry_batch_normalize(benchmark::State& state)
+{
+	sharaku_bench_batch<vector3, vector3, vector3>(state,
+		[](vector3 *r, const vector3 *a, const vector3 *, size_t n) { sharaku_normalize(r, a, n); });
+}
+BENCHMARK(BM_geometry_batch_normalize)->Apply(sharaku_bench_sizes);
+
+static void
+BM_geometry_batch_normalize_fast(benchmark::State& state)
+{
+	sharaku_bench_batch<vector3, vector3, vector3>(state,
+		[](vector3 *r, const vector3 *a, const vector3 *, size_t n) { sharaku_normalize_fast(r, a, n); });
+}
+BENCHMARK(BM_geometry_batch_normalize_fast)->Apply(sharaku_bench_sizes);
+
+static void
+BM_geometry_batch_distance(benchmark::State& state)
+{
+	sharaku_bench_batch<float, position3, position3>(state,
+		[](float *r, const position3 *a, const position3 *b, size_t n) { sharaku_distance(r, a, b, n); });
+}
+BENCHMARK(BM_geometry_batch_distance)->Apply(sharaku_bench_sizes);
+
+static void
+BM_geometry_batch_distance_fast(benchmark::State& state)
+{
+	sharaku_bench_batch<float, position3, position3>(state,
+		[](float *r, const position3 *a, const position3 *b, size_t n) { sharaku_distance_fast(r, a, b, n); });
+}
+BENCHMARK(BM_geometry_batch_distance_fast)->Apply(sharaku_bench_sizes);
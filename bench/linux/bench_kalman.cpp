@@ -0,0 +1,78 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/kalman.hpp>
+#include "bench.hpp"
+
+//-----------------------------------------------------------------------------
+// n個のトラックの1フレーム分の処理(予測と位置の観測による更新)
+//  kalman_filterをn個並べた場合と、kalman_bankの比較
+//  (1フレーム当たりの処理時間 = time_per_op * n)
+
+// n個のkalman_filter<S>を1つずつ処理する
+template <size_t S>
+static void
+BM_kalman_filter_tracks(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<kalman_filter<S>> f(n, kalman_filter<S>(0.5f));
+	std::vector<position3> z = sharaku_bench_data<position3>(n, 1.5f);
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			f[i].predict(0.01f);
+			f[i].update_position(z[i], 0.01f);
+		}
+		benchmark::DoNotOptimize(f.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK_TEMPLATE(BM_kalman_filter_tracks, 2)->Arg(1 << 10)->Arg(10000);
+BENCHMARK_TEMPLATE(BM_kalman_filter_tracks, 3)->Arg(1 << 10)->Arg(10000);
+
+// n個のトラックをkalman_bank<S>で一括して処理する
+template <size_t S>
+static void
+BM_kalman_bank(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	kalman_bank<S> bank(n, 0.5f);
+	std::vector<vector3> src = sharaku_bench_data<vector3>(n, 1.5f);
+	vector3_soa z(src.data(), n);
+	for (size_t i = 0; i < n; i++) {
+		bank.set_measurement_noise(i, 0.01f);
+	}
+
+	for (auto _ : state) {
+		bank.predict(0.01f);
+		bank.update_position(z);
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK_TEMPLATE(BM_kalman_bank, 2)->Arg(1 << 10)->Arg(10000);
+BENCHMARK_TEMPLATE(BM_kalman_bank, 3)->Arg(1 << 10)->Arg(10000);
@@ -0,0 +1,77 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/parallel.hpp>
+#include "bench.hpp"
+
+// スレッド数を1からCPU数の2倍まで倍々で変化させる
+static void
+sharaku_bench_threads(benchmark::internal::Benchmark *b)
+{
+	const int max_threads = (int)std::thread::hardware_concurrency() * 2;
+	for (int threads = 1; threads <= max_threads; threads *= 2) {
+		b->Args({4 << 20, threads});
+	}
+}
+
+// 4M点の座標変換をスレッド数を変えて計測する
+static void
+BM_parallel_transform(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	thread_pool pool(state.range(1));
+	const transform3 t = transform3::from_rotation(rotation3{10.0f, 20.0f, 30.0f},
+						       vector3{1.0f, 2.0f, 3.0f});
+	std::vector<position3> in = sharaku_bench_data<position3>(n, 1.5f);
+	std::vector<position3> out(n);
+
+	for (auto _ : state) {
+		sharaku_parallel_transform(pool, t, in.data(), out.data(), n);
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_parallel_transform)->Apply(sharaku_bench_threads)->UseRealTime();
+
+// 4M点の平行移動をスレッド数を変えて計測する
+static void
+BM_parallel_translate(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	thread_pool pool(state.range(1));
+	const vector3 vec{1.0f, 2.0f, 3.0f};
+	std::vector<position3> in = sharaku_bench_data<position3>(n, 1.5f);
+	std::vector<position3> out(n);
+
+	for (auto _ : state) {
+		sharaku_parallel_translate(pool, vec, in.data(), out.data(), n);
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_parallel_translate)->Apply(sharaku_bench_threads)->UseRealTime();
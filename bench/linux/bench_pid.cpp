@@ -0,0 +1,100 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/pid.hpp>
+#include "bench.hpp"
+
+// n個のpidをそれぞれ1ステップ進める
+static void
+BM_pid_step(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<pid> loops(n, pid(1.2f, 0.01f, 0.3f));
+	std::vector<int32_t> now(n), target(n);
+	std::vector<float> u(n);
+	for (size_t i = 0; i < n; i++) {
+		now[i] = (int32_t)(i % 101);
+		target[i] = (int32_t)(i % 37);
+	}
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			u[i] = loops[i](10.0f, now[i], target[i]);
+		}
+		benchmark::DoNotOptimize(u.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_pid_step)->Apply(sharaku_bench_sizes);
+
+// n個のpid_fixedをそれぞれ1ステップ進める
+static void
+BM_pid_fixed_step(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<pid_fixed> loops(n, pid_fixed(q16_16(1.2f), q16_16(0.01f),
+						  q16_16(0.3f), q16_16(10)));
+	std::vector<int32_t> now(n), target(n);
+	std::vector<q16_16> u(n);
+	for (size_t i = 0; i < n; i++) {
+		now[i] = (int32_t)(i % 101);
+		target[i] = (int32_t)(i % 37);
+	}
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			u[i] = loops[i](now[i], target[i]);
+		}
+		benchmark::DoNotOptimize(u.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_pid_fixed_step)->Apply(sharaku_bench_sizes);
+
+// pid_bankでn個のループを1ステップ進める
+static void
+BM_pid_bank_step(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	pid_bank bank(n);
+	std::vector<int32_t> now(n), target(n);
+	std::vector<float> u(n);
+	for (size_t i = 0; i < n; i++) {
+		bank.set_pid(i, 1.2f, 0.01f, 0.3f);
+		now[i] = (int32_t)(i % 101);
+		target[i] = (int32_t)(i % 37);
+	}
+
+	for (auto _ : state) {
+		bank(10.0f, now.data(), target.data(), u.data());
+		benchmark::DoNotOptimize(u.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_pid_bank_step)->Apply(sharaku_bench_sizes);
@@ -0,0 +1,187 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/point-cloud.hpp>
+#include "bench.hpp"
+#include <algorithm>
+#include <random>
+
+//-----------------------------------------------------------------------------
+// 点群処理のベンチマーク
+//  回転式LiDARの1フレームを模した点群(走査順に並ぶ)に対して計測する。
+//  time_per_opは1点当たりの処理時間。
+
+#define BENCH_RINGS	64	// 走査線数
+#define BENCH_LEAF	0.1f	// ボクセルの一辺の長さ
+
+static void
+sharaku_bench_cloud_sizes(benchmark::internal::Benchmark *b)
+{
+	b->Arg(1 << 17)->Arg(2 << 20)->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+// 走査線ごとに方位角の順に並んだ点群(shuffle = trueの場合は順序を乱す)
+static std::vector<position3>
+sharaku_bench_cloud(size_t n, bool shuffle)
+{
+	std::mt19937 gen(1);
+	std::normal_distribution<float> noise(0.0f, 0.02f);
+	const size_t cols = n / BENCH_RINGS;
+	std::vector<position3> v(cols * BENCH_RINGS);
+	for (size_t r = 0; r < BENCH_RINGS; r++) {
+		const float elev = -0.4f + 0.6f * (float)r / BENCH_RINGS;
+		for (size_t c = 0; c < cols; c++) {
+			const float az = 6.2831853f * (float)c / (float)cols;
+			const float range = 8.0f + 4.0f * sinf(3.0f * az) + noise(gen);
+			v[r * cols + c](range * cosf(az) * cosf(elev), range * sinf(az) * cosf(elev),
+					range * sinf(elev) + 1.8f);
+		}
+	}
+	if (shuffle) {
+		std::shuffle(v.begin(), v.end(), gen);
+	}
+	return v;
+}
+
+template <class F>
+static void
+sharaku_bench_cloud_run(benchmark::State& state, bool parallel, F f)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> p = sharaku_bench_cloud(n, false);
+	thread_pool pool;
+	thread_pool *tp = parallel ? &pool : nullptr;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(f(p.data(), p.size(), tp));
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, p.size());
+}
+
+//-----------------------------------------------------------------------------
+// 集約(境界箱、重心、共分散)
+
+static void
+BM_cloud_aabb(benchmark::State& state)
+{
+	sharaku_bench_cloud_run(state, false, sharaku_aabb);
+}
+BENCHMARK(BM_cloud_aabb)->Apply(sharaku_bench_cloud_sizes);
+
+static void
+BM_cloud_aabb_parallel(benchmark::State& state)
+{
+	sharaku_bench_cloud_run(state, true, sharaku_aabb);
+}
+BENCHMARK(BM_cloud_aabb_parallel)->Apply(sharaku_bench_cloud_sizes);
+
+static void
+BM_cloud_centroid(benchmark::State& state)
+{
+	sharaku_bench_cloud_run(state, false, sharaku_centroid);
+}
+BENCHMARK(BM_cloud_centroid)->Apply(sharaku_bench_cloud_sizes);
+
+static void
+BM_cloud_covariance(benchmark::State& state)
+{
+	sharaku_bench_cloud_run(state, false, [](const position3 *p, size_t n, thread_pool *tp) {
+		return sharaku_covariance(p, n, tp);
+	});
+}
+BENCHMARK(BM_cloud_covariance)->Apply(sharaku_bench_cloud_sizes);
+
+static void
+BM_cloud_covariance_parallel(benchmark::State& state)
+{
+	sharaku_bench_cloud_run(state, true, [](const position3 *p, size_t n, thread_pool *tp) {
+		return sharaku_covariance(p, n, tp);
+	});
+}
+BENCHMARK(BM_cloud_covariance_parallel)->Apply(sharaku_bench_cloud_sizes);
+
+// 比較用: 倍精度の2パス
+static void
+BM_cloud_covariance_twopass(benchmark::State& state)
+{
+	sharaku_bench_cloud_run(state, false, [](const position3 *p, size_t n, thread_pool *) {
+		double m[3] = {0.0, 0.0, 0.0}, c[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+		for (size_t i = 0; i < n; i++) {
+			m[0] += p[i].x; m[1] += p[i].y; m[2] += p[i].z;
+		}
+		for (int k = 0; k < 3; k++) {
+			m[k] /= (double)n;
+		}
+		for (size_t i = 0; i < n; i++) {
+			const double x = p[i].x - m[0], y = p[i].y - m[1], z = p[i].z - m[2];
+			c[0] += x * x; c[1] += x * y; c[2] += x * z;
+			c[3] += y * y; c[4] += y * z; c[5] += z * z;
+		}
+		return c[0] + c[1] + c[2] + c[3] + c[4] + c[5];
+	});
+}
+BENCHMARK(BM_cloud_covariance_twopass)->Apply(sharaku_bench_cloud_sizes);
+
+//-----------------------------------------------------------------------------
+// ボクセルグリッドによる間引き
+
+static void
+sharaku_bench_voxel(benchmark::State& state, bool shuffle, bool parallel)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> p = sharaku_bench_cloud(n, shuffle);
+	std::vector<position3> out;
+	thread_pool pool;
+	for (auto _ : state) {
+		sharaku_voxel_downsample(p.data(), p.size(), BENCH_LEAF, out,
+					 parallel ? &pool : nullptr);
+		benchmark::DoNotOptimize(out.data());
+	}
+	state.counters["voxels"] = (double)out.size();
+	sharaku_bench_counters(state, p.size());
+}
+
+static void
+BM_cloud_voxel(benchmark::State& state)
+{
+	sharaku_bench_voxel(state, false, false);
+}
+BENCHMARK(BM_cloud_voxel)->Apply(sharaku_bench_cloud_sizes);
+
+static void
+BM_cloud_voxel_parallel(benchmark::State& state)
+{
+	sharaku_bench_voxel(state, false, true);
+}
+BENCHMARK(BM_cloud_voxel_parallel)->Apply(sharaku_bench_cloud_sizes);
+
+// 走査順でない点群(直前のボクセルと一致しない)
+static void
+BM_cloud_voxel_shuffled(benchmark::State& state)
+{
+	sharaku_bench_voxel(state, true, false);
+}
+BENCHMARK(BM_cloud_voxel_shuffled)->Apply(sharaku_bench_cloud_sizes);
@@ -0,0 +1,72 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/quaternion.hpp>
+#include "bench.hpp"
+
+static void
+BM_quaternion_rotate(benchmark::State& state)
+{
+	const quaternion q = quaternion::from_rotation(rotation3{10.0f, 20.0f, 30.0f});
+	sharaku_bench_update<vector3, vector3>(state,
+		[q](vector3& a, vector3& b) { a = q.rotate(b); });
+}
+BENCHMARK(BM_quaternion_rotate)->Apply(sharaku_bench_sizes);
+
+static void
+BM_quaternion_rotate_batch(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	const quaternion q = quaternion::from_rotation(rotation3{10.0f, 20.0f, 30.0f});
+	std::vector<vector3> in = sharaku_bench_data<vector3>(n, 1.5f);
+	std::vector<vector3> out(n);
+
+	for (auto _ : state) {
+		q.rotate(in.data(), out.data(), n);
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_quaternion_rotate_batch)->Apply(sharaku_bench_sizes);
+
+static void
+BM_quaternion_compose(benchmark::State& state)
+{
+	const quaternion q = quaternion::from_rotation(rotation3{10.0f, 20.0f, 30.0f});
+	const size_t n = state.range(0);
+	std::vector<quaternion> r(n, quaternion::identity());
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			r[i] *= q;
+		}
+		benchmark::DoNotOptimize(r.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_quaternion_compose)->Apply(sharaku_bench_sizes);
@@ -0,0 +1,155 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/registration.hpp>
+#include "bench.hpp"
+#include <random>
+
+//-----------------------------------------------------------------------------
+// 位置合わせのベンチマーク
+//  LiDARの連続するスキャンを模して、起伏のある面上の点群(target)と、
+//  その一部を微小に動かした点群(src)を位置合わせする。
+
+#define BENCH_TARGET_RATIO	2	// srcに対するtargetの点数の比
+
+static void
+sharaku_bench_scan_sizes(benchmark::internal::Benchmark *b)
+{
+	b->Arg(10000)->Arg(100000)->Unit(benchmark::kMicrosecond)->UseRealTime();
+}
+
+static std::vector<position3>
+sharaku_bench_surface(size_t n, unsigned seed)
+{
+	std::mt19937 gen(seed);
+	std::uniform_real_distribution<float> u(-20.0f, 20.0f);
+	std::vector<position3> v(n);
+	for (position3& p : v) {
+		const float x = u(gen), y = u(gen);
+		p(x, y, 2.0f * sinf(0.5f * x) + cosf(0.3f * y) + 0.05f * x * y);
+	}
+	return v;
+}
+
+// 前のスキャンから少し動いた位置で取得したスキャン
+static std::vector<position3>
+sharaku_bench_scan(const std::vector<position3>& target, size_t n)
+{
+	const transform3 motion = transform3::from_rotation(rotation3{0.5f, -1.0f, 2.0f},
+							    vector3{0.2f, -0.1f, 0.05f});
+	std::vector<position3> v(n);
+	for (size_t i = 0; i < n; i++) {
+		v[i] = motion.apply(target[i * BENCH_TARGET_RATIO]);
+	}
+	return v;
+}
+
+//-----------------------------------------------------------------------------
+// Kabsch(対応点の組から剛体変換を求める)
+
+static void
+BM_registration_kabsch(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> src = sharaku_bench_data<position3>(n, 1.5f);
+	std::vector<position3> dst(n);
+	transform3::from_rotation(rotation3{10.0f, 20.0f, 30.0f}, vector3{1.0f, 2.0f, 3.0f})
+		.apply(src.data(), dst.data(), n);
+	transform3 t;
+	for (auto _ : state) {
+		sharaku_kabsch(src.data(), dst.data(), n, t);
+		benchmark::DoNotOptimize(t);
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_registration_kabsch)->Apply(sharaku_bench_scan_sizes);
+
+// 3x3の特異値分解と回転の復元のみ
+static void
+BM_registration_kabsch_solve(benchmark::State& state)
+{
+	std::vector<position3> src = sharaku_bench_data<position3>(1000, 1.5f);
+	std::vector<position3> dst(src.size());
+	transform3::from_rotation(rotation3{10.0f, 20.0f, 30.0f}, vector3{1.0f, 2.0f, 3.0f})
+		.apply(src.data(), dst.data(), src.size());
+	const cross_moments m = sharaku_cross_moments(src.data(), dst.data(), src.size());
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(sharaku_kabsch_solve(m));
+	}
+	sharaku_bench_counters(state, 1);
+}
+BENCHMARK(BM_registration_kabsch_solve);
+
+//-----------------------------------------------------------------------------
+// ICP
+//  iterations_per_secondは1秒当たりの反復回数
+
+static void
+sharaku_bench_icp(benchmark::State& state, uint32_t max_iterations, bool parallel)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> target = sharaku_bench_surface(n * BENCH_TARGET_RATIO, 1);
+	std::vector<position3> src = sharaku_bench_scan(target, n);
+	thread_pool pool;
+	kd_tree tree(target.data(), target.size(), &pool);
+	icp_params params = icp_params::defaults();
+	params.max_iterations = max_iterations;
+
+	uint64_t iterations = 0;
+	for (auto _ : state) {
+		const icp_result r = sharaku_icp(tree, src.data(), src.size(), transform3::identity(),
+						 params, parallel ? &pool : nullptr);
+		benchmark::DoNotOptimize(r.transform);
+		iterations += r.iterations;
+	}
+	state.counters["iterations"] = (double)iterations / (double)state.iterations();
+	state.counters["iterations_per_second"] =
+		benchmark::Counter((double)iterations, benchmark::Counter::kIsRate);
+	sharaku_bench_counters(state, n);
+}
+
+// 1反復(対応付けと更新)
+static void
+BM_registration_icp_iteration(benchmark::State& state)
+{
+	sharaku_bench_icp(state, 1, false);
+}
+BENCHMARK(BM_registration_icp_iteration)->Apply(sharaku_bench_scan_sizes);
+
+static void
+BM_registration_icp_iteration_parallel(benchmark::State& state)
+{
+	sharaku_bench_icp(state, 1, true);
+}
+BENCHMARK(BM_registration_icp_iteration_parallel)->Apply(sharaku_bench_scan_sizes);
+
+// 収束まで(既定の収束条件)
+static void
+BM_registration_icp(benchmark::State& state)
+{
+	sharaku_bench_icp(state, 30, false);
+}
+BENCHMARK(BM_registration_icp)->Apply(sharaku_bench_scan_sizes);
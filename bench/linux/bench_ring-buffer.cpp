@@ -0,0 +1,215 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/ring-buffer.hpp>
+#include <libsharaku/type/position.hpp>
+#include <pthread.h>
+#include <sched.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "bench.hpp"
+
+//-----------------------------------------------------------------------------
+// スレッド間のposition3の受け渡し
+//  生産者スレッドと消費者スレッド(ベンチマークのスレッド)を別のCPUへ
+//  固定し、spsc_ringとmutexで保護したstd::dequeを比較する。
+//  CPUが1つの環境では同一CPUで交互に実行される。
+
+// 呼び出しスレッドをcpu(CPU数の剰余)へ固定し、変更前の設定を返す
+static cpu_set_t
+sharaku_bench_pin(unsigned cpu)
+{
+	const unsigned n = std::thread::hardware_concurrency();
+	cpu_set_t old, set;
+	pthread_getaffinity_np(pthread_self(), sizeof(old), &old);
+	CPU_ZERO(&set);
+	CPU_SET(cpu % (n ? n : 1), &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	return old;
+}
+
+// 呼び出しスレッドのCPUの設定を戻す(以降のベンチマークへ影響させない)
+static void
+sharaku_bench_unpin(const cpu_set_t& old)
+{
+	pthread_setaffinity_np(pthread_self(), sizeof(old), &old);
+}
+
+// 1反復で64K要素をstate.range(0)要素ずつspsc_ringで受け渡す
+static void
+BM_spsc_ring_throughput(benchmark::State& state)
+{
+	const size_t batch = state.range(0);
+	const size_t n = 64 << 10;
+	spsc_ring<position3> ring(1024);
+	std::atomic<size_t> request{0};
+	std::atomic<bool> stop{false};
+	const cpu_set_t affinity = sharaku_bench_pin(0);
+
+	std::thread producer([&] {
+		sharaku_bench_pin(1);
+		std::vector<position3> buf(batch);
+		size_t sent = 0;
+		while (!stop.load(std::memory_order_relaxed)) {
+			if (sent == request.load(std::memory_order_acquire)) {
+				std::this_thread::yield();
+				continue;
+			}
+			size_t done = 0;
+			while (done < batch) {
+				size_t m = ring.push(buf.data() + done, batch - done);
+				if (m == 0) {
+					std::this_thread::yield();
+				}
+				done += m;
+			}
+			sent += batch;
+		}
+	});
+
+	std::vector<position3> buf(batch);
+	for (auto _ : state) {
+		request.fetch_add(n, std::memory_order_release);
+		size_t got = 0;
+		while (got < n) {
+			size_t m = ring.pop(buf.data(), batch);
+			if (m == 0) {
+				std::this_thread::yield();
+			}
+			got += m;
+		}
+		benchmark::DoNotOptimize(buf.data());
+	}
+	stop = true;
+	producer.join();
+	sharaku_bench_unpin(affinity);
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_spsc_ring_throughput)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+
+// 1反復で64K要素をstate.range(0)要素ずつmutexとstd::dequeで受け渡す
+static void
+BM_mutex_deque_throughput(benchmark::State& state)
+{
+	const size_t batch = state.range(0);
+	const size_t n = 64 << 10;
+	std::deque<position3> queue;
+	std::mutex mtx;
+	std::atomic<size_t> request{0};
+	std::atomic<bool> stop{false};
+	const cpu_set_t affinity = sharaku_bench_pin(0);
+
+	std::thread producer([&] {
+		sharaku_bench_pin(1);
+		std::vector<position3> buf(batch);
+		size_t sent = 0;
+		while (!stop.load(std::memory_order_relaxed)) {
+			if (sent == request.load(std::memory_order_acquire)) {
+				std::this_thread::yield();
+				continue;
+			}
+			size_t done = 0;
+			while (done < batch) {
+				bool full;
+				{
+					std::lock_guard<std::mutex> lock(mtx);
+					full = queue.size() >= 1024;
+					for (; !full && done < batch && queue.size() < 1024; done++) {
+						queue.push_back(buf[done]);
+					}
+				}
+				if (full) {
+					std::this_thread::yield();
+				}
+			}
+			sent += batch;
+		}
+	});
+
+	std::vector<position3> buf(batch);
+	for (auto _ : state) {
+		request.fetch_add(n, std::memory_order_release);
+		size_t got = 0;
+		while (got < n) {
+			size_t m = 0;
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				for (; m < batch && !queue.empty(); m++) {
+					buf[m] = queue.front();
+					queue.pop_front();
+				}
+			}
+			if (m == 0) {
+				std::this_thread::yield();
+			}
+			got += m;
+		}
+		benchmark::DoNotOptimize(buf.data());
+	}
+	stop = true;
+	producer.join();
+	sharaku_bench_unpin(affinity);
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_mutex_deque_throughput)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+
+// 1要素の往復時間(2つのspsc_ringによるping-pong)
+static void
+BM_spsc_ring_latency(benchmark::State& state)
+{
+	spsc_ring<position3> ping(16), pong(16);
+	std::atomic<bool> stop{false};
+	const cpu_set_t affinity = sharaku_bench_pin(0);
+
+	std::thread echo([&] {
+		sharaku_bench_pin(1);
+		position3 p;
+		while (!stop.load(std::memory_order_relaxed)) {
+			if (ping.pop(p)) {
+				while (!pong.push(p)) {
+				}
+			} else {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	position3 p = {1.0f, 2.0f, 3.0f};
+	for (auto _ : state) {
+		while (!ping.push(p)) {
+		}
+		while (!pong.pop(p)) {
+			std::this_thread::yield();
+		}
+	}
+	stop = true;
+	echo.join();
+	sharaku_bench_unpin(affinity);
+	sharaku_bench_counters(state, 1);
+}
+BENCHMARK(BM_spsc_ring_latency)->UseRealTime();
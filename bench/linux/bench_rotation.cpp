@@ -0,0 +1,263 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/rotation.hpp>
+#include "bench.hpp"
+
+static void
+BM_rotation3_set(benchmark::State& state)
+{
+	sharaku_bench_update<rotation3, rotation3>(state,
+		[](rotation3& a, rotation3& b) { a(b.x, b.y, b.z); });
+}
+BENCHMARK(BM_rotation3_set)->Apply(sharaku_bench_sizes);
+
+static void
+BM_rotation3_assign(benchmark::State& state)
+{
+	sharaku_bench_update<rotation3, rotation3>(state,
+		[](rotation3& a, rotation3& b) { a = b; });
+}
+BENCHMARK(BM_rotation3_assign)->Apply(sharaku_bench_sizes);
+
+static void
+BM_rotation3_add(benchmark::State& state)
+{
+	sharaku_bench_binary<rotation3, rotation3, rotation3>(state,
+		[](rotation3& a, rotation3& b) { return a + b; });
+}
+BENCHMARK(BM_rotation3_add)->Apply(sharaku_bench_sizes);
+
+static void
+BM_rotation3_sub(benchmark::State& state)
+{
+	sharaku_bench_binary<rotation3, rotation3, rotation3>(state,
+		[](rotation3& a, rotation3& b) { return a - b; });
+}
+BENCHMARK(BM_rotation3_sub)->Apply(sharaku_bench_sizes);
+
+static void
+BM_rotation3_add_assign(benchmark::State& state)
+{
+	sharaku_bench_update<rotation3, rotation3>(state,
+		[](rotation3& a, rotation3& b) { a += b; });
+}
+BENCHMARK(BM_rotation3_add_assign)->Apply(sharaku_bench_sizes);
+
+static void
+BM_rotation3_sub_assign(benchmark::State& state)
+{
+	sharaku_bench_update<rotation3, rotation3>(state,
+		[](rotation3& a, rotation3& b) { a -= b; });
+}
+BENCHMARK(BM_rotation3_sub_assign)->Apply(sharaku_bench_sizes);
+
+static void
+BM_rotation3_add_vector3(benchmark::State& state)
+{
+	sharaku_bench_binary<rotation3, rotation3, vector3>(state,
+		[](rotation3& a, vector3& b) { return a + b; });
+}
+BENCHMARK(BM_rotation3_add_vector3)->Apply(sharaku_bench_sizes);
+
+static void
+BM_rotation3_sub_vector3(benchmark::State& state)
+{
+	sharaku_bench_binary<rotation3, rotation3, vector3>(state,
+		[](rotation3& a, vector3& b) { return a - b; });
+}
+BENCHMARK(BM_rotation3_sub_vector3)->Apply(sharaku_bench_sizes);
+
+static void
+BM_rotation3_add_assign_vector3(benchmark::State& state)
+{
+	sharaku_bench_update<rotation3, vector3>(state,
+		[](rotation3& a, vector3& b) { a += b; });
+}
+BENCHMARK(BM_rotation3_add_assign_vector3)->Apply(sharaku_bench_sizes);
+
+static void
+BM_rotation3_sub_assign_vector3(benchmark::State& state)
+{
+	sharaku_bench_update<rotation3, vector3>(state,
+		[](rotation3& a, vector3& b) { a -= b; });
+}
+BENCHMARK(BM_rotation3_sub_assign_vector3)->Apply(sharaku_bench_sizes);
+
+//-----------------------------------------------------------------------------
+// 角度変換関数
+
+static void
+BM_sharaku_rho2steering(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<int32_t> rho(n);
+	std::vector<float> r(n);
+	for (size_t i = 0; i < n; i++) {
+		rho[i] = (int32_t)(i % 2000) - 1000;
+		rho[i] = rho[i] ? rho[i] : 1;
+	}
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			r[i] = sharaku_rho2steering(rho[i], 150);
+		}
+		benchmark::DoNotOptimize(r.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_sharaku_rho2steering)->Apply(sharaku_bench_sizes);
+
+static void
+BM_sharaku_steering2rho(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<int32_t> steering(n);
+	std::vector<float> r(n);
+	for (size_t i = 0; i < n; i++) {
+		steering[i] = (int32_t)(i % 179) - 89;
+	}
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			r[i] = sharaku_steering2rho(steering[i], 150);
+		}
+		benchmark::DoNotOptimize(r.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_sharaku_steering2rho)->Apply(sharaku_bench_sizes);
+
+static void
+BM_sharaku_rho2steering_fast(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<int32_t> rho(n);
+	std::vector<float> r(n);
+	for (size_t i = 0; i < n; i++) {
+		rho[i] = (int32_t)(i % 2000) - 1000;
+		rho[i] = rho[i] ? rho[i] : 1;
+	}
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			r[i] = sharaku_rho2steering_fast(rho[i], 150);
+		}
+		benchmark::DoNotOptimize(r.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_sharaku_rho2steering_fast)->Apply(sharaku_bench_sizes);
+
+static void
+BM_sharaku_rho2steering_batch(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<int32_t> rho(n);
+	std::vector<float> r(n);
+	for (size_t i = 0; i < n; i++) {
+		rho[i] = (int32_t)(i % 2000) - 1000;
+		rho[i] = rho[i] ? rho[i] : 1;
+	}
+
+	for (auto _ : state) {
+		sharaku_rho2steering_batch(rho.data(), r.data(), n, 150);
+		benchmark::DoNotOptimize(r.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_sharaku_rho2steering_batch)->Apply(sharaku_bench_sizes);
+
+static void
+BM_sharaku_steering2rho_fast(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<int32_t> steering(n);
+	std::vector<float> r(n);
+	for (size_t i = 0; i < n; i++) {
+		steering[i] = (int32_t)(i % 179) - 89;
+	}
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			r[i] = sharaku_steering2rho_fast(steering[i], 150);
+		}
+		benchmark::DoNotOptimize(r.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_sharaku_steering2rho_fast)->Apply(sharaku_bench_sizes);
+
+// range(1)は旋回方向(-1, 0, +1)
+static void
+BM_sharaku_differ_degree(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	const int leftright = (int)state.range(1);
+	std::vector<int32_t> target(n), now(n), r(n);
+	for (size_t i = 0; i < n; i++) {
+		target[i] = (int32_t)((i * 37) % 360);
+		now[i] = (int32_t)((i * 101) % 360);
+	}
+
+	for (auto _ : state) {
+		for (size_t i = 0; i < n; i++) {
+			r[i] = sharaku_differ_degree(target[i], now[i], leftright);
+		}
+		benchmark::DoNotOptimize(r.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_sharaku_differ_degree)
+	->ArgsProduct({{1, 64, 4 << 10, 1 << 20}, {-1, 0, 1}});
+
+// 旋回方向を混在させた一括計算
+static void
+BM_sharaku_differ_degree_batch(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<int32_t> target(n), now(n), leftright(n), r(n);
+	for (size_t i = 0; i < n; i++) {
+		target[i] = (int32_t)((i * 37) % 360);
+		now[i] = (int32_t)((i * 101) % 360);
+		leftright[i] = (int32_t)((i * 7) % 3) - 1;
+	}
+
+	for (auto _ : state) {
+		sharaku_differ_degree_batch(target.data(), now.data(), leftright.data(),
+					    r.data(), n);
+		benchmark::DoNotOptimize(r.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_sharaku_differ_degree_batch)->Apply(sharaku_bench_sizes);
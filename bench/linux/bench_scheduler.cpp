@@ -0,0 +1,56 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/scheduler.hpp>
+#include <libsharaku/type/digital-filter.hpp>
+#include "bench.hpp"
+
+//-----------------------------------------------------------------------------
+// スケジューラの1周期当たりの処理時間(模擬時計)
+//  同一周期のn個のlow_pass_filterを1つのグループで実行する。
+//  time_per_opは処理1個当たりの時間(スケジューラの呼び出し処理を含む)
+
+static void
+BM_scheduler_tick(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	const size_t ticks = 1000;
+	simulated_clock clock;
+	basic_scheduler<simulated_clock> sched(clock);
+	std::vector<low_pass_filter> f(n, low_pass_filter(0.1f));
+	for (size_t i = 0; i < n; i++) {
+		sched.add(1000000, [&f, i](float) { f[i] += 1.0f; });
+	}
+	int64_t end = 0;
+
+	for (auto _ : state) {
+		end += 1000000 * ticks;
+		sched.run_until(end - 1);
+		benchmark::DoNotOptimize(f.data());
+	}
+	sharaku_bench_counters(state, n * ticks);
+}
+BENCHMARK(BM_scheduler_tick)->Arg(1)->Arg(16)->Arg(256);
@@ -0,0 +1,224 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/spatial-index.hpp>
+#include "bench.hpp"
+#include <random>
+
+//-----------------------------------------------------------------------------
+// 空間インデックスのベンチマーク
+//  点数n(10K, 100K, 1M)の一様乱数の点群に対して構築と探索を計測する。
+//  探索は1クエリ当たりの処理時間をtime_per_opとして出力する。
+
+#define BENCH_EXTENT	100.0f	// 点群の範囲(-EXTENT～EXTENT)
+#define BENCH_QUERIES	1024	// 探索のクエリ数
+#define BENCH_K		8	// k近傍のk
+#define BENCH_RADIUS	5.0f	// 半径探索の半径
+
+static void
+sharaku_bench_points_sizes(benchmark::internal::Benchmark *b)
+{
+	b->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+}
+
+static std::vector<position3>
+sharaku_bench_points(size_t n, unsigned seed)
+{
+	std::mt19937 gen(seed);
+	std::uniform_real_distribution<float> d(-BENCH_EXTENT, BENCH_EXTENT);
+	std::vector<position3> v(n);
+	for (size_t i = 0; i < n; i++) {
+		v[i](d(gen), d(gen), d(gen));
+	}
+	return v;
+}
+
+// 平均して1セルに数点が入るセル幅
+static float
+sharaku_bench_cell(size_t n)
+{
+	return 2.0f * BENCH_EXTENT / cbrtf((float)n / 4.0f);
+}
+
+//-----------------------------------------------------------------------------
+// 構築
+
+static void
+BM_spatial_kd_build(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> pts = sharaku_bench_points(n, 1);
+	kd_tree tree;
+	for (auto _ : state) {
+		tree.build(pts.data(), n);
+		benchmark::DoNotOptimize(tree.items());
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_spatial_kd_build)->Apply(sharaku_bench_points_sizes);
+
+static void
+BM_spatial_kd_build_parallel(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> pts = sharaku_bench_points(n, 1);
+	thread_pool pool;
+	kd_tree tree;
+	for (auto _ : state) {
+		tree.build(pts.data(), n, &pool);
+		benchmark::DoNotOptimize(tree.items());
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_spatial_kd_build_parallel)->Apply(sharaku_bench_points_sizes)->UseRealTime();
+
+static void
+BM_spatial_grid_insert(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> pts = sharaku_bench_points(n, 1);
+	for (auto _ : state) {
+		hash_grid grid(sharaku_bench_cell(n));
+		for (size_t i = 0; i < n; i++) {
+			grid.insert((uint32_t)i, pts[i]);
+		}
+		benchmark::DoNotOptimize(grid.size());
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_spatial_grid_insert)->Apply(sharaku_bench_points_sizes);
+
+//-----------------------------------------------------------------------------
+// 探索(k近傍, 半径)
+
+template <class F>
+static void
+sharaku_bench_query(benchmark::State& state, size_t m, F f)
+{
+	std::vector<position3> qs = sharaku_bench_points(m, 2);
+	for (auto _ : state) {
+		for (size_t i = 0; i < m; i++) {
+			benchmark::DoNotOptimize(f(qs[i]));
+		}
+	}
+	sharaku_bench_counters(state, m);
+}
+
+static void
+BM_spatial_brute_knn(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> pts = sharaku_bench_points(n, 1);
+	knn_heap heap;
+	uint32_t idx[BENCH_K];
+	// 総当たりは遅いためクエリ数を減らす
+	sharaku_bench_query(state, 16, [&](const position3& q) {
+		heap.reset(BENCH_K);
+		for (size_t i = 0; i < n; i++) {
+			heap.push(sharaku_distance2(q, pts[i]), (uint32_t)i);
+		}
+		return heap.output(idx, nullptr);
+	});
+}
+BENCHMARK(BM_spatial_brute_knn)->Apply(sharaku_bench_points_sizes);
+
+static void
+BM_spatial_kd_knn(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> pts = sharaku_bench_points(n, 1);
+	kd_tree tree(pts.data(), n);
+	uint32_t idx[BENCH_K];
+	sharaku_bench_query(state, BENCH_QUERIES, [&](const position3& q) {
+		return tree.nearest(q, BENCH_K, idx);
+	});
+}
+BENCHMARK(BM_spatial_kd_knn)->Apply(sharaku_bench_points_sizes);
+
+static void
+BM_spatial_grid_knn(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> pts = sharaku_bench_points(n, 1);
+	hash_grid grid(sharaku_bench_cell(n));
+	for (size_t i = 0; i < n; i++) {
+		grid.insert((uint32_t)i, pts[i]);
+	}
+	uint32_t idx[BENCH_K];
+	sharaku_bench_query(state, BENCH_QUERIES, [&](const position3& q) {
+		return grid.nearest(q, BENCH_K, idx);
+	});
+}
+BENCHMARK(BM_spatial_grid_knn)->Apply(sharaku_bench_points_sizes);
+
+static void
+BM_spatial_kd_radius(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> pts = sharaku_bench_points(n, 1);
+	kd_tree tree(pts.data(), n);
+	std::vector<uint32_t> out;
+	sharaku_bench_query(state, BENCH_QUERIES, [&](const position3& q) {
+		out.clear();
+		return tree.radius(q, BENCH_RADIUS, out);
+	});
+}
+BENCHMARK(BM_spatial_kd_radius)->Apply(sharaku_bench_points_sizes);
+
+static void
+BM_spatial_grid_radius(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> pts = sharaku_bench_points(n, 1);
+	hash_grid grid(sharaku_bench_cell(n));
+	for (size_t i = 0; i < n; i++) {
+		grid.insert((uint32_t)i, pts[i]);
+	}
+	std::vector<uint32_t> out;
+	sharaku_bench_query(state, BENCH_QUERIES, [&](const position3& q) {
+		out.clear();
+		return grid.radius(q, BENCH_RADIUS, out);
+	});
+}
+BENCHMARK(BM_spatial_grid_radius)->Apply(sharaku_bench_points_sizes);
+
+// バッチ探索(スレッドプールで並列化)
+static void
+BM_spatial_kd_knn_batch(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	std::vector<position3> pts = sharaku_bench_points(n, 1);
+	std::vector<position3> qs = sharaku_bench_points(BENCH_QUERIES, 2);
+	thread_pool pool;
+	kd_tree tree(pts.data(), n, &pool);
+	std::vector<uint32_t> idx(BENCH_QUERIES * BENCH_K);
+	for (auto _ : state) {
+		tree.nearest(qs.data(), BENCH_QUERIES, BENCH_K, idx.data(), nullptr, &pool);
+		benchmark::DoNotOptimize(idx.data());
+	}
+	sharaku_bench_counters(state, BENCH_QUERIES);
+}
+BENCHMARK(BM_spatial_kd_knn_batch)->Apply(sharaku_bench_points_sizes)->UseRealTime();
@@ -0,0 +1,149 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/trajectory.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "bench.hpp"
+
+//-----------------------------------------------------------------------------
+// 軌跡ファイルの書き込み・再生(pose3、1M要素)
+//  テキスト形式(fprintf/fscanf)とtrajectory_writer/trajectory_readerの比較
+
+static const size_t sharaku_bench_poses = 1 << 20;
+
+static std::string
+sharaku_bench_trajectory_path(const char *name)
+{
+	const char *dir = getenv("TMPDIR");
+	return std::string(dir ? dir : "/tmp") + "/" + name;
+}
+
+static std::vector<pose3>
+sharaku_bench_pose_data(size_t n)
+{
+	std::vector<pose3> poses(n);
+	for (size_t i = 0; i < n; i++) {
+		poses[i].position(i * 0.001f, -(float)(i % 97), 1.5f);
+		poses[i].rotation((float)(i % 360), 0.25f, -(float)(i % 90));
+	}
+	return poses;
+}
+
+// テキスト形式で1要素ずつ書き込む
+static void
+BM_trajectory_text_write(benchmark::State& state)
+{
+	const std::string path = sharaku_bench_trajectory_path("sharaku_bench.txt");
+	const std::vector<pose3> poses = sharaku_bench_pose_data(sharaku_bench_poses);
+
+	for (auto _ : state) {
+		FILE *fp = fopen(path.c_str(), "w");
+		for (const pose3& p : poses) {
+			fprintf(fp, "%f %f %f %f %f %f\n", p.position.x, p.position.y, p.position.z,
+				p.rotation.x, p.rotation.y, p.rotation.z);
+		}
+		fclose(fp);
+	}
+	remove(path.c_str());
+	sharaku_bench_counters(state, poses.size());
+}
+BENCHMARK(BM_trajectory_text_write)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// trajectory_writerで1要素ずつ追記する
+static void
+BM_trajectory_write(benchmark::State& state)
+{
+	const std::string path = sharaku_bench_trajectory_path("sharaku_bench.traj");
+	const std::vector<pose3> poses = sharaku_bench_pose_data(sharaku_bench_poses);
+
+	for (auto _ : state) {
+		trajectory_writer<pose3> w;
+		w.open(path.c_str(), 1000000);
+		for (const pose3& p : poses) {
+			w.append(p);
+		}
+		w.close();
+	}
+	remove(path.c_str());
+	sharaku_bench_counters(state, poses.size());
+}
+BENCHMARK(BM_trajectory_write)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// テキスト形式のファイルを読み込み、位置の総和を求める
+static void
+BM_trajectory_text_replay(benchmark::State& state)
+{
+	const std::string path = sharaku_bench_trajectory_path("sharaku_bench.txt");
+	const std::vector<pose3> poses = sharaku_bench_pose_data(sharaku_bench_poses);
+	FILE *fp = fopen(path.c_str(), "w");
+	for (const pose3& p : poses) {
+		fprintf(fp, "%f %f %f %f %f %f\n", p.position.x, p.position.y, p.position.z,
+			p.rotation.x, p.rotation.y, p.rotation.z);
+	}
+	fclose(fp);
+
+	for (auto _ : state) {
+		fp = fopen(path.c_str(), "r");
+		pose3 p;
+		float sum = 0.0f;
+		while (fscanf(fp, "%f %f %f %f %f %f", &p.position.x, &p.position.y, &p.position.z,
+			      &p.rotation.x, &p.rotation.y, &p.rotation.z) == 6) {
+			sum += p.position.x;
+		}
+		fclose(fp);
+		benchmark::DoNotOptimize(sum);
+	}
+	remove(path.c_str());
+	sharaku_bench_counters(state, poses.size());
+}
+BENCHMARK(BM_trajectory_text_replay)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// trajectory_readerで開き、位置の総和を求める(ページキャッシュ上のファイル)
+static void
+BM_trajectory_replay(benchmark::State& state)
+{
+	const std::string path = sharaku_bench_trajectory_path("sharaku_bench.traj");
+	const std::vector<pose3> poses = sharaku_bench_pose_data(sharaku_bench_poses);
+	trajectory_writer<pose3> w;
+	w.open(path.c_str(), 1000000);
+	w.append(poses.data(), poses.size());
+	w.close();
+
+	for (auto _ : state) {
+		trajectory_reader<pose3> r;
+		r.open(path.c_str());
+		float sum = 0.0f;
+		for (const pose3& p : r) {
+			sum += p.position.x;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	remove(path.c_str());
+	sharaku_bench_counters(state, poses.size());
+}
+BENCHMARK(BM_trajectory_replay)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,58 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/transform.hpp>
+#include "bench.hpp"
+
+// 1点ずつ座標変換する
+static void
+BM_transform3_apply(benchmark::State& state)
+{
+	const transform3 t = transform3::from_rotation(rotation3{10.0f, 20.0f, 30.0f},
+						       vector3{1.0f, 2.0f, 3.0f});
+	sharaku_bench_update<position3, position3>(state,
+		[t](position3& a, position3& b) { a = t.apply(b); });
+}
+BENCHMARK(BM_transform3_apply)->Apply(sharaku_bench_sizes);
+
+// 配列を一括で座標変換する
+static void
+BM_transform3_apply_batch(benchmark::State& state)
+{
+	const size_t n = state.range(0);
+	const transform3 t = transform3::from_rotation(rotation3{10.0f, 20.0f, 30.0f},
+						       vector3{1.0f, 2.0f, 3.0f});
+	std::vector<position3> in = sharaku_bench_data<position3>(n, 1.5f);
+	std::vector<position3> out(n);
+
+	for (auto _ : state) {
+		t.apply(in.data(), out.data(), n);
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	sharaku_bench_counters(state, n);
+}
+BENCHMARK(BM_transform3_apply_batch)->Apply(sharaku_bench_sizes);
@@ -0,0 +1,76 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/vector.hpp>
+#include "bench.hpp"
+
+static void
+BM_vector3_set(benchmark::State& state)
+{
+	sharaku_bench_update<vector3, vector3>(state,
+		[](vector3& a, vector3& b) { a(b.x, b.y, b.z); });
+}
+BENCHMARK(BM_vector3_set)->Apply(sharaku_bench_sizes);
+
+static void
+BM_vector3_assign(benchmark::State& state)
+{
+	sharaku_bench_update<vector3, vector3>(state,
+		[](vector3& a, vector3& b) { a = b; });
+}
+BENCHMARK(BM_vector3_assign)->Apply(sharaku_bench_sizes);
+
+static void
+BM_vector3_add(benchmark::State& state)
+{
+	sharaku_bench_binary<vector3, vector3, vector3>(state,
+		[](vector3& a, vector3& b) { return a + b; });
+}
+BENCHMARK(BM_vector3_add)->Apply(sharaku_bench_sizes);
+
+static void
+BM_vector3_sub(benchmark::State& state)
+{
+	sharaku_bench_binary<vector3, vector3, vector3>(state,
+		[](vector3& a, vector3& b) { return a - b; });
+}
+BENCHMARK(BM_vector3_sub)->Apply(sharaku_bench_sizes);
+
+static void
+BM_vector3_add_assign(benchmark::State& state)
+{
+	sharaku_bench_update<vector3, vector3>(state,
+		[](vector3& a, vector3& b) { a += b; });
+}
+BENCHMARK(BM_vector3_add_assign)->Apply(sharaku_bench_sizes);
+
+static void
+BM_vector3_sub_assign(benchmark::State& state)
+{
+	sharaku_bench_update<vector3, vector3>(state,
+		[](vector3& a, vector3& b) { a -= b; });
+}
+BENCHMARK(BM_vector3_sub_assign)->Apply(sharaku_bench_sizes);
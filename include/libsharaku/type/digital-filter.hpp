@@ -27,46 +27,845 @@
 #ifndef SHARAKU_UV_DIGITAL_FILTER_H_
 #define SHARAKU_UV_DIGITAL_FILTER_H_
 
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <libsharaku/type/simd.hpp>
+
 //-----------------------------------------------------------------------------
 // １次ローパスフィルタ（Low-pass filter: LPF）の実装
-class low_pass_filter
+//  スカラ型Tで演算の型を指定する(float, double, q16_16など)。
+template <class T>
+class basic_low_pass_filter
 {
  public:
-	low_pass_filter(float q) {
+	basic_low_pass_filter(T q) {
 		set(q);
 		clear();
 	}
 	void clear(void) {
-		_x = 0;
+		_x = T(0);
 	}
-	void set(float q) {
+	void set(T q) {
 		_q = q;
+		_nq = T(1) - q;
 	}
-	float operator+(float x) {
-		_x = (x * _q) + (_x * (1 - _q));
+	T operator+(T x) {
+		_x = (x * _q) + (_x * _nq);
 		return _x;
 	}
-	low_pass_filter& operator+=(float x) {
-		_x = (x * _q) + (_x * (1 - _q));
+	basic_low_pass_filter& operator+=(T x) {
+		_x = (x * _q) + (_x * _nq);
 		return *this;
 	}
-	low_pass_filter& operator=(float x) {
+	basic_low_pass_filter& operator=(T x) {
 		_x = x;
 		return *this;
 	}
-	operator float() {
+	operator T() {
 		return _x;
 	}
 
  public:
-	float get_q(void) { return _q; }
+	T get_q(void) { return _q; }
+
+ protected:
+	T	_x;
+	T	_q;
+	T	_nq;	// 1 - _q
+
+ private:
+	basic_low_pass_filter() {}
+};
+
+typedef basic_low_pass_filter<float>	low_pass_filter;
+
+//-----------------------------------------------------------------------------
+// Nチャネル分の１次ローパスフィルタをまとめて処理するバンク
+//  状態と係数(q, 1 - q)をチャネル順に連続して保持し、
+//  1フレーム(Nチャネル分のサンプル)を1回の呼び出しでSIMD演算する。
+//  各チャネルの演算はlow_pass_filterと同一の結果となる。
+//  (積和をFMAへ縮約しない-ffp-contract=offのビルドの場合。縮約する場合は
+//  丸め誤差の範囲で異なる)
+template <size_t N>
+class low_pass_filter_bank
+{
+ public:
+	low_pass_filter_bank(float q) {
+		set(q);
+		clear();
+	}
+	void clear(void) {
+		for (size_t i = 0; i < N; i++) {
+			_x[i] = 0;
+		}
+	}
+	void set(float q) {
+		for (size_t i = 0; i < N; i++) {
+			set(i, q);
+		}
+	}
+	void set(size_t ch, float q) {
+		_q[ch] = q;
+		_nq[ch] = 1 - q;
+	}
+
+	// 1フレーム(N要素)を入力する
+	low_pass_filter_bank& operator+=(const float *frame) {
+		_update(frame);
+		return *this;
+	}
+
+	// framesフレーム分をまとめて入力する
+	//  in/outはフレーム順にNチャネルずつ並べたframes * N要素の配列。
+	//  outには各フレーム入力後の出力を書き出す(nullptrの場合は書き出さない)
+	void process(const float *in, float *out, size_t frames) {
+		for (size_t m = 0; m < frames; m++) {
+			_update(in + m * N);
+			if (out) {
+				for (size_t i = 0; i < N; i++) {
+					out[m * N + i] = _x[i];
+				}
+			}
+		}
+	}
+
+	float operator[](size_t ch) const {
+		return _x[ch];
+	}
+	low_pass_filter_bank& operator=(float x) {
+		for (size_t i = 0; i < N; i++) {
+			_x[i] = x;
+		}
+		return *this;
+	}
+
+ public:
+	size_t size(void) { return N; }
+	float get_q(size_t ch) { return _q[ch]; }
+
+ private:
+	void _update(const float *in) {
+		typedef sharaku_simd	S;
+		const size_t W = S::width;
+		size_t i = 0;
+		for (; i + W <= N; i += W) {
+			S::store(_x + i, S::add(S::mul(S::load(in + i), S::load(_q + i)),
+						S::mul(S::load(_x + i), S::load(_nq + i))));
+		}
+		if constexpr (N % W) {
+			for (; i < N; i++) {
+				_x[i] = (in[i] * _q[i]) + (_x[i] * _nq[i]);
+			}
+		}
+	}
 
  protected:
-	float	_x;
-	float	_q;
+	alignas(SHARAKU_SIMD_ALIGN) float	_x[N];
+	alignas(SHARAKU_SIMD_ALIGN) float	_q[N];
+	alignas(SHARAKU_SIMD_ALIGN) float	_nq[N];	// 1 - _q
 
  private:
-	low_pass_filter() {}
+	low_pass_filter_bank() {}
+};
+
+//-----------------------------------------------------------------------------
+// 2次IIRフィルタ(biquad)の係数
+//  H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+//  設計はdoubleで行い、floatへ丸めて保持する。
+//  fcは遮断(中心)周波数、fsはサンプリング周波数(同一単位、fc < fs / 2)。
+struct biquad_coef {
+	float b0, b1, b2;
+	float a1, a2;
+
+	// 係数をa0で正規化して格納する
+	static biquad_coef _make(double b0, double b1, double b2,
+				 double a0, double a1, double a2) {
+		return biquad_coef{(float)(b0 / a0), (float)(b1 / a0), (float)(b2 / a0),
+				   (float)(a1 / a0), (float)(a2 / a0)};
+	}
+	// 2次ローパス
+	static biquad_coef lowpass(double fc, double fs, double Q) {
+		const double w0 = 2.0 * 3.14159265358979323846 * fc / fs;
+		const double c = cos(w0), alpha = sin(w0) / (2.0 * Q);
+		return _make((1.0 - c) / 2.0, 1.0 - c, (1.0 - c) / 2.0,
+			     1.0 + alpha, -2.0 * c, 1.0 - alpha);
+	}
+	// 2次ハイパス
+	static biquad_coef highpass(double fc, double fs, double Q) {
+		const double w0 = 2.0 * 3.14159265358979323846 * fc / fs;
+		const double c = cos(w0), alpha = sin(w0) / (2.0 * Q);
+		return _make((1.0 + c) / 2.0, -(1.0 + c), (1.0 + c) / 2.0,
+			     1.0 + alpha, -2.0 * c, 1.0 - alpha);
+	}
+	// 2次バンドパス(中心周波数でのゲイン1)
+	static biquad_coef bandpass(double fc, double fs, double Q) {
+		const double w0 = 2.0 * 3.14159265358979323846 * fc / fs;
+		const double c = cos(w0), alpha = sin(w0) / (2.0 * Q);
+		return _make(alpha, 0.0, -alpha, 1.0 + alpha, -2.0 * c, 1.0 - alpha);
+	}
+	// 1次ローパス(b2 = a2 = 0)
+	static biquad_coef lowpass1(double fc, double fs) {
+		const double K = tan(3.14159265358979323846 * fc / fs);
+		return _make(K, K, 0.0, K + 1.0, K - 1.0, 0.0);
+	}
+	// 1次ハイパス(b2 = a2 = 0)
+	static biquad_coef highpass1(double fc, double fs) {
+		const double K = tan(3.14159265358979323846 * fc / fs);
+		return _make(1.0, -1.0, 0.0, K + 1.0, K - 1.0, 0.0);
+	}
+	// 素通し
+	static biquad_coef identity(void) {
+		return biquad_coef{1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+	}
+};
+
+// order次Butterworthフィルタの2次セクション数
+static inline size_t
+sharaku_butterworth_sections(size_t order)
+{
+	return (order + 1) / 2;
+}
+
+// order次Butterworthフィルタを2次セクションに分解する
+//  sosにはsharaku_butterworth_sections(order)個の係数を書き出す。
+//  奇数次の場合は最後のセクションを1次とする。
+static inline size_t
+sharaku_butterworth(biquad_coef *sos, size_t order, double fc, double fs, bool highpass)
+{
+	const size_t pairs = order / 2;
+	for (size_t k = 0; k < pairs; k++) {
+		// 共役極対のQ = 1 / (2 sin((2k + 1)π / 2N))
+		const double Q = 1.0 / (2.0 * sin((2.0 * k + 1.0) * 3.14159265358979323846 /
+						  (2.0 * order)));
+		sos[k] = highpass ? biquad_coef::highpass(fc, fs, Q) :
+				    biquad_coef::lowpass(fc, fs, Q);
+	}
+	if (order & 1) {
+		sos[pairs] = highpass ? biquad_coef::highpass1(fc, fs) :
+					biquad_coef::lowpass1(fc, fs);
+	}
+	return sharaku_butterworth_sections(order);
+}
+
+// order次Butterworthローパスの設計
+static inline size_t
+sharaku_butterworth_lowpass(biquad_coef *sos, size_t order, double fc, double fs)
+{
+	return sharaku_butterworth(sos, order, fc, fs, false);
+}
+
+// order次Butterworthハイパスの設計
+static inline size_t
+sharaku_butterworth_highpass(biquad_coef *sos, size_t order, double fc, double fs)
+{
+	return sharaku_butterworth(sos, order, fc, fs, true);
+}
+
+// Butterworthバンドパスの設計(f_lo～f_hiを通過域とする)
+//  order次ハイパス(f_lo)とorder次ローパス(f_hi)の縦続接続とし、
+//  sosには2 * sharaku_butterworth_sections(order)個の係数を書き出す。
+static inline size_t
+sharaku_butterworth_bandpass(biquad_coef *sos, size_t order,
+			     double f_lo, double f_hi, double fs)
+{
+	size_t n = sharaku_butterworth_highpass(sos, order, f_lo, fs);
+	return n + sharaku_butterworth_lowpass(sos + n, order, f_hi, fs);
+}
+
+//-----------------------------------------------------------------------------
+// S段のbiquadを縦続接続したIIRフィルタ(転置型直接形II)
+//  各段の演算
+//   y  = b0 * x + z1
+//   z1 = (b1 * x + z2) - a1 * y
+//   z2 = b2 * x - a2 * y
+//  z1の更新は帰還(a1 * y)を最後に加算し、サンプル間の依存経路を短くする。
+//  初期状態は全段素通しである。
+template <size_t S>
+class biquad_filter
+{
+ public:
+	biquad_filter() {
+		for (size_t s = 0; s < S; s++) {
+			_c[s] = biquad_coef::identity();
+		}
+		clear();
+	}
+	explicit biquad_filter(const biquad_coef *sos) {
+		set(sos);
+		clear();
+	}
+	void clear(void) {
+		for (size_t s = 0; s < S; s++) {
+			_z1[s] = 0.0f;
+			_z2[s] = 0.0f;
+		}
+		_y = 0.0f;
+	}
+	// S個の係数を設定する
+	void set(const biquad_coef *sos) {
+		for (size_t s = 0; s < S; s++) {
+			_c[s] = sos[s];
+		}
+	}
+	void set(size_t s, const biquad_coef& coef) {
+		_c[s] = coef;
+	}
+
+	// 1サンプルを入力し、出力を返す
+	float operator+(float x) {
+		_y = _update(x);
+		return _y;
+	}
+	biquad_filter& operator+=(float x) {
+		_y = _update(x);
+		return *this;
+	}
+	operator float() {
+		return _y;
+	}
+
+	// nサンプル分をまとめて入力する(outはinと同一でもよい)
+	//  係数と状態をローカル変数へ写してから処理し、outへの書き込みと
+	//  状態の読み書きが別名参照とならないようにする。
+	void process(const float *in, float *out, size_t n) {
+		biquad_coef c[S];
+		float z1[S], z2[S];
+		for (size_t s = 0; s < S; s++) {
+			c[s] = _c[s]; z1[s] = _z1[s]; z2[s] = _z2[s];
+		}
+		for (size_t i = 0; i < n; i++) {
+			float x = in[i];
+			for (size_t s = 0; s < S; s++) {
+				const float y = c[s].b0 * x + z1[s];
+				z1[s] = (c[s].b1 * x + z2[s]) - c[s].a1 * y;
+				z2[s] = c[s].b2 * x - c[s].a2 * y;
+				x = y;
+			}
+			out[i] = x;
+		}
+		for (size_t s = 0; s < S; s++) {
+			_z1[s] = z1[s]; _z2[s] = z2[s];
+		}
+		if (n) {
+			_y = out[n - 1];
+		}
+	}
+
+ public:
+	size_t sections(void) { return S; }
+	const biquad_coef& get(size_t s) { return _c[s]; }
+
+ private:
+	float _update(float x) {
+		for (size_t s = 0; s < S; s++) {
+			const biquad_coef& c = _c[s];
+			const float y = c.b0 * x + _z1[s];
+			_z1[s] = (c.b1 * x + _z2[s]) - c.a1 * y;
+			_z2[s] = c.b2 * x - c.a2 * y;
+			x = y;
+		}
+		return x;
+	}
+
+ protected:
+	biquad_coef	_c[S];
+	float		_z1[S];
+	float		_z2[S];
+	float		_y;	// 最新の出力
+};
+
+//-----------------------------------------------------------------------------
+// Nチャネル分のbiquad縦続接続フィルタをまとめて処理するバンク
+//  係数と状態を段ごとにチャネル順に連続して保持し、1フレーム(N
+//  チャネル分のサンプル)をチャネル方向のSIMD演算で処理する。
+//  各チャネルの演算はbiquad_filter<S>と同一の結果となる。
+//  (積和をFMAへ縮約しない-ffp-contract=offのビルドの場合。縮約する場合は
+//  丸め誤差の範囲で異なる)
+template <size_t N, size_t S>
+class biquad_filter_bank
+{
+ public:
+	biquad_filter_bank() {
+		set(biquad_coef::identity());
+		clear();
+	}
+	explicit biquad_filter_bank(const biquad_coef *sos) {
+		set(sos);
+		clear();
+	}
+	void clear(void) {
+		for (size_t s = 0; s < S; s++) {
+			for (size_t i = 0; i < N; i++) {
+				_z1[s][i] = 0.0f;
+				_z2[s][i] = 0.0f;
+			}
+		}
+		for (size_t i = 0; i < N; i++) {
+			_y[i] = 0.0f;
+		}
+	}
+	// 全チャネルに同一のS個の係数を設定する
+	void set(const biquad_coef *sos) {
+		for (size_t ch = 0; ch < N; ch++) {
+			set(ch, sos);
+		}
+	}
+	// 全チャネル・全段に同一の係数を設定する
+	void set(const biquad_coef& coef) {
+		for (size_t ch = 0; ch < N; ch++) {
+			for (size_t s = 0; s < S; s++) {
+				set(ch, s, coef);
+			}
+		}
+	}
+	// chチャネルにS個の係数を設定する
+	void set(size_t ch, const biquad_coef *sos) {
+		for (size_t s = 0; s < S; s++) {
+			set(ch, s, sos[s]);
+		}
+	}
+	void set(size_t ch, size_t s, const biquad_coef& coef) {
+		_b0[s][ch] = coef.b0;
+		_b1[s][ch] = coef.b1;
+		_b2[s][ch] = coef.b2;
+		_a1[s][ch] = coef.a1;
+		_a2[s][ch] = coef.a2;
+	}
+
+	// 1フレーム(N要素)を入力する
+	biquad_filter_bank& operator+=(const float *frame) {
+		_update(frame, _y);
+		return *this;
+	}
+
+	// framesフレーム分をまとめて入力する
+	//  in/outはフレーム順にNチャネルずつ並べたframes * N要素の配列。
+	//  outには各フレーム入力後の出力を書き出す(nullptrの場合は書き出さない)
+	void process(const float *in, float *out, size_t frames) {
+		for (size_t m = 0; m < frames; m++) {
+			_update(in + m * N, _y);
+			if (out) {
+				for (size_t i = 0; i < N; i++) {
+					out[m * N + i] = _y[i];
+				}
+			}
+		}
+	}
+
+	float operator[](size_t ch) const {
+		return _y[ch];
+	}
+
+ public:
+	size_t size(void) { return N; }
+	size_t sections(void) { return S; }
+
+ private:
+	void _update(const float *in, float *out) {
+		typedef sharaku_simd	V;
+		const size_t W = V::width;
+		size_t i = 0;
+		for (; i + W <= N; i += W) {
+			V::f32 x = V::load(in + i);
+			for (size_t s = 0; s < S; s++) {
+				const V::f32 y = V::add(V::mul(V::load(_b0[s] + i), x),
+							  V::load(_z1[s] + i));
+				V::store(_z1[s] + i,
+					  V::sub(V::add(V::mul(V::load(_b1[s] + i), x),
+							V::load(_z2[s] + i)),
+						 V::mul(V::load(_a1[s] + i), y)));
+				V::store(_z2[s] + i,
+					  V::sub(V::mul(V::load(_b2[s] + i), x),
+						  V::mul(V::load(_a2[s] + i), y)));
+				x = y;
+			}
+			V::store(out + i, x);
+		}
+		if constexpr (N % W) {
+			for (; i < N; i++) {
+				float x = in[i];
+				for (size_t s = 0; s < S; s++) {
+					const float y = _b0[s][i] * x + _z1[s][i];
+					_z1[s][i] = (_b1[s][i] * x + _z2[s][i]) - _a1[s][i] * y;
+					_z2[s][i] = _b2[s][i] * x - _a2[s][i] * y;
+					x = y;
+				}
+				out[i] = x;
+			}
+		}
+	}
+
+ protected:
+	alignas(SHARAKU_SIMD_ALIGN) float	_b0[S][N];
+	alignas(SHARAKU_SIMD_ALIGN) float	_b1[S][N];
+	alignas(SHARAKU_SIMD_ALIGN) float	_b2[S][N];
+	alignas(SHARAKU_SIMD_ALIGN) float	_a1[S][N];
+	alignas(SHARAKU_SIMD_ALIGN) float	_a2[S][N];
+	alignas(SHARAKU_SIMD_ALIGN) float	_z1[S][N];
+	alignas(SHARAKU_SIMD_ALIGN) float	_z2[S][N];
+	alignas(SHARAKU_SIMD_ALIGN) float	_y[N];	// 最新の出力
+};
+
+//-----------------------------------------------------------------------------
+// FIRフィルタの設計(窓関数法、Hamming窓)
+//  hにはtaps個の係数を書き出す。係数は中心に対して対称(直線位相)となり、
+//  群遅延は(taps - 1) / 2サンプルである。
+//  fc, f_lo, f_hiは遮断周波数、fsはサンプリング周波数(同一単位)。
+
+// Hamming窓を掛けた理想フィルタのk番目の係数
+//  理想フィルタは通過域[wl, wh](正規化角周波数)の帯域通過とする
+static inline double
+sharaku_fir_windowed_sinc(size_t k, size_t taps, double wl, double wh)
+{
+	const double pi = 3.14159265358979323846;
+	const double t = (double)k - (double)(taps - 1) / 2.0;
+	const double sinc = (t == 0.0) ? (wh - wl) / pi :
+			    (sin(wh * t) - sin(wl * t)) / (pi * t);
+	const double w = (taps > 1) ? 0.54 - 0.46 * cos(2.0 * pi * k / (taps - 1)) : 1.0;
+	return sinc * w;
+}
+
+// ローパス(直流ゲイン1に正規化する)
+static inline void
+sharaku_fir_lowpass(float *h, size_t taps, double fc, double fs)
+{
+	const double wc = 2.0 * 3.14159265358979323846 * fc / fs;
+	double sum = 0.0;
+	for (size_t k = 0; k < taps; k++) {
+		sum += sharaku_fir_windowed_sinc(k, taps, 0.0, wc);
+	}
+	for (size_t k = 0; k < taps; k++) {
+		h[k] = (float)(sharaku_fir_windowed_sinc(k, taps, 0.0, wc) / sum);
+	}
+}
+
+// バンドパス(f_lo～f_hiを通過域とし、中心周波数でのゲイン1に正規化する)
+static inline void
+sharaku_fir_bandpass(float *h, size_t taps, double f_lo, double f_hi, double fs)
+{
+	const double wl = 2.0 * 3.14159265358979323846 * f_lo / fs;
+	const double wh = 2.0 * 3.14159265358979323846 * f_hi / fs;
+	const double w0 = (wl + wh) / 2.0;
+	double re = 0.0, im = 0.0;
+	for (size_t k = 0; k < taps; k++) {
+		const double v = sharaku_fir_windowed_sinc(k, taps, wl, wh);
+		re += v * cos(w0 * k);
+		im += v * sin(w0 * k);
+	}
+	const double gain = sqrt(re * re + im * im);
+	for (size_t k = 0; k < taps; k++) {
+		h[k] = (float)(sharaku_fir_windowed_sinc(k, taps, wl, wh) / gain);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// T次(タップ数T)のFIRフィルタ
+//  y[n] = Σ h[k] * x[n - k] (k = 0～T-1)
+//  入力履歴は長さ2Tのバッファに同じサンプルを2箇所(pos, pos + T)書き込む
+//  二重書き込み方式で保持し、直近Tサンプルが常に連続した領域となるように
+//  する。これにより畳み込みの内側ループに剰余演算が不要となり、
+//  sharaku_simd_dot(積和SIMD演算)で一括して計算できる。
+//  係数はバッファの並び(古い順)に合わせて逆順に保持する。
+//  初期状態は素通し(h[0] = 1)である。
+template <size_t T>
+class fir_filter
+{
+ public:
+	fir_filter() {
+		for (size_t k = 0; k < T; k++) {
+			_hr[k] = 0.0f;
+		}
+		_hr[T - 1] = 1.0f;
+		clear();
+	}
+	explicit fir_filter(const float *h) {
+		set(h);
+		clear();
+	}
+	void clear(void) {
+		for (size_t i = 0; i < T * 2; i++) {
+			_buf[i] = 0.0f;
+		}
+		_pos = 0;
+		_y = 0.0f;
+	}
+	// T個の係数h[0]～h[T-1]を設定する
+	void set(const float *h) {
+		for (size_t k = 0; k < T; k++) {
+			_hr[T - 1 - k] = h[k];
+		}
+	}
+
+	// 1サンプルを入力し、出力を返す
+	float operator+(float x) {
+		_y = _update(x);
+		return _y;
+	}
+	fir_filter& operator+=(float x) {
+		_y = _update(x);
+		return *this;
+	}
+	operator float() {
+		return _y;
+	}
+
+	// nサンプル分をまとめて入力する(outはinと同一でもよい)
+	void process(const float *in, float *out, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			out[i] = _update(in[i]);
+		}
+		if (n) {
+			_y = out[n - 1];
+		}
+	}
+
+ public:
+	size_t taps(void) { return T; }
+	float get(size_t k) { return _hr[T - 1 - k]; }
+
+ private:
+	float _update(float x) {
+		// 直近T-1サンプルとの積和に最新サンプルの項を加える
+		// (書き込み直後のサンプルをベクトル読み出ししない)
+		const float *w = _buf + _pos + 1;
+		const float y = sharaku_simd_dot(_hr, w, T - 1) + _hr[T - 1] * x;
+		_buf[_pos] = x;
+		_buf[_pos + T] = x;
+		_pos = (_pos + 1 == T) ? 0 : _pos + 1;
+		return y;
+	}
+
+ protected:
+	alignas(SHARAKU_SIMD_ALIGN) float	_hr[T];		// 逆順の係数
+	alignas(SHARAKU_SIMD_ALIGN) float	_buf[T * 2];	// 入力履歴(二重書き込み)
+	size_t					_pos;		// 最古のサンプルの位置
+	float					_y;		// 最新の出力
+};
+
+//-----------------------------------------------------------------------------
+// 窓幅Wの移動平均フィルタ
+//  直近Wサンプルの総和を入出力の差分で更新し、1サンプル当たりO(1)で
+//  計算する。差分更新による丸め誤差の蓄積を防ぐため、履歴の先頭へ
+//  戻るたび(Wサンプルごと)に総和を履歴から計算し直す。
+//  入力数がW未満の間は入力済みのサンプルの平均を出力する。
+template <size_t W>
+class moving_average
+{
+ public:
+	moving_average() {
+		clear();
+	}
+	void clear(void) {
+		for (size_t i = 0; i < W; i++) {
+			_buf[i] = 0.0f;
+		}
+		_pos = 0;
+		_count = 0;
+		_sum = 0.0f;
+		_inv = 1.0f;
+		_y = 0.0f;
+	}
+
+	// 1サンプルを入力し、出力を返す
+	float operator+(float x) {
+		_y = _update(x);
+		return _y;
+	}
+	moving_average& operator+=(float x) {
+		_y = _update(x);
+		return *this;
+	}
+	operator float() {
+		return _y;
+	}
+
+	// nサンプル分をまとめて入力する(outはinと同一でもよい)
+	void process(const float *in, float *out, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			out[i] = _update(in[i]);
+		}
+		if (n) {
+			_y = out[n - 1];
+		}
+	}
+
+ public:
+	size_t window(void) { return W; }
+	size_t count(void) { return _count; }
+
+ private:
+	float _update(float x) {
+		_sum += x - _buf[_pos];
+		_buf[_pos] = x;
+		if (_count < W) {
+			_count++;
+			_inv = 1.0f / (float)_count;
+		}
+		if (++_pos == W) {
+			// 丸め誤差の補正
+			_pos = 0;
+			float sum = 0.0f;
+			for (size_t i = 0; i < W; i++) {
+				sum += _buf[i];
+			}
+			_sum = sum;
+		}
+		return _sum * _inv;
+	}
+
+ protected:
+	float	_buf[W];	// 入力履歴
+	size_t	_pos;		// 次に書き込む位置(最古のサンプル)
+	size_t	_count;		// 入力済みのサンプル数(最大W)
+	float	_sum;		// 履歴の総和
+	float	_inv;		// 1 / _count
+	float	_y;		// 最新の出力
+};
+
+//-----------------------------------------------------------------------------
+// 窓幅Wのメディアンフィルタ
+//  直近Wサンプルを、下半分の最大ヒープと上半分の最小ヒープに分けて保持
+//  する(下半分の要素数は上半分と等しいか1多い)。最古のサンプルの値を
+//  新しいサンプルで置き換えてヒープ内で移動させ、必要であれば2つの
+//  ヒープの先頭を交換する。1サンプル当たりO(log W)で更新でき、中央値は
+//  ヒープの先頭からO(1)で得られる。
+//  要素数が偶数の場合は中央の2サンプルの平均を出力する。
+//  入力数がW未満の間は入力済みのサンプルの中央値を出力する。
+template <size_t W>
+class median_filter
+{
+ public:
+	median_filter() {
+		clear();
+	}
+	void clear(void) {
+		_pos = 0;
+		_nlo = 0;
+		_nhi = 0;
+		_y = 0.0f;
+	}
+
+	// 1サンプルを入力し、出力を返す
+	float operator+(float x) {
+		_y = _update(x);
+		return _y;
+	}
+	median_filter& operator+=(float x) {
+		_y = _update(x);
+		return *this;
+	}
+	operator float() {
+		return _y;
+	}
+
+	// nサンプル分をまとめて入力する(outはinと同一でもよい)
+	void process(const float *in, float *out, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			out[i] = _update(in[i]);
+		}
+		if (n) {
+			_y = out[n - 1];
+		}
+	}
+
+ public:
+	size_t window(void) { return W; }
+	size_t count(void) { return _nlo + _nhi; }
+
+ private:
+	// ヒープh(MAX: 最大ヒープ)のi番目にスロットsを置く
+	template <bool MAX>
+	void _place(int32_t *h, size_t i, int32_t s) {
+		h[i] = s;
+		_where[s] = MAX ? (int32_t)i : ~(int32_t)i;
+	}
+	// ヒープの並びでaをbより先頭側に置くか
+	template <bool MAX>
+	bool _before(int32_t a, int32_t b) {
+		return MAX ? (_val[a] > _val[b]) : (_val[a] < _val[b]);
+	}
+	template <bool MAX>
+	void _sift_up(int32_t *h, size_t i) {
+		const int32_t s = h[i];
+		while (i > 0) {
+			const size_t p = (i - 1) / 2;
+			if (!_before<MAX>(s, h[p])) {
+				break;
+			}
+			_place<MAX>(h, i, h[p]);
+			i = p;
+		}
+		_place<MAX>(h, i, s);
+	}
+	template <bool MAX>
+	void _sift_down(int32_t *h, size_t n, size_t i) {
+		const int32_t s = h[i];
+		for (;;) {
+			size_t c = i * 2 + 1;
+			if (c >= n) {
+				break;
+			}
+			if (c + 1 < n && _before<MAX>(h[c + 1], h[c])) {
+				c++;
+			}
+			if (!_before<MAX>(h[c], s)) {
+				break;
+			}
+			_place<MAX>(h, i, h[c]);
+			i = c;
+		}
+		_place<MAX>(h, i, s);
+	}
+
+	float _update(float x) {
+		const int32_t s = (int32_t)_pos;
+		_val[s] = x;
+		if (_nlo + _nhi < W) {
+			// 窓が埋まるまでは要素数の少ない側へ追加する
+			if (_nlo == _nhi) {
+				_place<true>(_lo, _nlo, s);
+				_sift_up<true>(_lo, _nlo++);
+			} else {
+				_place<false>(_hi, _nhi, s);
+				_sift_up<false>(_hi, _nhi++);
+			}
+		} else if (_where[s] >= 0) {
+			// 最古のサンプルのあった位置で値を置き換える
+			const size_t i = (size_t)_where[s];
+			_sift_up<true>(_lo, i);
+			_sift_down<true>(_lo, _nlo, (size_t)_where[s]);
+		} else {
+			const size_t i = (size_t)~_where[s];
+			_sift_up<false>(_hi, i);
+			_sift_down<false>(_hi, _nhi, (size_t)~_where[s]);
+		}
+		// 下半分の最大値が上半分の最小値を超えた場合は先頭を交換する
+		if (_nhi && _val[_lo[0]] > _val[_hi[0]]) {
+			const int32_t l = _lo[0];
+			const int32_t r = _hi[0];
+			_place<true>(_lo, 0, r);
+			_place<false>(_hi, 0, l);
+			_sift_down<true>(_lo, _nlo, 0);
+			_sift_down<false>(_hi, _nhi, 0);
+		}
+		_pos = (_pos + 1 == W) ? 0 : _pos + 1;
+
+		if (_nlo > _nhi) {
+			return _val[_lo[0]];
+		}
+		return (_val[_lo[0]] + _val[_hi[0]]) * 0.5f;
+	}
+
+ protected:
+	float	_val[W];		// スロットごとのサンプル値
+	int32_t	_where[W];		// スロットのヒープ内の位置(下半分: i, 上半分: ~i)
+	int32_t	_lo[(W + 1) / 2];	// 下半分(最大ヒープ)のスロット番号
+	int32_t	_hi[W / 2 + 1];		// 上半分(最小ヒープ)のスロット番号
+	size_t	_pos;			// 次に書き込むスロット(最古のサンプル)
+	size_t	_nlo;			// 下半分の要素数
+	size_t	_nhi;			// 上半分の要素数
+	float	_y;			// 最新の出力
 };
 
 
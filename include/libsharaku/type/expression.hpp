@@ -0,0 +1,281 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_MM_EXPRESSION_H_
+#define SHARAKU_MM_EXPRESSION_H_
+
+#include <stddef.h>
+#include <assert.h>
+#include <type_traits>
+#include <libsharaku/type/simd.hpp>
+#include <libsharaku/type/vector-soa.hpp>
+
+//-----------------------------------------------------------------------------
+// 要素ごとの演算の遅延評価(式テンプレート)
+//  vector3_soa同士、またはvector3/position3/rotation3の配列同士の
+//  a + b - c + d * s のような式を、演算子の呼び出し時には評価せずに
+//  式の木として保持し、sharaku_eval()で1回のSIMDループにまとめて評価する。
+//  演算ごとに結果の配列を書き出して読み直すことがないため、
+//  k項の式のメモリ転送量は(k + 1)配列分となる
+//  (1演算ずつ評価した場合は3(k - 1)配列分)。
+//
+//  オペランドは全てfloatの連続領域として扱う。
+//  - vector3_soa: x, y, zレーン(余白を含む)を1つの配列とみなす
+//  - 配列(sharaku_expr()で指定): x0, y0, z0, x1, ...を1つの配列とみなす
+//  要素ごとの加減算とスカラ倍はどちらの並びでも同じ結果となるが、
+//  並びの異なるオペランドは混在できない(コンパイルエラーとなる)。
+//  単一のvector3等の演算子はインライン展開されてレジスタ上で完結するため、
+//  式テンプレートの対象は配列とする。
+
+// オペランドの並び
+struct sharaku_expr_soa {};
+struct sharaku_expr_aos {};
+
+// 葉: floatの連続領域
+template <class L>
+struct sharaku_expr_leaf {
+	typedef L layout;
+	const float	*p;
+	size_t		n;	// float数
+
+	size_t size(void) const { return n; }
+	sharaku_simd::f32 load(size_t i) const { return sharaku_simd::load(p + i); }
+	float at(size_t i) const { return p[i]; }
+};
+
+// 二項演算(A, Bは同じ並び、同じ要素数。要素数はsharaku_expr_make()で確認する)
+struct sharaku_expr_add {
+	static sharaku_simd::f32 simd(sharaku_simd::f32 a, sharaku_simd::f32 b) { return sharaku_simd::add(a, b); }
+	static float scalar(float a, float b) { return a + b; }
+};
+struct sharaku_expr_sub {
+	static sharaku_simd::f32 simd(sharaku_simd::f32 a, sharaku_simd::f32 b) { return sharaku_simd::sub(a, b); }
+	static float scalar(float a, float b) { return a - b; }
+};
+
+template <class Op, class A, class B>
+struct sharaku_expr_binary {
+	static_assert(std::is_same<typename A::layout, typename B::layout>::value,
+		      "operands of an expression must have the same layout");
+	typedef typename A::layout layout;
+	A	a;
+	B	b;
+
+	size_t size(void) const { return a.size(); }
+	sharaku_simd::f32 load(size_t i) const { return Op::simd(a.load(i), b.load(i)); }
+	float at(size_t i) const { return Op::scalar(a.at(i), b.at(i)); }
+};
+
+// スカラ倍
+template <class A>
+struct sharaku_expr_scale {
+	typedef typename A::layout layout;
+	A	a;
+	float	s;
+
+	size_t size(void) const { return a.size(); }
+	sharaku_simd::f32 load(size_t i) const {
+		return sharaku_simd::mul(a.load(i), sharaku_simd::set1(s));
+	}
+	float at(size_t i) const { return a.at(i) * s; }
+};
+
+// 式のオペランドとなる型と、式の節への変換
+template <class T>
+struct sharaku_expr_traits {
+	enum { value = 0 };
+};
+template <class L>
+struct sharaku_expr_traits<sharaku_expr_leaf<L>> {
+	enum { value = 1 };
+	typedef sharaku_expr_leaf<L> node;
+	static const node& get(const node& e) { return e; }
+};
+template <class Op, class A, class B>
+struct sharaku_expr_traits<sharaku_expr_binary<Op, A, B>> {
+	enum { value = 1 };
+	typedef sharaku_expr_binary<Op, A, B> node;
+	static const node& get(const node& e) { return e; }
+};
+template <class A>
+struct sharaku_expr_traits<sharaku_expr_scale<A>> {
+	enum { value = 1 };
+	typedef sharaku_expr_scale<A> node;
+	static const node& get(const node& e) { return e; }
+};
+template <>
+struct sharaku_expr_traits<vector3_soa> {
+	enum { value = 1 };
+	typedef sharaku_expr_leaf<sharaku_expr_soa> node;
+	static node get(const vector3_soa& soa) {
+		// x, y, zレーンは連続しているため、レーン長 * 3を1つの配列とする
+		return node{soa.x(), sharaku_simd::round_up(soa.size()) * 3};
+	}
+};
+
+template <class A, class B>
+using sharaku_expr_enable = typename std::enable_if<
+	sharaku_expr_traits<A>::value && sharaku_expr_traits<B>::value>::type;
+
+/*********************************************************************/
+/*! @brief 配列を式のオペランドとする
+
+	@param[in]      p               vector3, position3, rotation3の配列
+	@param[in]      n               要素数
+	@return         式の葉
+	@exception      none
+**********************************************************************/
+template <class T>
+static inline sharaku_expr_leaf<sharaku_expr_aos>
+sharaku_expr(const T *p, size_t n)
+{
+	static_assert(std::is_same<decltype(p->x), float>::value &&
+		      sizeof(T) == sizeof(float) * 3 && offsetof(T, x) == 0,
+		      "operand must be a float x, y, z type");
+	// 空の配列(p = NULL)も扱えるよう、メンバを参照せずに変換する
+	return sharaku_expr_leaf<sharaku_expr_aos>{reinterpret_cast<const float *>(p), n * 3};
+}
+
+// 二項演算の節を作成する(オペランドの要素数が異なる場合はassertで停止する)
+template <class Op, class A, class B>
+static inline sharaku_expr_binary<Op, typename sharaku_expr_traits<A>::node,
+				  typename sharaku_expr_traits<B>::node>
+sharaku_expr_make(const A& a, const B& b)
+{
+	sharaku_expr_binary<Op, typename sharaku_expr_traits<A>::node,
+			    typename sharaku_expr_traits<B>::node>
+		r{sharaku_expr_traits<A>::get(a), sharaku_expr_traits<B>::get(b)};
+	assert(r.a.size() == r.b.size());
+	return r;
+}
+
+template <class A, class B, class = sharaku_expr_enable<A, B>>
+static inline sharaku_expr_binary<sharaku_expr_add,
+				  typename sharaku_expr_traits<A>::node,
+				  typename sharaku_expr_traits<B>::node>
+operator+(const A& a, const B& b)
+{
+	return sharaku_expr_make<sharaku_expr_add>(a, b);
+}
+
+template <class A, class B, class = sharaku_expr_enable<A, B>>
+static inline sharaku_expr_binary<sharaku_expr_sub,
+				  typename sharaku_expr_traits<A>::node,
+				  typename sharaku_expr_traits<B>::node>
+operator-(const A& a, const B& b)
+{
+	return sharaku_expr_make<sharaku_expr_sub>(a, b);
+}
+
+template <class A, class = sharaku_expr_enable<A, A>>
+static inline sharaku_expr_scale<typename sharaku_expr_traits<A>::node>
+operator*(const A& a, float s)
+{
+	return {sharaku_expr_traits<A>::get(a), s};
+}
+
+template <class A, class = sharaku_expr_enable<A, A>>
+static inline sharaku_expr_scale<typename sharaku_expr_traits<A>::node>
+operator*(float s, const A& a)
+{
+	return {sharaku_expr_traits<A>::get(a), s};
+}
+
+// 式をSIMD幅単位で評価してdstへ書き出し、書き出したfloat数を返す
+template <class E>
+static inline size_t
+sharaku_eval_simd(float *dst, const E& e, size_t n)
+{
+	const size_t W = sharaku_simd::width;
+	size_t i = 0;
+	for (; i + W <= n; i += W) {
+		sharaku_simd::store(dst + i, e.load(i));
+	}
+	return i;
+}
+
+/*********************************************************************/
+/*! @brief 式を評価してvector3_soaへ書き出す
+
+	dstは式のオペランドと同じ要素数とする。要素ごとに読み込んでから
+	書き出すため、dst自身をオペランドに含めてもよい。
+
+	@param[out]     dst             書き出し先
+	@param[in]      e               vector3_soaをオペランドとする式
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         none
+	@exception      none
+**********************************************************************/
+template <class E>
+static inline void
+sharaku_eval(vector3_soa& dst, const E& e)
+{
+	typedef typename sharaku_expr_traits<E>::node node;
+	static_assert(std::is_same<typename node::layout, sharaku_expr_soa>::value,
+		      "expression must consist of vector3_soa");
+	// レーン長はSIMD幅の倍数であるため端数は生じない
+	const node& ex = sharaku_expr_traits<E>::get(e);
+	assert(ex.size() == sharaku_simd::round_up(dst.size()) * 3);
+	sharaku_eval_simd(dst.x(), ex, ex.size());
+}
+
+/*********************************************************************/
+/*! @brief 式を評価して配列へ書き出す
+
+	dstはオペランドの要素数分の領域を持つこと。dst自身をオペランドに
+	含めてもよい(例: sharaku_eval(p, sharaku_expr(p, n) + sharaku_expr(v, n) * dt))。
+
+	@param[out]     dst             書き出し先(vector3, position3, rotation3の配列)
+	@param[in]      e               sharaku_expr()をオペランドとする式
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         none
+	@exception      none
+**********************************************************************/
+template <class T, class E>
+static inline void
+sharaku_eval(T *dst, const E& e)
+{
+	typedef typename sharaku_expr_traits<E>::node node;
+	static_assert(std::is_same<typename node::layout, sharaku_expr_aos>::value,
+		      "expression must consist of arrays");
+	static_assert(std::is_same<decltype(dst->x), float>::value &&
+		      sizeof(T) == sizeof(float) * 3 && offsetof(T, x) == 0,
+		      "destination must be a float x, y, z type");
+	const node& ex = sharaku_expr_traits<E>::get(e);
+	float *p = reinterpret_cast<float *>(dst);
+	for (size_t i = sharaku_eval_simd(p, ex, ex.size()); i < ex.size(); i++) {
+		p[i] = ex.at(i);
+	}
+}
+
+
+#endif // SHARAKU_MM_EXPRESSION_H_
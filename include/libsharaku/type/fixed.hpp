@@ -0,0 +1,131 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_MM_FIXED_H_
+#define SHARAKU_MM_FIXED_H_
+
+#include <stdint.h>
+#include <limits>
+#include <type_traits>
+
+/* ========================================================================= */
+/* struct definition Section                                                 */
+/* ========================================================================= */
+
+/*! @class q16_16
+    @brief  Q16.16形式の固定小数点数
+
+	整数部16bit(符号含む)、小数部16bitの32bit整数として値を保持し、
+	四則演算を整数演算のみで行う(FPUのない環境向け)。
+	表現範囲は-32768～32767.99998、分解能は1/65536である。
+	乗除算の中間値は64bitで計算し、結果は0方向へ切り捨てる。
+	加減算および結果が表現範囲を超える場合の動作は2の補数の
+	ラップアラウンドとなる。
+	float/doubleからの変換はコンパイル時定数の生成を想定しており、
+	実行時に使用するとFPU(またはソフトウェア浮動小数点)を使用する。
+*/
+struct q16_16 {
+ public:
+	int32_t raw; ///< 値 * 65536
+
+ public:
+	q16_16() = default;
+	constexpr q16_16(int32_t v) : raw((int32_t)((uint32_t)v << 16)) {}
+	constexpr q16_16(float v) : raw((int32_t)(v * 65536.0f + ((v < 0.0f) ? -0.5f : 0.5f))) {}
+	constexpr q16_16(double v) : raw((int32_t)(v * 65536.0 + ((v < 0.0) ? -0.5 : 0.5))) {}
+
+	// 内部表現から構築する
+	static constexpr q16_16 from_raw(int32_t r) {
+		q16_16 q(0);
+		q.raw = r;
+		return q;
+	}
+	// 64bitの内部表現から、表現範囲に飽和させて構築する
+	static constexpr q16_16 from_raw_sat(int64_t r) {
+		r = (r > INT32_MAX) ? INT32_MAX : r;
+		r = (r < INT32_MIN) ? INT32_MIN : r;
+		return from_raw((int32_t)r);
+	}
+
+	constexpr explicit operator float() const { return (float)raw * (1.0f / 65536.0f); }
+	constexpr explicit operator double() const { return (double)raw * (1.0 / 65536.0); }
+	// 整数部(負の無限大方向へ丸める)
+	constexpr explicit operator int32_t() const { return raw >> 16; }
+
+	constexpr q16_16& operator+=(const q16_16& q) {
+		raw = (int32_t)((uint32_t)raw + (uint32_t)q.raw);
+		return (*this);
+	}
+	constexpr q16_16& operator-=(const q16_16& q) {
+		raw = (int32_t)((uint32_t)raw - (uint32_t)q.raw);
+		return (*this);
+	}
+	constexpr q16_16& operator*=(const q16_16& q) {
+		raw = (int32_t)(((int64_t)raw * q.raw) / 65536);
+		return (*this);
+	}
+	constexpr q16_16& operator/=(const q16_16& q) {
+		raw = (int32_t)(((int64_t)raw * 65536) / q.raw);
+		return (*this);
+	}
+};
+
+constexpr q16_16 operator+(q16_16 lhs, const q16_16& rhs) { return lhs += rhs; }
+constexpr q16_16 operator-(q16_16 lhs, const q16_16& rhs) { return lhs -= rhs; }
+constexpr q16_16 operator*(q16_16 lhs, const q16_16& rhs) { return lhs *= rhs; }
+constexpr q16_16 operator/(q16_16 lhs, const q16_16& rhs) { return lhs /= rhs; }
+constexpr q16_16 operator-(const q16_16& q) { return q16_16::from_raw((int32_t)(0u - (uint32_t)q.raw)); }
+
+constexpr bool operator==(const q16_16& lhs, const q16_16& rhs) { return lhs.raw == rhs.raw; }
+constexpr bool operator!=(const q16_16& lhs, const q16_16& rhs) { return lhs.raw != rhs.raw; }
+constexpr bool operator<(const q16_16& lhs, const q16_16& rhs) { return lhs.raw < rhs.raw; }
+constexpr bool operator<=(const q16_16& lhs, const q16_16& rhs) { return lhs.raw <= rhs.raw; }
+constexpr bool operator>(const q16_16& lhs, const q16_16& rhs) { return lhs.raw > rhs.raw; }
+constexpr bool operator>=(const q16_16& lhs, const q16_16& rhs) { return lhs.raw >= rhs.raw; }
+
+// q16_16の表現範囲(無限大は持たない)
+namespace std {
+template <>
+class numeric_limits<q16_16> {
+ public:
+	static constexpr bool is_specialized = true;
+	static constexpr bool is_signed = true;
+	static constexpr bool is_integer = false;
+	static constexpr bool is_exact = true;
+	static constexpr bool has_infinity = false;
+	static constexpr q16_16 min() noexcept { return q16_16::from_raw(1); }
+	static constexpr q16_16 max() noexcept { return q16_16::from_raw(INT32_MAX); }
+	static constexpr q16_16 lowest() noexcept { return q16_16::from_raw(INT32_MIN); }
+	static constexpr q16_16 epsilon() noexcept { return q16_16::from_raw(1); }
+	static constexpr q16_16 infinity() noexcept { return q16_16::from_raw(0); }
+};
+}
+
+static_assert(std::is_trivially_copyable<q16_16>::value, "q16_16 must be trivially copyable");
+static_assert(sizeof(q16_16) == 4, "q16_16 must be 4 bytes");
+
+
+#endif // SHARAKU_MM_FIXED_H_
@@ -0,0 +1,332 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_MM_GEOMETRY_H_
+#define SHARAKU_MM_GEOMETRY_H_
+
+#include <stddef.h>
+#include <float.h>
+#include <math.h>
+#include <cmath>
+#include <libsharaku/type/simd.hpp>
+#include <libsharaku/type/vector.hpp>
+#include <libsharaku/type/position.hpp>
+
+//-----------------------------------------------------------------------------
+// 内積、外積、長さ、正規化、距離
+//  長さ、正規化、距離には正確な版(sqrt、除算)と高速版(_fast)がある。
+//  高速版は1/sqrtの近似命令の結果をニュートン法で1回補正したもので、
+//  相対誤差は3e-7程度(SHARAKU_SIMD_DISABLEの場合は正確な版と同じ)。
+//  sqrt、除算が低速なCPU向けであり、これらがパイプライン化された
+//  近年のx86では正確な版の方が速い場合がある(bench_geometryで確認すること)。
+//  長さ0のベクトルの正規化は0ベクトルとする。高速版は分岐を避けるため
+//  長さの2乗をFLT_MIN以上に切り上げて1/sqrtを求める(長さ1e-19未満の
+//  ベクトルは正しい長さ、向きとならない)。
+//  配列版(dst, 入力配列, n)はx, y, zをSIMDレーンへ展開してwidth要素ずつ処理し、
+//  端数は1要素版で処理する。dstは入力配列と同じ領域でもよい。
+
+// 1/sqrt(x)の近似値をニュートン法で1回補正する
+static inline sharaku_simd::f32
+sharaku_simd_rsqrt_nr(sharaku_simd::f32 x)
+{
+	const sharaku_simd::f32 y = sharaku_simd::rsqrt(x);
+	const sharaku_simd::f32 hx = sharaku_simd::mul(x, sharaku_simd::set1(0.5f));
+	const sharaku_simd::f32 yy = sharaku_simd::mul(y, y);
+	return sharaku_simd::mul(y, sharaku_simd::sub(sharaku_simd::set1(1.5f),
+						     sharaku_simd::mul(hx, yy)));
+}
+
+// 1/sqrt(x)(高速版、xはFLT_MIN以上に切り上げる)
+static inline float
+sharaku_rsqrt_fast(float x)
+{
+#if defined(SHARAKU_SIMD_AVX512) || defined(SHARAKU_SIMD_AVX2) || \
+    defined(SHARAKU_SIMD_SSE2)
+	const __m128 v = _mm_max_ss(_mm_set_ss(x), _mm_set_ss(FLT_MIN));
+	const __m128 y = _mm_rsqrt_ss(v);
+	const __m128 t = _mm_mul_ss(_mm_mul_ss(_mm_mul_ss(v, _mm_set_ss(0.5f)), y), y);
+	return _mm_cvtss_f32(_mm_mul_ss(y, _mm_sub_ss(_mm_set_ss(1.5f), t)));
+#else
+	return 1.0f / sqrtf((x > FLT_MIN) ? x : FLT_MIN);
+#endif
+}
+
+/* ========================================================================= */
+/* 1要素版                                                                   */
+/* ========================================================================= */
+
+template <class T>
+constexpr T
+sharaku_dot(const basic_vector3<T>& a, const basic_vector3<T>& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+template <class T>
+constexpr basic_vector3<T>
+sharaku_cross(const basic_vector3<T>& a, const basic_vector3<T>& b)
+{
+	return basic_vector3<T>{a.y * b.z - a.z * b.y,
+				a.z * b.x - a.x * b.z,
+				a.x * b.y - a.y * b.x};
+}
+
+// 長さの2乗
+template <class T>
+constexpr T
+sharaku_length2(const basic_vector3<T>& v)
+{
+	return sharaku_dot(v, v);
+}
+
+template <class T>
+static inline T
+sharaku_length(const basic_vector3<T>& v)
+{
+	return std::sqrt(sharaku_length2(v));
+}
+
+static inline float
+sharaku_length_fast(const vector3& v)
+{
+	const float l2 = sharaku_length2(v);
+	return l2 * sharaku_rsqrt_fast(l2);
+}
+
+/*********************************************************************/
+/*! @brief 長さ1のベクトルを求める
+
+	@param[in]      v               正規化するベクトル
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         vと同じ向きの長さ1のベクトル(vの長さが0の場合は0ベクトル)
+	@exception      none
+**********************************************************************/
+template <class T>
+static inline basic_vector3<T>
+sharaku_normalize(const basic_vector3<T>& v)
+{
+	const T l2 = sharaku_length2(v);
+	if (!(l2 > T(0))) {
+		return basic_vector3<T>{T(0), T(0), T(0)};
+	}
+	const T inv = T(1) / std::sqrt(l2);
+	return basic_vector3<T>{v.x * inv, v.y * inv, v.z * inv};
+}
+
+static inline vector3
+sharaku_normalize_fast(const vector3& v)
+{
+	const float l2 = sharaku_length2(v);
+	const float inv = sharaku_rsqrt_fast(l2);
+	return vector3{v.x * inv, v.y * inv, v.z * inv};
+}
+
+// 2点間の距離の2乗
+template <class T>
+constexpr T
+sharaku_distance2(const basic_position3<T>& a, const basic_position3<T>& b)
+{
+	return sharaku_length2(basic_vector3<T>{a.x - b.x, a.y - b.y, a.z - b.z});
+}
+
+template <class T>
+static inline T
+sharaku_distance(const basic_position3<T>& a, const basic_position3<T>& b)
+{
+	return std::sqrt(sharaku_distance2(a, b));
+}
+
+static inline float
+sharaku_distance_fast(const position3& a, const position3& b)
+{
+	const float d2 = sharaku_distance2(a, b);
+	return d2 * sharaku_rsqrt_fast(d2);
+}
+
+/* ========================================================================= */
+/* 配列版                                                                    */
+/* ========================================================================= */
+
+// dst[i] = sharaku_dot(a[i], b[i])
+static inline void
+sharaku_dot(float *dst, const vector3 *a, const vector3 *b, size_t n)
+{
+	typedef sharaku_simd S;
+	size_t i = 0;
+	for (; i + S::width <= n; i += S::width) {
+		S::f32 ax, ay, az, bx, by, bz;
+		S::load3(&a[i].x, ax, ay, az);
+		S::load3(&b[i].x, bx, by, bz);
+		S::store(dst + i, S::madd(az, bz, S::madd(ay, by, S::mul(ax, bx))));
+	}
+	for (; i < n; i++) {
+		dst[i] = sharaku_dot(a[i], b[i]);
+	}
+}
+
+// dst[i] = sharaku_cross(a[i], b[i])
+static inline void
+sharaku_cross(vector3 *dst, const vector3 *a, const vector3 *b, size_t n)
+{
+	typedef sharaku_simd S;
+	size_t i = 0;
+	for (; i + S::width <= n; i += S::width) {
+		S::f32 ax, ay, az, bx, by, bz;
+		S::load3(&a[i].x, ax, ay, az);
+		S::load3(&b[i].x, bx, by, bz);
+		S::store3(&dst[i].x, S::sub(S::mul(ay, bz), S::mul(az, by)),
+				     S::sub(S::mul(az, bx), S::mul(ax, bz)),
+				     S::sub(S::mul(ax, by), S::mul(ay, bx)));
+	}
+	for (; i < n; i++) {
+		dst[i] = sharaku_cross(a[i], b[i]);
+	}
+}
+
+// 長さの2乗(width要素分)
+static inline sharaku_simd::f32
+sharaku_simd_length2(sharaku_simd::f32 x, sharaku_simd::f32 y, sharaku_simd::f32 z)
+{
+	typedef sharaku_simd S;
+	return S::madd(z, z, S::madd(y, y, S::mul(x, x)));
+}
+
+// dst[i] = sharaku_length(a[i])
+static inline void
+sharaku_length(float *dst, const vector3 *a, size_t n)
+{
+	typedef sharaku_simd S;
+	size_t i = 0;
+	for (; i + S::width <= n; i += S::width) {
+		S::f32 x, y, z;
+		S::load3(&a[i].x, x, y, z);
+		S::store(dst + i, S::sqrt(sharaku_simd_length2(x, y, z)));
+	}
+	for (; i < n; i++) {
+		dst[i] = sharaku_length(a[i]);
+	}
+}
+
+// dst[i] = sharaku_length_fast(a[i])
+static inline void
+sharaku_length_fast(float *dst, const vector3 *a, size_t n)
+{
+	typedef sharaku_simd S;
+	const S::f32 tiny = S::set1(FLT_MIN);
+	size_t i = 0;
+	for (; i + S::width <= n; i += S::width) {
+		S::f32 x, y, z;
+		S::load3(&a[i].x, x, y, z);
+		const S::f32 l2 = sharaku_simd_length2(x, y, z);
+		S::store(dst + i, S::mul(l2, sharaku_simd_rsqrt_nr(S::max(l2, tiny))));
+	}
+	for (; i < n; i++) {
+		dst[i] = sharaku_length_fast(a[i]);
+	}
+}
+
+// dst[i] = sharaku_normalize(a[i])
+static inline void
+sharaku_normalize(vector3 *dst, const vector3 *a, size_t n)
+{
+	typedef sharaku_simd S;
+	const S::f32 zero = S::set1(0.0f);
+	const S::f32 one = S::set1(1.0f);
+	size_t i = 0;
+	for (; i + S::width <= n; i += S::width) {
+		S::f32 x, y, z;
+		S::load3(&a[i].x, x, y, z);
+		const S::f32 l2 = sharaku_simd_length2(x, y, z);
+		const S::f32 inv = S::selgt(l2, zero, S::div(one, S::sqrt(l2)), zero);
+		S::store3(&dst[i].x, S::mul(x, inv), S::mul(y, inv), S::mul(z, inv));
+	}
+	for (; i < n; i++) {
+		dst[i] = sharaku_normalize(a[i]);
+	}
+}
+
+// dst[i] = sharaku_normalize_fast(a[i])
+static inline void
+sharaku_normalize_fast(vector3 *dst, const vector3 *a, size_t n)
+{
+	typedef sharaku_simd S;
+	const S::f32 tiny = S::set1(FLT_MIN);
+	size_t i = 0;
+	for (; i + S::width <= n; i += S::width) {
+		S::f32 x, y, z;
+		S::load3(&a[i].x, x, y, z);
+		const S::f32 l2 = sharaku_simd_length2(x, y, z);
+		const S::f32 inv = sharaku_simd_rsqrt_nr(S::max(l2, tiny));
+		S::store3(&dst[i].x, S::mul(x, inv), S::mul(y, inv), S::mul(z, inv));
+	}
+	for (; i < n; i++) {
+		dst[i] = sharaku_normalize_fast(a[i]);
+	}
+}
+
+// dst[i] = sharaku_distance(a[i], b[i])
+static inline void
+sharaku_distance(float *dst, const position3 *a, const position3 *b, size_t n)
+{
+	typedef sharaku_simd S;
+	size_t i = 0;
+	for (; i + S::width <= n; i += S::width) {
+		S::f32 ax, ay, az, bx, by, bz;
+		S::load3(&a[i].x, ax, ay, az);
+		S::load3(&b[i].x, bx, by, bz);
+		S::store(dst + i, S::sqrt(sharaku_simd_length2(S::sub(ax, bx), S::sub(ay, by),
+							       S::sub(az, bz))));
+	}
+	for (; i < n; i++) {
+		dst[i] = sharaku_distance(a[i], b[i]);
+	}
+}
+
+// dst[i] = sharaku_distance_fast(a[i], b[i])
+static inline void
+sharaku_distance_fast(float *dst, const position3 *a, const position3 *b, size_t n)
+{
+	typedef sharaku_simd S;
+	const S::f32 tiny = S::set1(FLT_MIN);
+	size_t i = 0;
+	for (; i + S::width <= n; i += S::width) {
+		S::f32 ax, ay, az, bx, by, bz;
+		S::load3(&a[i].x, ax, ay, az);
+		S::load3(&b[i].x, bx, by, bz);
+		const S::f32 d2 = sharaku_simd_length2(S::sub(ax, bx), S::sub(ay, by),
+						       S::sub(az, bz));
+		S::store(dst + i, S::mul(d2, sharaku_simd_rsqrt_nr(S::max(d2, tiny))));
+	}
+	for (; i < n; i++) {
+		dst[i] = sharaku_distance_fast(a[i], b[i]);
+	}
+}
+
+
+#endif // SHARAKU_MM_GEOMETRY_H_
@@ -0,0 +1,476 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_UV_KALMAN_H_
+#define SHARAKU_UV_KALMAN_H_
+
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <libsharaku/type/simd.hpp>
+#include <libsharaku/type/matrix.hpp>
+#include <libsharaku/type/vector.hpp>
+#include <libsharaku/type/position.hpp>
+#include <libsharaku/type/vector-soa.hpp>
+
+//-----------------------------------------------------------------------------
+// 3次元の等速(S = 2)・等加速度(S = 3)モデルのカルマンフィルタ
+//  各軸の状態を[位置, 速度(, 加速度)]のS次元ベクトルとし、
+//  最高次の微分(等速モデルでは加速度、等加速度モデルでは加加速度)を
+//  スペクトル密度qの白色雑音とする連続時間モデルを離散化して用いる。
+//  x, y, z軸は独立であり、遷移行列・雑音・観測行列が全軸で共通のため、
+//  共分散行列Pは3軸で1つ(S x S)を共有する。
+//  観測は位置・速度・加速度のいずれかを各軸ごとにスカラで行うため、
+//  更新に逆行列は不要である。
+template <size_t S>
+class kalman_filter
+{
+	static_assert(S >= 2, "kalman_filter requires position and velocity");
+
+ public:
+	explicit kalman_filter(float q = 1.0f) {
+		set_process_noise(q);
+		init(position3{0.0f, 0.0f, 0.0f}, vector3{0.0f, 0.0f, 0.0f}, 1.0f);
+	}
+
+	/*********************************************************************/
+	/*! @brief 状態を初期化する
+
+		@param[in]      pos             初期位置
+		@param[in]      vel             初期速度
+		@param[in]      p0              初期共分散(対角要素)
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         none
+		@exception      none
+	**********************************************************************/
+	void init(const position3& pos, const vector3& vel, float p0) {
+		memset(_x, 0, sizeof(_x));
+		_x[0][0] = pos.x; _x[1][0] = pos.y; _x[2][0] = pos.z;
+		_x[0][1] = vel.x; _x[1][1] = vel.y; _x[2][1] = vel.z;
+		_P = matrix<S, S>::identity(p0);
+	}
+	// 白色雑音のスペクトル密度を設定する
+	void set_process_noise(float q) {
+		_q = q;
+		_dt = NAN;
+	}
+
+	/*********************************************************************/
+	/*! @brief 時間をdtだけ進めた状態を予測する
+
+		遷移行列とプロセス雑音は前回と異なるdtの場合のみ計算し直す。
+
+		@param[in]      dt              経過時間
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         none
+		@exception      none
+	**********************************************************************/
+	void predict(float dt) {
+		if (!(dt == _dt)) {
+			_dt = dt;
+			_F = transition(dt);
+			_Q = process_noise(dt, _q);
+		}
+		const matrix<S, S> F = _F;
+		sharaku_unroll<3>([&](auto a) {
+			sharaku_unroll<S>([&](auto i) {
+				float v = _x[a][i];
+				sharaku_unroll<S - 1 - i>([&](auto k) {
+					v += F.m[i][i + 1 + k] * _x[a][i + 1 + k];
+				});
+				_x[a][i] = v;
+			});
+		});
+		// P = F * P * F^T + Q (Fは対角要素が1の上三角行列)
+		float t[S][S];
+		sharaku_unroll<S>([&](auto i) {
+			sharaku_unroll<S>([&](auto j) {
+				float v = _P.m[i][j];
+				sharaku_unroll<S - 1 - i>([&](auto k) {
+					v += F.m[i][i + 1 + k] * _P.m[i + 1 + k][j];
+				});
+				t[i][j] = v;
+			});
+		});
+		sharaku_unroll<S>([&](auto i) {
+			sharaku_unroll<S - i>([&](auto jj) {
+				constexpr size_t j = i + jj;
+				float v = t[i][j];
+				sharaku_unroll<S - 1 - j>([&](auto k) {
+					v += t[i][j + 1 + k] * F.m[j][j + 1 + k];
+				});
+				_P.m[i][j] = v + _Q.m[i][j];
+				_P.m[j][i] = _P.m[i][j];
+			});
+		});
+	}
+
+	// 加速度accを制御入力として時間をdtだけ進めた状態を予測する(等速モデル)
+	void predict(float dt, const vector3& acc) {
+		static_assert(S == 2, "control input is available for the constant-velocity model");
+		predict(dt);
+		const float h = 0.5f * dt * dt;
+		_x[0][0] += h * acc.x; _x[1][0] += h * acc.y; _x[2][0] += h * acc.z;
+		_x[0][1] += dt * acc.x; _x[1][1] += dt * acc.y; _x[2][1] += dt * acc.z;
+	}
+
+	// 位置・速度・加速度の観測値(観測雑音の分散r)で状態を更新する
+	void update_position(const position3& z, float r) {
+		_update<0>(z.x, z.y, z.z, r);
+	}
+	void update_velocity(const vector3& z, float r) {
+		_update<1>(z.x, z.y, z.z, r);
+	}
+	void update_acceleration(const vector3& z, float r) {
+		_update<2>(z.x, z.y, z.z, r);
+	}
+
+ public:
+	position3 position(void) const {
+		return position3{_x[0][0], _x[1][0], _x[2][0]};
+	}
+	vector3 velocity(void) const {
+		return vector3{_x[0][1], _x[1][1], _x[2][1]};
+	}
+	vector3 acceleration(void) const {
+		static_assert(S >= 3, "acceleration requires the constant-acceleration model");
+		return vector3{_x[0][2], _x[1][2], _x[2][2]};
+	}
+	// 共分散行列(3軸共通)
+	const matrix<S, S>& covariance(void) const { return _P; }
+	float get_q(void) const { return _q; }
+
+	/*********************************************************************/
+	/*! @brief 遷移行列を求める
+
+		F[i][j] = dt^(j - i) / (j - i)! (j >= i)
+
+		@param[in]      dt              経過時間
+		@return         遷移行列
+		@exception      none
+	**********************************************************************/
+	static matrix<S, S> transition(float dt) {
+		matrix<S, S> F = matrix<S, S>::zero();
+		for (size_t i = 0; i < S; i++) {
+			float c = 1.0f;
+			for (size_t j = i; j < S; j++) {
+				F.m[i][j] = c;
+				c = c * dt / (float)(j - i + 1);
+			}
+		}
+		return F;
+	}
+
+	/*********************************************************************/
+	/*! @brief プロセス雑音の共分散行列を求める
+
+		Q[i][j] = q * dt^n / ((S-1-i)! * (S-1-j)! * n)、n = 2S-1-i-j
+
+		@param[in]      dt              経過時間
+		@param[in]      q               白色雑音のスペクトル密度
+		@return         プロセス雑音の共分散行列
+		@exception      none
+	**********************************************************************/
+	static matrix<S, S> process_noise(float dt, float q) {
+		matrix<S, S> Q;
+		for (size_t i = 0; i < S; i++) {
+			for (size_t j = 0; j < S; j++) {
+				const size_t n = 2 * S - 1 - i - j;
+				float v = q / (float)n;
+				for (size_t k = 0; k < n; k++) {
+					v *= dt;
+				}
+				for (size_t k = 2; k < S - i; k++) {
+					v /= (float)k;
+				}
+				for (size_t k = 2; k < S - j; k++) {
+					v /= (float)k;
+				}
+				Q.m[i][j] = v;
+			}
+		}
+		return Q;
+	}
+
+ private:
+	// 上三角を下三角へ写し、丸め誤差による非対称を除く
+	static matrix<S, S> _symmetric(matrix<S, S> P) {
+		sharaku_unroll<S>([&](auto i) {
+			sharaku_unroll<i>([&](auto j) { P.m[i][j] = P.m[j][i]; });
+		});
+		return P;
+	}
+
+	// 状態のK番目の要素の観測(H = e_K)による更新
+	template <size_t K>
+	void _update(float zx, float zy, float zz, float r) {
+		static_assert(K < S, "observed element is out of the state");
+		const float inv = 1.0f / (_P.m[K][K] + r);
+		float k[S], pk[S];
+		sharaku_unroll<S>([&](auto i) {
+			pk[i] = _P.m[K][i];
+			k[i] = _P.m[i][K] * inv;
+		});
+		const float e[3] = {zx - _x[0][K], zy - _x[1][K], zz - _x[2][K]};
+		sharaku_unroll<3>([&](auto a) {
+			sharaku_unroll<S>([&](auto i) { _x[a][i] += k[i] * e[a]; });
+		});
+		sharaku_unroll<S>([&](auto i) {
+			sharaku_unroll<S>([&](auto j) { _P.m[i][j] -= k[i] * pk[j]; });
+		});
+		_P = _symmetric(_P);
+	}
+
+ protected:
+	float		_x[3][S];	// 各軸の状態[位置, 速度(, 加速度)]
+	matrix<S, S>	_P;		// 共分散行列(3軸共通)
+	float		_q;		// 白色雑音のスペクトル密度
+	float		_dt;		// _F, _Qを計算したdt
+	matrix<S, S>	_F;		// 遷移行列
+	matrix<S, S>	_Q;		// プロセス雑音の共分散行列
+};
+
+typedef kalman_filter<2>	kalman_cv;	// 等速モデル
+typedef kalman_filter<3>	kalman_ca;	// 等加速度モデル
+
+//-----------------------------------------------------------------------------
+// n個の独立した追跡対象(トラック)のkalman_filterをまとめて処理するバンク
+//  各トラックの状態と共分散行列の上三角要素、観測雑音の分散を要素ごとの
+//  レーン(SoA)に保持し、全トラックの予測・更新をSIMD演算で一括して行う。
+//  全トラックで経過時間dtとプロセス雑音qは共通とする。
+//  観測がないトラックは観測雑音の分散を無限大とすることで、
+//  分岐なしに更新から除外する(このとき観測値は有限値であること)。
+template <size_t S>
+class kalman_bank
+{
+	static_assert(S >= 2, "kalman_bank requires position and velocity");
+
+ public:
+	explicit kalman_bank(size_t n, float q = 1.0f) {
+		_n	= n;
+		_cap	= sharaku_simd::round_up(n);
+		// レーンの間隔をキャッシュラインの奇数倍とし、各レーンの同一位置が
+		// 同じキャッシュセット(4KBの倍数の間隔)に集中しないようにする
+		_stride	= _cap + ((_cap / 16) % 2 == 0 ? 16 : 0);
+		_buf	= (float *)sharaku_simd::alloc(sizeof(float) * _stride * _LANES);
+		memset(_buf, 0, sizeof(float) * _stride * _LANES);
+		for (size_t i = 0; i < _cap; i++) {
+			init(i, position3{0.0f, 0.0f, 0.0f}, vector3{0.0f, 0.0f, 0.0f}, 1.0f);
+			set_measurement_noise(i, 1.0f);
+		}
+		set_process_noise(q);
+	}
+	~kalman_bank() {
+		sharaku_simd::free(_buf);
+	}
+	kalman_bank(const kalman_bank&) = delete;
+	kalman_bank& operator=(const kalman_bank&) = delete;
+
+	// i番目のトラックを初期化する(kalman_filter::initと同じ)
+	void init(size_t i, const position3& pos, const vector3& vel, float p0) {
+		for (size_t k = 0; k < S; k++) {
+			_xl(0, k)[i] = 0.0f; _xl(1, k)[i] = 0.0f; _xl(2, k)[i] = 0.0f;
+			for (size_t l = k; l < S; l++) {
+				_Pl(k, l)[i] = (k == l) ? p0 : 0.0f;
+			}
+		}
+		_xl(0, 0)[i] = pos.x; _xl(1, 0)[i] = pos.y; _xl(2, 0)[i] = pos.z;
+		_xl(0, 1)[i] = vel.x; _xl(1, 1)[i] = vel.y; _xl(2, 1)[i] = vel.z;
+	}
+	// i番目のトラックの観測雑音の分散(観測がない場合は無限大)
+	void set_measurement_noise(size_t i, float r) {
+		_r()[i] = r;
+	}
+	void set_process_noise(float q) {
+		_q = q;
+	}
+
+	/*********************************************************************/
+	/*! @brief 全トラックの時間をdtだけ進めた状態を予測する
+
+		@param[in]      dt              経過時間
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         none
+		@exception      none
+	**********************************************************************/
+	void predict(float dt) {
+		typedef sharaku_simd	V;
+		const matrix<S, S> F = kalman_filter<S>::transition(dt);
+		const matrix<S, S> Q = kalman_filter<S>::process_noise(dt, _q);
+		V::f32 f[S][S], q[S][S];
+		sharaku_unroll<S>([&](auto i) {
+			sharaku_unroll<S>([&](auto j) {
+				f[i][j] = V::set1(F.m[i][j]);
+				q[i][j] = V::set1(Q.m[i][j]);
+			});
+		});
+
+		for (size_t n = 0; n < _cap; n += V::width) {
+			// x = F * x (Fは対角要素が1の上三角行列)
+			sharaku_unroll<3>([&](auto a) {
+				sharaku_unroll<S>([&](auto i) {
+					V::f32 v = V::load(_xl(a, i) + n);
+					sharaku_unroll<S - 1 - i>([&](auto k) {
+						v = V::add(v, V::mul(f[i][i + 1 + k],
+								     V::load(_xl(a, i + 1 + k) + n)));
+					});
+					V::store(_xl(a, i) + n, v);
+				});
+			});
+			// P = F * P * F^T + Q (上三角要素のみ)
+			V::f32 p[S][S], t[S][S];
+			_load_P(p, n);
+			sharaku_unroll<S>([&](auto i) {
+				sharaku_unroll<S>([&](auto j) {
+					V::f32 v = p[i][j];
+					sharaku_unroll<S - 1 - i>([&](auto k) {
+						v = V::add(v, V::mul(f[i][i + 1 + k], p[i + 1 + k][j]));
+					});
+					t[i][j] = v;
+				});
+			});
+			sharaku_unroll<S>([&](auto i) {
+				sharaku_unroll<S - i>([&](auto jj) {
+					constexpr size_t j = i + jj;
+					V::f32 v = t[i][j];
+					sharaku_unroll<S - 1 - j>([&](auto k) {
+						v = V::add(v, V::mul(t[i][j + 1 + k], f[j][j + 1 + k]));
+					});
+					V::store(_Pl(i, j) + n, V::add(v, q[i][j]));
+				});
+			});
+		}
+	}
+
+	// 全トラックの位置・速度・加速度の観測値zで状態を更新する
+	//  zはsize()要素であること
+	void update_position(const vector3_soa& z) {
+		_update<0>(z);
+	}
+	void update_velocity(const vector3_soa& z) {
+		_update<1>(z);
+	}
+	void update_acceleration(const vector3_soa& z) {
+		_update<2>(z);
+	}
+
+ public:
+	size_t size(void) const { return _n; }
+
+	position3 position(size_t i) const {
+		return position3{_xl(0, 0)[i], _xl(1, 0)[i], _xl(2, 0)[i]};
+	}
+	vector3 velocity(size_t i) const {
+		return vector3{_xl(0, 1)[i], _xl(1, 1)[i], _xl(2, 1)[i]};
+	}
+	vector3 acceleration(size_t i) const {
+		static_assert(S >= 3, "acceleration requires the constant-acceleration model");
+		return vector3{_xl(0, 2)[i], _xl(1, 2)[i], _xl(2, 2)[i]};
+	}
+	// i番目のトラックの共分散行列
+	matrix<S, S> covariance(size_t i) const {
+		matrix<S, S> P;
+		for (size_t k = 0; k < S; k++) {
+			for (size_t l = k; l < S; l++) {
+				P.m[k][l] = P.m[l][k] = _Pl(k, l)[i];
+			}
+		}
+		return P;
+	}
+	float get_q(void) const { return _q; }
+	float get_r(size_t i) const { return _r()[i]; }
+
+ private:
+	// 共分散行列(対称)をp[S][S]へ読み込む
+	void _load_P(sharaku_simd::f32 (&p)[S][S], size_t n) const {
+		sharaku_unroll<S>([&](auto i) {
+			sharaku_unroll<S - i>([&](auto jj) {
+				constexpr size_t j = i + jj;
+				p[i][j] = sharaku_simd::load(_Pl(i, j) + n);
+				p[j][i] = p[i][j];
+			});
+		});
+	}
+
+	template <size_t K>
+	void _update(const vector3_soa& z) {
+		static_assert(K < S, "observed element is out of the state");
+		typedef sharaku_simd	V;
+		const float *zl[3] = {z.x(), z.y(), z.z()};
+		const float *r = _r();
+		const V::f32 one = V::set1(1.0f);
+
+		for (size_t n = 0; n < _cap; n += V::width) {
+			V::f32 p[S][S], k[S];
+			_load_P(p, n);
+			const V::f32 inv = V::div(one, V::add(p[K][K], V::load(r + n)));
+			sharaku_unroll<S>([&](auto i) { k[i] = V::mul(p[i][K], inv); });
+			sharaku_unroll<3>([&](auto a) {
+				const V::f32 e = V::sub(V::load(zl[a] + n), V::load(_xl(a, K) + n));
+				sharaku_unroll<S>([&](auto i) {
+					V::store(_xl(a, i) + n,
+						 V::add(V::load(_xl(a, i) + n), V::mul(k[i], e)));
+				});
+			});
+			sharaku_unroll<S>([&](auto i) {
+				sharaku_unroll<S - i>([&](auto jj) {
+					constexpr size_t j = i + jj;
+					V::store(_Pl(i, j) + n, V::sub(p[i][j], V::mul(k[i], p[K][j])));
+				});
+			});
+		}
+	}
+
+ protected:
+	// レーン数: 状態(3軸 x S) + 共分散の上三角(S(S+1)/2) + 観測雑音
+	enum { _LANES = 3 * S + S * (S + 1) / 2 + 1 };
+	// a軸の状態のk番目の要素
+	float *_xl(size_t a, size_t k) const { return _buf + _stride * (a * S + k); }
+	// 共分散行列の(k, l)要素(k <= l)
+	float *_Pl(size_t k, size_t l) const {
+		return _buf + _stride * (3 * S + k * S - k * (k - 1) / 2 + (l - k));
+	}
+	float *_r(void) const { return _buf + _stride * (_LANES - 1); }
+
+ protected:
+	size_t	_n;		// トラック数
+	size_t	_cap;		// レーン長(トラック数を切り上げたもの)
+	size_t	_stride;	// レーンの間隔
+	float	*_buf;		// 各レーンの先頭
+	float	_q;		// 白色雑音のスペクトル密度
+};
+
+
+#endif // SHARAKU_UV_KALMAN_H_
@@ -0,0 +1,171 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_MM_MATRIX_H_
+#define SHARAKU_MM_MATRIX_H_
+
+#include <stddef.h>
+#include <type_traits>
+#include <utility>
+
+//-----------------------------------------------------------------------------
+// コンパイル時に回数の決まったループの展開
+//  f(std::integral_constant<size_t, i>)をi = 0～N-1の順に呼び出す。
+//  ループカウンタが定数となるため、配列添字は全てコンパイル時に解決される
+//  (最適化レベルによらずループ制御や配列のスタック退避が残らない)。
+template <class F, size_t... I>
+static inline void
+sharaku_unroll_seq(F&& f, std::index_sequence<I...>)
+{
+	(f(std::integral_constant<size_t, I>()), ...);
+}
+template <size_t N, class F>
+static inline void
+sharaku_unroll(F&& f)
+{
+	sharaku_unroll_seq(f, std::make_index_sequence<N>());
+}
+
+/* ========================================================================= */
+/* struct definition Section                                                 */
+/* ========================================================================= */
+
+/*! @class matrix
+    @brief  R行C列の固定サイズ行列構造体
+
+	要素は行優先でメンバ配列に保持し、ヒープを使用しない。
+	演算は全てsharaku_unrollで展開する。
+	状態推定(kalman.hpp)等の数次元の小さな行列を想定している。
+*/
+template <size_t R, size_t C>
+struct matrix {
+ public:
+	float m[R][C]; ///< 行列要素(行優先)
+
+ public:
+	float& operator()(size_t r, size_t c) { return m[r][c]; }
+	constexpr float operator()(size_t r, size_t c) const { return m[r][c]; }
+
+	matrix& operator+=(const matrix& a) {
+		sharaku_unroll<R>([&](auto i) {
+			sharaku_unroll<C>([&](auto j) { m[i][j] += a.m[i][j]; });
+		});
+		return (*this);
+	}
+	matrix& operator-=(const matrix& a) {
+		sharaku_unroll<R>([&](auto i) {
+			sharaku_unroll<C>([&](auto j) { m[i][j] -= a.m[i][j]; });
+		});
+		return (*this);
+	}
+	matrix& operator*=(float s) {
+		sharaku_unroll<R>([&](auto i) {
+			sharaku_unroll<C>([&](auto j) { m[i][j] *= s; });
+		});
+		return (*this);
+	}
+
+	// 転置行列を返す
+	matrix<C, R> transpose(void) const {
+		matrix<C, R> t;
+		sharaku_unroll<R>([&](auto i) {
+			sharaku_unroll<C>([&](auto j) { t.m[j][i] = m[i][j]; });
+		});
+		return t;
+	}
+
+	// 全要素が0の行列
+	static matrix zero(void) {
+		matrix z;
+		sharaku_unroll<R>([&](auto i) {
+			sharaku_unroll<C>([&](auto j) { z.m[i][j] = 0.0f; });
+		});
+		return z;
+	}
+	// 単位行列(対角要素をsとする)
+	static matrix identity(float s = 1.0f) {
+		static_assert(R == C, "identity requires a square matrix");
+		matrix e = zero();
+		sharaku_unroll<R>([&](auto i) { e.m[i][i] = s; });
+		return e;
+	}
+};
+
+template <size_t R, size_t C>
+static inline matrix<R, C>
+operator+(matrix<R, C> lhs, const matrix<R, C>& rhs)
+{
+	return lhs += rhs;
+}
+
+template <size_t R, size_t C>
+static inline matrix<R, C>
+operator-(matrix<R, C> lhs, const matrix<R, C>& rhs)
+{
+	return lhs -= rhs;
+}
+
+template <size_t R, size_t C>
+static inline matrix<R, C>
+operator*(matrix<R, C> lhs, float s)
+{
+	return lhs *= s;
+}
+
+/*********************************************************************/
+/*! @brief 行列の積を求める
+
+	@param[in]      lhs             R行K列の行列
+	@param[in]      rhs             K行C列の行列
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         R行C列の積
+	@exception      none
+**********************************************************************/
+template <size_t R, size_t K, size_t C>
+static inline matrix<R, C>
+operator*(const matrix<R, K>& lhs, const matrix<K, C>& rhs)
+{
+	matrix<R, C> r;
+	sharaku_unroll<R>([&](auto i) {
+		sharaku_unroll<C>([&](auto j) {
+			float s = lhs.m[i][0] * rhs.m[0][j];
+			sharaku_unroll<K - 1>([&](auto k) {
+				s += lhs.m[i][k + 1] * rhs.m[k + 1][j];
+			});
+			r.m[i][j] = s;
+		});
+	});
+	return r;
+}
+
+static_assert(std::is_trivially_copyable<matrix<3, 3>>::value, "matrix must be trivially copyable");
+static_assert(sizeof(matrix<3, 3>) == 36, "matrix<3, 3> must be 36 bytes");
+
+
+#endif // SHARAKU_MM_MATRIX_H_
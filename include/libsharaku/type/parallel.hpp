@@ -0,0 +1,367 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_MM_PARALLEL_H_
+#define SHARAKU_MM_PARALLEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <libsharaku/type/vector.hpp>
+#include <libsharaku/type/position.hpp>
+#include <libsharaku/type/rotation.hpp>
+#include <libsharaku/type/transform.hpp>
+
+// キャッシュラインサイズ(byte)
+#define SHARAKU_CACHE_LINE		64
+// 1チャンクの最小サイズ(byte)。これ未満の処理は呼び出しスレッドのみで行う
+#define SHARAKU_PARALLEL_MIN_CHUNK	(32 * 1024)
+// 1スレッド当たりのチャンク数(負荷の偏りを吸収するための分割数)
+#define SHARAKU_PARALLEL_CHUNKS_PER_THREAD	4
+
+/* ========================================================================= */
+/* class definition Section                                                  */
+/* ========================================================================= */
+
+/*! @class thread_pool
+    @brief  固定数のワーカースレッドでチャンク単位の処理を行うスレッドプール
+
+	run()はチャンク番号0～chunks-1を呼び出しスレッドとワーカースレッドで
+	分担して処理し、全チャンクの完了まで戻らない。
+	チャンクの割り当ては共有カウンタから先着順に行う。
+*/
+class thread_pool
+{
+ public:
+	/*********************************************************************/
+	/*! @brief スレッドプールを構築する
+
+		@param[in]      threads         処理に参加するスレッド数(呼び出し
+		                                スレッドを含む)。0の場合はCPU数
+		@exception      none
+	**********************************************************************/
+	explicit thread_pool(size_t threads = 0) {
+		if (threads == 0) {
+			threads = std::thread::hardware_concurrency();
+		}
+		for (size_t i = 1; i < threads; i++) {
+			_workers.emplace_back([this] { _worker(); });
+		}
+	}
+	~thread_pool() {
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			_stop = true;
+		}
+		_cv_start.notify_all();
+		for (std::thread& th : _workers) {
+			th.join();
+		}
+	}
+	thread_pool(const thread_pool&) = delete;
+	thread_pool& operator=(const thread_pool&) = delete;
+
+ public:
+	// 処理に参加するスレッド数(呼び出しスレッドを含む)
+	size_t size(void) const { return _workers.size() + 1; }
+
+	/*********************************************************************/
+	/*! @brief チャンク番号0～chunks-1に対してfuncを並列に実行する
+
+		@param[in]      chunks          チャンク数
+		@param[in]      func            void(size_t chunk)で呼び出す処理
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         none
+		@exception      none
+	**********************************************************************/
+	void run(size_t chunks, const std::function<void(size_t)>& func) {
+		if (chunks <= 1 || _workers.empty()) {
+			for (size_t c = 0; c < chunks; c++) {
+				func(c);
+			}
+			return;
+		}
+		std::lock_guard<std::mutex> run_lock(_run_mtx);
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			_func	= &func;
+			_chunks	= chunks;
+			_next.store(0, std::memory_order_relaxed);
+			_pending = _workers.size();
+			_gen++;
+		}
+		_cv_start.notify_all();
+		_drain(func, chunks);
+
+		std::unique_lock<std::mutex> lock(_mtx);
+		_cv_done.wait(lock, [this] { return _pending == 0; });
+		_func = nullptr;
+	}
+
+ private:
+	void _drain(const std::function<void(size_t)>& func, size_t chunks) {
+		size_t c;
+		while ((c = _next.fetch_add(1, std::memory_order_relaxed)) < chunks) {
+			func(c);
+		}
+	}
+
+	void _worker(void) {
+		uint64_t gen = 0;
+		for (;;) {
+			const std::function<void(size_t)> *func;
+			size_t chunks;
+			{
+				std::unique_lock<std::mutex> lock(_mtx);
+				_cv_start.wait(lock, [&] { return _stop || _gen != gen; });
+				if (_stop) {
+					return;
+				}
+				gen	= _gen;
+				func	= _func;
+				chunks	= _chunks;
+			}
+			_drain(*func, chunks);
+			{
+				std::lock_guard<std::mutex> lock(_mtx);
+				if (--_pending == 0) {
+					_cv_done.notify_one();
+				}
+			}
+		}
+	}
+
+ protected:
+	std::vector<std::thread>		_workers;
+	std::mutex				_run_mtx;	// run()の排他
+	std::mutex				_mtx;
+	std::condition_variable			_cv_start;
+	std::condition_variable			_cv_done;
+	const std::function<void(size_t)>	*_func = nullptr;
+	size_t					_chunks = 0;
+	size_t					_pending = 0;	// 処理中のワーカー数
+	uint64_t				_gen = 0;	// run()の世代
+	bool					_stop = false;
+	alignas(SHARAKU_CACHE_LINE) std::atomic<size_t> _next{0};
+};
+
+/*! @class parallel_chunk
+    @brief  配列をキャッシュライン境界で分割するチャンク情報
+
+	出力配列の各チャンクの先頭をキャッシュライン境界に合わせ、
+	隣り合うチャンクが同一キャッシュラインへ書き込まない(false sharing
+	しない)ように分割する。チャンク長は要素サイズとキャッシュライン
+	サイズの最小公倍数の倍数とする。
+*/
+struct parallel_chunk {
+ public:
+	size_t	n;	///< 要素数
+	size_t	first;	///< 最初のチャンクの要素数
+	size_t	size;	///< 2番目以降のチャンクの要素数
+	size_t	count;	///< チャンク数
+
+ public:
+	// c番目のチャンクの開始位置
+	size_t begin(size_t c) const {
+		return (c == 0) ? 0 : first + (c - 1) * size;
+	}
+	// c番目のチャンクの終了位置(この位置を含まない)
+	size_t end(size_t c) const {
+		const size_t e = first + c * size;
+		return (e < n) ? e : n;
+	}
+
+	/*********************************************************************/
+	/*! @brief 出力配列の分割方法を求める
+
+		@param[in]      out             出力配列の先頭
+		@param[in]      elem            1要素のサイズ(byte)
+		@param[in]      n               要素数
+		@param[in]      threads         処理スレッド数
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         チャンク情報
+		@exception      none
+	**********************************************************************/
+	static parallel_chunk make(const void *out, size_t elem, size_t n, size_t threads) {
+		// キャッシュライン境界を跨がないチャンク長の単位(要素数)
+		size_t unit = 1;
+		while ((unit * elem) % SHARAKU_CACHE_LINE) {
+			unit++;
+		}
+		// 先頭から最初のキャッシュライン境界までの要素数
+		// (境界に要素の先頭が来ない配置の場合は0)
+		const uintptr_t addr = (uintptr_t)out;
+		size_t head = 0;
+		while (head < unit &&
+		       (addr + head * elem) % SHARAKU_CACHE_LINE) {
+			head++;
+		}
+		if (head == unit) {
+			head = 0;
+		}
+
+		const size_t min_size = (SHARAKU_PARALLEL_MIN_CHUNK + elem - 1) / elem;
+		size_t sz = (n + threads * SHARAKU_PARALLEL_CHUNKS_PER_THREAD - 1) /
+			    (threads * SHARAKU_PARALLEL_CHUNKS_PER_THREAD);
+		sz = (sz < min_size) ? min_size : sz;
+		sz = (sz + unit - 1) / unit * unit;
+
+		parallel_chunk chunk;
+		chunk.n		= n;
+		chunk.first	= head + sz;
+		chunk.size	= sz;
+		chunk.count	= (n <= chunk.first) ? 1 : 1 + (n - chunk.first + sz - 1) / sz;
+		return chunk;
+	}
+};
+
+/* ========================================================================= */
+/* function definition Section                                               */
+/* ========================================================================= */
+
+/*********************************************************************/
+/*! @brief 出力配列outの[begin, end)ごとにfuncを並列に実行する
+
+	@param[in]      pool            処理を行うスレッドプール
+	@param[in]      out             出力配列の先頭(チャンク境界の決定に使用)
+	@param[in]      n               要素数
+	@param[in]      func            void(size_t begin, size_t end)で呼び出す処理
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         none
+	@exception      none
+**********************************************************************/
+template <class T, class F>
+static inline void
+sharaku_parallel_for(thread_pool& pool, const T *out, size_t n, F func)
+{
+	if (n == 0) {
+		return;
+	}
+	const parallel_chunk chunk = parallel_chunk::make(out, sizeof(T), n, pool.size());
+	pool.run(chunk.count, [&chunk, &func](size_t c) {
+		func(chunk.begin(c), chunk.end(c));
+	});
+}
+
+/*********************************************************************/
+/*! @brief 入力配列inの[begin, end)ごとにfuncで部分結果を求め、集約する
+
+	部分結果はチャンク順にmergeで畳み込むため、同じスレッド数であれば
+	結果は実行ごとに変わらない。
+
+	@param[in]      pool            処理を行うスレッドプール
+	@param[in]      in              入力配列の先頭(チャンク境界の決定に使用)
+	@param[in]      n               要素数
+	@param[in]      init            集約の初期値
+	@param[in]      func            R(size_t begin, size_t end)で呼び出す処理
+	@param[in]      merge           R(const R&, const R&)で部分結果を集約する処理
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         集約結果
+	@exception      none
+**********************************************************************/
+template <class T, class R, class F, class M>
+static inline R
+sharaku_parallel_reduce(thread_pool& pool, const T *in, size_t n, R init, F func, M merge)
+{
+	if (n == 0) {
+		return init;
+	}
+	const parallel_chunk chunk = parallel_chunk::make(in, sizeof(T), n, pool.size());
+	std::vector<R> part(chunk.count, init);
+	pool.run(chunk.count, [&chunk, &func, &part](size_t c) {
+		part[c] = func(chunk.begin(c), chunk.end(c));
+	});
+	R r = init;
+	for (const R& p : part) {
+		r = merge(r, p);
+	}
+	return r;
+}
+
+/*********************************************************************/
+/*! @brief n個のposition3を並列に座標変換する
+
+	@param[in]      pool            処理を行うスレッドプール
+	@param[in]      t               座標変換
+	@param[in]      in              変換するposition3の配列
+	@param[out]     out             変換結果の格納先(inと同一でもよい)
+	@param[in]      n               要素数
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         none
+	@exception      none
+**********************************************************************/
+static inline void
+sharaku_parallel_transform(thread_pool& pool, const transform3& t,
+			   const position3 *in, position3 *out, size_t n)
+{
+	sharaku_parallel_for(pool, out, n, [&](size_t begin, size_t end) {
+		t.apply(in + begin, out + begin, end - begin);
+	});
+}
+
+// n個のposition3をrotで並列に回転する(原点中心)
+static inline void
+sharaku_parallel_rotate(thread_pool& pool, const rotation3& rot,
+			const position3 *in, position3 *out, size_t n)
+{
+	const transform3 t = transform3::from_rotation(rot, vector3{0.0f, 0.0f, 0.0f});
+	sharaku_parallel_transform(pool, t, in, out, n);
+}
+
+// n個のposition3をvecで並列に平行移動する
+static inline void
+sharaku_parallel_translate(thread_pool& pool, const vector3& vec,
+			   const position3 *in, position3 *out, size_t n)
+{
+	sharaku_parallel_for(pool, out, n, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			out[i] = in[i] + vec;
+		}
+	});
+}
+
+
+#endif // SHARAKU_MM_PARALLEL_H_
@@ -28,6 +28,12 @@
 #define SHARAKU_UV_PID_H_
 
 #include <stdint.h>
+#include <string.h>
+#include <limits>
+#include <type_traits>
+#include <libsharaku/type/simd.hpp>
+#include <libsharaku/type/fixed.hpp>
+#include <libsharaku/type/digital-filter.hpp>
 
 //-----------------------------------------------------------------------------
 // PID制御の実装
@@ -44,61 +50,358 @@
 //    targetとnowとの差分と前回差分との差の大きさに比例する。
 //    変化が大きいときに出力値も大きくなる。
 //    瞬間的な変化が出力値に反映される。
-class pid
+//
+//  出力制限・アンチワインドアップ・微分フィルタ
+//   set_limit(umin, umax)
+//     操作量uを[umin, umax]に制限する(min/maxのみで分岐しない)。
+//   set_antiwindup(Kb)
+//     バックカリキュレーション方式のアンチワインドアップ。
+//     制限前後の操作量の差(u_sat - u)をKb倍して誤差積分へ戻す。
+//   set_derivative_filter(q)
+//     誤差微分edをlow_pass_filter(係数q)に通してから使用する。
+//   既定値(制限なし、Kb = 0、q = 1)では従来のPID制御と同一の結果となる。
+//   Δ時間0やオーバーフローで非有限値となったステップの後も、
+//   従来と同様に次のステップから復帰する。
+//
+//  スカラ型Tで演算の型を指定する(float, double, q16_16など)。
+//  pidはfloat版であり、従来のpidと同一の結果を返す。
+template <class T>
+class basic_pid
 {
+	template <class U>
+	struct _is_value {
+		static constexpr bool value =
+			std::is_floating_point<U>::value || std::is_same<U, T>::value;
+	};
+
  public:
-	pid(float Kp, float Ki, float Kd) {
+	basic_pid(T Kp, T Ki, T Kd) : _edf(T(1)) {
 		set_pid(Kp, Ki, Kd);
+		set_limit(_lowest(), _highest());
+		set_antiwindup(T(0));
 		clear();
 	}
 	void clear(void) {
-		_ei = 0.0f;
-		_el = 0.0f;
+		_ei = T(0);
+		_el = T(0);
+		_edf.clear();
 	}
-	void set_pid(float Kp, float Ki, float Kd) {
+	void set_pid(T Kp, T Ki, T Kd) {
 		_Kp = Kp;
 		_Ki = Ki;
 		_Kd = Kd;
 	}
-	float operator()(float delta_ms, int32_t now, int32_t target) {
-		register float	u = 0.0f;
-		register float	e = 0.0f;
-		register float	ed = 0.0f;
+	// 操作量の制限(umin <= umax)
+	void set_limit(T umin, T umax) {
+		_umin = umin;
+		_umax = umax;
+	}
+	// バックカリキュレーションゲイン(0で無効)
+	void set_antiwindup(T Kb) {
+		_Kb = Kb;
+	}
+	// 誤差微分のローパスフィルタ係数(1でフィルタなし)
+	void set_derivative_filter(T q) {
+		_edf.set(q);
+	}
+	// 整数の現在値・目標値(従来のpidと同じくint32_tで差を求める)
+	T operator()(T delta_ms, int32_t now, int32_t target) {
+		return _step(delta_ms, T(target - now));
+	}
+	// 浮動小数点またはTの現在値・目標値
+	//  整数や整数と浮動小数点の混在は上のint32_t版を使用する。
+	template <class U, class V,
+		  typename std::enable_if<_is_value<U>::value && _is_value<V>::value,
+					  int>::type = 0>
+	T operator()(T delta_ms, U now, V target) {
+		return _step(delta_ms, T(target) - T(now));
+	}
+ public:
+	T get_Kp(void) { return _Kp; }
+	T get_Ki(void) { return _Ki; }
+	T get_Kd(void) { return _Kd; }
+	T get_Kb(void) { return _Kb; }
+	T get_umin(void) { return _umin; }
+	T get_umax(void) { return _umax; }
+
+	T get_ei(void) { return _ei; }
+	T get_el(void) { return _el; }
+ private:
+	T _step(T delta_ms, T e) {
+		T	u;
+		T	us;
+		T	ed;
+		T	b;
 
 		// Δ時間T
 		// 誤差e      = 目標値 - 現在値
 		// 誤差積分ei = ei + e * T
-		// 誤差微分ed = (e - 前回誤差el) / T
+		// 誤差微分ed = LPF((e - 前回誤差el) / T)
 		// 前回誤差el = e
-		e	= target - now;			// 誤差
 		_ei	= _ei + e * delta_ms;		// 誤差積分
 		ed	= (e - _el) / delta_ms;		// 誤差微分
 		_el = e;
+		if (_edf.get_q() < T(1)) {
+			_edf += ed;
+		} else {
+			_edf = ed;			// フィルタなし
+		}
 
 		// PID計算
 		// 操作量u = 比例ゲインKP * e
 		//           + 積分ゲインKI * ei
 		//           + 微分ゲインKD * ed
-		u = _Kp * e + _Ki * _ei + _Kd * ed;
+		u = _Kp * e + _Ki * _ei + _Kd * (T)_edf;
+
+		// 出力制限とアンチワインドアップ
+		//  ei = ei + Kb * (制限後u - u) * T
+		//  補正量Kb * (制限後u - u)が0または非有限値の場合はeiを更新しない。
+		//  Kb = 0や制限なしでuが無限大となった場合の0 * infやinf - infを
+		//  eiへ残さないためである。uが非有限値の場合はそのまま出力する。
+		us	= (u < _umin) ? _umin : u;
+		us	= (us > _umax) ? _umax : us;
+		b	= _Kb * (us - u);
+		if (b != T(0) && b > _lowest() && b < _highest()) {
+			_ei = _ei + b * delta_ms;
+		}
+
+		return us;
+	}
+	static T _lowest(void) {
+		return std::numeric_limits<T>::has_infinity ?
+			-std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+	}
+	static T _highest(void) {
+		return std::numeric_limits<T>::has_infinity ?
+			std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+	}
+ protected:
+	T	_Kp;
+	T	_Ki;
+	T	_Kd;
+	T	_Kb;		// アンチワインドアップゲイン
+	T	_umin;		// 操作量の下限
+	T	_umax;		// 操作量の上限
+	T	_ei;		// 誤差積分
+	T	_el;		// 前回誤差
+	basic_low_pass_filter<T> _edf;	// 誤差微分のフィルタ
+
+ private:
+	basic_pid() {}
+};
+
+typedef basic_pid<float>	pid;
+
+//-----------------------------------------------------------------------------
+// 固定周期・固定小数点(Q16.16)のPID制御
+//  FPUのない環境向けに、全ての演算を整数演算のみで行う。
+//  サンプル周期Tは固定とし、微分項の除算(e - el) / Tは
+//  set_period()で一度だけ求めた逆数1 / Tとの乗算で行う。
+//  誤差積分eiおよび操作量uは64bitで計算してQ16.16の表現範囲に
+//  飽和させるため、長時間偏差が残ってもラップアラウンドしない。
+//  誤差eは±32767に飽和させる。サンプル周期は4 / 65536ms以上とする。
+class pid_fixed
+{
+ public:
+	pid_fixed(q16_16 Kp, q16_16 Ki, q16_16 Kd, q16_16 period_ms) {
+		set_pid(Kp, Ki, Kd);
+		set_period(period_ms);
+		clear();
+	}
+	void clear(void) {
+		_ei = 0;
+		_el = 0;
+	}
+	void set_pid(q16_16 Kp, q16_16 Ki, q16_16 Kd) {
+		_Kp = Kp.raw;
+		_Ki = Ki.raw;
+		_Kd = Kd.raw;
+	}
+	void set_period(q16_16 period_ms) {
+		_T	= period_ms.raw;
+		_invT	= (int32_t)(((int64_t)1 << 32) / period_ms.raw);	// 1 / T
+	}
+	q16_16 operator()(int32_t now, int32_t target) {
+		// 誤差e(整数)
+		int64_t e = (int64_t)target - now;
+		e = (e > INT16_MAX) ? INT16_MAX : e;
+		e = (e < -INT16_MAX) ? -INT16_MAX : e;
+
+		// 誤差積分ei = ei + e * T
+		// 誤差微分ed = (e - 前回誤差el) * (1 / T)
+		//  eが整数のため、Q16.16との積はそのままQ16.16となる
+		_ei = q16_16::from_raw_sat(_ei + e * _T).raw;
+		const int64_t ed = q16_16::from_raw_sat((e - _el) * _invT).raw;
+		_el = (int32_t)e;
 
-		return u;
+		// 操作量u = KP * e + KI * ei + KD * ed
+		return q16_16::from_raw_sat(_Kp * e + (((int64_t)_Ki * _ei) >> 16) +
+					    ((_Kd * ed) >> 16));
 	}
  public:
-	float get_Kp(void) { return _Kp; }
-	float get_Ki(void) { return _Ki; }
-	float get_Kd(void) { return _Kd; }
+	q16_16 get_Kp(void) { return q16_16::from_raw(_Kp); }
+	q16_16 get_Ki(void) { return q16_16::from_raw(_Ki); }
+	q16_16 get_Kd(void) { return q16_16::from_raw(_Kd); }
+	q16_16 get_period(void) { return q16_16::from_raw(_T); }
 
-	float get_ei(void) { return _ei; }
-	float get_el(void) { return _el; }
+	q16_16 get_ei(void) { return q16_16::from_raw(_ei); }
+	q16_16 get_el(void) { return q16_16(_el); }
  protected:
-	float	_Kp;
-	float	_Ki;
-	float	_Kd;
-	float	_ei;		// 誤差積分
-	float	_el;		// 前回誤差
+	int32_t	_Kp;
+	int32_t	_Ki;
+	int32_t	_Kd;
+	int32_t	_T;		// サンプル周期
+	int32_t	_invT;		// サンプル周期の逆数
+	int32_t	_ei;		// 誤差積分
+	int32_t	_el;		// 前回誤差(整数)
 
  private:
-	pid() {}
+	pid_fixed() {}
+};
+
+//-----------------------------------------------------------------------------
+// 複数のPID制御をまとめて実行するバンク
+//  Kp, Ki, Kd等の係数とei, el等の状態をそれぞれ連続したレーンに保持し、
+//  全ループを1回の呼び出しでSIMD演算する。
+//  出力制限・アンチワインドアップ・微分フィルタはmin/maxと積和のみで
+//  演算し、ループごとに分岐しない。
+//  演算順序はpid::operator()と同一であり、同じ設定と入力に対して
+//  pidと同一の結果を返す。ただし積和をFMAへ縮約しないビルド
+//  (GCC/Clangでは-ffp-contract=off)の場合に限る。縮約する場合は
+//  SIMD演算とスカラ演算で縮約される箇所が異なるため、丸め誤差の
+//  範囲で異なる結果となる。
+class pid_bank
+{
+ public:
+	explicit pid_bank(size_t n) {
+		_n	= n;
+		_cap	= sharaku_simd::round_up(n);
+		_buf	= (float *)sharaku_simd::alloc(sizeof(float) * _cap * _LANES);
+		memset(_buf, 0, sizeof(float) * _cap * _LANES);
+		for (size_t i = 0; i < _cap; i++) {
+			set_limit(i, -std::numeric_limits<float>::infinity(),
+				  std::numeric_limits<float>::infinity());
+			set_derivative_filter(i, 1.0f);
+		}
+	}
+	~pid_bank() {
+		sharaku_simd::free(_buf);
+	}
+	pid_bank(const pid_bank&) = delete;
+	pid_bank& operator=(const pid_bank&) = delete;
+
+	void clear(void) {
+		memset(_ei(), 0, sizeof(float) * _cap * 3);
+	}
+	void clear(size_t i) {
+		_ei()[i] = 0.0f;
+		_el()[i] = 0.0f;
+		_edf()[i] = 0.0f;
+	}
+	void set_pid(size_t i, float Kp, float Ki, float Kd) {
+		_Kp()[i] = Kp;
+		_Ki()[i] = Ki;
+		_Kd()[i] = Kd;
+	}
+	void set_limit(size_t i, float umin, float umax) {
+		_umin()[i] = umin;
+		_umax()[i] = umax;
+	}
+	void set_antiwindup(size_t i, float Kb) {
+		_Kb()[i] = Kb;
+	}
+	void set_derivative_filter(size_t i, float q) {
+		_q()[i] = q;
+		_nq()[i] = 1 - q;
+	}
+
+	// 全ループを1ステップ進める
+	//  now, target, uはsize()要素の配列
+	void operator()(float delta_ms, const int32_t *now,
+			const int32_t *target, float *u) {
+		typedef sharaku_simd	S;
+		const size_t W = S::width;
+		const float *Kp = _Kp(), *Ki = _Ki(), *Kd = _Kd(), *Kb = _Kb();
+		const float *umin = _umin(), *umax = _umax(), *q = _q(), *nq = _nq();
+		float *ei = _ei(), *el = _el(), *edf = _edf();
+		const S::f32 dt = S::set1(delta_ms);
+		const S::f32 zero = S::set1(0.0f), one = S::set1(1.0f);
+		const S::f32 inf = S::set1(std::numeric_limits<float>::infinity());
+		size_t i = 0;
+
+		for (; i + W <= _n; i += W) {
+			S::f32 e	= S::cvt(S::subi(S::loadi(target + i),
+							 S::loadi(now + i)));
+			S::f32 vei	= S::add(S::load(ei + i), S::mul(e, dt));
+			S::f32 ed	= S::div(S::sub(e, S::load(el + i)), dt);
+			S::f32 vq	= S::load(q + i);
+			S::f32 vedf	= S::selgt(one, vq,
+						   S::add(S::mul(ed, vq),
+							  S::mul(S::load(edf + i), S::load(nq + i))),
+						   ed);
+			S::f32 vu	= S::add(S::add(S::mul(S::load(Kp + i), e),
+							S::mul(S::load(Ki + i), vei)),
+						 S::mul(S::load(Kd + i), vedf));
+			// max/minは非有限値のvuをそのまま返すよう第2引数に置く
+			S::f32 us	= S::min(S::load(umax + i), S::max(S::load(umin + i), vu));
+			S::f32 b	= S::mul(S::load(Kb + i), S::sub(us, vu));
+			S::f32 ab	= S::abs(b);
+			vei = S::selgt(ab, zero,
+				       S::selgt(inf, ab, S::add(vei, S::mul(b, dt)), vei), vei);
+			S::store(ei + i, vei);
+			S::store(el + i, e);
+			S::store(edf + i, vedf);
+			S::store(u + i, us);
+		}
+		for (; i < _n; i++) {
+			float e		= target[i] - now[i];
+			ei[i]		= ei[i] + e * delta_ms;
+			float ed	= (e - el[i]) / delta_ms;
+			el[i]		= e;
+			edf[i]		= (q[i] < 1.0f) ? (ed * q[i]) + (edf[i] * nq[i]) : ed;
+			float vu	= Kp[i] * e + Ki[i] * ei[i] + Kd[i] * edf[i];
+			float us	= (vu < umin[i]) ? umin[i] : vu;
+			us		= (us > umax[i]) ? umax[i] : us;
+			float b		= Kb[i] * (us - vu);
+			if (b != 0.0f && b > -std::numeric_limits<float>::infinity() &&
+			    b < std::numeric_limits<float>::infinity()) {
+				ei[i] = ei[i] + b * delta_ms;
+			}
+			u[i]		= us;
+		}
+	}
+
+ public:
+	size_t size(void) { return _n; }
+
+	float get_Kp(size_t i) { return _Kp()[i]; }
+	float get_Ki(size_t i) { return _Ki()[i]; }
+	float get_Kd(size_t i) { return _Kd()[i]; }
+	float get_Kb(size_t i) { return _Kb()[i]; }
+	float get_umin(size_t i) { return _umin()[i]; }
+	float get_umax(size_t i) { return _umax()[i]; }
+
+	float get_ei(size_t i) { return _ei()[i]; }
+	float get_el(size_t i) { return _el()[i]; }
+
+ protected:
+	enum { _LANES = 11 };
+	float *_Kp(void) { return _buf; }
+	float *_Ki(void) { return _buf + _cap; }
+	float *_Kd(void) { return _buf + _cap * 2; }
+	float *_Kb(void) { return _buf + _cap * 3; }	// アンチワインドアップゲイン
+	float *_umin(void) { return _buf + _cap * 4; }	// 操作量の下限
+	float *_umax(void) { return _buf + _cap * 5; }	// 操作量の上限
+	float *_q(void) { return _buf + _cap * 6; }	// 微分フィルタ係数
+	float *_nq(void) { return _buf + _cap * 7; }	// 1 - _q
+	float *_ei(void) { return _buf + _cap * 8; }	// 誤差積分
+	float *_el(void) { return _buf + _cap * 9; }	// 前回誤差
+	float *_edf(void) { return _buf + _cap * 10; }	// 誤差微分(フィルタ後)
+
+ protected:
+	size_t	_n;		// ループ数
+	size_t	_cap;		// レーン長(ループ数を切り上げたもの)
+	float	*_buf;		// 各レーンの先頭
 };
 
 
@@ -0,0 +1,620 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_MM_POINT_CLOUD_H_
+#define SHARAKU_MM_POINT_CLOUD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include <libsharaku/type/simd.hpp>
+#include <libsharaku/type/position.hpp>
+#include <libsharaku/type/matrix.hpp>
+#include <libsharaku/type/parallel.hpp>
+
+// 単精度で累積する点数(これごとに倍精度の合計へ加える)
+#define SHARAKU_CLOUD_BLOCK	1024
+
+// ボクセル番号の絶対値の上限(これ以上の点と非有限値の点は除外する)
+#define SHARAKU_VOXEL_RANGE	1073741824.0f
+
+/* ========================================================================= */
+/* struct definition Section                                                 */
+/* ========================================================================= */
+
+/*! @class aabb3
+    @brief  軸に平行な境界箱
+
+	点を含まない場合はlo = +INFINITY, hi = -INFINITYとする。
+*/
+struct aabb3 {
+ public:
+	position3	lo;	///< 各軸の最小値
+	position3	hi;	///< 各軸の最大値
+
+ public:
+	bool empty(void) const { return !(lo.x <= hi.x); }
+
+	// 点を含まない境界箱
+	static aabb3 none(void) {
+		return aabb3{position3{INFINITY, INFINITY, INFINITY},
+			     position3{-INFINITY, -INFINITY, -INFINITY}};
+	}
+	// 2つの境界箱を含む境界箱
+	static aabb3 merge(const aabb3& a, const aabb3& b) {
+		return aabb3{position3{std::min(a.lo.x, b.lo.x), std::min(a.lo.y, b.lo.y),
+				       std::min(a.lo.z, b.lo.z)},
+			     position3{std::max(a.hi.x, b.hi.x), std::max(a.hi.y, b.hi.y),
+				       std::max(a.hi.z, b.hi.z)}};
+	}
+};
+
+/*! @class cloud_moments
+    @brief  点群の点数、平均、平均まわりの2次モーメントの和
+
+	部分集合ごとに求めたものをmerge()で集約する(Chanらの方法)。
+	平均からの偏差で集約するため、原点から離れた点群でも
+	桁落ちしない。
+*/
+struct cloud_moments {
+ public:
+	size_t	n;		///< 点数
+	double	mean[3];	///< 平均(x, y, z)
+	double	m2[3][3];	///< 平均からの偏差の積の和
+
+ public:
+	static cloud_moments zero(void) {
+		return cloud_moments{0, {0.0, 0.0, 0.0},
+				     {{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}}};
+	}
+
+	/*********************************************************************/
+	/*! @brief 2つの部分集合のモーメントを集約する
+
+		@param[in]      a               部分集合のモーメント
+		@param[in]      b               部分集合のモーメント
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         和集合のモーメント
+		@exception      none
+	**********************************************************************/
+	static cloud_moments merge(const cloud_moments& a, const cloud_moments& b) {
+		if (a.n == 0) {
+			return b;
+		}
+		if (b.n == 0) {
+			return a;
+		}
+		cloud_moments r;
+		r.n = a.n + b.n;
+		const double wb = (double)b.n / (double)r.n;
+		const double f = (double)a.n * wb;
+		double d[3];
+		for (int i = 0; i < 3; i++) {
+			d[i] = b.mean[i] - a.mean[i];
+			r.mean[i] = a.mean[i] + d[i] * wb;
+		}
+		for (int i = 0; i < 3; i++) {
+			for (int j = 0; j < 3; j++) {
+				r.m2[i][j] = a.m2[i][j] + b.m2[i][j] + d[i] * d[j] * f;
+			}
+		}
+		return r;
+	}
+};
+
+/*! @class voxel_entry
+    @brief  ボクセル内の点の合計(32byte)
+
+	合計はボクセルの頂点(各軸の最小の角)からの相対座標で持つ。
+	このため単精度でも、原点から離れたボクセルの重心の精度が落ちない。
+*/
+struct alignas(32) voxel_entry {
+ public:
+	int32_t		ix, iy, iz;	///< ボクセル番号(空きはix = INT32_MIN)
+	uint32_t	count;		///< 点数
+	float		sx, sy, sz;	///< ボクセルの頂点からの相対座標の合計
+};
+
+static_assert(sizeof(voxel_entry) == 32, "voxel_entry must be 32 bytes");
+
+/* ========================================================================= */
+/* class definition Section                                                  */
+/* ========================================================================= */
+
+/*! @class voxel_table
+    @brief  ボクセル番号をキーとする開番地法のハッシュ表
+
+	要素はハッシュ表に直接格納し(線形探索、負荷率1/2以下)、探索1回の
+	キャッシュミスを1回に抑える。最初に現れた順は別の配列に要素の位置として
+	持つ。ボクセル番号は全ビットを比較するため、離れたボクセルが同じ
+	要素にまとめられることはない。
+*/
+class voxel_table
+{
+ public:
+	voxel_table() : _slots(1024, _empty()), _mask(1023) {}
+
+ public:
+	/*********************************************************************/
+	/*! @brief ボクセルの要素を求める(無ければ点数0の要素を追加する)
+
+		返した参照は次にfind()を呼び出すまで有効である。
+
+		@param[in]      ix              ボクセル番号(x)
+		@param[in]      iy              ボクセル番号(y)
+		@param[in]      iz              ボクセル番号(z)
+		@return         ボクセルの要素
+		@exception      std::bad_alloc  メモリ確保に失敗した
+	**********************************************************************/
+	voxel_entry& find(int32_t ix, int32_t iy, int32_t iz) {
+		for (uint32_t h = _hash(ix, iy, iz) & _mask;; h = (h + 1) & _mask) {
+			voxel_entry& e = _slots[h];
+			if (e.ix == ix && e.iy == iy && e.iz == iz) {
+				return e;
+			}
+			if (e.ix == INT32_MIN) {
+				e.ix = ix;
+				e.iy = iy;
+				e.iz = iz;
+				_order.push_back(h);
+				if (_order.size() * 2 > _slots.size()) {
+					_grow();
+					return find(ix, iy, iz);
+				}
+				return e;
+			}
+		}
+	}
+
+	// tの要素を加える(tだけにあるボクセルはtでの順に末尾へ追加する)
+	void merge(const voxel_table& t) {
+		for (uint32_t h : t._order) {
+			const voxel_entry& s = t._slots[h];
+			voxel_entry& d = find(s.ix, s.iy, s.iz);
+			d.count	+= s.count;
+			d.sx	+= s.sx;
+			d.sy	+= s.sy;
+			d.sz	+= s.sz;
+		}
+	}
+
+	// 全要素を削除する(確保した領域は再利用する)
+	void clear(void) {
+		for (uint32_t h : _order) {
+			_slots[h] = _empty();
+		}
+		_order.clear();
+	}
+	size_t size(void) const { return _order.size(); }
+	// 最初に現れた順でi番目の要素
+	const voxel_entry& operator[](size_t i) const { return _slots[_order[i]]; }
+
+ private:
+	static voxel_entry _empty(void) {
+		return voxel_entry{INT32_MIN, 0, 0, 0, 0.0f, 0.0f, 0.0f};
+	}
+	static uint32_t _hash(int32_t ix, int32_t iy, int32_t iz) {
+		uint32_t h = (uint32_t)ix * 0x9e3779b1u + (uint32_t)iy * 0x85ebca77u +
+			     (uint32_t)iz * 0xc2b2ae3du;
+		return h ^ (h >> 15);
+	}
+	void _grow(void) {
+		std::vector<voxel_entry> old(_slots.size() * 2, _empty());
+		old.swap(_slots);
+		_mask = (uint32_t)_slots.size() - 1;
+		for (uint32_t& o : _order) {
+			const voxel_entry& e = old[o];
+			uint32_t h = _hash(e.ix, e.iy, e.iz) & _mask;
+			while (_slots[h].ix != INT32_MIN) {
+				h = (h + 1) & _mask;
+			}
+			_slots[h] = e;
+			o = h;
+		}
+	}
+
+ protected:
+	std::vector<voxel_entry>	_slots;
+	std::vector<uint32_t>		_order;		// 最初に現れた順の要素の位置
+	uint32_t			_mask;
+};
+
+/* ========================================================================= */
+/* function definition Section                                               */
+/* ========================================================================= */
+
+// poolがあれば並列に、無ければ呼び出しスレッドでfunc(0, n)を実行して集約する
+template <class R, class F, class M>
+static inline R
+sharaku_cloud_reduce(thread_pool *pool, const position3 *p, size_t n, R init, F func, M merge)
+{
+	if (pool) {
+		return sharaku_parallel_reduce(*pool, p, n, init, func, merge);
+	}
+	return (n == 0) ? init : merge(init, func(0, n));
+}
+
+// p[0]～p[n-1]の境界箱(逐次)
+static inline aabb3
+sharaku_aabb_serial(const position3 *p, size_t n)
+{
+	typedef sharaku_simd S;
+	aabb3 r = aabb3::none();
+	size_t i = 0;
+	if (n >= (size_t)S::width) {
+		S::f32 lx, ly, lz;
+		S::load3(&p[0].x, lx, ly, lz);
+		S::f32 hx = lx, hy = ly, hz = lz;
+		for (i = S::width; i + S::width <= n; i += S::width) {
+			S::f32 x, y, z;
+			S::load3(&p[i].x, x, y, z);
+			lx = S::min(lx, x); ly = S::min(ly, y); lz = S::min(lz, z);
+			hx = S::max(hx, x); hy = S::max(hy, y); hz = S::max(hz, z);
+		}
+		float t[6][S::width];
+		S::store(t[0], lx); S::store(t[1], ly); S::store(t[2], lz);
+		S::store(t[3], hx); S::store(t[4], hy); S::store(t[5], hz);
+		for (size_t k = 0; k < (size_t)S::width; k++) {
+			r.lo(std::min(r.lo.x, t[0][k]), std::min(r.lo.y, t[1][k]), std::min(r.lo.z, t[2][k]));
+			r.hi(std::max(r.hi.x, t[3][k]), std::max(r.hi.y, t[4][k]), std::max(r.hi.z, t[5][k]));
+		}
+	}
+	for (; i < n; i++) {
+		r.lo(std::min(r.lo.x, p[i].x), std::min(r.lo.y, p[i].y), std::min(r.lo.z, p[i].z));
+		r.hi(std::max(r.hi.x, p[i].x), std::max(r.hi.y, p[i].y), std::max(r.hi.z, p[i].z));
+	}
+	return r;
+}
+
+// p[0]～p[n-1]の座標の合計(逐次)
+static inline cloud_moments
+sharaku_centroid_serial(const position3 *p, size_t n)
+{
+	typedef sharaku_simd S;
+	cloud_moments r = cloud_moments::zero();
+	for (size_t b = 0; b < n; b += SHARAKU_CLOUD_BLOCK) {
+		const size_t e = std::min(n, b + SHARAKU_CLOUD_BLOCK);
+		S::f32 sx = S::set1(0.0f), sy = sx, sz = sx;
+		size_t i = b;
+		for (; i + S::width <= e; i += S::width) {
+			S::f32 x, y, z;
+			S::load3(&p[i].x, x, y, z);
+			sx = S::add(sx, x); sy = S::add(sy, y); sz = S::add(sz, z);
+		}
+		r.mean[0] += S::hsum(sx);
+		r.mean[1] += S::hsum(sy);
+		r.mean[2] += S::hsum(sz);
+		for (; i < e; i++) {
+			r.mean[0] += p[i].x;
+			r.mean[1] += p[i].y;
+			r.mean[2] += p[i].z;
+		}
+	}
+	r.n = n;
+	return r;
+}
+
+/*********************************************************************/
+/*! @brief p[0]～p[n-1]のモーメントを求める(逐次)
+
+	先頭の点からの偏差を単精度でSHARAKU_CLOUD_BLOCK点ずつ累積し、
+	倍精度の合計へ加える。
+
+	@param[in]      p               点の配列
+	@param[in]      n               点数
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         モーメント
+	@exception      none
+**********************************************************************/
+static inline cloud_moments
+sharaku_moments_serial(const position3 *p, size_t n)
+{
+	typedef sharaku_simd S;
+	cloud_moments r = cloud_moments::zero();
+	if (n == 0) {
+		return r;
+	}
+	// 1次(x, y, z)と2次(xx, xy, xz, yy, yz, zz)の合計
+	double d[9] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+	const position3 o = p[0];
+	const S::f32 ox = S::set1(o.x), oy = S::set1(o.y), oz = S::set1(o.z);
+	for (size_t b = 0; b < n; b += SHARAKU_CLOUD_BLOCK) {
+		const size_t e = std::min(n, b + SHARAKU_CLOUD_BLOCK);
+		S::f32 a[9];
+		for (int k = 0; k < 9; k++) {
+			a[k] = S::set1(0.0f);
+		}
+		size_t i = b;
+		for (; i + S::width <= e; i += S::width) {
+			S::f32 x, y, z;
+			S::load3(&p[i].x, x, y, z);
+			x = S::sub(x, ox); y = S::sub(y, oy); z = S::sub(z, oz);
+			a[0] = S::add(a[0], x);
+			a[1] = S::add(a[1], y);
+			a[2] = S::add(a[2], z);
+			a[3] = S::madd(x, x, a[3]);
+			a[4] = S::madd(x, y, a[4]);
+			a[5] = S::madd(x, z, a[5]);
+			a[6] = S::madd(y, y, a[6]);
+			a[7] = S::madd(y, z, a[7]);
+			a[8] = S::madd(z, z, a[8]);
+		}
+		for (int k = 0; k < 9; k++) {
+			d[k] += S::hsum(a[k]);
+		}
+		for (; i < e; i++) {
+			const double x = p[i].x - o.x, y = p[i].y - o.y, z = p[i].z - o.z;
+			d[0] += x; d[1] += y; d[2] += z;
+			d[3] += x * x; d[4] += x * y; d[5] += x * z;
+			d[6] += y * y; d[7] += y * z; d[8] += z * z;
+		}
+	}
+
+	const double inv = 1.0 / (double)n;
+	r.n = n;
+	r.mean[0] = o.x + d[0] * inv;
+	r.mean[1] = o.y + d[1] * inv;
+	r.mean[2] = o.z + d[2] * inv;
+	r.m2[0][0] = d[3] - d[0] * d[0] * inv;
+	r.m2[0][1] = d[4] - d[0] * d[1] * inv;
+	r.m2[0][2] = d[5] - d[0] * d[2] * inv;
+	r.m2[1][1] = d[6] - d[1] * d[1] * inv;
+	r.m2[1][2] = d[7] - d[1] * d[2] * inv;
+	r.m2[2][2] = d[8] - d[2] * d[2] * inv;
+	r.m2[1][0] = r.m2[0][1];
+	r.m2[2][0] = r.m2[0][2];
+	r.m2[2][1] = r.m2[1][2];
+	return r;
+}
+
+/*********************************************************************/
+/*! @brief p[0]～p[n-1]の境界箱を求める
+
+	@param[in]      p               点の配列(全て有限値であること)
+	@param[in]      n               点数
+	@param[in]      pool            処理を行うスレッドプール(NULLの場合は
+	                                呼び出しスレッドのみで行う)
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         境界箱(n = 0の場合はaabb3::none())
+	@exception      none
+**********************************************************************/
+static inline aabb3
+sharaku_aabb(const position3 *p, size_t n, thread_pool *pool = nullptr)
+{
+	return sharaku_cloud_reduce(pool, p, n, aabb3::none(),
+		[p](size_t b, size_t e) { return sharaku_aabb_serial(p + b, e - b); },
+		aabb3::merge);
+}
+
+/*********************************************************************/
+/*! @brief p[0]～p[n-1]の重心を求める
+
+	@param[in]      p               点の配列(全て有限値であること)
+	@param[in]      n               点数
+	@param[in]      pool            処理を行うスレッドプール(NULLの場合は
+	                                呼び出しスレッドのみで行う)
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         重心(n = 0の場合は原点)
+	@exception      none
+**********************************************************************/
+static inline position3
+sharaku_centroid(const position3 *p, size_t n, thread_pool *pool = nullptr)
+{
+	// 部分和をmeanに持たせて集約する
+	const cloud_moments s = sharaku_cloud_reduce(pool, p, n, cloud_moments::zero(),
+		[p](size_t b, size_t e) { return sharaku_centroid_serial(p + b, e - b); },
+		[](const cloud_moments& a, const cloud_moments& b) {
+			cloud_moments r = a;
+			r.n += b.n;
+			for (int i = 0; i < 3; i++) {
+				r.mean[i] += b.mean[i];
+			}
+			return r;
+		});
+	if (s.n == 0) {
+		return position3{0.0f, 0.0f, 0.0f};
+	}
+	const double inv = 1.0 / (double)s.n;
+	return position3{(float)(s.mean[0] * inv), (float)(s.mean[1] * inv),
+			 (float)(s.mean[2] * inv)};
+}
+
+// p[0]～p[n-1]のモーメント
+static inline cloud_moments
+sharaku_moments(const position3 *p, size_t n, thread_pool *pool = nullptr)
+{
+	return sharaku_cloud_reduce(pool, p, n, cloud_moments::zero(),
+		[p](size_t b, size_t e) { return sharaku_moments_serial(p + b, e - b); },
+		cloud_moments::merge);
+}
+
+/*********************************************************************/
+/*! @brief p[0]～p[n-1]の共分散行列を求める
+
+	平均からの偏差の積の和を点数nで割ったもの(標本共分散ではない)。
+
+	@param[in]      p               点の配列(全て有限値であること)
+	@param[in]      n               点数
+	@param[in]      pool            処理を行うスレッドプール(NULLの場合は
+	                                呼び出しスレッドのみで行う)
+	@param[out]     centroid        重心の格納先(NULLでもよい)
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         3x3の共分散行列(n = 0の場合は零行列)
+	@exception      none
+**********************************************************************/
+static inline matrix<3, 3>
+sharaku_covariance(const position3 *p, size_t n, thread_pool *pool = nullptr,
+		   position3 *centroid = nullptr)
+{
+	const cloud_moments m = sharaku_moments(p, n, pool);
+	matrix<3, 3> c = matrix<3, 3>::zero();
+	if (m.n) {
+		const double inv = 1.0 / (double)m.n;
+		for (size_t i = 0; i < 3; i++) {
+			for (size_t j = 0; j < 3; j++) {
+				c(i, j) = (float)(m.m2[i][j] * inv);
+			}
+		}
+	}
+	if (centroid) {
+		(*centroid)((float)m.mean[0], (float)m.mean[1], (float)m.mean[2]);
+	}
+	return c;
+}
+
+/*********************************************************************/
+/*! @brief p[0]～p[n-1]をボクセルごとにtableへ累積する
+
+	連続する点は同じボクセルに入ることが多いため、同じボクセルが続く間は
+	レジスタ上で合計し、ボクセルが変わった時にのみハッシュ表へ加える。
+
+	@param[out]     table           累積先
+	@param[in]      p               点の配列
+	@param[in]      n               点数
+	@param[in]      leaf            ボクセルの一辺の長さ
+	@return         none
+	@exception      std::bad_alloc  メモリ確保に失敗した
+**********************************************************************/
+static inline void
+sharaku_voxel_accumulate(voxel_table& table, const position3 *p, size_t n, float leaf)
+{
+	const float inv = 1.0f / leaf;
+	int32_t lx = 0, ly = 0, lz = 0;
+	uint32_t count = 0;
+	double sx = 0.0, sy = 0.0, sz = 0.0;
+	auto flush = [&]() {
+		if (count) {
+			voxel_entry& e = table.find(lx, ly, lz);
+			e.count	+= count;
+			e.sx	+= (float)(sx - (double)count * lx * leaf);
+			e.sy	+= (float)(sy - (double)count * ly * leaf);
+			e.sz	+= (float)(sz - (double)count * lz * leaf);
+		}
+	};
+	for (size_t i = 0; i < n; i++) {
+		const float fx = p[i].x * inv, fy = p[i].y * inv, fz = p[i].z * inv;
+		// 非有限値(NaNを含む)と範囲外の点を除外する
+		if (!(fabsf(fx) < SHARAKU_VOXEL_RANGE && fabsf(fy) < SHARAKU_VOXEL_RANGE &&
+		      fabsf(fz) < SHARAKU_VOXEL_RANGE)) {
+			continue;
+		}
+		// 切り捨てを負の方向の丸め(floor)に補正する
+		int32_t ix = (int32_t)fx, iy = (int32_t)fy, iz = (int32_t)fz;
+		ix -= (fx < (float)ix);
+		iy -= (fy < (float)iy);
+		iz -= (fz < (float)iz);
+		if (ix != lx || iy != ly || iz != lz) {
+			flush();
+			lx = ix; ly = iy; lz = iz;
+			count = 0;
+			sx = sy = sz = 0.0;
+		}
+		count++;
+		sx += p[i].x;
+		sy += p[i].y;
+		sz += p[i].z;
+	}
+	flush();
+}
+
+/*********************************************************************/
+/*! @brief ボクセルグリッドで点群を間引く
+
+	一辺leafの立方体(原点を頂点とする格子)ごとに、含まれる点の重心を
+	1点出力する。出力順は各ボクセルの点が最初に現れた順とする。
+	非有限値の点は除外する。
+	poolを指定した場合、入力をスレッド数に分割してスレッドごとの
+	ハッシュ表へ累積し、最後に先頭の表へ順に集約する。
+
+	処理時間は1スレッドで1点当たり約20～35ns(2GHzのx86コア1個で計測、
+	200万点で40～70ms)であり、大半は点ごとのボクセル番号の算出と
+	ハッシュ表の探索である。200万点を数msで処理するには16スレッド程度に
+	分割する必要がある(スレッド数に対する伸びと集約の時間は未計測)。
+
+	@param[in]      in              入力の点の配列
+	@param[in]      n               入力の点数
+	@param[in]      leaf            ボクセルの一辺の長さ(正の値)
+	@param[out]     out             間引いた点の格納先(内容は置き換える)
+	@param[in]      pool            処理を行うスレッドプール(NULLの場合は
+	                                呼び出しスレッドのみで行う)
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         出力した点数
+	@exception      std::bad_alloc  メモリ確保に失敗した
+**********************************************************************/
+static inline size_t
+sharaku_voxel_downsample(const position3 *in, size_t n, float leaf,
+			 std::vector<position3>& out, thread_pool *pool = nullptr)
+{
+	const size_t min_size = SHARAKU_PARALLEL_MIN_CHUNK / sizeof(position3);
+	size_t chunks = pool ? pool->size() : 1;
+	chunks = std::max<size_t>(1, std::min(chunks, n / min_size));
+
+	std::vector<voxel_table> tables(chunks);
+	if (chunks > 1) {
+		pool->run(chunks, [&](size_t c) {
+			const size_t b = n * c / chunks, e = n * (c + 1) / chunks;
+			sharaku_voxel_accumulate(tables[c], in + b, e - b, leaf);
+		});
+		for (size_t c = 1; c < chunks; c++) {
+			tables[0].merge(tables[c]);
+		}
+	} else {
+		sharaku_voxel_accumulate(tables[0], in, n, leaf);
+	}
+
+	const voxel_table& t = tables[0];
+	out.resize(t.size());
+	for (size_t i = 0; i < t.size(); i++) {
+		const voxel_entry& e = t[i];
+		const double w = 1.0 / (double)e.count;
+		out[i]((float)((double)e.ix * leaf + e.sx * w), (float)((double)e.iy * leaf + e.sy * w),
+		       (float)((double)e.iz * leaf + e.sz * w));
+	}
+	return out.size();
+}
+
+
+#endif // SHARAKU_MM_POINT_CLOUD_H_
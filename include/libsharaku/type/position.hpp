@@ -27,20 +27,32 @@
 #ifndef SHARAKU_MM_POSITION_H_
 #define SHARAKU_MM_POSITION_H_
 
+#include <stddef.h>
+#include <type_traits>
 #include <libsharaku/type/vector.hpp>
 
-struct position3 {
+/*! @class basic_position3
+    @brief  3次元座標構造体
+
+	トリビアルコピー可能な標準レイアウト型であり、memcpy/memmoveによる
+	一括コピーが可能である。集成体初期化 position3{x, y, z} により
+	コンパイル時定数として使用できる。
+	要素の型Tにはfloat, double, q16_16(固定小数点)を使用できる。
+*/
+template <class T>
+struct basic_position3 {
  public:
-	float x; ///< x座標
-	float y; ///< y座標
-	float z; ///< z座標
+	T x; ///< x座標
+	T y; ///< y座標
+	T z; ///< z座標
 
  public:
 	/*********************************************************************/
-	/*!@brief x, y, zを代入する
+	/*! @brief x, y, zを代入する
+
 		@param[in]      pos_x           新規設定を行うX座標
 		@param[in]      pos_y           新規設定を行うY座標
-		@param[in]      pos_z           新規設定を行うZ座標(省略時は0.0fとなる)
+		@param[in]      pos_z           新規設定を行うZ座標(省略時は0となる)
 		@par            Refer
 		- 参照するグローバル変数 none
 		@par            Modify
@@ -48,119 +60,11 @@ struct position3 {
 		@return         設定後の3次元座標構造体
 		@exception      none
 	**********************************************************************/
-	position3& operator()(float pos_x, float pos_y, float pos_z = 0.0f) {
+	constexpr basic_position3& operator()(T pos_x, T pos_y, T pos_z = T()) {
 		x = pos_x; y = pos_y; z = pos_z;
 		return (*this);
 	}
 
-	/*********************************************************************/
-	/*! @brief position3構造体を代入する
-
-		@param[in]      pos             代入する構造体
-		@par            Refer
-		- 参照するグローバル変数 none
-		@par            Modify
-		- 変更するグローバル変数 none
-		@return         設定後の3次元座標構造体
-		@exception      none
-	**********************************************************************/
-	position3& operator=(position3& pos) {
-		x = pos.x; y = pos.y; z = pos.z;
-		return (*this);
-	}
-	position3& operator=(const position3& pos) {
-		x = pos.x; y = pos.y; z = pos.z;
-		return (*this);
-	}
-
-	/*********************************************************************/
-	/*! @brief 各座標ごとに加算を行う
-
-		@param[in]      pos             加算するposition3
-		@par            Refer
-		- 参照するグローバル変数 none
-		@par            Modify
-		- 変更するグローバル変数 none
-		@return         加算結果
-		@exception      none
-	**********************************************************************/
-	position3 operator+(position3& pos) {
-		position3 result;
-		result.x = x + pos.x; result.y = y + pos.y; result.z = z + pos.z;
-		return result;
-	}
-	position3 operator+(const position3& pos) {
-		position3 result;
-		result.x = x + pos.x; result.y = y + pos.y; result.z = z + pos.z;
-		return result;
-	}
-
-	/*********************************************************************/
-	/*! @brief 各座標ごとに減算を行う
-
-		@param[in]      pos             減算するposition3
-		@par            Refer
-		- 参照するグローバル変数 none
-		@par            Modify
-		- 変更するグローバル変数 none
-		@return         減算結果
-		@exception      none
-	**********************************************************************/
-	position3 operator-(position3& pos) {
-		position3 result;
-		result.x = x - pos.x; result.y = y - pos.y; result.z = z - pos.z;
-		return result;
-	}
-	position3 operator-(const position3& pos) {
-		position3 result;
-		result.x = x - pos.x; result.y = y - pos.y; result.z = z - pos.z;
-		return result;
-	}
-
-	/*********************************************************************/
-	/*! @brief 各座標ごとに加算を行う
-
-		@param[in]      vec             加算するvector3
-		@par            Refer
-		- 参照するグローバル変数 none
-		@par            Modify
-		- 変更するグローバル変数 none
-		@return         加算結果
-		@exception      none
-	**********************************************************************/
-	position3 operator+(vector3& vec) {
-		position3 result;
-		result.x = x + vec.x; result.y = y + vec.y; result.z = z + vec.z;
-		return result;
-	}
-	position3 operator+(const vector3& vec) {
-		position3 result;
-		result.x = x + vec.x; result.y = y + vec.y; result.z = z + vec.z;
-		return result;
-	}
-
-	/*********************************************************************/
-	/*! @brief 各座標ごとに減算を行う
-
-		@param[in]      vec             減算するvector3
-		@par            Refer
-		- 参照するグローバル変数 none
-		@par            Modify
-		- 変更するグローバル変数 none
-		@return         減算結果
-		@exception      none
-	**********************************************************************/
-	position3 operator-(vector3& vec) {
-		position3 result;
-		result.x = x - vec.x; result.y = y - vec.y; result.z = z - vec.z;
-		return result;
-	}
-	position3 operator-(const vector3& vec) {
-		position3 result;
-		result.x = x - vec.x; result.y = y - vec.y; result.z = z - vec.z;
-		return result;
-	}
-
 	/*********************************************************************/
 	/*! @brief 各座標ごとに加算を行い、結果を自身に反映する
 
@@ -172,11 +76,7 @@ struct position3 {
 		@return         加算結果
 		@exception      none
 	**********************************************************************/
-	position3& operator+=(position3& pos) {
-		x += pos.x; y += pos.y; z += pos.z;
-		return (*this);
-	}
-	position3& operator+=(const position3& pos) {
+	constexpr basic_position3& operator+=(const basic_position3& pos) {
 		x += pos.x; y += pos.y; z += pos.z;
 		return (*this);
 	}
@@ -192,11 +92,7 @@ struct position3 {
 		@return         減算結果
 		@exception      none
 	**********************************************************************/
-	position3& operator-=(position3& pos) {
-		x -= pos.x; y -= pos.y; z -= pos.z;
-		return (*this);
-	}
-	position3& operator-=(const position3& pos) {
+	constexpr basic_position3& operator-=(const basic_position3& pos) {
 		x -= pos.x; y -= pos.y; z -= pos.z;
 		return (*this);
 	}
@@ -212,11 +108,7 @@ struct position3 {
 		@return         加算結果
 		@exception      none
 	**********************************************************************/
-	position3& operator+=(vector3& vec) {
-		x += vec.x; y += vec.y; z += vec.z;
-		return (*this);
-	}
-	position3& operator+=(const vector3& vec) {
+	constexpr basic_position3& operator+=(const basic_vector3<T>& vec) {
 		x += vec.x; y += vec.y; z += vec.z;
 		return (*this);
 	}
@@ -232,15 +124,97 @@ struct position3 {
 		@return         減算結果
 		@exception      none
 	**********************************************************************/
-	position3& operator-=(vector3& vec) {
-		x -= vec.x; y -= vec.y; z -= vec.z;
-		return (*this);
-	}
-	position3& operator-=(const vector3& vec) {
+	constexpr basic_position3& operator-=(const basic_vector3<T>& vec) {
 		x -= vec.x; y -= vec.y; z -= vec.z;
 		return (*this);
 	}
 };
 
+typedef basic_position3<float>	position3;	///< 単精度
+typedef basic_position3<double>	position3d;	///< 倍精度
+
+/*********************************************************************/
+/*! @brief 各座標ごとに加算を行う
+
+	@param[in]      lhs             加算されるposition3
+	@param[in]      rhs             加算するposition3
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         加算結果
+	@exception      none
+**********************************************************************/
+template <class T>
+constexpr basic_position3<T>
+operator+(const basic_position3<T>& lhs, const basic_position3<T>& rhs)
+{
+	return basic_position3<T>{lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z};
+}
+
+/*********************************************************************/
+/*! @brief 各座標ごとに減算を行う
+
+	@param[in]      lhs             減算されるposition3
+	@param[in]      rhs             減算するposition3
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         減算結果
+	@exception      none
+**********************************************************************/
+template <class T>
+constexpr basic_position3<T>
+operator-(const basic_position3<T>& lhs, const basic_position3<T>& rhs)
+{
+	return basic_position3<T>{lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z};
+}
+
+/*********************************************************************/
+/*! @brief 各座標ごとに加算を行う
+
+	@param[in]      lhs             加算されるposition3
+	@param[in]      rhs             加算するvector3
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         加算結果
+	@exception      none
+**********************************************************************/
+template <class T>
+constexpr basic_position3<T>
+operator+(const basic_position3<T>& lhs, const basic_vector3<T>& rhs)
+{
+	return basic_position3<T>{lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z};
+}
+
+/*********************************************************************/
+/*! @brief 各座標ごとに減算を行う
+
+	@param[in]      lhs             減算されるposition3
+	@param[in]      rhs             減算するvector3
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         減算結果
+	@exception      none
+**********************************************************************/
+template <class T>
+constexpr basic_position3<T>
+operator-(const basic_position3<T>& lhs, const basic_vector3<T>& rhs)
+{
+	return basic_position3<T>{lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z};
+}
+
+// バイナリ互換性のためのレイアウト固定
+static_assert(std::is_trivially_copyable<position3>::value, "position3 must be trivially copyable");
+static_assert(std::is_standard_layout<position3>::value, "position3 must be standard layout");
+static_assert(sizeof(position3) == 12, "position3 must be 12 bytes");
+static_assert(offsetof(position3, x) == 0 && offsetof(position3, y) == 4 &&
+	      offsetof(position3, z) == 8, "position3 layout must be x, y, z");
+
 
 #endif // SHARAKU_MM_POSITION_H_
@@ -0,0 +1,300 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_MM_QUATERNION_H_
+#define SHARAKU_MM_QUATERNION_H_
+
+#include <stddef.h>
+#include <math.h>
+#include <type_traits>
+#include <libsharaku/type/vector.hpp>
+#include <libsharaku/type/position.hpp>
+#include <libsharaku/type/rotation.hpp>
+
+/* ========================================================================= */
+/* struct definition Section                                                 */
+/* ========================================================================= */
+
+/*! @class quaternion
+    @brief  姿勢(回転)を表す四元数構造体
+
+	rotation3との相互変換では、rotation3の各要素を度単位の回転角とし、
+	x軸(ロール)、y軸(ピッチ)、z軸(ヨー)の順に固定座標系で回転する
+	(R = Rz * Ry * Rx)ものとする。
+	回転に使用する四元数は正規化されていること。
+*/
+struct quaternion {
+ public:
+	float w; ///< 実部
+	float x; ///< 虚部i
+	float y; ///< 虚部j
+	float z; ///< 虚部k
+
+ public:
+	/*********************************************************************/
+	/*! @brief w, x, y, zを代入する
+
+		@param[in]      q_w             新規設定を行う実部
+		@param[in]      q_x             新規設定を行う虚部i
+		@param[in]      q_y             新規設定を行う虚部j
+		@param[in]      q_z             新規設定を行う虚部k
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         設定後の四元数構造体
+		@exception      none
+	**********************************************************************/
+	constexpr quaternion& operator()(float q_w, float q_x, float q_y, float q_z) {
+		w = q_w; x = q_x; y = q_y; z = q_z;
+		return (*this);
+	}
+
+	/*********************************************************************/
+	/*! @brief 回転を合成し、結果を自身に反映する
+
+		@param[in]      q               後から適用する回転
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         合成結果(qを適用した後に自身を適用する回転)
+		@exception      none
+	**********************************************************************/
+	constexpr quaternion& operator*=(const quaternion& q) {
+		const float rw = w * q.w - x * q.x - y * q.y - z * q.z;
+		const float rx = w * q.x + x * q.w + y * q.z - z * q.y;
+		const float ry = w * q.y - x * q.z + y * q.w + z * q.x;
+		const float rz = w * q.z + x * q.y - y * q.x + z * q.w;
+		w = rw; x = rx; y = ry; z = rz;
+		return (*this);
+	}
+
+	// 共役(正規化されている場合は逆回転)を返す
+	constexpr quaternion conjugate(void) const {
+		return quaternion{w, -x, -y, -z};
+	}
+
+	// ノルムの2乗を返す
+	constexpr float norm2(void) const {
+		return w * w + x * x + y * y + z * z;
+	}
+
+	// 正規化した四元数を返す
+	quaternion normalize(void) const {
+		const float inv = 1.0f / sqrtf(norm2());
+		return quaternion{w * inv, x * inv, y * inv, z * inv};
+	}
+
+	/*********************************************************************/
+	/*! @brief vector3を回転する
+
+		t = 2 * (q.xyz × v)、v' = v + w * t + q.xyz × t による
+		15回の乗算で計算する。
+
+		@param[in]      vec             回転するvector3
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         回転後のvector3
+		@exception      none
+	**********************************************************************/
+	constexpr vector3 rotate(const vector3& vec) const {
+		float tx = y * vec.z - z * vec.y;
+		float ty = z * vec.x - x * vec.z;
+		float tz = x * vec.y - y * vec.x;
+		tx += tx; ty += ty; tz += tz;
+		return vector3{vec.x + w * tx + (y * tz - z * ty),
+			       vec.y + w * ty + (z * tx - x * tz),
+			       vec.z + w * tz + (x * ty - y * tx)};
+	}
+	constexpr position3 rotate(const position3& pos) const {
+		const vector3 v = rotate(vector3{pos.x, pos.y, pos.z});
+		return position3{v.x, v.y, v.z};
+	}
+
+	/*********************************************************************/
+	/*! @brief n個のvector3を同一の姿勢で回転する
+
+		回転行列の9要素を一度だけ求め、1要素当たり9回の乗算で回転する。
+
+		@param[in]      in              回転するvector3の配列
+		@param[out]     out             回転結果の格納先(inと同一でもよい)
+		@param[in]      n               要素数
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         none
+		@exception      none
+	**********************************************************************/
+	void rotate(const vector3 *in, vector3 *out, size_t n) const {
+		const float xx = x * x, yy = y * y, zz = z * z;
+		const float xy = x * y, xz = x * z, yz = y * z;
+		const float wx = w * x, wy = w * y, wz = w * z;
+		const float m00 = 1.0f - 2.0f * (yy + zz);
+		const float m01 = 2.0f * (xy - wz);
+		const float m02 = 2.0f * (xz + wy);
+		const float m10 = 2.0f * (xy + wz);
+		const float m11 = 1.0f - 2.0f * (xx + zz);
+		const float m12 = 2.0f * (yz - wx);
+		const float m20 = 2.0f * (xz - wy);
+		const float m21 = 2.0f * (yz + wx);
+		const float m22 = 1.0f - 2.0f * (xx + yy);
+		for (size_t i = 0; i < n; i++) {
+			const float vx = in[i].x, vy = in[i].y, vz = in[i].z;
+			out[i].x = m00 * vx + m01 * vy + m02 * vz;
+			out[i].y = m10 * vx + m11 * vy + m12 * vz;
+			out[i].z = m20 * vx + m21 * vy + m22 * vz;
+		}
+	}
+
+	/*********************************************************************/
+	/*! @brief rotation3(度単位のオイラー角)を四元数へ変換する
+
+		@param[in]      rot             変換するrotation3
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         正規化された四元数
+		@exception      none
+	**********************************************************************/
+	static quaternion from_rotation(const rotation3& rot) {
+		const float hx = rot.x * (M_PI_180 * 0.5f);
+		const float hy = rot.y * (M_PI_180 * 0.5f);
+		const float hz = rot.z * (M_PI_180 * 0.5f);
+		const float cx = cosf(hx), sx = sinf(hx);
+		const float cy = cosf(hy), sy = sinf(hy);
+		const float cz = cosf(hz), sz = sinf(hz);
+		return quaternion{cx * cy * cz + sx * sy * sz,
+				  sx * cy * cz - cx * sy * sz,
+				  cx * sy * cz + sx * cy * sz,
+				  cx * cy * sz - sx * sy * cz};
+	}
+
+	/*********************************************************************/
+	/*! @brief 四元数をrotation3(度単位のオイラー角)へ変換する
+
+		y軸の回転角は[-90, 90]、x, z軸は(-180, 180]の範囲となる。
+
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         変換後のrotation3
+		@exception      none
+	**********************************************************************/
+	rotation3 to_rotation(void) const {
+		float sp = 2.0f * (w * y - z * x);
+		sp = (sp > 1.0f) ? 1.0f : ((sp < -1.0f) ? -1.0f : sp);
+		return rotation3{
+			atan2f(2.0f * (w * x + y * z), 1.0f - 2.0f * (x * x + y * y)) / M_PI_180,
+			asinf(sp) / M_PI_180,
+			atan2f(2.0f * (w * z + x * y), 1.0f - 2.0f * (y * y + z * z)) / M_PI_180};
+	}
+
+	// 回転なしを表す四元数
+	static constexpr quaternion identity(void) {
+		return quaternion{1.0f, 0.0f, 0.0f, 0.0f};
+	}
+
+	/*********************************************************************/
+	/*! @brief 2つの姿勢を線形補間し、正規化する(nlerp)
+
+		@param[in]      a               t = 0での姿勢
+		@param[in]      b               t = 1での姿勢
+		@param[in]      t               補間係数(0～1)
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         補間結果(最短経路)
+		@exception      none
+	**********************************************************************/
+	static quaternion nlerp(const quaternion& a, const quaternion& b, float t) {
+		const float d = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+		const float tb = (d < 0.0f) ? -t : t;
+		const float ta = 1.0f - t;
+		return quaternion{ta * a.w + tb * b.w, ta * a.x + tb * b.x,
+				  ta * a.y + tb * b.y, ta * a.z + tb * b.z}.normalize();
+	}
+
+	/*********************************************************************/
+	/*! @brief 2つの姿勢を球面線形補間する(slerp)
+
+		2つの姿勢がほぼ一致する場合はnlerpで補間する。
+
+		@param[in]      a               t = 0での姿勢
+		@param[in]      b               t = 1での姿勢
+		@param[in]      t               補間係数(0～1)
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         補間結果(最短経路)
+		@exception      none
+	**********************************************************************/
+	static quaternion slerp(const quaternion& a, const quaternion& b, float t) {
+		float d = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+		const float sign = (d < 0.0f) ? -1.0f : 1.0f;
+		d *= sign;
+		if (d > 0.9995f) {
+			return nlerp(a, b, t);
+		}
+		const float theta = acosf(d);
+		const float inv = 1.0f / sinf(theta);
+		const float ta = sinf((1.0f - t) * theta) * inv;
+		const float tb = sinf(t * theta) * inv * sign;
+		return quaternion{ta * a.w + tb * b.w, ta * a.x + tb * b.x,
+				  ta * a.y + tb * b.y, ta * a.z + tb * b.z};
+	}
+};
+
+/*********************************************************************/
+/*! @brief 回転を合成する
+
+	@param[in]      lhs             後に適用する回転
+	@param[in]      rhs             先に適用する回転
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         合成結果(rhsを適用した後にlhsを適用する回転)
+	@exception      none
+**********************************************************************/
+constexpr quaternion
+operator*(const quaternion& lhs, const quaternion& rhs)
+{
+	return quaternion(lhs) *= rhs;
+}
+
+static_assert(std::is_trivially_copyable<quaternion>::value, "quaternion must be trivially copyable");
+static_assert(sizeof(quaternion) == 16, "quaternion must be 16 bytes");
+
+
+#endif // SHARAKU_MM_QUATERNION_H_
@@ -0,0 +1,595 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_MM_REGISTRATION_H_
+#define SHARAKU_MM_REGISTRATION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <libsharaku/type/simd.hpp>
+#include <libsharaku/type/vector.hpp>
+#include <libsharaku/type/position.hpp>
+#include <libsharaku/type/rotation.hpp>
+#include <libsharaku/type/transform.hpp>
+#include <libsharaku/type/geometry.hpp>
+#include <libsharaku/type/parallel.hpp>
+#include <libsharaku/type/point-cloud.hpp>
+#include <libsharaku/type/spatial-index.hpp>
+
+// ヤコビ法の最大掃引数(3x3では通常4～6回で収束する)
+#define SHARAKU_JACOBI_SWEEPS	16
+
+// ICPで一度に座標変換する点数(スタック上の作業領域の大きさ)
+#define SHARAKU_ICP_BLOCK	256
+
+/* ========================================================================= */
+/* struct definition Section                                                 */
+/* ========================================================================= */
+
+/*! @class cross_moments
+    @brief  対応点の組(s[i], d[i])の点数、平均、相互共分散の和
+
+	h[j][k]は(s[i] - ms)のj成分と(d[i] - md)のk成分の積の和である。
+	cloud_momentsと同様に、部分集合ごとに求めたものをmerge()で集約する。
+*/
+struct cross_moments {
+ public:
+	size_t	n;		///< 組の数
+	double	ms[3];		///< sの平均
+	double	md[3];		///< dの平均
+	double	h[3][3];	///< 平均からの偏差の積の和
+
+ public:
+	static cross_moments zero(void) {
+		return cross_moments{0, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0},
+				     {{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}}};
+	}
+
+	// 2つの部分集合のモーメントを集約する
+	static cross_moments merge(const cross_moments& a, const cross_moments& b) {
+		if (a.n == 0) {
+			return b;
+		}
+		if (b.n == 0) {
+			return a;
+		}
+		cross_moments r;
+		r.n = a.n + b.n;
+		const double wb = (double)b.n / (double)r.n;
+		const double f = (double)a.n * wb;
+		double ds[3], dd[3];
+		for (int i = 0; i < 3; i++) {
+			ds[i] = b.ms[i] - a.ms[i];
+			dd[i] = b.md[i] - a.md[i];
+			r.ms[i] = a.ms[i] + ds[i] * wb;
+			r.md[i] = a.md[i] + dd[i] * wb;
+		}
+		for (int i = 0; i < 3; i++) {
+			for (int j = 0; j < 3; j++) {
+				r.h[i][j] = a.h[i][j] + b.h[i][j] + ds[i] * dd[j] * f;
+			}
+		}
+		return r;
+	}
+};
+
+/*! @class icp_params
+    @brief  sharaku_icp()の設定
+*/
+struct icp_params {
+ public:
+	uint32_t	max_iterations;		///< 最大反復回数
+	float		max_distance;		///< 対応点とする最大距離
+	float		epsilon_translation;	///< 収束とみなす平行移動の更新量
+	float		epsilon_rotation;	///< 収束とみなす回転の更新量(度)
+
+ public:
+	static icp_params defaults(void) {
+		return icp_params{30, 1.0f, 1.0e-4f, 1.0e-3f};
+	}
+};
+
+/*! @class icp_result
+    @brief  sharaku_icp()の結果
+
+	inliersとrmseは最後の反復で対応付けた点についての値である。
+*/
+struct icp_result {
+ public:
+	transform3	transform;	///< srcをtargetへ合わせる座標変換
+	uint32_t	iterations;	///< 反復回数
+	size_t		inliers;	///< 対応付けた点数
+	float		rmse;		///< 対応点間の距離の二乗平均平方根
+	bool		converged;	///< 更新量が収束条件を満たした
+};
+
+/* ========================================================================= */
+/* function definition Section                                               */
+/* ========================================================================= */
+
+/*********************************************************************/
+/*! @brief 組(s[i], d[i])のモーメントを求める(逐次)
+
+	先頭の組からの偏差を単精度でSHARAKU_CLOUD_BLOCK組ずつ累積し、
+	倍精度の合計へ加える。
+
+	@param[in]      s               点の配列
+	@param[in]      d               sに対応する点の配列
+	@param[in]      n               組の数
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         モーメント
+	@exception      none
+**********************************************************************/
+static inline cross_moments
+sharaku_cross_moments_serial(const position3 *s, const position3 *d, size_t n)
+{
+	typedef sharaku_simd S;
+	cross_moments r = cross_moments::zero();
+	if (n == 0) {
+		return r;
+	}
+	// sの合計(3)、dの合計(3)、積の合計(9)
+	double t[15];
+	std::fill(t, t + 15, 0.0);
+	const position3 so = s[0], d0 = d[0];
+	const S::f32 sox = S::set1(so.x), soy = S::set1(so.y), soz = S::set1(so.z);
+	const S::f32 dox = S::set1(d0.x), doy = S::set1(d0.y), doz = S::set1(d0.z);
+	for (size_t b = 0; b < n; b += SHARAKU_CLOUD_BLOCK) {
+		const size_t e = std::min(n, b + SHARAKU_CLOUD_BLOCK);
+		S::f32 a[15];
+		for (int k = 0; k < 15; k++) {
+			a[k] = S::set1(0.0f);
+		}
+		size_t i = b;
+		for (; i + S::width <= e; i += S::width) {
+			S::f32 sx, sy, sz, dx, dy, dz;
+			S::load3(&s[i].x, sx, sy, sz);
+			S::load3(&d[i].x, dx, dy, dz);
+			sx = S::sub(sx, sox); sy = S::sub(sy, soy); sz = S::sub(sz, soz);
+			dx = S::sub(dx, dox); dy = S::sub(dy, doy); dz = S::sub(dz, doz);
+			a[0] = S::add(a[0], sx);
+			a[1] = S::add(a[1], sy);
+			a[2] = S::add(a[2], sz);
+			a[3] = S::add(a[3], dx);
+			a[4] = S::add(a[4], dy);
+			a[5] = S::add(a[5], dz);
+			a[6] = S::madd(sx, dx, a[6]);
+			a[7] = S::madd(sx, dy, a[7]);
+			a[8] = S::madd(sx, dz, a[8]);
+			a[9] = S::madd(sy, dx, a[9]);
+			a[10] = S::madd(sy, dy, a[10]);
+			a[11] = S::madd(sy, dz, a[11]);
+			a[12] = S::madd(sz, dx, a[12]);
+			a[13] = S::madd(sz, dy, a[13]);
+			a[14] = S::madd(sz, dz, a[14]);
+		}
+		for (int k = 0; k < 15; k++) {
+			t[k] += S::hsum(a[k]);
+		}
+		for (; i < e; i++) {
+			const double v[6] = {s[i].x - so.x, s[i].y - so.y, s[i].z - so.z,
+					     d[i].x - d0.x, d[i].y - d0.y, d[i].z - d0.z};
+			for (int k = 0; k < 6; k++) {
+				t[k] += v[k];
+			}
+			for (int j = 0; j < 3; j++) {
+				for (int k = 0; k < 3; k++) {
+					t[6 + j * 3 + k] += v[j] * v[3 + k];
+				}
+			}
+		}
+	}
+
+	const double inv = 1.0 / (double)n;
+	const double o[6] = {so.x, so.y, so.z, d0.x, d0.y, d0.z};
+	r.n = n;
+	for (int k = 0; k < 3; k++) {
+		r.ms[k] = o[k] + t[k] * inv;
+		r.md[k] = o[3 + k] + t[3 + k] * inv;
+	}
+	for (int j = 0; j < 3; j++) {
+		for (int k = 0; k < 3; k++) {
+			r.h[j][k] = t[6 + j * 3 + k] - t[j] * t[3 + k] * inv;
+		}
+	}
+	return r;
+}
+
+// 組(s[i], d[i])のモーメント
+static inline cross_moments
+sharaku_cross_moments(const position3 *s, const position3 *d, size_t n,
+		      thread_pool *pool = nullptr)
+{
+	return sharaku_cloud_reduce(pool, s, n, cross_moments::zero(),
+		[s, d](size_t b, size_t e) {
+			return sharaku_cross_moments_serial(s + b, d + b, e - b);
+		},
+		cross_moments::merge);
+}
+
+/*********************************************************************/
+/*! @brief 3x3対称行列の固有値分解をヤコビ法で行う
+
+	@param[in,out]  a               対称行列(破壊される)
+	@param[out]     w               固有値(降順)
+	@param[out]     v               固有ベクトル(列ベクトル、wの順)
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         none
+	@exception      none
+**********************************************************************/
+static inline void
+sharaku_jacobi3(double a[3][3], double w[3], double v[3][3])
+{
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			v[i][j] = (i == j) ? 1.0 : 0.0;
+		}
+	}
+	static const int pq[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+	for (int sweep = 0; sweep < SHARAKU_JACOBI_SWEEPS; sweep++) {
+		const double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+		const double diag = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+		if (off <= diag * 1.0e-30) {
+			break;
+		}
+		for (const int *r : pq) {
+			const int p = r[0], q = r[1];
+			if (a[p][q] == 0.0) {
+				continue;
+			}
+			// a[p][q]を0とする回転(c, s)
+			const double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+			const double t = ((theta < 0.0) ? -1.0 : 1.0) /
+					 (fabs(theta) + sqrt(theta * theta + 1.0));
+			const double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+			for (int k = 0; k < 3; k++) {
+				const double kp = a[k][p], kq = a[k][q];
+				a[k][p] = c * kp - s * kq;
+				a[k][q] = s * kp + c * kq;
+			}
+			for (int k = 0; k < 3; k++) {
+				const double pk = a[p][k], qk = a[q][k];
+				a[p][k] = c * pk - s * qk;
+				a[q][k] = s * pk + c * qk;
+			}
+			for (int k = 0; k < 3; k++) {
+				const double kp = v[k][p], kq = v[k][q];
+				v[k][p] = c * kp - s * kq;
+				v[k][q] = s * kp + c * kq;
+			}
+		}
+	}
+
+	// 固有値の降順に並べ替える
+	for (int i = 0; i < 3; i++) {
+		w[i] = a[i][i];
+	}
+	for (int i = 0; i < 2; i++) {
+		for (int j = i + 1; j < 3; j++) {
+			if (w[j] > w[i]) {
+				std::swap(w[i], w[j]);
+				for (int k = 0; k < 3; k++) {
+					std::swap(v[k][i], v[k][j]);
+				}
+			}
+		}
+	}
+}
+
+// 3次元ベクトル(倍精度)の演算
+static inline double
+sharaku_dot3(const double a[3], const double b[3])
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+static inline void
+sharaku_cross3(const double a[3], const double b[3], double r[3])
+{
+	r[0] = a[1] * b[2] - a[2] * b[1];
+	r[1] = a[2] * b[0] - a[0] * b[2];
+	r[2] = a[0] * b[1] - a[1] * b[0];
+}
+// aを正規化する(長さがeps以下の場合はfalse)
+static inline bool
+sharaku_normalize3(double a[3], double eps)
+{
+	const double l = sqrt(sharaku_dot3(a, a));
+	if (!(l > eps)) {
+		return false;
+	}
+	for (int k = 0; k < 3; k++) {
+		a[k] /= l;
+	}
+	return true;
+}
+
+/*********************************************************************/
+/*! @brief モーメントから最小二乗の剛体変換を求める(Kabschの方法)
+
+	Σ|R * s[i] + t - d[i]|^2を最小とする回転Rと平行移動tを求める。
+	H = U * Σ * V^Tの特異値分解は、H^T * Hの固有値分解(V, Σ^2)と
+	u = H * v / σから求め、R = V * U^Tとする。
+	第3の左特異ベクトルをu1 × u2とし、det(V) < 0の場合はv3の符号を
+	反転することで、鏡映を含まない回転を得る(点群が平面上にあり
+	σ3 = 0の場合も同じ扱いとなる)。
+	点が直線上にある場合、直線まわりの回転は不定のため任意の1つを返す。
+	全ての点が一致する場合は回転なしとする。
+
+	@param[in]      m               組(s[i], d[i])のモーメント
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         sをdへ合わせる座標変換
+	@exception      none
+**********************************************************************/
+static inline transform3
+sharaku_kabsch_solve(const cross_moments& m)
+{
+	double r[3][3] = {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}};
+
+	// A = H^T * H
+	double a[3][3];
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			a[i][j] = m.h[0][i] * m.h[0][j] + m.h[1][i] * m.h[1][j] + m.h[2][i] * m.h[2][j];
+		}
+	}
+	double w[3], v[3][3];
+	sharaku_jacobi3(a, w, v);
+
+	// 左特異ベクトル u = H * v / σ (u1, u2をグラム・シュミットで直交化)
+	const double eps = sqrt(fabs(w[0])) * 1.0e-9;
+	double u[3][3];
+	for (int c = 0; c < 2; c++) {
+		for (int k = 0; k < 3; k++) {
+			u[c][k] = m.h[k][0] * v[0][c] + m.h[k][1] * v[1][c] + m.h[k][2] * v[2][c];
+		}
+	}
+	if (sharaku_normalize3(u[0], eps)) {
+		const double d = sharaku_dot3(u[1], u[0]);
+		for (int k = 0; k < 3; k++) {
+			u[1][k] -= d * u[0][k];
+		}
+		if (!sharaku_normalize3(u[1], eps)) {
+			// 直線上の点: u1に直交する任意の単位ベクトル
+			const double e[3] = {(fabs(u[0][0]) < 0.6) ? 1.0 : 0.0,
+					     (fabs(u[0][0]) < 0.6) ? 0.0 : 1.0, 0.0};
+			sharaku_cross3(u[0], e, u[1]);
+			sharaku_normalize3(u[1], 0.0);
+		}
+		sharaku_cross3(u[0], u[1], u[2]);
+
+		// det(V) < 0ならv3を反転する
+		double vc[3][3];
+		for (int c = 0; c < 3; c++) {
+			for (int k = 0; k < 3; k++) {
+				vc[c][k] = v[k][c];
+			}
+		}
+		double x[3];
+		sharaku_cross3(vc[0], vc[1], x);
+		if (sharaku_dot3(x, vc[2]) < 0.0) {
+			for (int k = 0; k < 3; k++) {
+				vc[2][k] = -vc[2][k];
+			}
+		}
+		// R = V * U^T
+		for (int i = 0; i < 3; i++) {
+			for (int j = 0; j < 3; j++) {
+				r[i][j] = vc[0][i] * u[0][j] + vc[1][i] * u[1][j] + vc[2][i] * u[2][j];
+			}
+		}
+	}
+
+	transform3 t;
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			t.rot.m[i][j] = (float)r[i][j];
+		}
+	}
+	t.trans((float)(m.md[0] - (r[0][0] * m.ms[0] + r[0][1] * m.ms[1] + r[0][2] * m.ms[2])),
+		(float)(m.md[1] - (r[1][0] * m.ms[0] + r[1][1] * m.ms[1] + r[1][2] * m.ms[2])),
+		(float)(m.md[2] - (r[2][0] * m.ms[0] + r[2][1] * m.ms[1] + r[2][2] * m.ms[2])));
+	return t;
+}
+
+/*********************************************************************/
+/*! @brief 対応点の組から最小二乗の剛体変換を求める
+
+	@param[in]      src             変換元の点の配列
+	@param[in]      dst             src[i]に対応する点の配列
+	@param[in]      n               組の数
+	@param[out]     out             srcをdstへ合わせる座標変換
+	                                (dst[i] ≒ out.apply(src[i]))
+	@param[in]      pool            処理を行うスレッドプール(NULLの場合は
+	                                呼び出しスレッドのみで行う)
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         false: 組が無い(outは変更しない)
+	@exception      none
+**********************************************************************/
+static inline bool
+sharaku_kabsch(const position3 *src, const position3 *dst, size_t n,
+	       transform3& out, thread_pool *pool = nullptr)
+{
+	if (n == 0) {
+		return false;
+	}
+	out = sharaku_kabsch_solve(sharaku_cross_moments(src, dst, n, pool));
+	return true;
+}
+
+// 対応点の組から回転(度単位のオイラー角)と平行移動を求める
+static inline bool
+sharaku_kabsch(const position3 *src, const position3 *dst, size_t n,
+	       rotation3& rot, vector3& trans, thread_pool *pool = nullptr)
+{
+	transform3 t;
+	if (!sharaku_kabsch(src, dst, n, t, pool)) {
+		return false;
+	}
+	rot = t.rot.to_rotation();
+	trans = t.trans;
+	return true;
+}
+
+// 回転行列の回転角(度)
+static inline float
+sharaku_rotation_angle(const rotation_matrix3& r)
+{
+	const float s = 0.5f * sqrtf((r.m[2][1] - r.m[1][2]) * (r.m[2][1] - r.m[1][2]) +
+				     (r.m[0][2] - r.m[2][0]) * (r.m[0][2] - r.m[2][0]) +
+				     (r.m[1][0] - r.m[0][1]) * (r.m[1][0] - r.m[0][1]));
+	const float c = 0.5f * (r.m[0][0] + r.m[1][1] + r.m[2][2] - 1.0f);
+	return atan2f(s, c) / M_PI_180;
+}
+
+/*! @class icp_sums
+    @brief  ICPの1反復で対応付けた組のモーメントと距離の2乗の和
+*/
+struct icp_sums {
+ public:
+	cross_moments	m;	///< 対応点の組のモーメント
+	double		sse;	///< 距離の2乗の和
+
+ public:
+	static icp_sums zero(void) { return icp_sums{cross_moments::zero(), 0.0}; }
+	static icp_sums merge(const icp_sums& a, const icp_sums& b) {
+		return icp_sums{cross_moments::merge(a.m, b.m), a.sse + b.sse};
+	}
+};
+
+/*********************************************************************/
+/*! @brief src[0]～src[n-1]をtで変換して最近傍と対応付ける
+
+	SHARAKU_ICP_BLOCK点ずつスタック上で一括変換(SIMD)し、距離
+	max_d2以内に最近傍がある点を詰めてからモーメントを累積する。
+
+	@param[in]      target          対応付け先のk-d木
+	@param[in]      t               srcに適用する座標変換
+	@param[in]      src             点の配列
+	@param[in]      n               点数
+	@param[in]      max_d2          対応点とする最大距離の2乗
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         対応付けた組のモーメントと距離の2乗の和
+	@exception      none
+**********************************************************************/
+static inline icp_sums
+sharaku_icp_match(const kd_tree& target, const transform3& t,
+		  const position3 *src, size_t n, float max_d2)
+{
+	position3 a[SHARAKU_ICP_BLOCK], b[SHARAKU_ICP_BLOCK];
+	icp_sums r = icp_sums::zero();
+	for (size_t i = 0; i < n; i += SHARAKU_ICP_BLOCK) {
+		const size_t m = std::min(n - i, (size_t)SHARAKU_ICP_BLOCK);
+		t.apply(src + i, a, m);
+		size_t k = 0;
+		for (size_t j = 0; j < m; j++) {
+			float d2 = max_d2;
+			const spatial_item *it = target.closest(a[j], d2);
+			if (it) {
+				a[k] = a[j];
+				b[k] = it->p;
+				r.sse += d2;
+				k++;
+			}
+		}
+		r.m = cross_moments::merge(r.m, sharaku_cross_moments_serial(a, b, k));
+	}
+	return r;
+}
+
+/*********************************************************************/
+/*! @brief 点対点ICPでsrcをtargetへ位置合わせする
+
+	各反復で、現在の変換を適用したsrcの各点をtargetの最近傍
+	(距離params.max_distance以内)と対応付け、Kabschの方法で求めた
+	更新量を変換へ合成する。更新量の平行移動と回転角がともに
+	epsilon_translation, epsilon_rotation未満となった時点で終了する。
+	対応点が3組未満となった場合は収束せずに終了する。
+	反復中はメモリを確保しない(poolを指定した場合の部分結果を除く)。
+
+	@param[in]      target          位置合わせ先の点群のk-d木
+	@param[in]      src             位置合わせする点の配列
+	@param[in]      n               点数
+	@param[in]      guess           初期の座標変換
+	@param[in]      params          設定
+	@param[in]      pool            処理を行うスレッドプール(NULLの場合は
+	                                呼び出しスレッドのみで行う)
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         結果
+	@exception      none
+**********************************************************************/
+static inline icp_result
+sharaku_icp(const kd_tree& target, const position3 *src, size_t n,
+	    const transform3& guess, const icp_params& params, thread_pool *pool = nullptr)
+{
+	icp_result res{guess, 0, 0, 0.0f, false};
+	const float max_d2 = params.max_distance * params.max_distance;
+	while (res.iterations < params.max_iterations) {
+		const transform3 t = res.transform;
+		const icp_sums s = sharaku_cloud_reduce(pool, src, n, icp_sums::zero(),
+			[&](size_t b, size_t e) {
+				return sharaku_icp_match(target, t, src + b, e - b, max_d2);
+			},
+			icp_sums::merge);
+		res.inliers = s.m.n;
+		res.rmse = (s.m.n) ? (float)sqrt(s.sse / (double)s.m.n) : 0.0f;
+		if (s.m.n < 3) {
+			break;
+		}
+
+		const transform3 delta = sharaku_kabsch_solve(s.m);
+		res.transform = delta * res.transform;
+		res.iterations++;
+		if (sharaku_length(delta.trans) < params.epsilon_translation &&
+		    sharaku_rotation_angle(delta.rot) < params.epsilon_rotation) {
+			res.converged = true;
+			break;
+		}
+	}
+	return res;
+}
+
+
+#endif // SHARAKU_MM_REGISTRATION_H_
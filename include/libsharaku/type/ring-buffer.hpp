@@ -0,0 +1,204 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_MM_RING_BUFFER_H_
+#define SHARAKU_MM_RING_BUFFER_H_
+
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+#include <libsharaku/type/simd.hpp>
+
+// キャッシュラインサイズ(byte)
+#ifndef SHARAKU_CACHE_LINE
+#define SHARAKU_CACHE_LINE		64
+#endif
+
+/* ========================================================================= */
+/* class definition Section                                                  */
+/* ========================================================================= */
+
+/*! @class spsc_ring
+    @brief  単一生産者・単一消費者のロックフリーリングバッファ
+
+	1つのスレッドがpush()、別の1つのスレッドがpop()を呼び出す場合に限り、
+	排他なしに要素を受け渡す。要素型Tはvector3、position3等の
+	trivially copyableな型とし、memcpyで複製する。
+	容量は構築時に2のべき乗へ切り上げて確保し、以後メモリを確保しない。
+
+	書き込み位置(生産者が更新)と読み出し位置(消費者が更新)は
+	別のキャッシュラインに置き、それぞれ相手側の位置のキャッシュを
+	同じラインに持つ。相手側の位置はキャッシュで空き(または要素)が
+	足りない場合にのみ読み直すため、通常の受け渡しでキャッシュラインの
+	往復は要素の転送分のみとなる。
+*/
+template <class T>
+class spsc_ring
+{
+	static_assert(std::is_trivially_copyable<T>::value, "spsc_ring requires a trivially copyable type");
+
+ public:
+	/*********************************************************************/
+	/*! @brief リングバッファを構築する
+
+		@param[in]      capacity        格納できる要素数(2のべき乗へ切り上げる)
+		@exception      none
+	**********************************************************************/
+	explicit spsc_ring(size_t capacity) {
+		size_t cap = 1;
+		while (cap < capacity) {
+			cap <<= 1;
+		}
+		_mask	= cap - 1;
+		_buf	= (T *)sharaku_simd::alloc(sizeof(T) * cap);
+	}
+	~spsc_ring() {
+		sharaku_simd::free(_buf);
+	}
+	spsc_ring(const spsc_ring&) = delete;
+	spsc_ring& operator=(const spsc_ring&) = delete;
+
+	/*********************************************************************/
+	/*! @brief 要素を1つ書き込む(生産者スレッド)
+
+		@param[in]      v               書き込む要素
+		@return         書き込んだ場合true、満杯の場合false
+		@exception      none
+	**********************************************************************/
+	bool push(const T& v) {
+		return push(&v, 1) == 1;
+	}
+
+	/*********************************************************************/
+	/*! @brief 要素を1つ読み出す(消費者スレッド)
+
+		@param[out]     v               読み出した要素の格納先
+		@return         読み出した場合true、空の場合false
+		@exception      none
+	**********************************************************************/
+	bool pop(T& v) {
+		return pop(&v, 1) == 1;
+	}
+
+	/*********************************************************************/
+	/*! @brief 最大n要素をまとめて書き込む(生産者スレッド)
+
+		@param[in]      src             書き込む要素の配列
+		@param[in]      n               要素数
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         書き込んだ要素数(空きが足りない場合はn未満)
+		@exception      none
+	**********************************************************************/
+	size_t push(const T *src, size_t n) {
+		const size_t head = _p.head.load(std::memory_order_relaxed);
+		size_t room = _mask + 1 - (head - _p.tail);
+		if (room < n) {
+			_p.tail = _c.tail.load(std::memory_order_acquire);
+			room = _mask + 1 - (head - _p.tail);
+			n = (room < n) ? room : n;
+		}
+		if (n == 0) {
+			return 0;
+		}
+		_copy_in(head & _mask, src, n);
+		_p.head.store(head + n, std::memory_order_release);
+		return n;
+	}
+
+	/*********************************************************************/
+	/*! @brief 最大n要素をまとめて読み出す(消費者スレッド)
+
+		@param[out]     dst             読み出した要素の格納先
+		@param[in]      n               要素数
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         読み出した要素数(要素が足りない場合はn未満)
+		@exception      none
+	**********************************************************************/
+	size_t pop(T *dst, size_t n) {
+		const size_t tail = _c.tail.load(std::memory_order_relaxed);
+		size_t avail = _c.head - tail;
+		if (avail < n) {
+			_c.head = _p.head.load(std::memory_order_acquire);
+			avail = _c.head - tail;
+			n = (avail < n) ? avail : n;
+		}
+		if (n == 0) {
+			return 0;
+		}
+		_copy_out(tail & _mask, dst, n);
+		_c.tail.store(tail + n, std::memory_order_release);
+		return n;
+	}
+
+ public:
+	size_t capacity(void) const { return _mask + 1; }
+	// 格納されている要素数(他方のスレッドの実行中は目安)
+	size_t size(void) const {
+		return _p.head.load(std::memory_order_acquire) -
+		       _c.tail.load(std::memory_order_acquire);
+	}
+	bool empty(void) const { return size() == 0; }
+
+ private:
+	// 位置posからn要素を書き込む(終端で折り返す)
+	void _copy_in(size_t pos, const T *src, size_t n) {
+		const size_t first = (n < _mask + 1 - pos) ? n : _mask + 1 - pos;
+		memcpy((void *)(_buf + pos), src, sizeof(T) * first);
+		memcpy((void *)_buf, src + first, sizeof(T) * (n - first));
+	}
+	void _copy_out(size_t pos, T *dst, size_t n) {
+		const size_t first = (n < _mask + 1 - pos) ? n : _mask + 1 - pos;
+		memcpy((void *)dst, _buf + pos, sizeof(T) * first);
+		memcpy((void *)(dst + first), _buf, sizeof(T) * (n - first));
+	}
+
+ protected:
+	// 生産者が更新する領域
+	struct alignas(SHARAKU_CACHE_LINE) _producer {
+		std::atomic<size_t>	head{0};	// 書き込み位置(累積)
+		size_t			tail = 0;	// 読み出し位置のキャッシュ
+	};
+	// 消費者が更新する領域
+	struct alignas(SHARAKU_CACHE_LINE) _consumer {
+		std::atomic<size_t>	tail{0};	// 読み出し位置(累積)
+		size_t			head = 0;	// 書き込み位置のキャッシュ
+	};
+
+	_producer	_p;
+	_consumer	_c;
+	alignas(SHARAKU_CACHE_LINE) size_t	_mask;	// 容量 - 1
+	T		*_buf;
+};
+
+
+#endif // SHARAKU_MM_RING_BUFFER_H_
@@ -28,7 +28,11 @@
 #define SHARAKU_UTILTY_ROTATION_H_
 
 #include <stdint.h>
+#include <stddef.h>
 #include <math.h>
+#include <limits>
+#include <type_traits>
+#include <libsharaku/type/simd.hpp>
 #include <libsharaku/type/vector.hpp>
 
 // 数学定義
@@ -44,7 +48,7 @@
 static inline float
 sharaku_rho2steering(int32_t rho, int32_t wheel_length)
 {
-	register float tan_theta = ((float)wheel_length * M_PI) / rho;
+	float tan_theta = ((float)wheel_length * M_PI) / rho;
 	int32_t steering = (int32_t)(atan(tan_theta) / M_PI_180);
 	return steering;
 }
@@ -53,191 +57,255 @@ sharaku_rho2steering(int32_t rho, int32_t wheel_length)
 static inline float
 sharaku_steering2rho(int32_t steering, int32_t wheel_length)
 {
-	register float tan_theta = tan((float)steering * M_PI_180);
-	register float rho = 0.0f;
+	float tan_theta = tan((float)steering * M_PI_180);
+	float rho = 0.0f;
 	rho = ((float)wheel_length * M_PI) / tan_theta;
 	return rho;
 }
 
-// 角度の差分を取得する。leftrightは旋回方向であり、-1, 0, +1を指定する
-static inline int32_t
-sharaku_differ_degree(int32_t target, int32_t now, int leftright)
+//-----------------------------------------------------------------------------
+// Steering角度/半径変換の高速版
+//  sharaku_rho2steering_fast
+//    atanを[0, 1]の11次ミニマックス多項式で近似する(|x| > 1は
+//    atan(x) = π/2 - atan(1/x)で折り返す)。
+//    切り捨て前の角度誤差は1.1e-4度以下(正の有限なfloat全てに対する
+//    atanとの差の最大値は1.05e-4度)であり、結果は厳密値と一致するか、
+//    厳密値が整数境界から1.1e-4度以内の場合に限り1度異なる。
+//  sharaku_steering2rho_fast
+//    整数角度に対するcotをコンパイル時に生成したテーブルから引く。
+//    厳密値に対する相対誤差は1.0e-6以下である(180度周期で折り返すため、
+//    角度の大きさによらない)。sharaku_steering2rhoはtanの引数をfloatで
+//    丸めるため、|steering| <= 89でも相対2.0e-5程度の誤差を持ち、
+//    ±90度や180度の倍数では厳密値(0, ±inf)の代わりに有限値を返す。
+
+// コンパイル時テーブル生成用のsin/cos(ラジアン、|rad| <= π程度)
+static constexpr double
+sharaku_constexpr_sin(double rad)
 {
-	// 起点Xを0点とした差分を作成する
-	int32_t result;
-	if (leftright > 0) {
-		// 左回りでの角度差分をとる
-		int32_t diff = 360 + target - now;
-		if (diff >= 360) {
-			result = diff - 360;
-		} else {
-			result = diff;
-		}
-	} else if (leftright < 0) {
-		// 右回りでの角度差分をとる
-		int32_t diff = -360 + target - now;
-		if (diff <= 360) {
-			result = diff + 360;
-		} else {
-			result = diff;
-		}
-	} else {
-		// 近い方を選択する
-		int32_t diff1 = sharaku_differ_degree(target, now, 1);
-		int32_t diff2 = sharaku_differ_degree(target, now, -1);
-		if (fabs(diff2) > diff1) {
-			result = diff1;
-		} else {
-			result = diff2;
-		}
+	double term = rad, sum = rad;
+	for (int n = 1; n < 20; n++) {
+		term = -term * rad * rad / ((2 * n) * (2 * n + 1));
+		sum += term;
+	}
+	return sum;
+}
+static constexpr double
+sharaku_constexpr_cos(double rad)
+{
+	double term = 1.0, sum = 1.0;
+	for (int n = 1; n < 20; n++) {
+		term = -term * rad * rad / ((2 * n - 1) * (2 * n));
+		sum += term;
 	}
-	return result;
+	return sum;
 }
 
-/* ========================================================================= */
-/* struct definition Section                                                 */
-/* ========================================================================= */
+// -90度から89度までの整数角度に対するcot(添字は角度 + 90)
+struct sharaku_steering_table {
+	float cot[180];
 
-/*! @class rotation3
-    @brief  3次元ベクトル(移動量)構造体
-*/
-struct rotation3 {
- public:
-	float x; ///< x軸の回転角
-	float y; ///< y軸の回転角
-	float z; ///< z軸の回転角
+	constexpr sharaku_steering_table() : cot() {
+		for (int i = 0; i < 180; i++) {
+			int deg = i - 90;
+			double rad = deg * (3.14159265358979323846 / 180.0);
+			if (deg == 0) {
+				cot[i] = std::numeric_limits<float>::infinity();
+			} else if (deg == -90) {
+				cot[i] = 0.0f;
+			} else {
+				cot[i] = (float)(sharaku_constexpr_cos(rad) /
+						 sharaku_constexpr_sin(rad));
+			}
+		}
+	}
+};
 
- public:
-	/*********************************************************************/
-	/*! @brief x, y, zを代入する
+// atanの高速版(ラジアン)
+//  分岐予測ミスを避けるため、逆数は常に計算して選択する。
+static inline float
+sharaku_atan_fast(float x)
+{
+	const float a = fabsf(x);
+	const float inv = 1.0f / a;
+	const float r = (a > 1.0f) ? inv : a;
+	const float r2 = r * r;
+	float p = -0.011719122529f;
+	p = p * r2 + 0.052647329867f;
+	p = p * r2 - 0.116426475346f;
+	p = p * r2 + 0.193540379405f;
+	p = p * r2 - 0.332622826099f;
+	p = p * r2 + 0.999977231026f;
+	p = p * r;
+	p = (a > 1.0f) ? (1.5707963268f - p) : p;
+	return (0.0f > x) ? (0.0f - p) : p;
+}
 
-		@param[in]      rotat_x           新規設定を行うX軸の回転角度
-		@param[in]      rotat_y           新規設定を行うY軸の回転角度
-		@param[in]      rotat_z           新規設定を行うZ軸の回転角度(省略時は0.0fとなる)
-		@par            Refer
-		- 参照するグローバル変数 none
-		@par            Modify
-		- 変更するグローバル変数 none
-		@return         設定後の3次元回転角度構造体
-		@exception      none
-	**********************************************************************/
-	rotation3& operator()(float rotat_x, float rotat_y, float rotat_z = 0.0f) {
-		x = rotat_x; y = rotat_y; z = rotat_z;
-		return (*this);
-	}
+// sharaku_atan_fastのSIMD版(各レーンに同一の演算を行う)
+static inline sharaku_simd::f32
+sharaku_atan_fast_simd(sharaku_simd::f32 x)
+{
+	typedef sharaku_simd	S;
+	const S::f32 one = S::set1(1.0f);
+	const S::f32 zero = S::set1(0.0f);
+	const S::f32 a = S::abs(x);
+	const S::f32 r = S::selgt(a, one, S::div(one, a), a);
+	const S::f32 r2 = S::mul(r, r);
+	S::f32 p = S::set1(-0.011719122529f);
+	p = S::add(S::mul(p, r2), S::set1(0.052647329867f));
+	p = S::sub(S::mul(p, r2), S::set1(0.116426475346f));
+	p = S::add(S::mul(p, r2), S::set1(0.193540379405f));
+	p = S::sub(S::mul(p, r2), S::set1(0.332622826099f));
+	p = S::add(S::mul(p, r2), S::set1(0.999977231026f));
+	p = S::mul(p, r);
+	p = S::selgt(a, one, S::sub(S::set1(1.5707963268f), p), p);
+	return S::selgt(zero, x, S::sub(zero, p), p);
+}
 
-	/*********************************************************************/
-	/*! @brief rotation3構造体を代入する
+// 半径をSteering角度へ変換する(高速版)
+static inline float
+sharaku_rho2steering_fast(int32_t rho, int32_t wheel_length)
+{
+	float tan_theta = ((float)wheel_length * (float)M_PI) / (float)rho;
+	int32_t steering = (int32_t)(sharaku_atan_fast(tan_theta) * (float)(180.0 / M_PI));
+	return steering;
+}
 
-		@param[in]      rotat             代入する構造体
-		@par            Refer
-		- 参照するグローバル変数 none
-		@par            Modify
-		- 変更するグローバル変数 none
-		@return         設定後の3次元回転角度構造体
-		@exception      none
-	**********************************************************************/
-	rotation3& operator=(rotation3& rotat) {
-		x = rotat.x; y = rotat.y; z = rotat.z;
-		return (*this);
-	}
-	rotation3& operator=(const rotation3& rotat) {
-		x = rotat.x; y = rotat.y; z = rotat.z;
-		return (*this);
+// Steering角度を半径へ変換する(高速版)
+static inline float
+sharaku_steering2rho_fast(int32_t steering, int32_t wheel_length)
+{
+	static constexpr sharaku_steering_table table;
+	int64_t i = (int64_t)steering + 90;
+	if ((uint64_t)i >= 180u) {
+		i = ((i % 180) + 180) % 180;
 	}
+	return ((float)wheel_length * (float)M_PI) * table.cot[i];
+}
 
-	/*********************************************************************/
-	/*! @brief 各座標ごとに加算を行う
-
-		@param[in]      rotat             加算するrotation3
-		@par            Refer
-		- 参照するグローバル変数 none
-		@par            Modify
-		- 変更するグローバル変数 none
-		@return         加算結果
-		@exception      none
-	**********************************************************************/
-	rotation3 operator+(rotation3& rotat) {
-		rotation3 result;
-		result.x = x + rotat.x; result.y = y + rotat.y; result.z = z + rotat.z;
-		return result;
+// 半径の配列をSteering角度へ一括変換する(高速版)
+static inline void
+sharaku_rho2steering_batch(const int32_t *rho, float *steering, size_t n,
+			   int32_t wheel_length)
+{
+	typedef sharaku_simd	S;
+	const size_t W = S::width;
+	const float k = (float)wheel_length * (float)M_PI;
+	const float deg = (float)(180.0 / M_PI);
+	size_t i = 0;
+	for (; i + W <= n; i += W) {
+		S::f32 tan_theta = S::div(S::set1(k), S::cvt(S::loadi(rho + i)));
+		S::f32 theta = S::mul(sharaku_atan_fast_simd(tan_theta), S::set1(deg));
+		S::store(steering + i, S::cvt(S::cvtt(theta)));
 	}
-	rotation3 operator+(const rotation3& rotat) {
-		rotation3 result;
-		result.x = x + rotat.x; result.y = y + rotat.y; result.z = z + rotat.z;
-		return result;
+	for (; i < n; i++) {
+		float tan_theta = k / (float)rho[i];
+		steering[i] = (float)(int32_t)(sharaku_atan_fast(tan_theta) * deg);
 	}
+}
 
-	/*********************************************************************/
-	/*! @brief 各座標ごとに減算を行う
-
-		@param[in]      rotat             減算するrotation3
-		@par            Refer
-		- 参照するグローバル変数 none
-		@par            Modify
-		- 変更するグローバル変数 none
-		@return         減算結果
-		@exception      none
-	**********************************************************************/
-	rotation3 operator-(rotation3& rotat) {
-		rotation3 result;
-		result.x = x - rotat.x; result.y = y - rotat.y; result.z = z - rotat.z;
-		return result;
-	}
-	rotation3 operator-(const rotation3& rotat) {
-		rotation3 result;
-		result.x = x - rotat.x; result.y = y - rotat.y; result.z = z - rotat.z;
-		return result;
+// Steering角度の配列を半径へ一括変換する(高速版)
+static inline void
+sharaku_steering2rho_batch(const int32_t *steering, float *rho, size_t n,
+			   int32_t wheel_length)
+{
+	for (size_t i = 0; i < n; i++) {
+		rho[i] = sharaku_steering2rho_fast(steering[i], wheel_length);
 	}
+}
 
-	/*********************************************************************/
-	/*! @brief 各座標ごとに加算を行う
+// 角度の差分を取得する。leftrightは旋回方向であり、-1, 0, +1を指定する
+//  d = target - nowとしたとき、
+//    leftright > 0 : d < 0ならd + 360、それ以外はd(左回りでの角度差分)
+//    leftright < 0 : d > 720ならd - 360、それ以外はd(右回りでの角度差分)
+//    leftright = 0 : |右回り| > 左回りなら左回り、それ以外は右回り
+//  となる。各方向の値を全て求めてから選択するため分岐を含まず、
+//  範囲外や負の角度を与えてもよい(dはint32_tで折り返す)。
+static inline int32_t
+sharaku_differ_degree(int32_t target, int32_t now, int leftright)
+{
+	// 起点Xを0点とした差分を作成する
+	const int32_t d = (int32_t)((uint32_t)target - (uint32_t)now);
+	// 左回りでの角度差分をとる
+	const int32_t left = (int32_t)((uint32_t)d + ((d < 0) ? 360u : 0u));
+	// 右回りでの角度差分をとる
+	const int32_t right = (int32_t)((uint32_t)d - ((d > 720) ? 360u : 0u));
+	// 近い方を選択する
+	const int64_t abs_right = (right < 0) ? -(int64_t)right : (int64_t)right;
+	const int32_t nearest = (abs_right > left) ? left : right;
 
-		@param[in]      vec             加算するvector3
-		@par            Refer
-		- 参照するグローバル変数 none
-		@par            Modify
-		- 変更するグローバル変数 none
-		@return         加算結果
-		@exception      none
-	**********************************************************************/
-	rotation3 operator+(vector3& vec) {
-		rotation3 result;
-		result.x = x + vec.x; result.y = y + vec.y; result.z = z + vec.z;
-		return result;
+	const int32_t result = (leftright > 0) ? left : right;
+	return (leftright == 0) ? nearest : result;
+}
+
+// 角度の差分を一括で取得する
+//  target, now, leftright, resultはn要素の配列であり、各要素について
+//  sharaku_differ_degreeと同一の結果を返す(|target - now| < 2^31の範囲)。
+static inline void
+sharaku_differ_degree_batch(const int32_t *target, const int32_t *now,
+			    const int32_t *leftright, int32_t *result, size_t n)
+{
+	typedef sharaku_simd	S;
+	const size_t W = S::width;
+	const S::i32 zero = S::set1i(0);
+	const S::i32 d360 = S::set1i(360);
+	const S::i32 d720 = S::set1i(720);
+	size_t i = 0;
+	for (; i + W <= n; i += W) {
+		S::i32 d = S::subi(S::loadi(target + i), S::loadi(now + i));
+		S::i32 lr = S::loadi(leftright + i);
+		S::i32 left = S::addi(d, S::selgti(zero, d, d360, zero));
+		S::i32 right = S::subi(d, S::selgti(d, d720, d360, zero));
+		S::i32 nearest = S::selgti(S::absi(right), left, left, right);
+		S::i32 r = S::selgti(lr, zero, left, S::selgti(zero, lr, right, nearest));
+		S::storei(result + i, r);
 	}
-	rotation3 operator+(const vector3& vec) {
-		rotation3 result;
-		result.x = x + vec.x; result.y = y + vec.y; result.z = z + vec.z;
-		return result;
+	for (; i < n; i++) {
+		result[i] = sharaku_differ_degree(target[i], now[i], leftright[i]);
 	}
+}
+
+/* ========================================================================= */
+/* struct definition Section                                                 */
+/* ========================================================================= */
+
+/*! @class basic_rotation3
+    @brief  3次元回転角度構造体
 
+	トリビアルコピー可能な標準レイアウト型であり、memcpy/memmoveによる
+	一括コピーが可能である。集成体初期化 rotation3{x, y, z} により
+	コンパイル時定数として使用できる。
+	要素の型Tにはfloat, double, q16_16(固定小数点)を使用できる。
+*/
+template <class T>
+struct basic_rotation3 {
+ public:
+	T x; ///< x軸の回転角
+	T y; ///< y軸の回転角
+	T z; ///< z軸の回転角
+
+ public:
 	/*********************************************************************/
-	/*! @brief 各座標ごとに減算を行う
+	/*! @brief x, y, zを代入する
 
-		@param[in]      vec             減算するvector3
+		@param[in]      rotat_x         新規設定を行うX軸の回転角度
+		@param[in]      rotat_y         新規設定を行うY軸の回転角度
+		@param[in]      rotat_z         新規設定を行うZ軸の回転角度(省略時は0となる)
 		@par            Refer
 		- 参照するグローバル変数 none
 		@par            Modify
 		- 変更するグローバル変数 none
-		@return         減算結果
+		@return         設定後の3次元回転角度構造体
 		@exception      none
 	**********************************************************************/
-	rotation3 operator-(vector3& vec) {
-		rotation3 result;
-		result.x = x - vec.x; result.y = y - vec.y; result.z = z - vec.z;
-		return result;
-	}
-	rotation3 operator-(const vector3& vec) {
-		rotation3 result;
-		result.x = x - vec.x; result.y = y - vec.y; result.z = z - vec.z;
-		return result;
+	constexpr basic_rotation3& operator()(T rotat_x, T rotat_y, T rotat_z = T()) {
+		x = rotat_x; y = rotat_y; z = rotat_z;
+		return (*this);
 	}
 
 	/*********************************************************************/
 	/*! @brief 各座標ごとに加算を行い、結果を自身に反映する
 
-		@param[in]      rotat             加算するrotation3
+		@param[in]      rotat           加算するrotation3
 		@par            Refer
 		- 参照するグローバル変数 none
 		@par            Modify
@@ -245,11 +313,7 @@ struct rotation3 {
 		@return         加算結果
 		@exception      none
 	**********************************************************************/
-	rotation3& operator+=(rotation3& rotat) {
-		x += rotat.x; y += rotat.y; z += rotat.z;
-		return (*this);
-	}
-	rotation3& operator+=(const rotation3& rotat) {
+	constexpr basic_rotation3& operator+=(const basic_rotation3& rotat) {
 		x += rotat.x; y += rotat.y; z += rotat.z;
 		return (*this);
 	}
@@ -257,7 +321,7 @@ struct rotation3 {
 	/*********************************************************************/
 	/*! @brief 各座標ごとに減算を行い、結果を自身に反映する
 
-		@param[in]      rotat             減算するrotation3
+		@param[in]      rotat           減算するrotation3
 		@par            Refer
 		- 参照するグローバル変数 none
 		@par            Modify
@@ -265,11 +329,7 @@ struct rotation3 {
 		@return         減算結果
 		@exception      none
 	**********************************************************************/
-	rotation3& operator-=(rotation3& rotat) {
-		x -= rotat.x; y -= rotat.y; z -= rotat.z;
-		return (*this);
-	}
-	rotation3& operator-=(const rotation3& rotat) {
+	constexpr basic_rotation3& operator-=(const basic_rotation3& rotat) {
 		x -= rotat.x; y -= rotat.y; z -= rotat.z;
 		return (*this);
 	}
@@ -285,11 +345,7 @@ struct rotation3 {
 		@return         加算結果
 		@exception      none
 	**********************************************************************/
-	rotation3& operator+=(vector3& vec) {
-		x += vec.x; y += vec.y; z += vec.z;
-		return (*this);
-	}
-	rotation3& operator+=(const vector3& vec) {
+	constexpr basic_rotation3& operator+=(const basic_vector3<T>& vec) {
 		x += vec.x; y += vec.y; z += vec.z;
 		return (*this);
 	}
@@ -305,15 +361,97 @@ struct rotation3 {
 		@return         減算結果
 		@exception      none
 	**********************************************************************/
-	rotation3& operator-=(vector3& vec) {
-		x -= vec.x; y -= vec.y; z -= vec.z;
-		return (*this);
-	}
-	rotation3& operator-=(const vector3& vec) {
+	constexpr basic_rotation3& operator-=(const basic_vector3<T>& vec) {
 		x -= vec.x; y -= vec.y; z -= vec.z;
 		return (*this);
 	}
 };
 
+typedef basic_rotation3<float>	rotation3;	///< 単精度
+typedef basic_rotation3<double>	rotation3d;	///< 倍精度
+
+/*********************************************************************/
+/*! @brief 各座標ごとに加算を行う
+
+	@param[in]      lhs             加算されるrotation3
+	@param[in]      rhs             加算するrotation3
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         加算結果
+	@exception      none
+**********************************************************************/
+template <class T>
+constexpr basic_rotation3<T>
+operator+(const basic_rotation3<T>& lhs, const basic_rotation3<T>& rhs)
+{
+	return basic_rotation3<T>{lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z};
+}
+
+/*********************************************************************/
+/*! @brief 各座標ごとに減算を行う
+
+	@param[in]      lhs             減算されるrotation3
+	@param[in]      rhs             減算するrotation3
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         減算結果
+	@exception      none
+**********************************************************************/
+template <class T>
+constexpr basic_rotation3<T>
+operator-(const basic_rotation3<T>& lhs, const basic_rotation3<T>& rhs)
+{
+	return basic_rotation3<T>{lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z};
+}
+
+/*********************************************************************/
+/*! @brief 各座標ごとに加算を行う
+
+	@param[in]      lhs             加算されるrotation3
+	@param[in]      rhs             加算するvector3
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         加算結果
+	@exception      none
+**********************************************************************/
+template <class T>
+constexpr basic_rotation3<T>
+operator+(const basic_rotation3<T>& lhs, const basic_vector3<T>& rhs)
+{
+	return basic_rotation3<T>{lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z};
+}
+
+/*********************************************************************/
+/*! @brief 各座標ごとに減算を行う
+
+	@param[in]      lhs             減算されるrotation3
+	@param[in]      rhs             減算するvector3
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         減算結果
+	@exception      none
+**********************************************************************/
+template <class T>
+constexpr basic_rotation3<T>
+operator-(const basic_rotation3<T>& lhs, const basic_vector3<T>& rhs)
+{
+	return basic_rotation3<T>{lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z};
+}
+
+// バイナリ互換性のためのレイアウト固定
+static_assert(std::is_trivially_copyable<rotation3>::value, "rotation3 must be trivially copyable");
+static_assert(std::is_standard_layout<rotation3>::value, "rotation3 must be standard layout");
+static_assert(sizeof(rotation3) == 12, "rotation3 must be 12 bytes");
+static_assert(offsetof(rotation3, x) == 0 && offsetof(rotation3, y) == 4 &&
+	      offsetof(rotation3, z) == 8, "rotation3 layout must be x, y, z");
+
 
 #endif // SHARAKU_UTILTY_ROTATION_H_
@@ -0,0 +1,374 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_UV_SCHEDULER_H_
+#define SHARAKU_UV_SCHEDULER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ジッタ・オーバーランのヒストグラムのビン数
+//  k番目のビンは[2^k, 2^(k+1))us(0番目は0us以上)、最後のビンはそれ以上を数える
+#define SHARAKU_SCHEDULER_HIST	16
+
+/* ========================================================================= */
+/* class definition Section                                                  */
+/* ========================================================================= */
+
+/*! @class monotonic_clock
+    @brief  CLOCK_MONOTONICによる時刻の取得と絶対時刻までの待機
+
+	時刻はナノ秒単位の整数で扱う。
+	待機はclock_nanosleep(TIMER_ABSTIME)で行うため、処理時間や
+	スリープの誤差が次の周期へ累積しない。
+*/
+class monotonic_clock
+{
+ public:
+	int64_t now_ns(void) {
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+	}
+	void sleep_until(int64_t t_ns) {
+		struct timespec ts;
+		ts.tv_sec	= (time_t)(t_ns / 1000000000);
+		ts.tv_nsec	= (long)(t_ns % 1000000000);
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+		}
+	}
+};
+
+/*! @class simulated_clock
+    @brief  試験用の模擬時計
+
+	sleep_until()は待機せずに時刻を指定時刻まで進め、設定した起床遅延を
+	加える。処理時間はタスクからadvance()で時刻を進めて模擬する。
+*/
+class simulated_clock
+{
+ public:
+	explicit simulated_clock(int64_t t0_ns = 0) : _now(t0_ns) {}
+
+	int64_t now_ns(void) { return _now.load(); }
+	void sleep_until(int64_t t_ns) {
+		int64_t now = _now.load();
+		_now.store(((t_ns > now) ? t_ns : now) + _latency);
+	}
+	// 時刻をd_nsだけ進める(処理時間の模擬)
+	void advance(int64_t d_ns) {
+		_now.fetch_add(d_ns);
+	}
+	// sleep_until()ごとに加える起床遅延
+	void set_wakeup_latency(int64_t ns) {
+		_latency = ns;
+	}
+
+ protected:
+	std::atomic<int64_t>	_now;
+	int64_t			_latency = 0;
+};
+
+/*! @class scheduler_stats
+    @brief  周期グループの実行統計
+
+	ジッタは周期の開始予定時刻から実際に起床した時刻までの遅れ、
+	オーバーランは処理の終了時刻が次の開始予定時刻を過ぎた量である。
+*/
+struct scheduler_stats {
+ public:
+	uint64_t	ticks;		///< 実行した周期数
+	uint64_t	overruns;	///< オーバーランした周期数
+	uint64_t	skipped;	///< オーバーランにより実行しなかった周期数
+	int64_t		max_jitter_ns;	///< ジッタの最大値
+	int64_t		max_overrun_ns;	///< オーバーランの最大値
+	uint64_t	jitter_hist[SHARAKU_SCHEDULER_HIST];	///< ジッタのヒストグラム
+	uint64_t	overrun_hist[SHARAKU_SCHEDULER_HIST];	///< オーバーランのヒストグラム
+
+ public:
+	// 時間nsを数えるヒストグラムのビン番号
+	static size_t bin(int64_t ns) {
+		int64_t us = ns / 1000;
+		size_t k = 0;
+		while (us >= 2 && k < SHARAKU_SCHEDULER_HIST - 1) {
+			us >>= 1;
+			k++;
+		}
+		return k;
+	}
+};
+
+/*! @class basic_scheduler
+    @brief  固定周期の制御スケジューラ
+
+	登録した処理(pid、フィルタ等を呼び出す関数)を周期ごとのグループに
+	まとめ、同一周期の処理は登録順に1回の起床で続けて実行する。
+	各周期の開始予定時刻は起動時刻 + 周期 * nの絶対時刻とし、
+	処理にはその周期の経過時間delta_ms(前回実行した周期からの
+	予定時刻の差)を渡す。処理が次の開始予定時刻を過ぎた場合は、
+	過ぎた周期を実行せずに次の将来の予定時刻から再開する
+	(このとき次回のdelta_msは飛ばした周期分を含む)。
+
+	実行方法は次の2通りである。
+	- start()/stop(): 周期グループごとにスレッドを生成し、指定された
+	  CPUへ固定して実行する
+	- run_until(): 呼び出しスレッドで全グループを開始予定時刻順に実行する
+	  (同時刻の場合は短い周期を先に実行する)。simulated_clockと
+	  組み合わせると実行順序と統計が決定的となる
+
+	処理の登録は実行前に行うこと。
+*/
+template <class Clock>
+class basic_scheduler
+{
+ public:
+	typedef std::function<void(float delta_ms)>	task;
+
+ public:
+	explicit basic_scheduler(Clock& clock) : _clock(clock) {}
+	~basic_scheduler() {
+		stop();
+	}
+	basic_scheduler(const basic_scheduler&) = delete;
+	basic_scheduler& operator=(const basic_scheduler&) = delete;
+
+	/*********************************************************************/
+	/*! @brief 周期period_nsで実行する処理を登録する
+
+		@param[in]      period_ns       実行周期(ns)
+		@param[in]      func            void(float delta_ms)で呼び出す処理
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         none
+		@exception      none
+	**********************************************************************/
+	void add(int64_t period_ns, task func) {
+		_find(period_ns).tasks.push_back(std::move(func));
+	}
+
+	// 周期period_nsのグループを実行するCPUを指定する(start()で使用)
+	void set_affinity(int64_t period_ns, int cpu) {
+		_find(period_ns).cpu = cpu;
+	}
+
+	/*********************************************************************/
+	/*! @brief 周期グループごとのスレッドで実行を開始する
+
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		各スレッドは最初の周期を実行する前にCPUへ固定する。
+		実行中(stop()前)に呼び出した場合は何もせずfalseを返す。
+
+		@return         全スレッドのCPU固定に成功した場合true
+		@exception      none
+	**********************************************************************/
+	bool start(void) {
+		for (std::unique_ptr<_group>& g : _groups) {
+			if (g->th.joinable()) {
+				return false;
+			}
+		}
+		bool ok = true;
+		_stop = false;
+		_reset(_clock.now_ns());
+		for (std::unique_ptr<_group>& g : _groups) {
+			_group *pg = g.get();
+			std::promise<bool> pinned;
+			std::future<bool> result = pinned.get_future();
+			pg->th = std::thread([this, pg, p = std::move(pinned)]() mutable {
+				p.set_value(_pin(pg->cpu));
+				_loop(*pg);
+			});
+			ok = result.get() && ok;
+		}
+		return ok;
+	}
+	// スレッドを停止する(実行中の周期の終了を待つ)
+	void stop(void) {
+		_stop = true;
+		for (std::unique_ptr<_group>& g : _groups) {
+			if (g->th.joinable()) {
+				g->th.join();
+			}
+		}
+	}
+
+	/*********************************************************************/
+	/*! @brief 開始予定時刻がend_ns以下の周期を呼び出しスレッドで実行する
+
+		初回の呼び出し時の時刻を起動時刻とし、以後の呼び出しは
+		前回の続きから実行する。
+
+		@param[in]      end_ns          実行を終了する時刻
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         none
+		@exception      none
+	**********************************************************************/
+	void run_until(int64_t end_ns) {
+		if (!_started) {
+			_reset(_clock.now_ns());
+		}
+		for (;;) {
+			_group *next = nullptr;
+			for (std::unique_ptr<_group>& g : _groups) {
+				if (!next || g->next < next->next ||
+				    (g->next == next->next && g->period < next->period)) {
+					next = g.get();
+				}
+			}
+			if (!next || next->next > end_ns) {
+				break;
+			}
+			_clock.sleep_until(next->next);
+			_tick(*next);
+		}
+	}
+
+ public:
+	// 周期グループ数
+	size_t groups(void) const { return _groups.size(); }
+
+	// 周期period_nsのグループの統計(存在しない場合は全て0)
+	scheduler_stats stats(int64_t period_ns) {
+		for (std::unique_ptr<_group>& g : _groups) {
+			if (g->period == period_ns) {
+				std::lock_guard<std::mutex> lock(g->mtx);
+				return g->stats;
+			}
+		}
+		return scheduler_stats{};
+	}
+
+ private:
+	struct _group {
+		int64_t			period;
+		int			cpu = -1;
+		std::vector<task>	tasks;
+		int64_t			next = 0;	// 次の開始予定時刻
+		int64_t			last = 0;	// 前回実行した周期の開始予定時刻
+		scheduler_stats		stats{};
+		std::mutex		mtx;		// statsの排他
+		std::thread		th;
+	};
+
+	_group& _find(int64_t period_ns) {
+		for (std::unique_ptr<_group>& g : _groups) {
+			if (g->period == period_ns) {
+				return *g;
+			}
+		}
+		_groups.emplace_back(new _group);
+		_groups.back()->period = period_ns;
+		return *_groups.back();
+	}
+
+	void _reset(int64_t t0) {
+		for (std::unique_ptr<_group>& g : _groups) {
+			g->next = t0;
+			g->last = t0 - g->period;
+			std::lock_guard<std::mutex> lock(g->mtx);
+			g->stats = scheduler_stats{};
+		}
+		_started = true;
+	}
+
+	// 呼び出しスレッドをcpuへ固定する(cpu < 0の場合は固定しない)
+	static bool _pin(int cpu) {
+		if (cpu < 0) {
+			return true;
+		}
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+	}
+
+	void _loop(_group& g) {
+		while (!_stop) {
+			_clock.sleep_until(g.next);
+			if (_stop) {
+				break;
+			}
+			_tick(g);
+		}
+	}
+
+	// 1周期分を実行し、次の開始予定時刻を求める
+	void _tick(_group& g) {
+		const int64_t jitter = _clock.now_ns() - g.next;
+		const float delta_ms = (float)(g.next - g.last) * 1.0e-6f;
+		for (task& t : g.tasks) {
+			t(delta_ms);
+		}
+		const int64_t end = _clock.now_ns();
+
+		g.last = g.next;
+		g.next += g.period;
+		std::lock_guard<std::mutex> lock(g.mtx);
+		scheduler_stats& s = g.stats;
+		s.ticks++;
+		s.max_jitter_ns = (jitter > s.max_jitter_ns) ? jitter : s.max_jitter_ns;
+		s.jitter_hist[scheduler_stats::bin(jitter)]++;
+		if (end > g.next) {
+			const int64_t over = end - g.next;
+			const int64_t skip = over / g.period + 1;
+			g.next += skip * g.period;
+			s.overruns++;
+			s.skipped += skip;
+			s.max_overrun_ns = (over > s.max_overrun_ns) ? over : s.max_overrun_ns;
+			s.overrun_hist[scheduler_stats::bin(over)]++;
+		}
+	}
+
+ protected:
+	Clock&					_clock;
+	std::vector<std::unique_ptr<_group>>	_groups;
+	std::atomic<bool>			_stop{false};
+	bool					_started = false;
+};
+
+typedef basic_scheduler<monotonic_clock>	scheduler;
+
+
+#endif // SHARAKU_UV_SCHEDULER_H_
@@ -0,0 +1,471 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_UV_SIMD_H_
+#define SHARAKU_UV_SIMD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <new>
+
+//-----------------------------------------------------------------------------
+// SIMD命令セットの選択
+//  コンパイラが定義するマクロからコンパイル時に選択する。
+//  SHARAKU_SIMD_DISABLEを定義した場合はスカラ実装となる。
+#if !defined(SHARAKU_SIMD_DISABLE)
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define SHARAKU_SIMD_AVX512
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define SHARAKU_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SHARAKU_SIMD_SSE2
+#endif
+#endif
+
+// SIMDレーンの配置境界(キャッシュラインサイズ)
+#define SHARAKU_SIMD_ALIGN	64
+
+//-----------------------------------------------------------------------------
+// x, y, zの3要素を繰り返し並べた配列(vector3等の配列)と
+// x, y, zそれぞれのレーンとの相互変換(4要素分、SSE命令で行う)
+#if defined(SHARAKU_SIMD_AVX512) || defined(SHARAKU_SIMD_AVX2) || \
+    defined(SHARAKU_SIMD_SSE2)
+static inline void
+sharaku_simd_load3_m128(const float *p, __m128& x, __m128& y, __m128& z)
+{
+	// a = [x0 y0 z0 x1], b = [y1 z1 x2 y2], c = [z2 x3 y3 z3]
+	const __m128 a = _mm_loadu_ps(p);
+	const __m128 b = _mm_loadu_ps(p + 4);
+	const __m128 c = _mm_loadu_ps(p + 8);
+	x = _mm_shuffle_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 0, 0)),
+			   _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)),
+			   _MM_SHUFFLE(2, 0, 2, 0));
+	y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+			   _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)),
+			   _MM_SHUFFLE(2, 0, 2, 0));
+	z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+			   _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)),
+			   _MM_SHUFFLE(2, 0, 2, 0));
+}
+static inline void
+sharaku_simd_store3_m128(float *p, __m128 x, __m128 y, __m128 z)
+{
+	const __m128 a = _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)),
+					_mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)),
+					_MM_SHUFFLE(2, 0, 2, 0));
+	const __m128 b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)),
+					_mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)),
+					_MM_SHUFFLE(2, 0, 2, 0));
+	const __m128 c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)),
+					_mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)),
+					_MM_SHUFFLE(2, 0, 2, 0));
+	_mm_storeu_ps(p, a);
+	_mm_storeu_ps(p + 4, b);
+	_mm_storeu_ps(p + 8, c);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// SIMDレジスタ操作の抽象化
+//  f32はfloat、i32はint32_tのパックであり、widthレーンを同時に処理する。
+//  スカラ実装ではwidth = 1となる。
+//  各演算はIEEE754の単精度演算であり、スカラ演算と同一の結果となる。
+//  ただしmadd(a * b + c)はFMA命令が使用できる場合に融合積和となり、
+//  hsum(全レーンの総和)は加算順序がレーン順と異なるため、
+//  スカラ演算とは丸め誤差の範囲で異なる。
+struct sharaku_simd {
+#if defined(SHARAKU_SIMD_AVX512)
+	typedef __m512	f32;
+	typedef __m512i	i32;
+	enum { width = 16 };
+
+	static inline f32 load(const float *p) { return _mm512_loadu_ps(p); }
+	static inline void store(float *p, f32 a) { _mm512_storeu_ps(p, a); }
+	static inline f32 set1(float v) { return _mm512_set1_ps(v); }
+	static inline f32 add(f32 a, f32 b) { return _mm512_add_ps(a, b); }
+	static inline f32 sub(f32 a, f32 b) { return _mm512_sub_ps(a, b); }
+	static inline f32 mul(f32 a, f32 b) { return _mm512_mul_ps(a, b); }
+	static inline f32 div(f32 a, f32 b) { return _mm512_div_ps(a, b); }
+	static inline f32 min(f32 a, f32 b) { return _mm512_min_ps(a, b); }
+	static inline f32 max(f32 a, f32 b) { return _mm512_max_ps(a, b); }
+	static inline f32 abs(f32 a) { return _mm512_abs_ps(a); }
+	static inline f32 madd(f32 a, f32 b, f32 c) { return _mm512_fmadd_ps(a, b, c); }
+	static inline f32 sqrt(f32 a) { return _mm512_sqrt_ps(a); }
+	// 1/sqrt(a)の近似値(相対誤差2^-14以下)
+	static inline f32 rsqrt(f32 a) { return _mm512_rsqrt14_ps(a); }
+	static inline float hsum(f32 a) { return _mm512_reduce_add_ps(a); }
+	// a > b ? x : y
+	static inline f32 selgt(f32 a, f32 b, f32 x, f32 y) {
+		return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(a, b, _CMP_GT_OQ), y, x);
+	}
+
+	static inline i32 loadi(const int32_t *p) { return _mm512_loadu_si512(p); }
+	static inline void storei(int32_t *p, i32 a) { _mm512_storeu_si512(p, a); }
+	static inline i32 set1i(int32_t v) { return _mm512_set1_epi32(v); }
+	static inline i32 addi(i32 a, i32 b) { return _mm512_add_epi32(a, b); }
+	static inline i32 subi(i32 a, i32 b) { return _mm512_sub_epi32(a, b); }
+	static inline i32 absi(i32 a) { return _mm512_abs_epi32(a); }
+	static inline f32 cvt(i32 a) { return _mm512_cvtepi32_ps(a); }
+	static inline i32 cvtt(f32 a) { return _mm512_cvttps_epi32(a); }
+	// a > b ? x : y
+	static inline i32 selgti(i32 a, i32 b, i32 x, i32 y) {
+		return _mm512_mask_blend_epi32(_mm512_cmpgt_epi32_mask(a, b), y, x);
+	}
+
+	// x, y, zを並べたwidth要素分を各レーンへ読み込む/書き出す
+	static inline void load3(const float *p, f32& x, f32& y, f32& z) {
+		__m128 x4[4], y4[4], z4[4];
+		for (int k = 0; k < 4; k++) {
+			sharaku_simd_load3_m128(p + k * 12, x4[k], y4[k], z4[k]);
+		}
+		x = _mm512_castps128_ps512(x4[0]);
+		y = _mm512_castps128_ps512(y4[0]);
+		z = _mm512_castps128_ps512(z4[0]);
+		x = _mm512_insertf32x4(x, x4[1], 1);
+		y = _mm512_insertf32x4(y, y4[1], 1);
+		z = _mm512_insertf32x4(z, z4[1], 1);
+		x = _mm512_insertf32x4(x, x4[2], 2);
+		y = _mm512_insertf32x4(y, y4[2], 2);
+		z = _mm512_insertf32x4(z, z4[2], 2);
+		x = _mm512_insertf32x4(x, x4[3], 3);
+		y = _mm512_insertf32x4(y, y4[3], 3);
+		z = _mm512_insertf32x4(z, z4[3], 3);
+	}
+	static inline void store3(float *p, f32 x, f32 y, f32 z) {
+		sharaku_simd_store3_m128(p, _mm512_extractf32x4_ps(x, 0),
+					 _mm512_extractf32x4_ps(y, 0),
+					 _mm512_extractf32x4_ps(z, 0));
+		sharaku_simd_store3_m128(p + 12, _mm512_extractf32x4_ps(x, 1),
+					 _mm512_extractf32x4_ps(y, 1),
+					 _mm512_extractf32x4_ps(z, 1));
+		sharaku_simd_store3_m128(p + 24, _mm512_extractf32x4_ps(x, 2),
+					 _mm512_extractf32x4_ps(y, 2),
+					 _mm512_extractf32x4_ps(z, 2));
+		sharaku_simd_store3_m128(p + 36, _mm512_extractf32x4_ps(x, 3),
+					 _mm512_extractf32x4_ps(y, 3),
+					 _mm512_extractf32x4_ps(z, 3));
+	}
+#elif defined(SHARAKU_SIMD_AVX2)
+	typedef __m256	f32;
+	typedef __m256i	i32;
+	enum { width = 8 };
+
+	static inline f32 load(const float *p) { return _mm256_loadu_ps(p); }
+	static inline void store(float *p, f32 a) { _mm256_storeu_ps(p, a); }
+	static inline f32 set1(float v) { return _mm256_set1_ps(v); }
+	static inline f32 add(f32 a, f32 b) { return _mm256_add_ps(a, b); }
+	static inline f32 sub(f32 a, f32 b) { return _mm256_sub_ps(a, b); }
+	static inline f32 mul(f32 a, f32 b) { return _mm256_mul_ps(a, b); }
+	static inline f32 div(f32 a, f32 b) { return _mm256_div_ps(a, b); }
+	static inline f32 min(f32 a, f32 b) { return _mm256_min_ps(a, b); }
+	static inline f32 max(f32 a, f32 b) { return _mm256_max_ps(a, b); }
+	static inline f32 abs(f32 a) {
+		return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+	}
+	static inline f32 madd(f32 a, f32 b, f32 c) {
+#if defined(__FMA__)
+		return _mm256_fmadd_ps(a, b, c);
+#else
+		return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+	}
+	static inline f32 sqrt(f32 a) { return _mm256_sqrt_ps(a); }
+	// 1/sqrt(a)の近似値(相対誤差1.5 * 2^-12以下)
+	static inline f32 rsqrt(f32 a) { return _mm256_rsqrt_ps(a); }
+	static inline float hsum(f32 a) {
+		__m128 t = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+		t = _mm_add_ps(t, _mm_movehl_ps(t, t));
+		return _mm_cvtss_f32(_mm_add_ss(t, _mm_shuffle_ps(t, t, 1)));
+	}
+	// a > b ? x : y
+	static inline f32 selgt(f32 a, f32 b, f32 x, f32 y) {
+		return _mm256_blendv_ps(y, x, _mm256_cmp_ps(a, b, _CMP_GT_OQ));
+	}
+
+	static inline i32 loadi(const int32_t *p) {
+		return _mm256_loadu_si256((const __m256i *)p);
+	}
+	static inline void storei(int32_t *p, i32 a) {
+		_mm256_storeu_si256((__m256i *)p, a);
+	}
+	static inline i32 set1i(int32_t v) { return _mm256_set1_epi32(v); }
+	static inline i32 addi(i32 a, i32 b) { return _mm256_add_epi32(a, b); }
+	static inline i32 subi(i32 a, i32 b) { return _mm256_sub_epi32(a, b); }
+	static inline i32 absi(i32 a) { return _mm256_abs_epi32(a); }
+	static inline f32 cvt(i32 a) { return _mm256_cvtepi32_ps(a); }
+	static inline i32 cvtt(f32 a) { return _mm256_cvttps_epi32(a); }
+	// a > b ? x : y
+	static inline i32 selgti(i32 a, i32 b, i32 x, i32 y) {
+		return _mm256_blendv_epi8(y, x, _mm256_cmpgt_epi32(a, b));
+	}
+
+	// x, y, zを並べたwidth要素分を各レーンへ読み込む/書き出す
+	static inline void load3(const float *p, f32& x, f32& y, f32& z) {
+		__m128 xl, yl, zl, xh, yh, zh;
+		sharaku_simd_load3_m128(p, xl, yl, zl);
+		sharaku_simd_load3_m128(p + 12, xh, yh, zh);
+		x = _mm256_set_m128(xh, xl);
+		y = _mm256_set_m128(yh, yl);
+		z = _mm256_set_m128(zh, zl);
+	}
+	static inline void store3(float *p, f32 x, f32 y, f32 z) {
+		sharaku_simd_store3_m128(p, _mm256_castps256_ps128(x),
+					 _mm256_castps256_ps128(y),
+					 _mm256_castps256_ps128(z));
+		sharaku_simd_store3_m128(p + 12, _mm256_extractf128_ps(x, 1),
+					 _mm256_extractf128_ps(y, 1),
+					 _mm256_extractf128_ps(z, 1));
+	}
+#elif defined(SHARAKU_SIMD_SSE2)
+	typedef __m128	f32;
+	typedef __m128i	i32;
+	enum { width = 4 };
+
+	static inline f32 load(const float *p) { return _mm_loadu_ps(p); }
+	static inline void store(float *p, f32 a) { _mm_storeu_ps(p, a); }
+	static inline f32 set1(float v) { return _mm_set1_ps(v); }
+	static inline f32 add(f32 a, f32 b) { return _mm_add_ps(a, b); }
+	static inline f32 sub(f32 a, f32 b) { return _mm_sub_ps(a, b); }
+	static inline f32 mul(f32 a, f32 b) { return _mm_mul_ps(a, b); }
+	static inline f32 div(f32 a, f32 b) { return _mm_div_ps(a, b); }
+	static inline f32 min(f32 a, f32 b) { return _mm_min_ps(a, b); }
+	static inline f32 max(f32 a, f32 b) { return _mm_max_ps(a, b); }
+	static inline f32 abs(f32 a) {
+		return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+	}
+	static inline f32 madd(f32 a, f32 b, f32 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+	static inline f32 sqrt(f32 a) { return _mm_sqrt_ps(a); }
+	// 1/sqrt(a)の近似値(相対誤差1.5 * 2^-12以下)
+	static inline f32 rsqrt(f32 a) { return _mm_rsqrt_ps(a); }
+	static inline float hsum(f32 a) {
+		__m128 t = _mm_add_ps(a, _mm_movehl_ps(a, a));
+		return _mm_cvtss_f32(_mm_add_ss(t, _mm_shuffle_ps(t, t, 1)));
+	}
+	// a > b ? x : y
+	static inline f32 selgt(f32 a, f32 b, f32 x, f32 y) {
+		f32 m = _mm_cmpgt_ps(a, b);
+		return _mm_or_ps(_mm_and_ps(m, x), _mm_andnot_ps(m, y));
+	}
+
+	static inline i32 loadi(const int32_t *p) {
+		return _mm_loadu_si128((const __m128i *)p);
+	}
+	static inline void storei(int32_t *p, i32 a) {
+		_mm_storeu_si128((__m128i *)p, a);
+	}
+	static inline i32 set1i(int32_t v) { return _mm_set1_epi32(v); }
+	static inline i32 addi(i32 a, i32 b) { return _mm_add_epi32(a, b); }
+	static inline i32 subi(i32 a, i32 b) { return _mm_sub_epi32(a, b); }
+	static inline i32 absi(i32 a) {
+		// SSE2にはpabsdが無いため、符号マスクで反転する
+		i32 m = _mm_srai_epi32(a, 31);
+		return _mm_sub_epi32(_mm_xor_si128(a, m), m);
+	}
+	static inline f32 cvt(i32 a) { return _mm_cvtepi32_ps(a); }
+	static inline i32 cvtt(f32 a) { return _mm_cvttps_epi32(a); }
+	// a > b ? x : y
+	static inline i32 selgti(i32 a, i32 b, i32 x, i32 y) {
+		i32 m = _mm_cmpgt_epi32(a, b);
+		return _mm_or_si128(_mm_and_si128(m, x), _mm_andnot_si128(m, y));
+	}
+
+	// x, y, zを並べたwidth要素分を各レーンへ読み込む/書き出す
+	static inline void load3(const float *p, f32& x, f32& y, f32& z) {
+		sharaku_simd_load3_m128(p, x, y, z);
+	}
+	static inline void store3(float *p, f32 x, f32 y, f32 z) {
+		sharaku_simd_store3_m128(p, x, y, z);
+	}
+#else
+	typedef float	f32;
+	typedef int32_t	i32;
+	enum { width = 1 };
+
+	static inline f32 load(const float *p) { return *p; }
+	static inline void store(float *p, f32 a) { *p = a; }
+	static inline f32 set1(float v) { return v; }
+	static inline f32 add(f32 a, f32 b) { return a + b; }
+	static inline f32 sub(f32 a, f32 b) { return a - b; }
+	static inline f32 mul(f32 a, f32 b) { return a * b; }
+	static inline f32 div(f32 a, f32 b) { return a / b; }
+	static inline f32 min(f32 a, f32 b) { return (a < b) ? a : b; }
+	static inline f32 max(f32 a, f32 b) { return (a > b) ? a : b; }
+	static inline f32 abs(f32 a) { return fabsf(a); }
+	static inline f32 madd(f32 a, f32 b, f32 c) { return a * b + c; }
+	static inline f32 sqrt(f32 a) { return sqrtf(a); }
+	// 1/sqrt(a)(近似命令がないため正確な値とする)
+	static inline f32 rsqrt(f32 a) { return 1.0f / sqrtf(a); }
+	static inline float hsum(f32 a) { return a; }
+	// a > b ? x : y
+	static inline f32 selgt(f32 a, f32 b, f32 x, f32 y) {
+		return (a > b) ? x : y;
+	}
+
+	static inline i32 loadi(const int32_t *p) { return *p; }
+	static inline void storei(int32_t *p, i32 a) { *p = a; }
+	static inline i32 set1i(int32_t v) { return v; }
+	static inline i32 addi(i32 a, i32 b) {
+		return (int32_t)((uint32_t)a + (uint32_t)b);
+	}
+	static inline i32 subi(i32 a, i32 b) {
+		return (int32_t)((uint32_t)a - (uint32_t)b);
+	}
+	static inline i32 absi(i32 a) {
+		return (int32_t)((a < 0) ? (0u - (uint32_t)a) : (uint32_t)a);
+	}
+	static inline f32 cvt(i32 a) { return (float)a; }
+	static inline i32 cvtt(f32 a) { return (int32_t)a; }
+	// a > b ? x : y
+	static inline i32 selgti(i32 a, i32 b, i32 x, i32 y) {
+		return (a > b) ? x : y;
+	}
+
+	// x, y, zを並べたwidth要素分を各レーンへ読み込む/書き出す
+	static inline void load3(const float *p, f32& x, f32& y, f32& z) {
+		x = p[0]; y = p[1]; z = p[2];
+	}
+	static inline void store3(float *p, f32 x, f32 y, f32 z) {
+		p[0] = x; p[1] = y; p[2] = z;
+	}
+#endif
+
+	// 要素数nをレーン幅の倍数へ切り上げる
+	static inline size_t round_up(size_t n) {
+		const size_t lanes = SHARAKU_SIMD_ALIGN / sizeof(float);
+		return (n + lanes - 1) & ~(lanes - 1);
+	}
+
+	// SHARAKU_SIMD_ALIGN境界に配置した領域を確保/解放する
+	static inline void *alloc(size_t size) {
+		return ::operator new(size, std::align_val_t(SHARAKU_SIMD_ALIGN));
+	}
+	static inline void free(void *p) {
+		::operator delete(p, std::align_val_t(SHARAKU_SIMD_ALIGN));
+	}
+};
+
+//-----------------------------------------------------------------------------
+// float配列の一括演算
+//  配列同士の重なりは、dstと入力が完全に一致する場合のみ許容する。
+
+// dst[i] = a[i] + b[i]
+static inline void
+sharaku_simd_add(float *dst, const float *a, const float *b, size_t n)
+{
+	const size_t W = sharaku_simd::width;
+	const size_t m = n - n % W;
+	size_t i = 0;
+	for (; i < m; i += W) {
+		sharaku_simd::store(dst + i, sharaku_simd::add(sharaku_simd::load(a + i),
+							       sharaku_simd::load(b + i)));
+	}
+	for (; i < n; i++) {
+		dst[i] = a[i] + b[i];
+	}
+}
+
+// dst[i] = a[i] - b[i]
+static inline void
+sharaku_simd_sub(float *dst, const float *a, const float *b, size_t n)
+{
+	const size_t W = sharaku_simd::width;
+	const size_t m = n - n % W;
+	size_t i = 0;
+	for (; i < m; i += W) {
+		sharaku_simd::store(dst + i, sharaku_simd::sub(sharaku_simd::load(a + i),
+							       sharaku_simd::load(b + i)));
+	}
+	for (; i < n; i++) {
+		dst[i] = a[i] - b[i];
+	}
+}
+
+// dst[i] = a[i] * s
+static inline void
+sharaku_simd_scale(float *dst, const float *a, float s, size_t n)
+{
+	const size_t W = sharaku_simd::width;
+	const sharaku_simd::f32 vs = sharaku_simd::set1(s);
+	const size_t m = n - n % W;
+	size_t i = 0;
+	for (; i < m; i += W) {
+		sharaku_simd::store(dst + i, sharaku_simd::mul(sharaku_simd::load(a + i), vs));
+	}
+	for (; i < n; i++) {
+		dst[i] = a[i] * s;
+	}
+}
+
+// dst[i] = dst[i] + a[i] * s
+static inline void
+sharaku_simd_accumulate(float *dst, const float *a, float s, size_t n)
+{
+	const size_t W = sharaku_simd::width;
+	const sharaku_simd::f32 vs = sharaku_simd::set1(s);
+	const size_t m = n - n % W;
+	size_t i = 0;
+	for (; i < m; i += W) {
+		sharaku_simd::f32 t = sharaku_simd::mul(sharaku_simd::load(a + i), vs);
+		sharaku_simd::store(dst + i, sharaku_simd::add(sharaku_simd::load(dst + i), t));
+	}
+	for (; i < n; i++) {
+		dst[i] = dst[i] + a[i] * s;
+	}
+}
+
+
+// a[0..n)とb[0..n)の内積
+//  4本の累積レジスタで積和の依存を分散する。加算順序が逐次加算と
+//  異なるため、結果は逐次加算と丸め誤差の範囲で異なる。
+static inline float
+sharaku_simd_dot(const float *a, const float *b, size_t n)
+{
+	typedef sharaku_simd	S;
+	const size_t W = S::width;
+	S::f32 s0 = S::set1(0.0f), s1 = s0, s2 = s0, s3 = s0;
+	size_t i = 0;
+	for (; i + W * 4 <= n; i += W * 4) {
+		s0 = S::madd(S::load(a + i), S::load(b + i), s0);
+		s1 = S::madd(S::load(a + i + W), S::load(b + i + W), s1);
+		s2 = S::madd(S::load(a + i + W * 2), S::load(b + i + W * 2), s2);
+		s3 = S::madd(S::load(a + i + W * 3), S::load(b + i + W * 3), s3);
+	}
+	for (; i + W <= n; i += W) {
+		s0 = S::madd(S::load(a + i), S::load(b + i), s0);
+	}
+	float sum = S::hsum(S::add(S::add(s0, s1), S::add(s2, s3)));
+	for (; i < n; i++) {
+		sum += a[i] * b[i];
+	}
+	return sum;
+}
+
+
+#endif // SHARAKU_UV_SIMD_H_
@@ -0,0 +1,751 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_MM_SPATIAL_INDEX_H_
+#define SHARAKU_MM_SPATIAL_INDEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <libsharaku/type/position.hpp>
+#include <libsharaku/type/geometry.hpp>
+#include <libsharaku/type/parallel.hpp>
+
+// kd_treeの葉に格納する最大点数
+#define SHARAKU_KD_LEAF		16
+
+// 近傍探索の結果が見つからない場合の番号
+#define SHARAKU_SPATIAL_NONE	UINT32_MAX
+
+/* ========================================================================= */
+/* struct definition Section                                                 */
+/* ========================================================================= */
+
+/*! @class spatial_item
+    @brief  空間インデックスに格納する点と番号の組(16byte)
+*/
+struct spatial_item {
+ public:
+	position3	p;	///< 位置
+	uint32_t	id;	///< 登録時の番号
+};
+
+static_assert(sizeof(spatial_item) == 16, "spatial_item must be 16 bytes");
+
+/*! @class knn_heap
+    @brief  k近傍探索の候補(距離の2乗が最大のものを先頭とするヒープ)
+
+	候補数がkに達した後は、先頭より近い点のみ先頭と入れ替える。
+	バッチ探索では1つのknn_heapを複数の探索で使い回し、
+	探索ごとのメモリ確保を避ける。
+*/
+class knn_heap
+{
+ public:
+	void reset(size_t k) {
+		_k = k;
+		_v.clear();
+		_v.reserve(k);
+	}
+	// 候補に加えるための距離の2乗の上限(k = 0の場合は-INFINITY)
+	float bound(void) const {
+		if (_v.size() < _k) {
+			return INFINITY;
+		}
+		return _k ? _v.front().first : -INFINITY;
+	}
+	void push(float d2, uint32_t id) {
+		if (_v.size() < _k) {
+			_v.emplace_back(d2, id);
+			std::push_heap(_v.begin(), _v.end());
+		} else if (_k && d2 < _v.front().first) {
+			std::pop_heap(_v.begin(), _v.end());
+			_v.back() = std::make_pair(d2, id);
+			std::push_heap(_v.begin(), _v.end());
+		}
+	}
+	size_t size(void) const { return _v.size(); }
+
+	/*********************************************************************/
+	/*! @brief 候補を距離の昇順にk個書き出す
+
+		k個に満たない分はSHARAKU_SPATIAL_NONE、INFINITYとする。
+		書き出し後の候補は空となる。
+
+		@param[out]     idx             番号の格納先(k要素)
+		@param[out]     d2              距離の2乗の格納先(k要素、NULLでもよい)
+		@return         見つかった点の数
+		@exception      none
+	**********************************************************************/
+	size_t output(uint32_t *idx, float *d2) {
+		std::sort_heap(_v.begin(), _v.end());
+		const size_t found = _v.size();
+		for (size_t i = 0; i < _k; i++) {
+			idx[i] = (i < found) ? _v[i].second : SHARAKU_SPATIAL_NONE;
+			if (d2) {
+				d2[i] = (i < found) ? _v[i].first : INFINITY;
+			}
+		}
+		_v.clear();
+		return found;
+	}
+
+ protected:
+	size_t					_k = 0;
+	std::vector<std::pair<float, uint32_t>>	_v;
+};
+
+/* ========================================================================= */
+/* function definition Section                                               */
+/* ========================================================================= */
+
+// 点の第axis座標(0: x, 1: y, 2: z)
+static inline float
+sharaku_axis(const position3& p, uint32_t axis)
+{
+	return (axis == 0) ? p.x : ((axis == 1) ? p.y : p.z);
+}
+
+/*********************************************************************/
+/*! @brief q[0]～q[m-1]の探索をチャンクに分けて並列に行う
+
+	radius探索の結果はチャンクごとに集めてから順に連結し、
+	q[i]の結果をidx[offsets[i]]～idx[offsets[i + 1] - 1]に格納する。
+
+	@param[in]      pool            処理を行うスレッドプール(NULLの場合は
+	                                呼び出しスレッドのみで行う)
+	@param[in]      m               探索数
+	@param[in]      func            void(size_t i, std::vector<uint32_t>& out)で
+	                                q[i]の結果をoutへ追加する処理
+	@param[out]     offsets         各探索の結果の開始位置(m + 1要素)
+	@param[out]     idx             結果の番号
+	@return         none
+	@exception      none
+**********************************************************************/
+template <class F>
+static inline void
+sharaku_spatial_collect(thread_pool *pool, size_t m, F func,
+			std::vector<uint32_t>& offsets, std::vector<uint32_t>& idx)
+{
+	offsets.assign(m + 1, 0);
+	idx.clear();
+	if (m == 0) {
+		return;
+	}
+	const size_t threads = pool ? pool->size() : 1;
+	const size_t chunks = (threads == 1) ? 1 :
+			      std::min(m, threads * SHARAKU_PARALLEL_CHUNKS_PER_THREAD);
+	std::vector<std::vector<uint32_t>> part(chunks);
+	auto body = [&](size_t c) {
+		const size_t b = m * c / chunks, e = m * (c + 1) / chunks;
+		for (size_t i = b; i < e; i++) {
+			func(i, part[c]);
+			offsets[i + 1] = (uint32_t)part[c].size();
+		}
+	};
+	if (pool) {
+		pool->run(chunks, body);
+	} else {
+		body(0);
+	}
+	// チャンク内の相対位置を全体の位置へ変換して連結する
+	for (size_t c = 0; c < chunks; c++) {
+		const size_t b = m * c / chunks, e = m * (c + 1) / chunks;
+		const uint32_t base = (uint32_t)idx.size();
+		for (size_t i = b; i < e; i++) {
+			offsets[i + 1] += base;
+		}
+		idx.insert(idx.end(), part[c].begin(), part[c].end());
+	}
+}
+
+// q[0]～q[m-1]のk近傍探索を並列に行う(結果はq[i]ごとにk要素)
+template <class Index>
+static inline void
+sharaku_spatial_nearest(thread_pool *pool, const Index& index, const position3 *q,
+			size_t m, size_t k, uint32_t *idx, float *d2)
+{
+	const size_t threads = pool ? pool->size() : 1;
+	const size_t chunks = (threads == 1 || m == 0) ? 1 :
+			      std::min(m, threads * SHARAKU_PARALLEL_CHUNKS_PER_THREAD);
+	auto body = [&](size_t c) {
+		knn_heap heap;
+		for (size_t i = m * c / chunks; i < m * (c + 1) / chunks; i++) {
+			heap.reset(k);
+			index.nearest(q[i], heap);
+			heap.output(idx + i * k, d2 ? d2 + i * k : nullptr);
+		}
+	};
+	if (chunks > 1) {
+		pool->run(chunks, body);
+	} else {
+		body(0);
+	}
+}
+
+/* ========================================================================= */
+/* class definition Section                                                  */
+/* ========================================================================= */
+
+/*! @class kd_tree
+    @brief  position3の静的なk-d木
+
+	構築時に点を複製して並べ替え、各節点の範囲を配列上の連続区間とする。
+	分割は範囲の広がりが最大の軸の中央値で行い、区間を半分に分ける
+	(左右の点数の差は高々1)。このため全ての葉は同じ深さとなり、
+	節点は分割軸と分割値のみをヒープ順(子は2i+1, 2i+2)の配列に持つ。
+	葉の点数はSHARAKU_KD_LEAF以下とする。
+	構築の上位の段は呼び出しスレッドで行い、以降の部分木は
+	thread_poolで並列に構築する。
+	探索は構築後に複数のスレッドから同時に行ってよい。
+*/
+class kd_tree
+{
+ public:
+	kd_tree() {}
+	kd_tree(const position3 *pts, size_t n, thread_pool *pool = nullptr) {
+		build(pts, n, pool);
+	}
+
+	/*********************************************************************/
+	/*! @brief 点群からk-d木を構築する
+
+		点の番号は配列の添字とする。
+
+		@param[in]      pts             点の配列
+		@param[in]      n               点数(UINT32_MAX未満)
+		@param[in]      pool            構築に使用するスレッドプール(NULL可)
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         none
+		@exception      none
+	**********************************************************************/
+	void build(const position3 *pts, size_t n, thread_pool *pool = nullptr) {
+		_items.resize(n);
+		for (size_t i = 0; i < n; i++) {
+			_items[i].p = pts[i];
+			_items[i].id = (uint32_t)i;
+		}
+		_depth = 0;
+		for (size_t c = n; c > SHARAKU_KD_LEAF; c = (c + 1) / 2) {
+			_depth++;
+		}
+		_nodes.resize(((size_t)1 << _depth) - 1);
+
+		// 深さsplitまでを呼び出しスレッドで構築し、以降の部分木を並列に構築する
+		size_t split = _depth;
+		if (pool && pool->size() > 1) {
+			split = 0;
+			while (split < _depth &&
+			       ((size_t)1 << split) < pool->size() * SHARAKU_PARALLEL_CHUNKS_PER_THREAD) {
+				split++;
+			}
+		}
+		_build(0, 0, n, 0, split);
+		if (pool && split < _depth) {
+			// 深さsplitの節点はヒープ順で連続する
+			const size_t first = ((size_t)1 << split) - 1;
+			pool->run((size_t)1 << split, [&](size_t c) {
+				size_t b, e;
+				_range(first + c, b, e);
+				_build(first + c, b, e, split, _depth);
+			});
+		}
+	}
+
+ public:
+	size_t size(void) const { return _items.size(); }
+	size_t depth(void) const { return _depth; }
+	// 並べ替え後の点(番号はid)
+	const spatial_item *items(void) const { return _items.data(); }
+
+	/*********************************************************************/
+	/*! @brief qのk近傍を探索する
+
+		@param[in]      q               探索位置
+		@param[in]      k               探索数
+		@param[out]     idx             距離の昇順の番号(k要素、不足分は
+		                                SHARAKU_SPATIAL_NONE)
+		@param[out]     d2              距離の2乗(k要素、不足分はINFINITY、NULL可)
+		@return         見つかった点の数
+		@exception      none
+	**********************************************************************/
+	size_t nearest(const position3& q, size_t k, uint32_t *idx, float *d2 = nullptr) const {
+		knn_heap heap;
+		heap.reset(k);
+		nearest(q, heap);
+		return heap.output(idx, d2);
+	}
+	// heapへqの近傍を加える(heapはreset()済みであること)
+	void nearest(const position3& q, knn_heap& heap) const {
+		if (!_items.empty()) {
+			_nearest(q, 0, 0, _items.size(), 0, heap);
+		}
+	}
+
+	/*********************************************************************/
+	/*! @brief qの最近傍を距離の2乗max_d2以内で探索する
+
+		k = 1の探索をヒープを使わずに行い、max_d2で枝刈りする。
+
+		@param[in]      q               探索位置
+		@param[in,out]  d2              入力は距離の2乗の上限、出力は
+		                                見つかった点までの距離の2乗
+		@return         見つかった点(items()内)。無ければNULL
+		@exception      none
+	**********************************************************************/
+	const spatial_item *closest(const position3& q, float& d2) const {
+		const spatial_item *best = nullptr;
+		if (!_items.empty()) {
+			_closest(q, 0, 0, _items.size(), 0, d2, best);
+		}
+		return best;
+	}
+
+	/*********************************************************************/
+	/*! @brief qから距離r以内の点を探索する
+
+		@param[in]      q               探索位置
+		@param[in]      r               半径
+		@param[out]     out             見つかった点の番号を追加する(順不同)
+		@return         見つかった点の数
+		@exception      none
+	**********************************************************************/
+	size_t radius(const position3& q, float r, std::vector<uint32_t>& out) const {
+		const size_t before = out.size();
+		if (!_items.empty()) {
+			_radius(q, r * r, 0, 0, _items.size(), 0, out);
+		}
+		return out.size() - before;
+	}
+
+	// q[0]～q[m-1]のk近傍(結果はq[i]ごとにk要素、poolで並列に探索する)
+	void nearest(const position3 *q, size_t m, size_t k, uint32_t *idx,
+		     float *d2 = nullptr, thread_pool *pool = nullptr) const {
+		sharaku_spatial_nearest(pool, *this, q, m, k, idx, d2);
+	}
+	// q[0]～q[m-1]の半径r以内の点
+	// (q[i]の結果はidx[offsets[i]]～idx[offsets[i + 1] - 1])
+	void radius(const position3 *q, size_t m, float r, std::vector<uint32_t>& offsets,
+		    std::vector<uint32_t>& idx, thread_pool *pool = nullptr) const {
+		sharaku_spatial_collect(pool, m, [&](size_t i, std::vector<uint32_t>& out) {
+			radius(q[i], r, out);
+		}, offsets, idx);
+	}
+
+ private:
+	struct _node {
+		float		split;	// 分割値
+		uint32_t	axis;	// 分割軸
+	};
+
+	// 節点nodeの範囲[b, e)を求める
+	void _range(size_t node, size_t& b, size_t& e) const {
+		size_t level = 0;
+		while ((((size_t)2 << level) - 1) <= node) {
+			level++;
+		}
+		b = 0;
+		e = _items.size();
+		const size_t pos = node - (((size_t)1 << level) - 1);
+		for (size_t l = level; l > 0; l--) {
+			const size_t mid = b + (e - b) / 2;
+			if ((pos >> (l - 1)) & 1) {
+				b = mid;
+			} else {
+				e = mid;
+			}
+		}
+	}
+
+	// 節点node(範囲[b, e)、深さdepth)から深さlimitまで構築する
+	void _build(size_t node, size_t b, size_t e, size_t depth, size_t limit) {
+		if (depth >= limit) {
+			return;
+		}
+		float lo[3] = {INFINITY, INFINITY, INFINITY};
+		float hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+		for (size_t i = b; i < e; i++) {
+			const position3& p = _items[i].p;
+			lo[0] = std::min(lo[0], p.x); hi[0] = std::max(hi[0], p.x);
+			lo[1] = std::min(lo[1], p.y); hi[1] = std::max(hi[1], p.y);
+			lo[2] = std::min(lo[2], p.z); hi[2] = std::max(hi[2], p.z);
+		}
+		uint32_t axis = 0;
+		for (uint32_t a = 1; a < 3; a++) {
+			if (hi[a] - lo[a] > hi[axis] - lo[axis]) {
+				axis = a;
+			}
+		}
+		const size_t mid = b + (e - b) / 2;
+		std::nth_element(_items.begin() + b, _items.begin() + mid, _items.begin() + e,
+				 [axis](const spatial_item& l, const spatial_item& r) {
+			return sharaku_axis(l.p, axis) < sharaku_axis(r.p, axis);
+		});
+		_nodes[node].split	= sharaku_axis(_items[mid].p, axis);
+		_nodes[node].axis	= axis;
+		_build(node * 2 + 1, b, mid, depth + 1, limit);
+		_build(node * 2 + 2, mid, e, depth + 1, limit);
+	}
+
+	void _nearest(const position3& q, size_t node, size_t b, size_t e,
+		      size_t depth, knn_heap& heap) const {
+		if (depth == _depth) {
+			for (size_t i = b; i < e; i++) {
+				heap.push(sharaku_distance2(q, _items[i].p), _items[i].id);
+			}
+			return;
+		}
+		const _node& nd = _nodes[node];
+		const size_t mid = b + (e - b) / 2;
+		const float diff = sharaku_axis(q, nd.axis) - nd.split;
+		if (diff < 0.0f) {
+			_nearest(q, node * 2 + 1, b, mid, depth + 1, heap);
+			if (diff * diff <= heap.bound()) {
+				_nearest(q, node * 2 + 2, mid, e, depth + 1, heap);
+			}
+		} else {
+			_nearest(q, node * 2 + 2, mid, e, depth + 1, heap);
+			if (diff * diff <= heap.bound()) {
+				_nearest(q, node * 2 + 1, b, mid, depth + 1, heap);
+			}
+		}
+	}
+
+	void _closest(const position3& q, size_t node, size_t b, size_t e,
+		      size_t depth, float& d2, const spatial_item *&best) const {
+		if (depth == _depth) {
+			for (size_t i = b; i < e; i++) {
+				const float d = sharaku_distance2(q, _items[i].p);
+				if (d <= d2) {
+					d2 = d;
+					best = &_items[i];
+				}
+			}
+			return;
+		}
+		const _node& nd = _nodes[node];
+		const size_t mid = b + (e - b) / 2;
+		const float diff = sharaku_axis(q, nd.axis) - nd.split;
+		if (diff < 0.0f) {
+			_closest(q, node * 2 + 1, b, mid, depth + 1, d2, best);
+			if (diff * diff <= d2) {
+				_closest(q, node * 2 + 2, mid, e, depth + 1, d2, best);
+			}
+		} else {
+			_closest(q, node * 2 + 2, mid, e, depth + 1, d2, best);
+			if (diff * diff <= d2) {
+				_closest(q, node * 2 + 1, b, mid, depth + 1, d2, best);
+			}
+		}
+	}
+
+	void _radius(const position3& q, float r2, size_t node, size_t b, size_t e,
+		     size_t depth, std::vector<uint32_t>& out) const {
+		if (depth == _depth) {
+			for (size_t i = b; i < e; i++) {
+				if (sharaku_distance2(q, _items[i].p) <= r2) {
+					out.push_back(_items[i].id);
+				}
+			}
+			return;
+		}
+		const _node& nd = _nodes[node];
+		const size_t mid = b + (e - b) / 2;
+		const float diff = sharaku_axis(q, nd.axis) - nd.split;
+		if (diff <= 0.0f || diff * diff <= r2) {
+			_radius(q, r2, node * 2 + 1, b, mid, depth + 1, out);
+		}
+		if (diff >= 0.0f || diff * diff <= r2) {
+			_radius(q, r2, node * 2 + 2, mid, e, depth + 1, out);
+		}
+	}
+
+ protected:
+	std::vector<spatial_item>	_items;		// 並べ替えた点
+	std::vector<_node>		_nodes;		// 節点(ヒープ順)
+	size_t				_depth = 0;	// 葉の深さ
+};
+
+/*! @class hash_grid
+    @brief  position3の一様格子による動的な空間インデックス
+
+	空間を一辺cellの立方体に分割し、点を含むセルのハッシュ表へ登録する。
+	点の追加、削除、移動はそのセルの点列のみを更新するため、
+	フレームごとに一部の点が動く場合に木の再構築が不要となる。
+	番号は呼び出し側が割り当てる(番号の最大値に比例する表を持つため、
+	0から詰めて使用すること)。
+	セル座標は各軸21bitに折り返してキーとするため、遠く離れたセルが
+	同じキーとなる場合があるが、探索は距離を確認するため結果は変わらない。
+	探索は更新と同時に行わないこと(探索同士は同時に行ってよい)。
+	セルの一辺はradius探索の半径程度とするのがよい。
+*/
+class hash_grid
+{
+ public:
+	explicit hash_grid(float cell) : _cell(cell), _inv(1.0f / cell) {}
+
+	/*********************************************************************/
+	/*! @brief 番号idの点を位置pに登録する(登録済みの場合は移動する)
+
+		@param[in]      id              番号(SHARAKU_SPATIAL_NONE未満)
+		@param[in]      p               位置
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         none
+		@exception      none
+	**********************************************************************/
+	void insert(uint32_t id, const position3& p) {
+		if (id >= _key.size()) {
+			_key.resize((size_t)id + 1, _NONE);
+		}
+		const uint64_t key = _key_of(p);
+		if (_key[id] == key) {
+			// 同じセル内の移動
+			std::vector<spatial_item>& cell = _cells[key];
+			for (spatial_item& it : cell) {
+				if (it.id == id) {
+					it.p = p;
+					break;
+				}
+			}
+			return;
+		}
+		if (_key[id] != _NONE) {
+			_remove(_key[id], id);
+		} else {
+			_n++;
+		}
+		_key[id] = key;
+		_cells[key].push_back(spatial_item{p, id});
+	}
+	// 番号idの点を移動する(insertと同じ)
+	void update(uint32_t id, const position3& p) {
+		insert(id, p);
+	}
+	// 番号idの点を削除する(登録されていない場合はfalse)
+	bool erase(uint32_t id) {
+		if (!contains(id)) {
+			return false;
+		}
+		_remove(_key[id], id);
+		_key[id] = _NONE;
+		_n--;
+		return true;
+	}
+	void clear(void) {
+		_cells.clear();
+		_key.clear();
+		_n = 0;
+	}
+
+ public:
+	size_t size(void) const { return _n; }
+	float cell(void) const { return _cell; }
+	bool contains(uint32_t id) const {
+		return id < _key.size() && _key[id] != _NONE;
+	}
+
+	/*********************************************************************/
+	/*! @brief qのk近傍を探索する
+
+		qを含むセルから外側へ1周ずつセルを調べ、k個見つかり、かつ
+		k番目の距離が未調査のセルまでの最短距離以下となった時点で終了する。
+		次の周のセル数が登録セル数を超えた場合は、残りの登録セルを
+		直接調べて終了する(疎な点群や点から離れた位置の探索で、
+		空のセルを周ごとに調べ続けないため)。
+
+		@param[in]      q               探索位置
+		@param[in]      k               探索数
+		@param[out]     idx             距離の昇順の番号(k要素、不足分は
+		                                SHARAKU_SPATIAL_NONE)
+		@param[out]     d2              距離の2乗(k要素、不足分はINFINITY、NULL可)
+		@return         見つかった点の数
+		@exception      none
+	**********************************************************************/
+	size_t nearest(const position3& q, size_t k, uint32_t *idx, float *d2 = nullptr) const {
+		knn_heap heap;
+		heap.reset(k);
+		nearest(q, heap);
+		return heap.output(idx, d2);
+	}
+	// heapへqの近傍を加える(heapはreset()済みであること)
+	void nearest(const position3& q, knn_heap& heap) const {
+		const int32_t cx = _coord(q.x), cy = _coord(q.y), cz = _coord(q.z);
+		size_t visited = 0;
+		for (int32_t s = 0; visited < _n; s++) {
+			// 周sのセル数は(2s + 1)^3 - (2s - 1)^3 = 24s^2 + 2
+			const size_t shell = (s == 0) ? 1 : (size_t)24 * s * s + 2;
+			if (shell > _cells.size()) {
+				_scan_outside(cx, cy, cz, s, q, heap);
+				break;
+			}
+			for (int32_t dz = -s; dz <= s; dz++) {
+				for (int32_t dy = -s; dy <= s; dy++) {
+					const bool edge = (dz == -s || dz == s || dy == -s || dy == s);
+					// 周の上のセルのみ(内側は調査済み)
+					for (int32_t dx = -s; dx <= s; dx += (edge || s == 0) ? 1 : 2 * s) {
+						visited += _scan(_key_of(cx + dx, cy + dy, cz + dz), q, heap);
+					}
+				}
+			}
+			// 未調査のセルまでの距離はs * cell以上
+			const float reach = (float)s * _cell;
+			if (heap.bound() <= reach * reach) {
+				break;
+			}
+		}
+	}
+
+	/*********************************************************************/
+	/*! @brief qから距離r以内の点を探索する
+
+		@param[in]      q               探索位置
+		@param[in]      r               半径
+		@param[out]     out             見つかった点の番号を追加する(順不同)
+		@return         見つかった点の数
+		@exception      none
+	**********************************************************************/
+	size_t radius(const position3& q, float r, std::vector<uint32_t>& out) const {
+		const size_t before = out.size();
+		const float r2 = r * r;
+		const int32_t x0 = _coord(q.x - r), x1 = _coord(q.x + r);
+		const int32_t y0 = _coord(q.y - r), y1 = _coord(q.y + r);
+		const int32_t z0 = _coord(q.z - r), z1 = _coord(q.z + r);
+		for (int32_t z = z0; z <= z1; z++) {
+			for (int32_t y = y0; y <= y1; y++) {
+				for (int32_t x = x0; x <= x1; x++) {
+					auto it = _cells.find(_key_of(x, y, z));
+					if (it == _cells.end()) {
+						continue;
+					}
+					for (const spatial_item& p : it->second) {
+						if (sharaku_distance2(q, p.p) <= r2) {
+							out.push_back(p.id);
+						}
+					}
+				}
+			}
+		}
+		return out.size() - before;
+	}
+
+	// q[0]～q[m-1]のk近傍(結果はq[i]ごとにk要素、poolで並列に探索する)
+	void nearest(const position3 *q, size_t m, size_t k, uint32_t *idx,
+		     float *d2 = nullptr, thread_pool *pool = nullptr) const {
+		sharaku_spatial_nearest(pool, *this, q, m, k, idx, d2);
+	}
+	// q[0]～q[m-1]の半径r以内の点
+	// (q[i]の結果はidx[offsets[i]]～idx[offsets[i + 1] - 1])
+	void radius(const position3 *q, size_t m, float r, std::vector<uint32_t>& offsets,
+		    std::vector<uint32_t>& idx, thread_pool *pool = nullptr) const {
+		sharaku_spatial_collect(pool, m, [&](size_t i, std::vector<uint32_t>& out) {
+			radius(q[i], r, out);
+		}, offsets, idx);
+	}
+
+ private:
+	static constexpr uint64_t _NONE = UINT64_MAX;
+
+	int32_t _coord(float v) const {
+		return (int32_t)floorf(v * _inv);
+	}
+	static uint64_t _key_of(int32_t x, int32_t y, int32_t z) {
+		const uint64_t m = 0x1FFFFF;
+		return (((uint64_t)x & m) << 42) | (((uint64_t)y & m) << 21) | ((uint64_t)z & m);
+	}
+	uint64_t _key_of(const position3& p) const {
+		return _key_of(_coord(p.x), _coord(p.y), _coord(p.z));
+	}
+	// セルkeyの点をheapへ加え、点数を返す
+	size_t _scan(uint64_t key, const position3& q, knn_heap& heap) const {
+		auto it = _cells.find(key);
+		if (it == _cells.end()) {
+			return 0;
+		}
+		for (const spatial_item& p : it->second) {
+			heap.push(sharaku_distance2(q, p.p), p.id);
+		}
+		return it->second.size();
+	}
+	// (cx, cy, cz)から周s以上離れた登録セルの点をheapへ加える
+	void _scan_outside(int32_t cx, int32_t cy, int32_t cz, int32_t s,
+			   const position3& q, knn_heap& heap) const {
+		for (const auto& c : _cells) {
+			if (_ring(c.first, cx, cy, cz) < s) {
+				continue;	// 調査済み
+			}
+			for (const spatial_item& p : c.second) {
+				heap.push(sharaku_distance2(q, p.p), p.id);
+			}
+		}
+	}
+	// セルkeyが(cx, cy, cz)の何周目にあるか(キーと同じく21bitで折り返す)
+	static int32_t _ring(uint64_t key, int32_t cx, int32_t cy, int32_t cz) {
+		const uint64_t m = 0x1FFFFF;
+		const int32_t c[3] = {cz, cy, cx};
+		int32_t r = 0;
+		for (int i = 0; i < 3; i++) {
+			int32_t d = (int32_t)(((key >> (21 * i)) - (uint64_t)c[i]) & m);
+			d = (d ^ 0x100000) - 0x100000;		// 符号拡張
+			d = (d < 0) ? -d : d;
+			r = (d > r) ? d : r;
+		}
+		return r;
+	}
+	void _remove(uint64_t key, uint32_t id) {
+		auto it = _cells.find(key);
+		std::vector<spatial_item>& cell = it->second;
+		for (size_t i = 0; i < cell.size(); i++) {
+			if (cell[i].id == id) {
+				cell[i] = cell.back();
+				cell.pop_back();
+				break;
+			}
+		}
+		if (cell.empty()) {
+			_cells.erase(it);
+		}
+	}
+
+ protected:
+	float		_cell;		// セルの一辺
+	float		_inv;		// 1 / _cell
+	size_t		_n = 0;		// 登録点数
+	std::vector<uint64_t>	_key;	// 番号ごとのセルのキー(未登録は_NONE)
+	std::unordered_map<uint64_t, std::vector<spatial_item>>	_cells;
+};
+
+
+#endif // SHARAKU_MM_SPATIAL_INDEX_H_
@@ -0,0 +1,364 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_MM_TRAJECTORY_H_
+#define SHARAKU_MM_TRAJECTORY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <vector>
+#include <libsharaku/type/vector.hpp>
+#include <libsharaku/type/position.hpp>
+#include <libsharaku/type/rotation.hpp>
+
+// trajectory_writerの書き込みバッファのサイズ(byte)
+#define SHARAKU_TRAJECTORY_BUFFER	(64 * 1024)
+
+/* ========================================================================= */
+/* struct definition Section                                                 */
+/* ========================================================================= */
+
+/*! @class pose3
+    @brief  位置と姿勢の組
+*/
+struct pose3 {
+ public:
+	position3	position;	///< 位置
+	rotation3	rotation;	///< 姿勢(度単位のオイラー角)
+};
+
+static_assert(std::is_trivially_copyable<pose3>::value, "pose3 must be trivially copyable");
+static_assert(sizeof(pose3) == 24, "pose3 must be 24 bytes");
+
+// 軌跡ファイルに格納できる型と、ヘッダに記録する型番号
+template <class T> struct trajectory_type;
+template <> struct trajectory_type<vector3> { enum { id = 1 }; };
+template <> struct trajectory_type<position3> { enum { id = 2 }; };
+template <> struct trajectory_type<rotation3> { enum { id = 3 }; };
+template <> struct trajectory_type<pose3> { enum { id = 4 }; };
+
+/*! @class trajectory_header
+    @brief  軌跡ファイルのヘッダ
+
+	軌跡ファイルは64byteのヘッダと、それに続くcount個のレコード
+	(型Tのメモリ表現そのもの)からなる。レコードは書き込んだ環境の
+	バイト順で格納し、i番目のレコードの時刻はt0_ns + i * timestep_nsとする。
+*/
+struct trajectory_header {
+ public:
+	char		magic[8];	///< "SHKTRAJ"
+	uint32_t	endian;		///< 0x01020304(書き込んだ環境のバイト順)
+	uint16_t	version;	///< 形式のバージョン
+	uint16_t	type;		///< レコードの型番号(trajectory_type)
+	uint32_t	record_size;	///< レコードのサイズ(byte)
+	uint32_t	reserved0;
+	uint64_t	count;		///< レコード数
+	int64_t		timestep_ns;	///< レコードの時間間隔(ns)
+	int64_t		t0_ns;		///< 先頭レコードの時刻(ns)
+	uint8_t		reserved[16];
+
+ public:
+	static constexpr uint32_t ENDIAN = 0x01020304;
+	static constexpr uint16_t VERSION = 1;
+
+	// 型Tのファイルのヘッダを作成する
+	template <class T>
+	static trajectory_header make(int64_t timestep_ns, int64_t t0_ns) {
+		trajectory_header h;
+		memset(&h, 0, sizeof(h));
+		memcpy(h.magic, "SHKTRAJ", 8);
+		h.endian	= ENDIAN;
+		h.version	= VERSION;
+		h.type		= trajectory_type<T>::id;
+		h.record_size	= sizeof(T);
+		h.timestep_ns	= timestep_ns;
+		h.t0_ns		= t0_ns;
+		return h;
+	}
+	// 型Tのファイルとして読み込めるか(バイト順が異なる場合も不可)
+	template <class T>
+	bool valid(void) const {
+		return memcmp(magic, "SHKTRAJ", 8) == 0 && endian == ENDIAN &&
+		       version == VERSION && type == trajectory_type<T>::id &&
+		       record_size == sizeof(T);
+	}
+};
+
+static_assert(sizeof(trajectory_header) == 64, "trajectory_header must be 64 bytes");
+
+/* ========================================================================= */
+/* class definition Section                                                  */
+/* ========================================================================= */
+
+/*! @class trajectory_writer
+    @brief  軌跡ファイルへの追記専用の書き込み
+
+	レコードは内部バッファ(SHARAKU_TRAJECTORY_BUFFER)へ溜め、
+	バッファが満杯になった時点とflush()、close()でまとめて書き込む。
+	ヘッダのレコード数は書き込みのたびに更新するため、書き込み中の
+	ファイルもflush()済みの範囲は読み込める。
+	バッファは確定済みのレコードの直後へ書き込むため、書き込みに失敗
+	した後のflush()の再試行で同じレコードが重複することはない。
+*/
+template <class T>
+class trajectory_writer
+{
+ public:
+	trajectory_writer() {}
+	~trajectory_writer() {
+		close();
+	}
+	trajectory_writer(const trajectory_writer&) = delete;
+	trajectory_writer& operator=(const trajectory_writer&) = delete;
+
+	/*********************************************************************/
+	/*! @brief 軌跡ファイルを作成する(既存のファイルは切り詰める)
+
+		@param[in]      path            ファイルのパス
+		@param[in]      timestep_ns     レコードの時間間隔(ns)
+		@param[in]      t0_ns           先頭レコードの時刻(ns)
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         成功した場合true
+		@exception      none
+	**********************************************************************/
+	bool open(const char *path, int64_t timestep_ns, int64_t t0_ns = 0) {
+		close();
+		_fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (_fd < 0) {
+			return false;
+		}
+		_header = trajectory_header::make<T>(timestep_ns, t0_ns);
+		_synced = 0;
+		_buf.clear();
+		_buf.reserve(_capacity());
+		if (!_write(&_header, sizeof(_header), 0)) {
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	// レコードを追記する(開いていない場合はfalse)
+	bool append(const T& v) {
+		if (_fd < 0 || (_buf.size() == _capacity() && !flush())) {
+			return false;
+		}
+		_buf.push_back(v);
+		return true;
+	}
+	// v[0]～v[n-1]を追記する
+	//  falseを返した場合も、先頭の一部はバッファへ追加済みの場合がある
+	//  (追加済みの数はsize()の増分で確認できる)。
+	bool append(const T *v, size_t n) {
+		if (_fd < 0) {
+			return false;
+		}
+		while (n) {
+			if (_buf.size() == _capacity() && !flush()) {
+				return false;
+			}
+			size_t m = _capacity() - _buf.size();
+			m = (m < n) ? m : n;
+			_buf.insert(_buf.end(), v, v + m);
+			v += m;
+			n -= m;
+		}
+		return true;
+	}
+
+	// バッファのレコードを書き込み、ヘッダのレコード数を更新する
+	//  失敗した場合はバッファを残し、再度呼び出すと同じ位置から書き直す。
+	bool flush(void) {
+		if (_fd < 0) {
+			return false;
+		}
+		if (!_buf.empty()) {
+			const off_t off = sizeof(trajectory_header) + sizeof(T) * _header.count;
+			if (!_write(_buf.data(), sizeof(T) * _buf.size(), off)) {
+				// 途中まで書き込んだレコードを切り捨てる
+				(void)::ftruncate(_fd, off);
+				return false;
+			}
+			_header.count += _buf.size();
+			_buf.clear();
+		}
+		if (_synced != _header.count) {
+			if (!_write(&_header.count, sizeof(_header.count),
+				    offsetof(trajectory_header, count))) {
+				return false;
+			}
+			_synced = _header.count;
+		}
+		return true;
+	}
+
+	// バッファを書き込んでファイルを閉じる
+	bool close(void) {
+		if (_fd < 0) {
+			return true;
+		}
+		const bool ok = flush();
+		::close(_fd);
+		_fd = -1;
+		return ok;
+	}
+
+ public:
+	// 追記したレコード数(バッファ内を含む)
+	uint64_t size(void) const { return _header.count + _buf.size(); }
+	bool is_open(void) const { return _fd >= 0; }
+
+ private:
+	static size_t _capacity(void) {
+		return (SHARAKU_TRAJECTORY_BUFFER + sizeof(T) - 1) / sizeof(T);
+	}
+	bool _write(const void *p, size_t size, off_t off) {
+		const char *c = (const char *)p;
+		while (size) {
+			const ssize_t n = ::pwrite(_fd, c, size, off);
+			if (n < 0 && errno == EINTR) {
+				continue;	// シグナルによる中断は再試行する
+			}
+			if (n <= 0) {
+				return false;
+			}
+			c += n;
+			off += n;
+			size -= n;
+		}
+		return true;
+	}
+
+ protected:
+	int			_fd = -1;
+	trajectory_header	_header{};
+	uint64_t		_synced = 0;	// ファイルのヘッダに書き込んだレコード数
+	std::vector<T>		_buf;		// 書き込みバッファ
+};
+
+/*! @class trajectory_reader
+    @brief  軌跡ファイルのmmapによる読み込み
+
+	ファイル全体を読み込み専用でmmapし、レコードを複製せずに
+	型Tの配列として公開する。レコード数はヘッダのレコード数と
+	ファイルサイズから求まる数の小さい方とする(書き込み中のファイル
+	の場合は最後にflush()した範囲となる)。
+	バイト順、型、レコードサイズが異なるファイルは開けない。
+*/
+template <class T>
+class trajectory_reader
+{
+ public:
+	trajectory_reader() {}
+	~trajectory_reader() {
+		close();
+	}
+	trajectory_reader(const trajectory_reader&) = delete;
+	trajectory_reader& operator=(const trajectory_reader&) = delete;
+
+	/*********************************************************************/
+	/*! @brief 軌跡ファイルを開く
+
+		@param[in]      path            ファイルのパス
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         成功した場合true
+		@exception      none
+	**********************************************************************/
+	bool open(const char *path) {
+		close();
+		const int fd = ::open(path, O_RDONLY);
+		if (fd < 0) {
+			return false;
+		}
+		struct stat st;
+		if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(trajectory_header)) {
+			::close(fd);
+			return false;
+		}
+		void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (p == MAP_FAILED) {
+			return false;
+		}
+		_map	= p;
+		_len	= st.st_size;
+		if (!header().template valid<T>()) {
+			close();
+			return false;
+		}
+		const uint64_t avail = (_len - sizeof(trajectory_header)) / sizeof(T);
+		_n = (header().count < avail) ? header().count : avail;
+		madvise(_map, _len, MADV_SEQUENTIAL);
+		return true;
+	}
+	void close(void) {
+		if (_map) {
+			munmap(_map, _len);
+		}
+		_map	= nullptr;
+		_len	= 0;
+		_n	= 0;
+	}
+
+ public:
+	bool is_open(void) const { return _map != nullptr; }
+	const trajectory_header& header(void) const {
+		return *(const trajectory_header *)_map;
+	}
+	size_t size(void) const { return _n; }
+	const T *data(void) const {
+		return (const T *)((const char *)_map + sizeof(trajectory_header));
+	}
+	const T *begin(void) const { return data(); }
+	const T *end(void) const { return data() + _n; }
+	const T& operator[](size_t i) const { return data()[i]; }
+
+	// i番目のレコードの時刻(ns)
+	int64_t time_ns(size_t i) const {
+		return header().t0_ns + (int64_t)i * header().timestep_ns;
+	}
+
+ protected:
+	void	*_map = nullptr;
+	size_t	_len = 0;
+	size_t	_n = 0;
+};
+
+
+#endif // SHARAKU_MM_TRAJECTORY_H_
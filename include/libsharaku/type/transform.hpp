@@ -0,0 +1,295 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_MM_TRANSFORM_H_
+#define SHARAKU_MM_TRANSFORM_H_
+
+#include <stddef.h>
+#include <math.h>
+#include <type_traits>
+#include <libsharaku/type/simd.hpp>
+#include <libsharaku/type/vector.hpp>
+#include <libsharaku/type/position.hpp>
+#include <libsharaku/type/rotation.hpp>
+#include <libsharaku/type/quaternion.hpp>
+
+/* ========================================================================= */
+/* struct definition Section                                                 */
+/* ========================================================================= */
+
+/*! @class rotation_matrix3
+    @brief  3x3回転行列構造体
+
+	rotation3(度単位のオイラー角)から一度だけsin/cosを計算して構築し、
+	以後の座標変換を乗算と加算のみで行う。
+	回転順序はquaternionと同一(R = Rz * Ry * Rx)である。
+*/
+struct rotation_matrix3 {
+ public:
+	float m[3][3]; ///< 行列要素(行優先)
+
+ public:
+	/*********************************************************************/
+	/*! @brief vector3を回転する
+
+		@param[in]      vec             回転するvector3
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         回転後のvector3
+		@exception      none
+	**********************************************************************/
+	constexpr vector3 apply(const vector3& vec) const {
+		return vector3{m[0][0] * vec.x + m[0][1] * vec.y + m[0][2] * vec.z,
+			       m[1][0] * vec.x + m[1][1] * vec.y + m[1][2] * vec.z,
+			       m[2][0] * vec.x + m[2][1] * vec.y + m[2][2] * vec.z};
+	}
+	constexpr position3 apply(const position3& pos) const {
+		return position3{m[0][0] * pos.x + m[0][1] * pos.y + m[0][2] * pos.z,
+				 m[1][0] * pos.x + m[1][1] * pos.y + m[1][2] * pos.z,
+				 m[2][0] * pos.x + m[2][1] * pos.y + m[2][2] * pos.z};
+	}
+
+	// n要素を一括で回転する(outはinと同一でもよい)
+	void apply(const vector3 *in, vector3 *out, size_t n) const {
+		_apply((const float *)in, (float *)out, n, 0.0f, 0.0f, 0.0f);
+	}
+	void apply(const position3 *in, position3 *out, size_t n) const {
+		_apply((const float *)in, (float *)out, n, 0.0f, 0.0f, 0.0f);
+	}
+
+	// 逆回転(転置行列)を返す
+	constexpr rotation_matrix3 inverse(void) const {
+		return rotation_matrix3{{{m[0][0], m[1][0], m[2][0]},
+					 {m[0][1], m[1][1], m[2][1]},
+					 {m[0][2], m[1][2], m[2][2]}}};
+	}
+
+	/*********************************************************************/
+	/*! @brief rotation3(度単位のオイラー角)から回転行列を構築する
+
+		@param[in]      rot             変換するrotation3
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         回転行列
+		@exception      none
+	**********************************************************************/
+	static rotation_matrix3 from_rotation(const rotation3& rot) {
+		const float cx = cosf(rot.x * M_PI_180), sx = sinf(rot.x * M_PI_180);
+		const float cy = cosf(rot.y * M_PI_180), sy = sinf(rot.y * M_PI_180);
+		const float cz = cosf(rot.z * M_PI_180), sz = sinf(rot.z * M_PI_180);
+		return rotation_matrix3{{{cz * cy, cz * sy * sx - sz * cx, cz * sy * cx + sz * sx},
+					 {sz * cy, sz * sy * sx + cz * cx, sz * sy * cx - cz * sx},
+					 {-sy, cy * sx, cy * cx}}};
+	}
+
+	// 正規化された四元数から回転行列を構築する
+	static constexpr rotation_matrix3 from_quaternion(const quaternion& q) {
+		return rotation_matrix3{{
+			{1.0f - 2.0f * (q.y * q.y + q.z * q.z),
+			 2.0f * (q.x * q.y - q.w * q.z),
+			 2.0f * (q.x * q.z + q.w * q.y)},
+			{2.0f * (q.x * q.y + q.w * q.z),
+			 1.0f - 2.0f * (q.x * q.x + q.z * q.z),
+			 2.0f * (q.y * q.z - q.w * q.x)},
+			{2.0f * (q.x * q.z - q.w * q.y),
+			 2.0f * (q.y * q.z + q.w * q.x),
+			 1.0f - 2.0f * (q.x * q.x + q.y * q.y)}}};
+	}
+
+	/*********************************************************************/
+	/*! @brief 回転行列をrotation3(度単位のオイラー角)へ変換する
+
+		y軸の回転角は[-90, 90]、x, z軸は(-180, 180]の範囲となる。
+
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         変換後のrotation3
+		@exception      none
+	**********************************************************************/
+	rotation3 to_rotation(void) const {
+		float sy = -m[2][0];
+		sy = (sy > 1.0f) ? 1.0f : ((sy < -1.0f) ? -1.0f : sy);
+		return rotation3{atan2f(m[2][1], m[2][2]) / M_PI_180,
+				 asinf(sy) / M_PI_180,
+				 atan2f(m[1][0], m[0][0]) / M_PI_180};
+	}
+
+	// 回転なしを表す行列
+	static constexpr rotation_matrix3 identity(void) {
+		return rotation_matrix3{{{1.0f, 0.0f, 0.0f},
+					 {0.0f, 1.0f, 0.0f},
+					 {0.0f, 0.0f, 1.0f}}};
+	}
+
+ private:
+	friend struct transform3;
+
+	// in/outはx, y, zを繰り返し並べたn要素分のfloat配列
+	//  out = m * in + (tx, ty, tz)
+	void _apply(const float *in, float *out, size_t n,
+		    float tx, float ty, float tz) const {
+		typedef sharaku_simd	S;
+		const size_t W = S::width;
+		const S::f32 m00 = S::set1(m[0][0]), m01 = S::set1(m[0][1]), m02 = S::set1(m[0][2]);
+		const S::f32 m10 = S::set1(m[1][0]), m11 = S::set1(m[1][1]), m12 = S::set1(m[1][2]);
+		const S::f32 m20 = S::set1(m[2][0]), m21 = S::set1(m[2][1]), m22 = S::set1(m[2][2]);
+		const S::f32 vtx = S::set1(tx), vty = S::set1(ty), vtz = S::set1(tz);
+		size_t i = 0;
+		for (; i + W <= n; i += W) {
+			S::f32 x, y, z;
+			S::load3(in + i * 3, x, y, z);
+			S::f32 ox = S::add(S::add(S::add(S::mul(m00, x), S::mul(m01, y)),
+						  S::mul(m02, z)), vtx);
+			S::f32 oy = S::add(S::add(S::add(S::mul(m10, x), S::mul(m11, y)),
+						  S::mul(m12, z)), vty);
+			S::f32 oz = S::add(S::add(S::add(S::mul(m20, x), S::mul(m21, y)),
+						  S::mul(m22, z)), vtz);
+			S::store3(out + i * 3, ox, oy, oz);
+		}
+		for (; i < n; i++) {
+			const float x = in[i * 3], y = in[i * 3 + 1], z = in[i * 3 + 2];
+			out[i * 3]	= m[0][0] * x + m[0][1] * y + m[0][2] * z + tx;
+			out[i * 3 + 1]	= m[1][0] * x + m[1][1] * y + m[1][2] * z + ty;
+			out[i * 3 + 2]	= m[2][0] * x + m[2][1] * y + m[2][2] * z + tz;
+		}
+	}
+};
+
+/*********************************************************************/
+/*! @brief 回転を合成する
+
+	@param[in]      lhs             後に適用する回転
+	@param[in]      rhs             先に適用する回転
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         合成結果(rhsを適用した後にlhsを適用する回転)
+	@exception      none
+**********************************************************************/
+constexpr rotation_matrix3
+operator*(const rotation_matrix3& lhs, const rotation_matrix3& rhs)
+{
+	rotation_matrix3 r{};
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			r.m[i][j] = lhs.m[i][0] * rhs.m[0][j] +
+				    lhs.m[i][1] * rhs.m[1][j] +
+				    lhs.m[i][2] * rhs.m[2][j];
+		}
+	}
+	return r;
+}
+
+/*! @class transform3
+    @brief  回転と平行移動からなる座標変換構造体
+
+	position3に対しては回転の後に平行移動を行い(p' = R * p + t)、
+	vector3(移動量)に対しては回転のみを行う。
+*/
+struct transform3 {
+ public:
+	rotation_matrix3	rot;	///< 回転
+	vector3			trans;	///< 平行移動
+
+ public:
+	constexpr position3 apply(const position3& pos) const {
+		return rot.apply(pos) + trans;
+	}
+	constexpr vector3 apply(const vector3& vec) const {
+		return rot.apply(vec);
+	}
+
+	/*********************************************************************/
+	/*! @brief n個のposition3を一括で座標変換する
+
+		x, y, zをSIMDレーンへ並べ替えて、width要素ずつ変換する。
+
+		@param[in]      in              変換するposition3の配列
+		@param[out]     out             変換結果の格納先(inと同一でもよい)
+		@param[in]      n               要素数
+		@par            Refer
+		- 参照するグローバル変数 none
+		@par            Modify
+		- 変更するグローバル変数 none
+		@return         none
+		@exception      none
+	**********************************************************************/
+	void apply(const position3 *in, position3 *out, size_t n) const {
+		rot._apply((const float *)in, (float *)out, n, trans.x, trans.y, trans.z);
+	}
+	// n個のvector3を一括で回転する(outはinと同一でもよい)
+	void apply(const vector3 *in, vector3 *out, size_t n) const {
+		rot.apply(in, out, n);
+	}
+
+	// 逆変換を返す
+	constexpr transform3 inverse(void) const {
+		const rotation_matrix3 r = rot.inverse();
+		const vector3 t = r.apply(trans);
+		return transform3{r, vector3{-t.x, -t.y, -t.z}};
+	}
+
+	// rotation3(度単位のオイラー角)と平行移動から構築する
+	static transform3 from_rotation(const rotation3& r, const vector3& t) {
+		return transform3{rotation_matrix3::from_rotation(r), t};
+	}
+
+	// 変換なしを表す座標変換
+	static constexpr transform3 identity(void) {
+		return transform3{rotation_matrix3::identity(), vector3{0.0f, 0.0f, 0.0f}};
+	}
+};
+
+/*********************************************************************/
+/*! @brief 座標変換を合成する
+
+	@param[in]      lhs             後に適用する座標変換
+	@param[in]      rhs             先に適用する座標変換
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         合成結果(rhsを適用した後にlhsを適用する座標変換)
+	@exception      none
+**********************************************************************/
+constexpr transform3
+operator*(const transform3& lhs, const transform3& rhs)
+{
+	return transform3{lhs.rot * rhs.rot, lhs.rot.apply(rhs.trans) + lhs.trans};
+}
+
+static_assert(std::is_trivially_copyable<rotation_matrix3>::value, "rotation_matrix3 must be trivially copyable");
+static_assert(std::is_trivially_copyable<transform3>::value, "transform3 must be trivially copyable");
+
+
+#endif // SHARAKU_MM_TRANSFORM_H_
@@ -0,0 +1,213 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_MM_VECTOR_SOA_H_
+#define SHARAKU_MM_VECTOR_SOA_H_
+
+#include <string.h>
+#include <assert.h>
+#include <libsharaku/type/simd.hpp>
+#include <libsharaku/type/vector.hpp>
+
+/* ========================================================================= */
+/* class definition Section                                                  */
+/* ========================================================================= */
+
+/*! @class vector3_soa
+    @brief  vector3の配列をx[], y[], z[]のレーンに分割して保持するバッチ型
+
+	各レーンはSHARAKU_SIMD_ALIGN境界に配置し、レーン長はその倍数へ
+	切り上げる。x, y, zのレーンは1つの領域に連続して配置されるため、
+	成分ごとに独立な演算は3レーン分を1回のSIMDループで処理する。
+	切り上げた余白は常に0であり、外部には公開しない。
+*/
+class vector3_soa
+{
+ public:
+	explicit vector3_soa(size_t n) {
+		_init(n);
+	}
+	vector3_soa(const vector3 *src, size_t n) {
+		_init(n);
+		load(src, n);
+	}
+	vector3_soa(vector3_soa&& soa) {
+		_n = soa._n; _cap = soa._cap; _buf = soa._buf;
+		soa._n = 0; soa._cap = 0; soa._buf = nullptr;
+	}
+	~vector3_soa() {
+		if (_buf) {
+			sharaku_simd::free(_buf);
+		}
+	}
+	vector3_soa(const vector3_soa&) = delete;
+	vector3_soa& operator=(const vector3_soa&) = delete;
+
+ public:
+	size_t size(void) const { return _n; }
+
+	float *x(void) { return _buf; }
+	float *y(void) { return _buf + _cap; }
+	float *z(void) { return _buf + _cap * 2; }
+	const float *x(void) const { return _buf; }
+	const float *y(void) const { return _buf + _cap; }
+	const float *z(void) const { return _buf + _cap * 2; }
+
+	/*********************************************************************/
+	/*! @brief i番目の要素をvector3として取得する
+
+		@param[in]      i               要素番号
+		@return         i番目の要素
+		@exception      none
+	**********************************************************************/
+	vector3 get(size_t i) const {
+		vector3 vec;
+		vec(x()[i], y()[i], z()[i]);
+		return vec;
+	}
+
+	/*********************************************************************/
+	/*! @brief i番目の要素にvector3を設定する
+
+		@param[in]      i               要素番号
+		@param[in]      vec             設定するvector3
+		@exception      none
+	**********************************************************************/
+	void set(size_t i, const vector3& vec) {
+		x()[i] = vec.x; y()[i] = vec.y; z()[i] = vec.z;
+	}
+
+	/*********************************************************************/
+	/*! @brief vector3の配列から先頭n要素を読み込む
+
+		@param[in]      src             読み込むvector3配列
+		@param[in]      n               要素数(size()以下)
+		@exception      none
+	**********************************************************************/
+	void load(const vector3 *src, size_t n) {
+		float *px = x(), *py = y(), *pz = z();
+		for (size_t i = 0; i < n; i++) {
+			px[i] = src[i].x; py[i] = src[i].y; pz[i] = src[i].z;
+		}
+	}
+
+	/*********************************************************************/
+	/*! @brief 全要素をvector3の配列へ書き出す
+
+		@param[out]     dst             書き出し先(size()要素分)
+		@exception      none
+	**********************************************************************/
+	void store(vector3 *dst) const {
+		const float *px = x(), *py = y(), *pz = z();
+		for (size_t i = 0; i < _n; i++) {
+			dst[i].x = px[i]; dst[i].y = py[i]; dst[i].z = pz[i];
+		}
+	}
+
+	/*********************************************************************/
+	/*! @brief 要素ごとに加算を行い、結果を自身に反映する
+
+		@param[in]      soa             加算するvector3_soa(同一要素数)
+		@return         加算結果
+		@exception      none
+	**********************************************************************/
+	vector3_soa& operator+=(const vector3_soa& soa) {
+		assert(size() == soa.size());
+		sharaku_simd_add(_buf, _buf, soa._buf, _cap * 3);
+		return (*this);
+	}
+
+	/*********************************************************************/
+	/*! @brief 要素ごとに減算を行い、結果を自身に反映する
+
+		@param[in]      soa             減算するvector3_soa(同一要素数)
+		@return         減算結果
+		@exception      none
+	**********************************************************************/
+	vector3_soa& operator-=(const vector3_soa& soa) {
+		assert(size() == soa.size());
+		sharaku_simd_sub(_buf, _buf, soa._buf, _cap * 3);
+		return (*this);
+	}
+
+	/*********************************************************************/
+	/*! @brief 全要素をスカラ倍し、結果を自身に反映する
+
+		@param[in]      s               倍率
+		@return         演算結果
+		@exception      none
+	**********************************************************************/
+	vector3_soa& operator*=(float s) {
+		sharaku_simd_scale(_buf, _buf, s, _cap * 3);
+		return (*this);
+	}
+
+	/*********************************************************************/
+	/*! @brief soa * sを自身に積算する(積分ステップ)
+
+		@param[in]      soa             積算するvector3_soa(同一要素数)
+		@param[in]      s               倍率(Δ時間など)
+		@return         演算結果
+		@exception      none
+	**********************************************************************/
+	vector3_soa& accumulate(const vector3_soa& soa, float s) {
+		assert(size() == soa.size());
+		sharaku_simd_accumulate(_buf, soa._buf, s, _cap * 3);
+		return (*this);
+	}
+
+	// dst = a + b (全て同一要素数)
+	static void add(vector3_soa& dst, const vector3_soa& a, const vector3_soa& b) {
+		assert(dst.size() == a.size() && dst.size() == b.size());
+		sharaku_simd_add(dst._buf, a._buf, b._buf, dst._cap * 3);
+	}
+	// dst = a - b (全て同一要素数)
+	static void sub(vector3_soa& dst, const vector3_soa& a, const vector3_soa& b) {
+		assert(dst.size() == a.size() && dst.size() == b.size());
+		sharaku_simd_sub(dst._buf, a._buf, b._buf, dst._cap * 3);
+	}
+	// dst = a * s (同一要素数)
+	static void scale(vector3_soa& dst, const vector3_soa& a, float s) {
+		assert(dst.size() == a.size());
+		sharaku_simd_scale(dst._buf, a._buf, s, dst._cap * 3);
+	}
+
+ private:
+	void _init(size_t n) {
+		_n	= n;
+		_cap	= sharaku_simd::round_up(n);
+		_buf	= (float *)sharaku_simd::alloc(sizeof(float) * _cap * 3);
+		memset(_buf, 0, sizeof(float) * _cap * 3);
+	}
+
+ protected:
+	size_t	_n;		// 要素数
+	size_t	_cap;		// レーン長(要素数を切り上げたもの)
+	float	*_buf;		// x, y, zレーンの先頭
+};
+
+
+#endif // SHARAKU_MM_VECTOR_SOA_H_
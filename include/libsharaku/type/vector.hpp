@@ -27,11 +27,23 @@
 #ifndef SHARAKU_MM_VECTOR_H_
 #define SHARAKU_MM_VECTOR_H_
 
-struct vector3 {
+#include <stddef.h>
+#include <type_traits>
+
+/*! @class basic_vector3
+    @brief  3次元ベクトル(移動量)構造体
+
+	トリビアルコピー可能な標準レイアウト型であり、memcpy/memmoveによる
+	一括コピーが可能である。集成体初期化 vector3{x, y, z} により
+	コンパイル時定数として使用できる。
+	要素の型Tにはfloat, double, q16_16(固定小数点)を使用できる。
+*/
+template <class T>
+struct basic_vector3 {
  public:
-	float x; ///< xベクトル
-	float y; ///< yベクトル
-	float z; ///< zベクトル
+	T x; ///< xベクトル
+	T y; ///< yベクトル
+	T z; ///< zベクトル
 
  public:
 	/*********************************************************************/
@@ -39,7 +51,7 @@ struct vector3 {
 
 		@param[in]      vec_x           新規設定を行うXベクトル
 		@param[in]      vec_y           新規設定を行うYベクトル
-		@param[in]      vec_z           新規設定を行うZベクトル(省略時は0.0fとなる)
+		@param[in]      vec_z           新規設定を行うZベクトル(省略時は0となる)
 		@par            Refer
 		- 参照するグローバル変数 none
 		@par            Modify
@@ -47,75 +59,11 @@ struct vector3 {
 		@return         設定後の3次元ベクトル(移動量)構造体
 		@exception      none
 	**********************************************************************/
-	vector3& operator()(float vec_x, float vec_y, float vec_z = 0.0f) {
+	constexpr basic_vector3& operator()(T vec_x, T vec_y, T vec_z = T()) {
 		x = vec_x; y = vec_y; z = vec_z;
 		return (*this);
 	}
 
-	/*********************************************************************/
-	/*! @brief vector3構造体を代入する
-
-		@param[in]      vec             代入する構造体
-		@par            Refer
-		- 参照するグローバル変数 none
-		@par            Modify
-		- 変更するグローバル変数 none
-		@return         設定後の3次元ベクトル(移動量)構造体
-		@exception      none
-	**********************************************************************/
-	vector3& operator=(vector3& vec) {
-		x = vec.x; y = vec.y; z = vec.z;
-		return (*this);
-	}
-	vector3& operator=(const vector3& vec) {
-		x = vec.x; y = vec.y; z = vec.z;
-		return (*this);
-	}
-
-	/*********************************************************************/
-	/*! @brief 各座標ごとに加算を行う
-
-		@param[in]      vec             加算するvector3
-		@par            Refer
-		- 参照するグローバル変数 none
-		@par            Modify
-		- 変更するグローバル変数 none
-		@return         加算結果
-		@exception      none
-	**********************************************************************/
-	vector3 operator+(vector3& vec) {
-		vector3 result;
-		result.x = x + vec.x; result.y = y + vec.y; result.z = z + vec.z;
-		return result;
-	}
-	vector3 operator+(const vector3& vec) {
-		vector3 result;
-		result.x = x + vec.x; result.y = y + vec.y; result.z = z + vec.z;
-		return result;
-	}
-
-	/*********************************************************************/
-	/*! @brief 各座標ごとに減算を行う
-
-		@param[in]      vec             減算するvector3
-		@par            Refer
-		- 参照するグローバル変数 none
-		@par            Modify
-		- 変更するグローバル変数 none
-		@return         減算結果
-		@exception      none
-	**********************************************************************/
-	vector3 operator-(vector3& vec) {
-		vector3 result;
-		result.x = x - vec.x; result.y = y - vec.y; result.z = z - vec.z;
-		return result;
-	}
-	vector3 operator-(const vector3& vec) {
-		vector3 result;
-		result.x = x - vec.x; result.y = y - vec.y; result.z = z - vec.z;
-		return result;
-	}
-
 	/*********************************************************************/
 	/*! @brief 各座標ごとに加算を行い、結果を自身に反映する
 
@@ -127,11 +75,7 @@ struct vector3 {
 		@return         加算結果
 		@exception      none
 	**********************************************************************/
-	vector3& operator+=(vector3& vec) {
-		x += vec.x; y += vec.y; z += vec.z;
-		return (*this);
-	}
-	vector3& operator+=(const vector3& vec) {
+	constexpr basic_vector3& operator+=(const basic_vector3& vec) {
 		x += vec.x; y += vec.y; z += vec.z;
 		return (*this);
 	}
@@ -147,15 +91,59 @@ struct vector3 {
 		@return         減算結果
 		@exception      none
 	**********************************************************************/
-	vector3& operator-=(vector3& vec) {
-		x -= vec.x; y -= vec.y; z -= vec.z;
-		return (*this);
-	}
-	vector3& operator-=(const vector3& vec) {
+	constexpr basic_vector3& operator-=(const basic_vector3& vec) {
 		x -= vec.x; y -= vec.y; z -= vec.z;
 		return (*this);
 	}
 };
 
+typedef basic_vector3<float>	vector3;	///< 単精度
+typedef basic_vector3<double>	vector3d;	///< 倍精度
+
+/*********************************************************************/
+/*! @brief 各座標ごとに加算を行う
+
+	@param[in]      lhs             加算されるvector3
+	@param[in]      rhs             加算するvector3
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         加算結果
+	@exception      none
+**********************************************************************/
+template <class T>
+constexpr basic_vector3<T>
+operator+(const basic_vector3<T>& lhs, const basic_vector3<T>& rhs)
+{
+	return basic_vector3<T>{lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z};
+}
+
+/*********************************************************************/
+/*! @brief 各座標ごとに減算を行う
+
+	@param[in]      lhs             減算されるvector3
+	@param[in]      rhs             減算するvector3
+	@par            Refer
+	- 参照するグローバル変数 none
+	@par            Modify
+	- 変更するグローバル変数 none
+	@return         減算結果
+	@exception      none
+**********************************************************************/
+template <class T>
+constexpr basic_vector3<T>
+operator-(const basic_vector3<T>& lhs, const basic_vector3<T>& rhs)
+{
+	return basic_vector3<T>{lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z};
+}
+
+// バイナリ互換性のためのレイアウト固定
+static_assert(std::is_trivially_copyable<vector3>::value, "vector3 must be trivially copyable");
+static_assert(std::is_standard_layout<vector3>::value, "vector3 must be standard layout");
+static_assert(sizeof(vector3) == 12, "vector3 must be 12 bytes");
+static_assert(offsetof(vector3, x) == 0 && offsetof(vector3, y) == 4 &&
+	      offsetof(vector3, z) == 8, "vector3 layout must be x, y, z");
+
 
 #endif // SHARAKU_MM_VECTOR_H_
@@ -26,9 +26,344 @@
 
 #include <libsharaku/type/digital-filter.hpp>
 #include <gtest/gtest.h>
+#include <math.h>
+#include <algorithm>
+#include <complex>
+#include <vector>
 
 TEST(digital_filter, low_pass_filter) {
 	low_pass_filter	f(0.0f);
 
 	EXPECT_EQ(f.get_q(), 0.0f);
 }
+
+TEST(digital_filter, low_pass_filter_bank) {
+	const size_t N = 19;
+	const size_t M = 50;
+	low_pass_filter_bank<N> bank(0.25f);
+	std::vector<low_pass_filter> f(N, low_pass_filter(0.25f));
+	std::vector<float> in(N * M), out(N * M);
+
+	bank.set(3, 0.75f);
+	f[3].set(0.75f);
+	for (size_t i = 0; i < in.size(); i++) {
+		in[i] = (float)((i * 31) % 17) - 8.0f;
+	}
+
+	bank += in.data();
+	for (size_t ch = 0; ch < N; ch++) {
+		f[ch] += in[ch];
+		EXPECT_EQ(bank[ch], (float)f[ch]);
+	}
+	bank.process(in.data() + N, out.data(), M - 1);
+	for (size_t m = 1; m < M; m++) {
+		for (size_t ch = 0; ch < N; ch++) {
+			EXPECT_EQ(out[(m - 1) * N + ch], f[ch] + in[m * N + ch]);
+		}
+	}
+	bank.clear();
+	EXPECT_EQ(bank[0], 0.0f);
+	EXPECT_EQ(bank.get_q(3), 0.75f);
+}
+
+// 縦続接続したbiquadの周波数fでの振幅特性
+static double
+biquad_gain(const biquad_coef *sos, size_t n, double f, double fs)
+{
+	const std::complex<double> z1 = std::polar(1.0, -2.0 * M_PI * f / fs);
+	const std::complex<double> z2 = z1 * z1;
+	std::complex<double> h = 1.0;
+	for (size_t s = 0; s < n; s++) {
+		h *= ((double)sos[s].b0 + (double)sos[s].b1 * z1 + (double)sos[s].b2 * z2) /
+		     (1.0 + (double)sos[s].a1 * z1 + (double)sos[s].a2 * z2);
+	}
+	return std::abs(h);
+}
+
+TEST(digital_filter, butterworth) {
+	const double fs = 1000.0, fc = 50.0;
+	biquad_coef sos[4];
+
+	for (size_t order = 1; order <= 6; order++) {
+		size_t n = sharaku_butterworth_lowpass(sos, order, fc, fs);
+		EXPECT_EQ(n, (order + 1) / 2);
+		EXPECT_NEAR(biquad_gain(sos, n, 0.0, fs), 1.0, 1.0e-5);
+		EXPECT_NEAR(biquad_gain(sos, n, fc, fs), M_SQRT1_2, 1.0e-4);
+		// 双一次変換したButterworth特性 1 / sqrt(1 + Ω^2N)
+		for (double f = 5.0; f < fs / 2.0; f += 45.0) {
+			double w = tan(M_PI * f / fs) / tan(M_PI * fc / fs);
+			EXPECT_NEAR(biquad_gain(sos, n, f, fs),
+				    1.0 / sqrt(1.0 + pow(w, 2.0 * order)), 1.0e-4);
+		}
+
+		n = sharaku_butterworth_highpass(sos, order, fc, fs);
+		EXPECT_NEAR(biquad_gain(sos, n, 0.0, fs), 0.0, 1.0e-5);
+		EXPECT_NEAR(biquad_gain(sos, n, fc, fs), M_SQRT1_2, 1.0e-4);
+		EXPECT_NEAR(biquad_gain(sos, n, fs / 2.0, fs), 1.0, 1.0e-4);
+	}
+
+	// 4次ローパスの阻止域(1オクターブ当たり約24dB減衰)
+	size_t n = sharaku_butterworth_lowpass(sos, 4, fc, fs);
+	EXPECT_LT(biquad_gain(sos, n, fc * 4.0, fs), 0.005);
+
+	n = sharaku_butterworth_bandpass(sos, 2, 40.0, 120.0, fs);
+	EXPECT_EQ(n, 2u);
+	EXPECT_GT(biquad_gain(sos, n, 70.0, fs), 0.9);
+	EXPECT_LT(biquad_gain(sos, n, 5.0, fs), 0.02);
+	EXPECT_LT(biquad_gain(sos, n, 450.0, fs), 0.05);
+
+	biquad_coef bp = biquad_coef::bandpass(100.0, fs, 2.0);
+	EXPECT_NEAR(biquad_gain(&bp, 1, 100.0, fs), 1.0, 1.0e-5);
+}
+
+TEST(digital_filter, biquad_filter) {
+	const double fs = 1000.0;
+	biquad_coef sos[2];
+	sharaku_butterworth_lowpass(sos, 4, 50.0, fs);
+	biquad_filter<2> f(sos);
+	biquad_filter<2> g(sos);
+
+	// 定常応答: 直流はそのまま、遮断周波数の10倍は十分に減衰する
+	float peak = 0.0f;
+	for (int i = 0; i < 2000; i++) {
+		f += 1.0f + sinf(2.0f * (float)M_PI * 500.0f * i / (float)fs + 0.3f);
+		if (i > 1000) {
+			peak = fmaxf(peak, fabsf((float)f - 1.0f));
+		}
+	}
+	EXPECT_NEAR((float)f, 1.0f, 1.0e-3f);
+	EXPECT_LT(peak, 1.0e-3f);
+
+	// ブロック処理は1サンプルずつの入力と同一
+	std::vector<float> in(257), out(257);
+	for (size_t i = 0; i < in.size(); i++) {
+		in[i] = (float)((i * 31) % 17) - 8.0f;
+	}
+	f.clear();
+	f.process(in.data(), out.data(), in.size());
+	for (size_t i = 0; i < in.size(); i++) {
+		EXPECT_EQ(out[i], g + in[i]);
+	}
+	EXPECT_EQ((float)f, (float)g);
+
+	// 既定値は素通し
+	biquad_filter<3> through;
+	EXPECT_EQ(through + 1.25f, 1.25f);
+}
+
+TEST(digital_filter, biquad_filter_bank) {
+	const size_t N = 21;
+	const size_t M = 100;
+	const double fs = 1000.0;
+	biquad_coef lp[2], hp[2];
+	sharaku_butterworth_lowpass(lp, 4, 50.0, fs);
+	sharaku_butterworth_highpass(hp, 3, 20.0, fs);
+	biquad_filter_bank<N, 2> bank(lp);
+	std::vector<biquad_filter<2>> f(N, biquad_filter<2>(lp));
+	std::vector<float> in(N * M), out(N * M);
+
+	bank.set(5, hp);
+	f[5].set(hp);
+	for (size_t i = 0; i < in.size(); i++) {
+		in[i] = (float)((i * 31) % 17) - 8.0f;
+	}
+	bank += in.data();
+	for (size_t ch = 0; ch < N; ch++) {
+		f[ch] += in[ch];
+		EXPECT_EQ(bank[ch], (float)f[ch]);
+	}
+	bank.process(in.data() + N, out.data(), M - 1);
+	for (size_t m = 1; m < M; m++) {
+		for (size_t ch = 0; ch < N; ch++) {
+			EXPECT_EQ(out[(m - 1) * N + ch], f[ch] + in[m * N + ch]);
+		}
+	}
+	bank.clear();
+	EXPECT_EQ(bank[0], 0.0f);
+}
+
+// FIR係数の周波数fでの振幅特性
+static double
+fir_gain(const float *h, size_t taps, double f, double fs)
+{
+	std::complex<double> sum = 0.0;
+	for (size_t k = 0; k < taps; k++) {
+		sum += (double)h[k] * std::polar(1.0, -2.0 * M_PI * f / fs * k);
+	}
+	return std::abs(sum);
+}
+
+TEST(digital_filter, fir_design) {
+	const double fs = 1000.0;
+	float h[63];
+
+	sharaku_fir_lowpass(h, 63, 100.0, fs);
+	for (size_t k = 0; k < 63; k++) {
+		EXPECT_EQ(h[k], h[62 - k]);	// 直線位相
+	}
+	EXPECT_NEAR(fir_gain(h, 63, 0.0, fs), 1.0, 1.0e-5);
+	EXPECT_NEAR(fir_gain(h, 63, 20.0, fs), 1.0, 0.01);
+	EXPECT_LT(fir_gain(h, 63, 200.0, fs), 0.01);
+
+	sharaku_fir_bandpass(h, 63, 150.0, 250.0, fs);
+	EXPECT_NEAR(fir_gain(h, 63, 200.0, fs), 1.0, 1.0e-5);
+	EXPECT_LT(fir_gain(h, 63, 0.0, fs), 0.01);
+	EXPECT_LT(fir_gain(h, 63, 400.0, fs), 0.01);
+}
+
+template <size_t T>
+static void
+fir_filter_check(void)
+{
+	std::vector<float> h(T), in(3 * T + 7), out(in.size());
+	for (size_t k = 0; k < T; k++) {
+		h[k] = (float)((k * 7) % 11) * 0.1f - 0.5f;
+	}
+	for (size_t i = 0; i < in.size(); i++) {
+		in[i] = (float)((i * 31) % 17) - 8.0f;
+	}
+	fir_filter<T> f(h.data());
+	fir_filter<T> g(h.data());
+
+	// インパルス応答は係数と一致する
+	EXPECT_EQ(f + 1.0f, h[0]);
+	for (size_t k = 1; k < T; k++) {
+		EXPECT_EQ(f + 0.0f, h[k]);
+	}
+	EXPECT_EQ(f + 0.0f, 0.0f);
+
+	// 直接畳み込みとの比較
+	f.clear();
+	f.process(in.data(), out.data(), in.size());
+	for (size_t i = 0; i < in.size(); i++) {
+		double ref = 0.0, mag = 0.0;
+		for (size_t k = 0; k < T && k <= i; k++) {
+			ref += (double)h[k] * in[i - k];
+			mag += fabs((double)h[k] * in[i - k]);
+		}
+		EXPECT_NEAR(out[i], ref, 1.0e-6 * mag + 1.0e-6) << "T=" << T << " i=" << i;
+		// ブロック処理は1サンプルずつの入力と同一
+		EXPECT_EQ(out[i], g + in[i]);
+	}
+	EXPECT_EQ((float)f, (float)g);
+}
+
+TEST(digital_filter, fir_filter) {
+	fir_filter_check<1>();
+	fir_filter_check<5>();
+	fir_filter_check<32>();
+	fir_filter_check<67>();
+
+	// 既定値は素通し
+	fir_filter<8> through;
+	EXPECT_EQ(through + 1.25f, 1.25f);
+	EXPECT_EQ(through + -3.0f, -3.0f);
+}
+
+// 直近W個(入力数がW未満の場合は入力済み)のサンプル
+static std::vector<float>
+window_of(const std::vector<float>& in, size_t i, size_t w)
+{
+	const size_t b = (i + 1 > w) ? i + 1 - w : 0;
+	return std::vector<float>(in.begin() + b, in.begin() + i + 1);
+}
+
+template <size_t W>
+static void
+moving_average_check(const std::vector<float>& in)
+{
+	moving_average<W> f;
+	moving_average<W> g;
+	std::vector<float> out(in.size());
+	f.process(in.data(), out.data(), in.size());
+	for (size_t i = 0; i < in.size(); i++) {
+		const std::vector<float> w = window_of(in, i, W);
+		double ref = 0.0, mag = 0.0;
+		for (float v : w) {
+			ref += v;
+			mag += fabs(v);
+		}
+		ref /= w.size();
+		mag /= w.size();
+		EXPECT_NEAR(out[i], ref, 1.0e-5 * mag + 1.0e-6) << "W=" << W << " i=" << i;
+		// ブロック処理は1サンプルずつの入力と同一
+		EXPECT_EQ(out[i], g + in[i]);
+	}
+	EXPECT_EQ(f.count(), (in.size() < W) ? in.size() : W);
+}
+
+template <size_t W>
+static void
+median_filter_check(const std::vector<float>& in)
+{
+	median_filter<W> f;
+	median_filter<W> g;
+	std::vector<float> out(in.size());
+	f.process(in.data(), out.data(), in.size());
+	for (size_t i = 0; i < in.size(); i++) {
+		std::vector<float> w = window_of(in, i, W);
+		std::sort(w.begin(), w.end());
+		const size_t n = w.size();
+		const float ref = (n & 1) ? w[n / 2] : (w[n / 2 - 1] + w[n / 2]) * 0.5f;
+		ASSERT_EQ(out[i], ref) << "W=" << W << " i=" << i;
+		EXPECT_EQ(out[i], g + in[i]);
+	}
+	EXPECT_EQ(f.count(), (in.size() < W) ? in.size() : W);
+}
+
+// 重複値を多く含む入力(線形合同法)
+static std::vector<float>
+filter_input(size_t n)
+{
+	std::vector<float> in(n);
+	uint32_t r = 12345;
+	for (size_t i = 0; i < n; i++) {
+		r = r * 1103515245u + 12345u;
+		in[i] = (float)((r >> 16) % 41) - 20.0f;
+	}
+	return in;
+}
+
+TEST(digital_filter, moving_average) {
+	const std::vector<float> in = filter_input(2000);
+	moving_average_check<1>(in);
+	moving_average_check<2>(in);
+	moving_average_check<5>(in);
+	moving_average_check<64>(in);
+	moving_average_check<1024>(in);
+
+	// 大きなオフセットを持つ入力を長時間入力しても誤差が蓄積しない
+	moving_average<16> f;
+	float y = 0.0f;
+	for (size_t i = 0; i < 1000000; i++) {
+		y = f + (10000.0f + (float)(i % 7) * 0.1f);
+	}
+	double ref = 0.0;
+	for (size_t i = 1000000 - 16; i < 1000000; i++) {
+		ref += 10000.0 + (double)(float)((float)(i % 7) * 0.1f);
+	}
+	EXPECT_NEAR(y, ref / 16.0, 2.0e-3);
+}
+
+TEST(digital_filter, median_filter) {
+	const std::vector<float> in = filter_input(3000);
+	median_filter_check<1>(in);
+	median_filter_check<2>(in);
+	median_filter_check<5>(in);
+	median_filter_check<6>(in);
+	median_filter_check<33>(in);
+	median_filter_check<256>(in);
+
+	// 単調な入力(ヒープ間の入れ替えが毎回発生する)
+	std::vector<float> ramp(500);
+	for (size_t i = 0; i < ramp.size(); i++) {
+		ramp[i] = (i < 250) ? (float)i : (float)(500 - i);
+	}
+	median_filter_check<7>(ramp);
+	median_filter_check<8>(ramp);
+
+	// 外れ値を除去する
+	median_filter<5> f;
+	f + 1.0f; f + 1.0f; f + 100.0f; f + 1.0f;
+	EXPECT_EQ(f + 1.0f, 1.0f);
+}
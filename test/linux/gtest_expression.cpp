@@ -0,0 +1,133 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/expression.hpp>
+#include <libsharaku/type/position.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+#include "gtest_helper.hpp"
+
+// 1演算ずつ評価した結果と一致すること
+TEST(expression, soa_four_terms) {
+	const size_t n = 1001;
+	std::vector<vector3> p = make_vectors(n, 1.5f);
+	std::vector<vector3> a = make_vectors(n, 0.25f);
+	std::vector<vector3> b = make_vectors(n, -2.0f);
+	std::vector<vector3> c = make_vectors(n, 3.0f);
+	vector3_soa sp(p.data(), n), sa(a.data(), n), sb(b.data(), n), sc(c.data(), n);
+	vector3_soa r(n);
+
+	sharaku_eval(r, sp + sa - sb + sc * 0.5f);
+	for (size_t i = 0; i < n; i++) {
+		const vector3 e = p[i] + a[i] - b[i] + vector3{c[i].x * 0.5f, c[i].y * 0.5f, c[i].z * 0.5f};
+		const vector3 v = r.get(i);
+		EXPECT_FLOAT_EQ(v.x, e.x);
+		EXPECT_FLOAT_EQ(v.y, e.y);
+		EXPECT_FLOAT_EQ(v.z, e.z);
+	}
+	// 余白は0のまま
+	const size_t cap = r.y() - r.x();
+	for (size_t i = n; i < cap; i++) {
+		EXPECT_EQ(r.x()[i], 0.0f);
+		EXPECT_EQ(r.z()[i], 0.0f);
+	}
+}
+
+// 書き出し先をオペランドに含めた場合(積分ステップ)
+TEST(expression, soa_in_place) {
+	const size_t n = 100;
+	std::vector<vector3> p = make_vectors(n, 1.5f);
+	std::vector<vector3> v = make_vectors(n, 0.25f);
+	vector3_soa sp(p.data(), n), sv(v.data(), n);
+
+	sharaku_eval(sp, sp + sv * 0.01f);
+	for (size_t i = 0; i < n; i++) {
+		const vector3 r = sp.get(i);
+		EXPECT_FLOAT_EQ(r.x, p[i].x + v[i].x * 0.01f);
+		EXPECT_FLOAT_EQ(r.y, p[i].y + v[i].y * 0.01f);
+		EXPECT_FLOAT_EQ(r.z, p[i].z + v[i].z * 0.01f);
+	}
+}
+
+// 配列(position3 + vector3)の式、SIMD幅で割り切れない要素数
+TEST(expression, aos_position) {
+	for (size_t n : {0u, 1u, 5u, 37u, 1000u}) {
+		std::vector<vector3> a = make_vectors(n, 0.25f);
+		std::vector<vector3> b = make_vectors(n, -2.0f);
+		std::vector<vector3> c = make_vectors(n, 3.0f);
+		std::vector<position3> p(n), r(n + 1);
+		for (size_t i = 0; i < n; i++) {
+			p[i](i * 1.0f, i * 2.0f, i * -3.0f);
+		}
+		r[n](7.0f, 8.0f, 9.0f);
+
+		sharaku_eval(r.data(), sharaku_expr(p.data(), n) + sharaku_expr(a.data(), n) -
+				       sharaku_expr(b.data(), n) + 2.0f * sharaku_expr(c.data(), n));
+		for (size_t i = 0; i < n; i++) {
+			const position3 e = p[i] + a[i] - b[i] + vector3{c[i].x * 2.0f, c[i].y * 2.0f, c[i].z * 2.0f};
+			EXPECT_FLOAT_EQ(r[i].x, e.x);
+			EXPECT_FLOAT_EQ(r[i].y, e.y);
+			EXPECT_FLOAT_EQ(r[i].z, e.z);
+		}
+		// 要素数を超えて書き出さない
+		EXPECT_EQ(r[n].x, 7.0f);
+		EXPECT_EQ(r[n].y, 8.0f);
+		EXPECT_EQ(r[n].z, 9.0f);
+	}
+}
+
+TEST(expression, aos_in_place) {
+	const size_t n = 19;
+	std::vector<vector3> p = make_vectors(n, 1.5f);
+	std::vector<vector3> v = make_vectors(n, 0.25f);
+	std::vector<vector3> q = p;
+
+	sharaku_eval(q.data(), sharaku_expr(q.data(), n) - sharaku_expr(v.data(), n) * 0.5f);
+	for (size_t i = 0; i < n; i++) {
+		EXPECT_FLOAT_EQ(q[i].x, p[i].x - v[i].x * 0.5f);
+		EXPECT_FLOAT_EQ(q[i].y, p[i].y - v[i].y * 0.5f);
+		EXPECT_FLOAT_EQ(q[i].z, p[i].z - v[i].z * 0.5f);
+	}
+}
+
+// 空の配列(data() = NULLの場合がある)を扱えること
+TEST(expression, aos_empty) {
+	std::vector<vector3> a, b;
+
+	sharaku_eval(a.data(), sharaku_expr(a.data(), 0) + sharaku_expr(b.data(), 0));
+	EXPECT_TRUE(a.empty());
+}
+
+#ifndef NDEBUG
+// 要素数の異なるオペランドは式にできない
+TEST(expression, size_mismatch) {
+	std::vector<vector3> a = make_vectors(8, 1.0f);
+	std::vector<vector3> b = make_vectors(4, 1.0f);
+
+	EXPECT_DEATH((void)(sharaku_expr(a.data(), 8) + sharaku_expr(b.data(), 4)), "");
+	EXPECT_DEATH((void)(sharaku_expr(a.data(), 8) - sharaku_expr(b.data(), 4) * 2.0f), "");
+}
+#endif
@@ -0,0 +1,108 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/fixed.hpp>
+#include <libsharaku/type/vector.hpp>
+#include <libsharaku/type/position.hpp>
+#include <libsharaku/type/rotation.hpp>
+#include <libsharaku/type/pid.hpp>
+#include <libsharaku/type/digital-filter.hpp>
+#include <gtest/gtest.h>
+
+TEST(fixed, q16_16) {
+	constexpr q16_16 a(1.5f);
+	constexpr q16_16 b(-2);
+	static_assert(a.raw == 0x18000, "constexpr q16_16");
+
+	EXPECT_EQ((a + b).raw, q16_16(-0.5f).raw);
+	EXPECT_EQ((a - b).raw, q16_16(3.5f).raw);
+	EXPECT_EQ((a * b).raw, q16_16(-3).raw);
+	EXPECT_EQ((b / a).raw, q16_16::from_raw(-87381).raw);
+	EXPECT_EQ((-a).raw, -0x18000);
+	EXPECT_EQ((int32_t)q16_16(-0.25f), -1);
+	EXPECT_EQ((int32_t)q16_16(32767), 32767);
+	EXPECT_FLOAT_EQ((float)q16_16(0.125f), 0.125f);
+	EXPECT_DOUBLE_EQ((double)q16_16(-100.75), -100.75);
+	EXPECT_TRUE(b < a);
+	EXPECT_TRUE(a >= a);
+	EXPECT_TRUE(a != b);
+}
+
+TEST(fixed, vector3) {
+	typedef basic_vector3<q16_16>	vector3q;
+	typedef basic_position3<q16_16>	position3q;
+	typedef basic_rotation3<q16_16>	rotation3q;
+	vector3q v{q16_16(1.0f), q16_16(2.0f), q16_16(-3.0f)};
+	position3q p{q16_16(0.5f), q16_16(0.25f), q16_16(0)};
+	rotation3q r;
+
+	p += v;
+	EXPECT_EQ(p.x, q16_16(1.5f));
+	EXPECT_EQ(p.z, q16_16(-3));
+	p = p - v;
+	EXPECT_EQ(p.y, q16_16(0.25f));
+	r(q16_16(10), q16_16(20));
+	EXPECT_EQ(r.z, q16_16(0));
+	EXPECT_EQ((r + v).y, q16_16(22));
+	EXPECT_EQ(sizeof(vector3q), 12u);
+
+	vector3d vd{1.0, 2.0, 3.0};
+	vd += vector3d{0.5, 0.5, 0.5};
+	EXPECT_EQ(vd.z, 3.5);
+}
+
+TEST(fixed, pid) {
+	pid			pf(0.8f, 0.05f, 0.2f);
+	basic_pid<double>	pd(0.8, 0.05, 0.2);
+	basic_pid<q16_16>	pq(q16_16(0.8f), q16_16(0.05f), q16_16(0.2f));
+
+	// 1次遅れのプラントに対するステップ応答
+	float yf = 0.0f;
+	for (int step = 0; step < 200; step++) {
+		int32_t now = (int32_t)yf;
+		float uf = pf(1.0f, now, 100);
+		double ud = pd(1.0, now, 100);
+		q16_16 uq = pq(q16_16(1), now, 100);
+		EXPECT_NEAR(ud, uf, 1.0e-3 * (1.0 + fabs(ud)));
+		EXPECT_NEAR((float)uq, uf, 0.05f + 1.0e-3f * fabsf(uf));
+		yf += (uf - yf) * 0.1f;
+	}
+}
+
+TEST(fixed, low_pass_filter) {
+	low_pass_filter				lf(0.25f);
+	basic_low_pass_filter<q16_16>		lq(q16_16(0.25f));
+	basic_low_pass_filter<double>		ld(0.25);
+
+	for (int i = 0; i < 100; i++) {
+		float x = (float)((i * 37) % 200 - 100);
+		lf += x;
+		lq += q16_16(x);
+		ld += x;
+		EXPECT_NEAR((float)(q16_16)lq, (float)lf, 1.0e-3f);
+		EXPECT_NEAR((double)ld, (float)lf, 1.0e-3);
+	}
+}
@@ -0,0 +1,99 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+// このファイルは-ffp-contract=fast(GCCのGNUモードの既定値)でビルドする。
+// 積和がFMAへ縮約される利用者のビルド設定でも、SIMDのバンクと
+// スカラ版の結果が丸め誤差の範囲で一致することを確認する。
+
+#include <libsharaku/type/pid.hpp>
+#include <libsharaku/type/digital-filter.hpp>
+#include <gtest/gtest.h>
+#include <math.h>
+#include <vector>
+
+// 相対誤差の許容値(丸め方の違いによる差のみを許容する)
+static const float fp_contract_tolerance = 1.0e-5f;
+
+TEST(fp_contract, pid_bank) {
+	const size_t n = 37;
+	pid_bank bank(n);
+	std::vector<pid> loops;
+	std::vector<int32_t> now(n), target(n);
+	std::vector<float> u(n);
+
+	for (size_t i = 0; i < n; i++) {
+		loops.push_back(pid(0.5f + i * 0.1f, 0.02f, 0.3f));
+		bank.set_pid(i, 0.5f + i * 0.1f, 0.02f, 0.3f);
+		loops[i].set_limit(-200.0f, 50.0f + i);
+		bank.set_limit(i, -200.0f, 50.0f + i);
+		loops[i].set_antiwindup(0.1f * i);
+		bank.set_antiwindup(i, 0.1f * i);
+		loops[i].set_derivative_filter(0.05f * (i + 1));
+		bank.set_derivative_filter(i, 0.05f * (i + 1));
+	}
+	for (int step = 0; step < 100; step++) {
+		for (size_t i = 0; i < n; i++) {
+			now[i] = (int32_t)(i * 7 + step * 3) % 101 - 50;
+			target[i] = (int32_t)(i * 13) % 97;
+		}
+		bank(10.0f, now.data(), target.data(), u.data());
+		for (size_t i = 0; i < n; i++) {
+			const float ref = loops[i](10.0f, now[i], target[i]);
+			EXPECT_NEAR(u[i], ref, fp_contract_tolerance * (1.0f + fabsf(ref)));
+			// アンチワインドアップはuの丸め誤差をKb * T倍してeiへ加える
+			//  (制限前のuは最大でも1000程度)
+			EXPECT_NEAR(bank.get_ei(i), loops[i].get_ei(),
+				    fp_contract_tolerance * (1.0f + fabsf(loops[i].get_ei()) +
+							     bank.get_Kb(i) * 10.0f * 1000.0f));
+		}
+	}
+}
+
+TEST(fp_contract, filter_bank) {
+	const size_t N = 21;
+	const size_t M = 100;
+	biquad_coef lp[2];
+	sharaku_butterworth_lowpass(lp, 4, 50.0, 1000.0);
+	low_pass_filter_bank<N> lbank(0.25f);
+	biquad_filter_bank<N, 2> bbank(lp);
+	std::vector<low_pass_filter> lf(N, low_pass_filter(0.25f));
+	std::vector<biquad_filter<2>> bf(N, biquad_filter<2>(lp));
+	std::vector<float> in(N);
+
+	for (size_t m = 0; m < M; m++) {
+		for (size_t ch = 0; ch < N; ch++) {
+			in[ch] = (float)(((m * N + ch) * 31) % 17) - 8.0f;
+		}
+		lbank += in.data();
+		bbank += in.data();
+		for (size_t ch = 0; ch < N; ch++) {
+			const float l = lf[ch] + in[ch];
+			const float b = bf[ch] + in[ch];
+			EXPECT_NEAR(lbank[ch], l, fp_contract_tolerance * (1.0f + fabsf(l)));
+			EXPECT_NEAR(bbank[ch], b, fp_contract_tolerance * (1.0f + fabsf(b)));
+		}
+	}
+}
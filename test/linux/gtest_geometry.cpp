@@ -0,0 +1,183 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/geometry.hpp>
+#include <gtest/gtest.h>
+#include <math.h>
+#include <random>
+#include <vector>
+
+// 高速版の相対誤差の上限
+//  近似値(相対誤差e <= 1.5 * 2^-12)をニュートン法で1回補正した誤差は
+//  1.5 * e^2 (約2e-7)であり、これに演算の丸め誤差を加えたもの
+#define FAST_REL_ERROR	1.0e-6
+
+static std::vector<vector3>
+make_random_vectors(size_t n, unsigned seed)
+{
+	std::mt19937 gen(seed);
+	std::uniform_real_distribution<float> dir(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> mag(-4.0f, 4.0f);
+	std::vector<vector3> v(n);
+	for (size_t i = 0; i < n; i++) {
+		// 長さ1e-4～1e4程度に分布させる
+		const float s = powf(10.0f, mag(gen));
+		v[i](dir(gen) * s, dir(gen) * s, dir(gen) * s);
+	}
+	return v;
+}
+
+static double
+rel_error(double v, double ref)
+{
+	return fabs(v - ref) / fabs(ref);
+}
+
+TEST(geometry, dot_cross) {
+	const vector3 a{1.0f, 2.0f, 3.0f};
+	const vector3 b{4.0f, -5.0f, 6.0f};
+	EXPECT_EQ(sharaku_dot(a, b), 12.0f);
+	EXPECT_EQ(sharaku_length2(a), 14.0f);
+
+	const vector3 c = sharaku_cross(a, b);
+	EXPECT_EQ(c.x, 27.0f);
+	EXPECT_EQ(c.y, 6.0f);
+	EXPECT_EQ(c.z, -13.0f);
+	EXPECT_EQ(sharaku_dot(c, a), 0.0f);
+	EXPECT_EQ(sharaku_dot(c, b), 0.0f);
+
+	constexpr vector3 ex{1.0f, 0.0f, 0.0f};
+	constexpr vector3 ey{0.0f, 1.0f, 0.0f};
+	static_assert(sharaku_cross(ex, ey).z == 1.0f, "constexpr cross");
+	static_assert(sharaku_dot(ex, ey) == 0.0f, "constexpr dot");
+}
+
+TEST(geometry, length_distance) {
+	const vector3 v{3.0f, 4.0f, 12.0f};
+	EXPECT_EQ(sharaku_length(v), 13.0f);
+	EXPECT_NEAR(sharaku_length_fast(v), 13.0f, 13.0f * FAST_REL_ERROR);
+
+	const position3 p{1.0f, 2.0f, 3.0f};
+	const position3 q{4.0f, 6.0f, 15.0f};
+	EXPECT_EQ(sharaku_distance2(p, q), 169.0f);
+	EXPECT_EQ(sharaku_distance(p, q), 13.0f);
+	EXPECT_NEAR(sharaku_distance_fast(p, q), 13.0f, 13.0f * FAST_REL_ERROR);
+
+	const basic_vector3<double> d{1.0, 1.0, 1.0};
+	EXPECT_DOUBLE_EQ(sharaku_length(d), sqrt(3.0));
+}
+
+TEST(geometry, zero_vector) {
+	const vector3 z{0.0f, 0.0f, 0.0f};
+	EXPECT_EQ(sharaku_length(z), 0.0f);
+	EXPECT_EQ(sharaku_length_fast(z), 0.0f);
+	EXPECT_EQ(sharaku_distance_fast(position3{1.0f, 2.0f, 3.0f}, position3{1.0f, 2.0f, 3.0f}), 0.0f);
+	const vector3 n = sharaku_normalize(z);
+	const vector3 f = sharaku_normalize_fast(z);
+	EXPECT_EQ(n.x, 0.0f); EXPECT_EQ(n.y, 0.0f); EXPECT_EQ(n.z, 0.0f);
+	EXPECT_EQ(f.x, 0.0f); EXPECT_EQ(f.y, 0.0f); EXPECT_EQ(f.z, 0.0f);
+}
+
+// 高速版の誤差を倍精度で求めた値と比較する
+TEST(geometry, fast_accuracy) {
+	std::vector<vector3> v = make_random_vectors(100000, 1);
+	double max_len = 0.0, max_norm = 0.0, max_rsqrt = 0.0;
+	for (const vector3& a : v) {
+		const double ref = sqrt((double)a.x * a.x + (double)a.y * a.y + (double)a.z * a.z);
+		const float l2 = sharaku_length2(a);
+		max_rsqrt = fmax(max_rsqrt, rel_error(sharaku_rsqrt_fast(l2), 1.0 / sqrt((double)l2)));
+		max_len = fmax(max_len, rel_error(sharaku_length_fast(a), ref));
+		const vector3 n = sharaku_normalize_fast(a);
+		max_norm = fmax(max_norm, fabs(sqrt((double)n.x * n.x + (double)n.y * n.y + (double)n.z * n.z) - 1.0));
+	}
+	EXPECT_LT(max_rsqrt, FAST_REL_ERROR);
+	EXPECT_LT(max_len, FAST_REL_ERROR);
+	EXPECT_LT(max_norm, FAST_REL_ERROR);
+
+	// 正確な版は丸め誤差のみ
+	double max_exact = 0.0;
+	for (const vector3& a : v) {
+		const vector3 n = sharaku_normalize(a);
+		max_exact = fmax(max_exact, fabs(sqrt((double)n.x * n.x + (double)n.y * n.y + (double)n.z * n.z) - 1.0));
+	}
+	EXPECT_LT(max_exact, 4.0e-7);
+}
+
+// 配列版は1要素版と同じ誤差範囲であること(SIMD幅の端数、0ベクトル、同一領域を含む)
+TEST(geometry, batch) {
+	const size_t n = 1003;
+	std::vector<vector3> a = make_random_vectors(n, 2);
+	std::vector<vector3> b = make_random_vectors(n, 3);
+	a[5](0.0f, 0.0f, 0.0f);
+	b[7] = a[7];
+	std::vector<position3> p(n), q(n);
+	for (size_t i = 0; i < n; i++) {
+		p[i](a[i].x, a[i].y, a[i].z);
+		q[i](b[i].x, b[i].y, b[i].z);
+	}
+
+	std::vector<float> dot(n), len(n), lenf(n), dist(n), distf(n);
+	std::vector<vector3> cross(n), norm(n), normf = a;
+	sharaku_dot(dot.data(), a.data(), b.data(), n);
+	sharaku_cross(cross.data(), a.data(), b.data(), n);
+	sharaku_length(len.data(), a.data(), n);
+	sharaku_length_fast(lenf.data(), a.data(), n);
+	sharaku_normalize(norm.data(), a.data(), n);
+	sharaku_normalize_fast(normf.data(), normf.data(), n);
+	sharaku_distance(dist.data(), p.data(), q.data(), n);
+	sharaku_distance_fast(distf.data(), p.data(), q.data(), n);
+
+	for (size_t i = 0; i < n; i++) {
+		const float d = sharaku_dot(a[i], b[i]);
+		EXPECT_NEAR(dot[i], d, fabsf(d) * 1.0e-6f + 1.0e-6f * sharaku_length(a[i]) * sharaku_length(b[i]));
+		const vector3 c = sharaku_cross(a[i], b[i]);
+		const float cl = sharaku_length(a[i]) * sharaku_length(b[i]) * 1.0e-6f;
+		EXPECT_NEAR(cross[i].x, c.x, cl);
+		EXPECT_NEAR(cross[i].y, c.y, cl);
+		EXPECT_NEAR(cross[i].z, c.z, cl);
+
+		const float l = sharaku_length(a[i]);
+		EXPECT_FLOAT_EQ(len[i], l);
+		EXPECT_NEAR(lenf[i], l, l * FAST_REL_ERROR);
+		const vector3 e = sharaku_normalize(a[i]);
+		EXPECT_FLOAT_EQ(norm[i].x, e.x);
+		EXPECT_FLOAT_EQ(norm[i].y, e.y);
+		EXPECT_FLOAT_EQ(norm[i].z, e.z);
+		EXPECT_NEAR(normf[i].x, e.x, FAST_REL_ERROR);
+		EXPECT_NEAR(normf[i].y, e.y, FAST_REL_ERROR);
+		EXPECT_NEAR(normf[i].z, e.z, FAST_REL_ERROR);
+
+		const float ds = sharaku_distance(p[i], q[i]);
+		EXPECT_FLOAT_EQ(dist[i], ds);
+		EXPECT_NEAR(distf[i], ds, ds * FAST_REL_ERROR);
+	}
+	EXPECT_EQ(len[5], 0.0f);
+	EXPECT_EQ(lenf[5], 0.0f);
+	EXPECT_EQ(normf[5].x, 0.0f);
+	EXPECT_EQ(norm[5].x, 0.0f);
+	EXPECT_EQ(dist[7], 0.0f);
+	EXPECT_EQ(distf[7], 0.0f);
+}
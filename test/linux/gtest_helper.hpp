@@ -0,0 +1,88 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. *
+ *
+ */
+
+#ifndef SHARAKU_TEST_GTEST_HELPER_H_
+#define SHARAKU_TEST_GTEST_HELPER_H_
+
+#include <libsharaku/type/position.hpp>
+#include <random>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// テストデータの生成
+
+// 要素ごとに異なる値を持つベクトル列
+static inline std::vector<vector3>
+make_vectors(size_t n, float base)
+{
+	std::vector<vector3> v(n);
+	for (size_t i = 0; i < n; i++) {
+		v[i](base + i * 0.5f, base - i * 0.25f, base * i);
+	}
+	return v;
+}
+
+// 規則的に並んだ点列(乱数を使わない)
+static inline std::vector<position3>
+make_points(size_t n)
+{
+	std::vector<position3> v(n);
+	for (size_t i = 0; i < n; i++) {
+		v[i](i * 0.001f, (float)(i % 101) - 50.0f, 20.0f - (float)(i % 7));
+	}
+	return v;
+}
+
+// [-extent, extent]の一様乱数の点列(軸ごとにscaleを掛ける)
+static inline std::vector<position3>
+make_uniform_points(size_t n, unsigned seed, float extent,
+		    const vector3& scale = vector3{1.0f, 1.0f, 1.0f})
+{
+	std::mt19937 gen(seed);
+	std::uniform_real_distribution<float> d(-extent, extent);
+	std::vector<position3> v(n);
+	for (size_t i = 0; i < n; i++) {
+		const float x = d(gen), y = d(gen), z = d(gen);
+		v[i](x * scale.x, y * scale.y, z * scale.z);
+	}
+	return v;
+}
+
+// offsetを中心とする正規乱数の点列(軸ごとに広がりと相関を持たせる)
+static inline std::vector<position3>
+make_normal_points(size_t n, unsigned seed, float offset)
+{
+	std::mt19937 gen(seed);
+	std::normal_distribution<float> d(0.0f, 1.0f);
+	std::vector<position3> v(n);
+	for (size_t i = 0; i < n; i++) {
+		const float a = d(gen), b = d(gen), c = d(gen);
+		v[i](offset + 3.0f * a, offset - 2.0f + a + 0.5f * b, 0.1f * c - b);
+	}
+	return v;
+}
+
+#endif // SHARAKU_TEST_GTEST_HELPER_H_
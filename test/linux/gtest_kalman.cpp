@@ -0,0 +1,221 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/kalman.hpp>
+#include <gtest/gtest.h>
+#include <math.h>
+#include <vector>
+
+// -1～1の疑似乱数(線形合同法)
+static float
+kalman_noise(uint32_t& r)
+{
+	r = r * 1103515245u + 12345u;
+	return (float)((r >> 8) & 0xffff) / 32768.0f - 1.0f;
+}
+
+TEST(kalman, model) {
+	const float dt = 0.1f, q = 2.0f;
+	const matrix<2, 2> F = kalman_cv::transition(dt);
+	EXPECT_EQ(F(0, 0), 1.0f);
+	EXPECT_FLOAT_EQ(F(0, 1), dt);
+	EXPECT_EQ(F(1, 0), 0.0f);
+	EXPECT_EQ(F(1, 1), 1.0f);
+
+	const matrix<2, 2> Q = kalman_cv::process_noise(dt, q);
+	EXPECT_FLOAT_EQ(Q(0, 0), q * dt * dt * dt / 3.0f);
+	EXPECT_FLOAT_EQ(Q(0, 1), q * dt * dt / 2.0f);
+	EXPECT_FLOAT_EQ(Q(1, 0), q * dt * dt / 2.0f);
+	EXPECT_FLOAT_EQ(Q(1, 1), q * dt);
+
+	const matrix<3, 3> F3 = kalman_ca::transition(dt);
+	EXPECT_FLOAT_EQ(F3(0, 2), dt * dt / 2.0f);
+	EXPECT_FLOAT_EQ(F3(1, 2), dt);
+	EXPECT_EQ(F3(2, 0), 0.0f);
+
+	const matrix<3, 3> Q3 = kalman_ca::process_noise(dt, q);
+	EXPECT_FLOAT_EQ(Q3(0, 0), q * powf(dt, 5) / 20.0f);
+	EXPECT_FLOAT_EQ(Q3(0, 1), q * powf(dt, 4) / 8.0f);
+	EXPECT_FLOAT_EQ(Q3(0, 2), q * powf(dt, 3) / 6.0f);
+	EXPECT_FLOAT_EQ(Q3(1, 1), q * powf(dt, 3) / 3.0f);
+	EXPECT_FLOAT_EQ(Q3(2, 1), q * powf(dt, 2) / 2.0f);
+	EXPECT_FLOAT_EQ(Q3(2, 2), q * dt);
+}
+
+TEST(kalman, update) {
+	// P = 1, r = 1の場合、観測値と予測値の中間となる
+	kalman_cv kf(0.0f);
+	kf.update_position(position3{2.0f, -4.0f, 1.0f}, 1.0f);
+	EXPECT_FLOAT_EQ(kf.position().x, 1.0f);
+	EXPECT_FLOAT_EQ(kf.position().y, -2.0f);
+	EXPECT_FLOAT_EQ(kf.position().z, 0.5f);
+	EXPECT_FLOAT_EQ(kf.covariance()(0, 0), 0.5f);
+	EXPECT_FLOAT_EQ(kf.covariance()(1, 1), 1.0f);
+
+	// 観測雑音が無限大の場合は更新しない
+	kalman_cv inf(1.0f);
+	inf.predict(0.5f);
+	const matrix<2, 2> P = inf.covariance();
+	inf.update_position(position3{5.0f, 5.0f, 5.0f}, INFINITY);
+	EXPECT_EQ(inf.position().x, 0.0f);
+	EXPECT_EQ(inf.covariance()(0, 0), P(0, 0));
+	EXPECT_EQ(inf.covariance()(0, 1), P(0, 1));
+}
+
+TEST(kalman, constant_velocity) {
+	const float dt = 0.02f;
+	const vector3 vel = {1.0f, -2.0f, 0.5f};
+	kalman_cv kf(0.01f);
+	kf.init(position3{0.0f, 0.0f, 0.0f}, vector3{0.0f, 0.0f, 0.0f}, 100.0f);
+	uint32_t r = 1;
+
+	for (int step = 1; step <= 1000; step++) {
+		const float t = dt * step;
+		kf.predict(dt);
+		kf.update_position(position3{vel.x * t + 0.05f * kalman_noise(r),
+					     vel.y * t + 0.05f * kalman_noise(r),
+					     vel.z * t + 0.05f * kalman_noise(r)},
+				   0.05f * 0.05f / 3.0f);
+	}
+	EXPECT_NEAR(kf.velocity().x, vel.x, 0.05f);
+	EXPECT_NEAR(kf.velocity().y, vel.y, 0.05f);
+	EXPECT_NEAR(kf.velocity().z, vel.z, 0.05f);
+	EXPECT_NEAR(kf.position().x, vel.x * 20.0f, 0.03f);
+	EXPECT_NEAR(kf.position().y, vel.y * 20.0f, 0.03f);
+	EXPECT_NEAR(kf.position().z, vel.z * 20.0f, 0.03f);
+
+	// 共分散行列は対称かつ正定値
+	const matrix<2, 2> P = kf.covariance();
+	EXPECT_EQ(P(0, 1), P(1, 0));
+	EXPECT_GT(P(0, 0), 0.0f);
+	EXPECT_GT(P(0, 0) * P(1, 1) - P(0, 1) * P(1, 0), 0.0f);
+}
+
+TEST(kalman, control_input) {
+	// IMUの加速度を制御入力とし、オドメトリの位置で更新する
+	const float dt = 0.01f;
+	const vector3 acc = {0.5f, 0.0f, -9.8f};
+	kalman_cv kf(0.001f);
+	kalman_cv open(0.001f);
+	for (int step = 1; step <= 500; step++) {
+		const float t = dt * step;
+		kf.predict(dt, acc);
+		open.predict(dt, acc);
+		if (step % 10 == 0) {
+			kf.update_position(position3{0.5f * acc.x * t * t, 0.0f,
+						     0.5f * acc.z * t * t}, 1.0e-4f);
+		}
+	}
+	EXPECT_NEAR(kf.velocity().x, acc.x * 5.0f, 0.01f);
+	EXPECT_NEAR(kf.velocity().z, acc.z * 5.0f, 0.05f);
+	// 観測なしでも加速度の積分で移動する
+	EXPECT_NEAR(open.position().z, 0.5f * acc.z * 25.0f, 0.2f);
+}
+
+TEST(kalman, constant_acceleration) {
+	const float dt = 0.01f;
+	const vector3 acc = {0.0f, 2.0f, -1.0f};
+	kalman_ca kf(1.0f);
+	kf.init(position3{0.0f, 0.0f, 0.0f}, vector3{1.0f, 0.0f, 0.0f}, 10.0f);
+	for (int step = 1; step <= 2000; step++) {
+		const float t = dt * step;
+		kf.predict(dt);
+		kf.update_position(position3{t, 0.5f * acc.y * t * t, 0.5f * acc.z * t * t},
+				   1.0e-4f);
+	}
+	EXPECT_NEAR(kf.acceleration().x, 0.0f, 0.05f);
+	EXPECT_NEAR(kf.acceleration().y, acc.y, 0.05f);
+	EXPECT_NEAR(kf.acceleration().z, acc.z, 0.05f);
+	EXPECT_NEAR(kf.velocity().x, 1.0f, 0.01f);
+	EXPECT_NEAR(kf.velocity().y, acc.y * 20.0f, 0.02f);
+
+	// 加速度の観測による更新
+	kf.update_acceleration(vector3{0.0f, 2.0f, -1.0f}, 1.0e-6f);
+	EXPECT_NEAR(kf.acceleration().y, acc.y, 1.0e-3f);
+}
+
+template <size_t S>
+static void
+kalman_bank_check(void)
+{
+	const size_t n = 37;
+	kalman_bank<S> bank(n, 0.5f);
+	std::vector<kalman_filter<S>> tracks(n, kalman_filter<S>(0.5f));
+	vector3_soa z(n);
+	uint32_t r = 7;
+
+	for (size_t i = 0; i < n; i++) {
+		const position3 pos = {(float)i, -(float)i, 0.5f * i};
+		const vector3 vel = {0.1f * i, 1.0f, -0.2f};
+		tracks[i].init(pos, vel, 1.0f + i);
+		bank.init(i, pos, vel, 1.0f + i);
+	}
+	for (int step = 0; step < 50; step++) {
+		bank.predict(0.05f);
+		for (size_t i = 0; i < n; i++) {
+			tracks[i].predict(0.05f);
+			// 3トラックに1つは観測なし
+			const float rv = (i % 3 == (size_t)step % 3) ? INFINITY : 0.01f * (i + 1);
+			const vector3 zi = {(float)i + 0.1f * step + kalman_noise(r),
+					    -(float)i + 0.05f * step + kalman_noise(r),
+					    0.5f * i + kalman_noise(r)};
+			z.set(i, zi);
+			bank.set_measurement_noise(i, rv);
+			tracks[i].update_position(position3{zi.x, zi.y, zi.z}, rv);
+		}
+		bank.update_position(z);
+	}
+	for (size_t i = 0; i < n; i++) {
+		const position3 p = bank.position(i), pe = tracks[i].position();
+		const vector3 v = bank.velocity(i), ve = tracks[i].velocity();
+		EXPECT_NEAR(p.x, pe.x, 1.0e-4f * (1.0f + fabsf(pe.x))) << "S=" << S << " i=" << i;
+		EXPECT_NEAR(p.y, pe.y, 1.0e-4f * (1.0f + fabsf(pe.y))) << "S=" << S << " i=" << i;
+		EXPECT_NEAR(p.z, pe.z, 1.0e-4f * (1.0f + fabsf(pe.z))) << "S=" << S << " i=" << i;
+		EXPECT_NEAR(v.x, ve.x, 1.0e-3f * (1.0f + fabsf(ve.x))) << "S=" << S << " i=" << i;
+		EXPECT_NEAR(v.y, ve.y, 1.0e-3f * (1.0f + fabsf(ve.y))) << "S=" << S << " i=" << i;
+		const matrix<S, S> P = bank.covariance(i), Pe = tracks[i].covariance();
+		for (size_t k = 0; k < S; k++) {
+			for (size_t l = 0; l < S; l++) {
+				EXPECT_NEAR(P(k, l), Pe(k, l), 1.0e-4f * (1.0f + fabsf(Pe(k, l))));
+			}
+		}
+	}
+}
+
+TEST(kalman, kalman_bank) {
+	kalman_bank_check<2>();
+	kalman_bank_check<3>();
+
+	// 観測雑音が無限大のトラックは更新しない
+	kalman_bank<2> bank(3);
+	vector3_soa z(3);
+	z.set(1, vector3{5.0f, 5.0f, 5.0f});
+	bank.set_measurement_noise(1, INFINITY);
+	bank.update_position(z);
+	EXPECT_EQ(bank.position(1).x, 0.0f);
+	EXPECT_EQ(bank.covariance(1)(0, 0), 1.0f);
+	EXPECT_EQ(bank.size(), 3u);
+}
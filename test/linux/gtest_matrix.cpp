@@ -0,0 +1,76 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/matrix.hpp>
+#include <gtest/gtest.h>
+
+TEST(matrix, matrix) {
+	const matrix<2, 3> a = {{{1.0f, 2.0f, 3.0f}, {4.0f, 5.0f, 6.0f}}};
+	const matrix<3, 2> b = {{{7.0f, 8.0f}, {9.0f, 10.0f}, {11.0f, 12.0f}}};
+
+	const matrix<2, 2> c = a * b;
+	EXPECT_EQ(c(0, 0), 58.0f);
+	EXPECT_EQ(c(0, 1), 64.0f);
+	EXPECT_EQ(c(1, 0), 139.0f);
+	EXPECT_EQ(c(1, 1), 154.0f);
+
+	const matrix<3, 2> t = a.transpose();
+	for (size_t i = 0; i < 2; i++) {
+		for (size_t j = 0; j < 3; j++) {
+			EXPECT_EQ(t(j, i), a(i, j));
+		}
+	}
+
+	const matrix<2, 2> d = c + matrix<2, 2>::identity(2.0f) - c * 0.5f;
+	EXPECT_EQ(d(0, 0), 31.0f);
+	EXPECT_EQ(d(0, 1), 32.0f);
+	EXPECT_EQ(d(1, 0), 69.5f);
+	EXPECT_EQ(d(1, 1), 79.0f);
+
+	// 単位行列との積は元の行列
+	const matrix<2, 3> e = matrix<2, 2>::identity() * a;
+	for (size_t i = 0; i < 2; i++) {
+		for (size_t j = 0; j < 3; j++) {
+			EXPECT_EQ(e(i, j), a(i, j));
+			EXPECT_EQ((matrix<2, 3>::zero()(i, j)), 0.0f);
+		}
+	}
+}
+
+TEST(matrix, unroll) {
+	int order[5];
+	size_t n = 0;
+	sharaku_unroll<5>([&](auto i) {
+		static_assert(decltype(i)::value < 5, "index must be a constant");
+		order[n++] = (int)i;
+	});
+	EXPECT_EQ(n, 5u);
+	for (int i = 0; i < 5; i++) {
+		EXPECT_EQ(order[i], i);
+	}
+	sharaku_unroll<0>([&](auto) { n++; });
+	EXPECT_EQ(n, 5u);
+}
@@ -0,0 +1,119 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/parallel.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+#include "gtest_helper.hpp"
+
+TEST(parallel, run) {
+	thread_pool pool(4);
+	std::vector<std::atomic<int>> hit(1000);
+
+	EXPECT_EQ(pool.size(), 4u);
+	for (int k = 0; k < 3; k++) {
+		pool.run(hit.size(), [&](size_t c) { hit[c]++; });
+	}
+	for (size_t c = 0; c < hit.size(); c++) {
+		EXPECT_EQ(hit[c].load(), 3);
+	}
+}
+
+TEST(parallel, chunk) {
+	std::vector<position3> out(1 << 20);
+	for (size_t offset = 0; offset < 4; offset++) {
+		const position3 *p = out.data() + offset;
+		const size_t n = out.size() - offset;
+		parallel_chunk chunk = parallel_chunk::make(p, sizeof(position3), n, 8);
+
+		EXPECT_GT(chunk.count, 1u);
+		EXPECT_EQ(chunk.begin(0), 0u);
+		EXPECT_EQ(chunk.end(chunk.count - 1), n);
+		for (size_t c = 1; c < chunk.count; c++) {
+			EXPECT_EQ(chunk.begin(c), chunk.end(c - 1));
+			// チャンクの先頭はキャッシュライン境界
+			EXPECT_EQ((uintptr_t)(p + chunk.begin(c)) % SHARAKU_CACHE_LINE, 0u);
+		}
+	}
+
+	// 小さな配列は分割しない
+	parallel_chunk small = parallel_chunk::make(out.data(), sizeof(position3), 100, 8);
+	EXPECT_EQ(small.count, 1u);
+	EXPECT_EQ(small.end(0), 100u);
+}
+
+TEST(parallel, transform) {
+	const size_t n = 200003;
+	thread_pool pool(4);
+	const transform3 t = transform3::from_rotation(rotation3{10.0f, -20.0f, 30.0f},
+						       vector3{-4.0f, 0.5f, 7.0f});
+	const vector3 vec{1.0f, -2.0f, 3.0f};
+	std::vector<position3> in = make_points(n);
+	std::vector<position3> out(n), serial(n), moved(n);
+
+	t.apply(in.data(), serial.data(), n);
+	sharaku_parallel_transform(pool, t, in.data(), out.data(), n);
+	sharaku_parallel_translate(pool, vec, in.data(), moved.data(), n);
+	for (size_t i = 0; i < n; i++) {
+		EXPECT_FLOAT_EQ(out[i].x, serial[i].x);
+		EXPECT_FLOAT_EQ(out[i].y, serial[i].y);
+		EXPECT_FLOAT_EQ(out[i].z, serial[i].z);
+		EXPECT_EQ(moved[i].x, in[i].x + vec.x);
+		EXPECT_EQ(moved[i].z, in[i].z + vec.z);
+	}
+
+	// 同一配列上での回転
+	const transform3 r = transform3::from_rotation(rotation3{0.0f, 0.0f, 90.0f},
+						       vector3{0.0f, 0.0f, 0.0f});
+	r.apply(in.data(), serial.data(), n);
+	sharaku_parallel_rotate(pool, rotation3{0.0f, 0.0f, 90.0f}, in.data(), in.data(), n);
+	for (size_t i = 0; i < n; i++) {
+		EXPECT_FLOAT_EQ(in[i].x, serial[i].x);
+		EXPECT_FLOAT_EQ(in[i].y, serial[i].y);
+	}
+}
+
+TEST(parallel, reduce) {
+	thread_pool pool(4);
+	std::vector<int32_t> v(300001);
+	for (size_t i = 0; i < v.size(); i++) {
+		v[i] = (int32_t)(i % 1000);
+	}
+	int64_t ref = 0;
+	for (int32_t a : v) {
+		ref += a;
+	}
+	auto sum = [&](size_t b, size_t e) {
+		int64_t s = 0;
+		for (size_t i = b; i < e; i++) {
+			s += v[i];
+		}
+		return s;
+	};
+	auto add = [](int64_t a, int64_t b) { return a + b; };
+	EXPECT_EQ(sharaku_parallel_reduce(pool, v.data(), v.size(), (int64_t)0, sum, add), ref);
+	EXPECT_EQ(sharaku_parallel_reduce(pool, v.data(), 0, (int64_t)-1, sum, add), -1);
+}
@@ -25,7 +25,9 @@
  */
 
 #include <libsharaku/type/pid.hpp>
+#include <math.h>
 #include <gtest/gtest.h>
+#include <vector>
 
 TEST(pid, pid) {
 	pid	p(0.0f, 0.0f, 0.0f);
@@ -34,3 +36,278 @@ TEST(pid, pid) {
 	EXPECT_EQ(p.get_Ki(), 0.0f);
 	EXPECT_EQ(p.get_Kd(), 0.0f);
 }
+
+TEST(pid, pid_bank) {
+	const size_t n = 37;
+	pid_bank bank(n);
+	std::vector<pid> loops;
+	std::vector<int32_t> now(n), target(n);
+	std::vector<float> u(n);
+
+	for (size_t i = 0; i < n; i++) {
+		float Kp = 0.5f + i * 0.125f;
+		float Ki = 0.01f * i;
+		float Kd = 0.3f / (i + 1);
+		loops.push_back(pid(Kp, Ki, Kd));
+		bank.set_pid(i, Kp, Ki, Kd);
+		EXPECT_EQ(bank.get_Kp(i), Kp);
+	}
+	for (int step = 0; step < 100; step++) {
+		for (size_t i = 0; i < n; i++) {
+			now[i] = (int32_t)(i * 7 + step * 3) % 101 - 50;
+			target[i] = (int32_t)(i * 13) % 97;
+		}
+		bank(10.0f, now.data(), target.data(), u.data());
+		for (size_t i = 0; i < n; i++) {
+			EXPECT_EQ(u[i], loops[i](10.0f, now[i], target[i]));
+			EXPECT_EQ(bank.get_ei(i), loops[i].get_ei());
+			EXPECT_EQ(bank.get_el(i), loops[i].get_el());
+		}
+	}
+	bank.clear();
+	EXPECT_EQ(bank.get_ei(0), 0.0f);
+	EXPECT_EQ(bank.get_Kd(n - 1), loops[n - 1].get_Kd());
+}
+
+// 1次遅れのプラント(時定数tau_ms)に対するステップ応答で、
+// pid_fixedの操作量がfloatのpidと許容誤差内で一致すること
+//  許容誤差: |u_fixed - u_float| <= 0.05 + 0.002 * |u_float|
+//  (係数と周期の逆数をQ16.16へ丸める誤差と、各項の切り捨て誤差による)
+TEST(pid, pid_fixed_step_response) {
+	const float Kp = 0.8f, Ki = 0.02f, Kd = 1.5f;
+	const float T = 1.0f, tau_ms = 20.0f;
+	pid		pf(Kp, Ki, Kd);
+	pid_fixed	pq{q16_16(Kp), q16_16(Ki), q16_16(Kd), q16_16(T)};
+	float y = 0.0f;
+
+	EXPECT_EQ(pq.get_period(), q16_16(T));
+	for (int step = 0; step < 500; step++) {
+		const int32_t target = (step < 250) ? 200 : -60;
+		const int32_t now = (int32_t)y;
+		const float uf = pf(T, now, target);
+		const float uq = (float)pq(now, target);
+		EXPECT_NEAR(uq, uf, 0.05f + 0.002f * fabsf(uf)) << "step " << step;
+		EXPECT_NEAR((float)pq.get_ei(), pf.get_ei(), 0.01f + 1.0e-4f * fabsf(pf.get_ei()));
+		y += (uf - y) * (T / tau_ms);
+	}
+}
+
+// 偏差が残り続けても誤差積分と操作量がラップアラウンドしないこと
+TEST(pid, pid_fixed_saturation) {
+	pid_fixed	pq(q16_16(1), q16_16(1), q16_16(0), q16_16(100));
+
+	for (int step = 0; step < 1000; step++) {
+		q16_16 u = pq(-100000, 100000);
+		EXPECT_GT(u.raw, 0);
+	}
+	EXPECT_EQ(pq.get_ei().raw, INT32_MAX);
+	EXPECT_EQ(pq.get_el(), q16_16(32767));
+	EXPECT_EQ(pq(-100000, 100000).raw, INT32_MAX);
+
+	for (int step = 0; step < 1000; step++) {
+		q16_16 u = pq(100000, -100000);
+		EXPECT_LT(u.raw, INT32_MAX);
+	}
+	EXPECT_EQ(pq.get_ei().raw, INT32_MIN);
+	pq.clear();
+	EXPECT_EQ(pq(0, 0).raw, 0);
+}
+
+// 変更前のpid::operator()(出力制限等なし)
+struct pid_reference {
+	float Kp, Ki, Kd, ei, el;
+	float operator()(float delta_ms, int32_t now, int32_t target) {
+		float e = target - now;
+		ei = ei + e * delta_ms;
+		float ed = (e - el) / delta_ms;
+		el = e;
+		return Kp * e + Ki * ei + Kd * ed;
+	}
+};
+
+// 既定値では出力制限等を追加する前と同一の結果となること
+TEST(pid, default_compatible) {
+	pid		p(0.7f, 0.03f, 0.4f);
+	pid_reference	ref{0.7f, 0.03f, 0.4f, 0.0f, 0.0f};
+
+	for (int step = 0; step < 200; step++) {
+		int32_t now = (step * 37) % 211 - 100;
+		EXPECT_EQ(p(10.0f, now, 50), ref(10.0f, now, 50));
+		EXPECT_EQ(p.get_ei(), ref.ei);
+	}
+}
+
+// NaNを含めて同一の値であること
+static void
+pid_expect_same(float actual, float expected)
+{
+	if (isnan(expected)) {
+		EXPECT_TRUE(isnan(actual));
+	} else {
+		EXPECT_EQ(actual, expected);
+	}
+}
+
+// Δ時間0で非有限値となったステップの後も従来と同様に復帰すること
+TEST(pid, zero_delta) {
+	const float	dt[] = {0.0f, 10.0f, 10.0f, 0.0f, 10.0f, 10.0f};
+	const int32_t	now[] = {0, 0, 0, 0, 3, 3};
+	pid		p(1.0f, 0.1f, 0.5f);
+	pid_reference	ref{1.0f, 0.1f, 0.5f, 0.0f, 0.0f};
+	pid_bank	bank(1);
+	const int32_t	target = 10;
+	float		u;
+
+	bank.set_pid(0, 1.0f, 0.1f, 0.5f);
+	for (size_t step = 0; step < sizeof(dt) / sizeof(dt[0]); step++) {
+		float expected = ref(dt[step], now[step], target);
+		pid_expect_same(p(dt[step], now[step], target), expected);
+		EXPECT_EQ(p.get_ei(), ref.ei);
+		bank(dt[step], &now[step], &target, &u);
+		pid_expect_same(u, expected);
+		EXPECT_EQ(bank.get_ei(0), ref.ei);
+	}
+	// 最後のΔ時間0(0 / 0)の後も有限値へ復帰している
+	EXPECT_EQ(p(10.0f, 3, 10), ref(10.0f, 3, 10));
+	EXPECT_FALSE(isnan(p.get_ei()));
+}
+
+// 操作量がオーバーフローしたステップの後も誤差積分が壊れないこと
+TEST(pid, overflow) {
+	pid		p(1.0e38f, 0.1f, 0.0f);
+	pid		limited(1.0e38f, 0.1f, 0.0f);
+	pid_reference	ref{1.0e38f, 0.1f, 0.0f, 0.0f, 0.0f};
+	pid_bank	bank(1);
+	const int32_t	target = 0;
+	float		u;
+
+	limited.set_limit(-10.0f, 10.0f);
+	limited.set_antiwindup(1.0f);
+	bank.set_pid(0, 1.0e38f, 0.1f, 0.0f);
+	bank.set_limit(0, -10.0f, 10.0f);
+	bank.set_antiwindup(0, 1.0f);
+
+	// Kp * eが無限大となる(制限ありでは補正量が-infとなるため補正しない)
+	int32_t now = -1000;
+	u = p(1.0f, now, target);
+	EXPECT_TRUE(isinf(u));
+	EXPECT_EQ(u, ref(1.0f, now, target));
+	EXPECT_EQ(limited(1.0f, now, target), 10.0f);
+	EXPECT_EQ(limited.get_ei(), 1000.0f);
+	bank(1.0f, &now, &target, &u);
+	EXPECT_EQ(u, 10.0f);
+	EXPECT_EQ(bank.get_ei(0), limited.get_ei());
+
+	// 誤差0に戻った後は有限値となる(u = Ki * ei = 100を10へ制限して補正する)
+	now = 0;
+	EXPECT_EQ(p(1.0f, now, target), ref(1.0f, now, target));
+	EXPECT_EQ(p.get_ei(), 1000.0f);
+	EXPECT_EQ(limited(1.0f, now, target), 10.0f);
+	EXPECT_EQ(limited.get_ei(), 910.0f);
+	bank(1.0f, &now, &target, &u);
+	EXPECT_EQ(u, 10.0f);
+	EXPECT_EQ(bank.get_ei(0), limited.get_ei());
+}
+
+// 従来のpidで可能だった引数の型の組み合わせで呼び出せること
+TEST(pid, argument_types) {
+	pid	p(0.7f, 0.03f, 0.4f);
+	pid	ref(0.7f, 0.03f, 0.4f);
+	float	u;
+
+	u = p(10.0f, (uint32_t)3, (uint32_t)8);
+	EXPECT_EQ(u, ref(10.0f, 3, 8));
+	u = p(10.0f, (int64_t)4, (int64_t)9);
+	EXPECT_EQ(u, ref(10.0f, 4, 9));
+	u = p(10, (int16_t)5, 10);
+	EXPECT_EQ(u, ref(10.0f, 5, 10));
+	// 整数と浮動小数点の混在はint32_tとして扱う
+	u = p(10.0f, 6.75f, 11);
+	EXPECT_EQ(u, ref(10.0f, 6, 11));
+	// 浮動小数点同士は切り捨てずにそのまま扱う
+	u = p(10.0f, 7.5f, 12.0f);
+	EXPECT_EQ(u, ref(10.0f, 7.5f, 12.0f));
+	EXPECT_EQ(p.get_el(), 4.5f);
+}
+
+// 出力が飽和するプラントに対するステップ応答
+//  プラント: y = y + (20 * u - y) * T / 100 (|u| <= 10)
+static float
+pid_saturated_overshoot(float Kb, float *max_abs_u, float *max_abs_ei)
+{
+	pid	p(0.05f, 0.002f, 0.0f);
+	float	y = 0.0f, peak = 0.0f;
+
+	p.set_limit(-10.0f, 10.0f);
+	p.set_antiwindup(Kb);
+	*max_abs_u = 0.0f;
+	*max_abs_ei = 0.0f;
+	for (int step = 0; step < 2000; step++) {
+		float u = p(1.0f, (int32_t)y, 150);
+		*max_abs_u = fmaxf(*max_abs_u, fabsf(u));
+		*max_abs_ei = fmaxf(*max_abs_ei, fabsf(p.get_ei()));
+		y += (20.0f * u - y) * (1.0f / 100.0f);
+		peak = fmaxf(peak, y);
+	}
+	EXPECT_NEAR(y, 150.0f, 2.0f);
+	return peak - 150.0f;
+}
+
+TEST(pid, saturated_plant) {
+	float u_free, ei_free, u_aw, ei_aw;
+	float overshoot_free = pid_saturated_overshoot(0.0f, &u_free, &ei_free);
+	float overshoot_aw = pid_saturated_overshoot(20.0f, &u_aw, &ei_aw);
+
+	EXPECT_LE(u_free, 10.0f);
+	EXPECT_LE(u_aw, 10.0f);
+	// アンチワインドアップにより誤差積分の蓄積とオーバーシュートが減少する
+	EXPECT_LT(ei_aw, ei_free);
+	EXPECT_LT(overshoot_aw, overshoot_free * 0.5f);
+}
+
+// 微分フィルタにより測定ノイズによる微分項の変動が減少すること
+TEST(pid, derivative_filter) {
+	pid	raw(0.0f, 0.0f, 1.0f);
+	pid	filtered(0.0f, 0.0f, 1.0f);
+	float	sum_raw = 0.0f, sum_filtered = 0.0f;
+
+	filtered.set_derivative_filter(0.1f);
+	for (int step = 0; step < 100; step++) {
+		int32_t now = (step & 1) ? 5 : -5;
+		sum_raw += fabsf(raw(1.0f, now, 0));
+		sum_filtered += fabsf(filtered(1.0f, now, 0));
+	}
+	EXPECT_LT(sum_filtered, sum_raw * 0.2f);
+}
+
+// 出力制限等を設定した場合もpid_bankとpidが同一の結果となること
+TEST(pid, pid_bank_limit) {
+	const size_t n = 21;
+	pid_bank bank(n);
+	std::vector<pid> loops;
+	std::vector<int32_t> now(n), target(n);
+	std::vector<float> u(n);
+
+	for (size_t i = 0; i < n; i++) {
+		loops.push_back(pid(0.5f + i * 0.1f, 0.02f, 0.3f));
+		bank.set_pid(i, 0.5f + i * 0.1f, 0.02f, 0.3f);
+		loops[i].set_limit(-20.0f, 5.0f + i);
+		bank.set_limit(i, -20.0f, 5.0f + i);
+		loops[i].set_antiwindup(0.1f * i);
+		bank.set_antiwindup(i, 0.1f * i);
+		loops[i].set_derivative_filter(0.05f * (i + 1));
+		bank.set_derivative_filter(i, 0.05f * (i + 1));
+	}
+	for (int step = 0; step < 100; step++) {
+		for (size_t i = 0; i < n; i++) {
+			now[i] = (int32_t)(i * 7 + step * 3) % 101 - 50;
+			target[i] = (int32_t)(i * 13) % 97;
+		}
+		bank(10.0f, now.data(), target.data(), u.data());
+		for (size_t i = 0; i < n; i++) {
+			EXPECT_EQ(u[i], loops[i](10.0f, now[i], target[i]));
+			EXPECT_EQ(bank.get_ei(i), loops[i].get_ei());
+			EXPECT_LE(u[i], bank.get_umax(i));
+		}
+	}
+}
@@ -0,0 +1,167 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/point-cloud.hpp>
+#include <gtest/gtest.h>
+#include <math.h>
+#include <map>
+#include <tuple>
+#include <vector>
+#include "gtest_helper.hpp"
+
+// 倍精度の2パスで求めた重心と共分散
+static void
+reference_covariance(const std::vector<position3>& p, double mean[3], double cov[3][3])
+{
+	for (int i = 0; i < 3; i++) {
+		mean[i] = 0.0;
+	}
+	for (const position3& q : p) {
+		mean[0] += q.x; mean[1] += q.y; mean[2] += q.z;
+	}
+	for (int i = 0; i < 3; i++) {
+		mean[i] /= (double)p.size();
+	}
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			cov[i][j] = 0.0;
+		}
+	}
+	for (const position3& q : p) {
+		const double d[3] = {q.x - mean[0], q.y - mean[1], q.z - mean[2]};
+		for (int i = 0; i < 3; i++) {
+			for (int j = 0; j < 3; j++) {
+				cov[i][j] += d[i] * d[j];
+			}
+		}
+	}
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			cov[i][j] /= (double)p.size();
+		}
+	}
+}
+
+TEST(point_cloud, aabb) {
+	thread_pool pool(4);
+	for (size_t n : {1u, 3u, 17u, 100003u}) {
+		std::vector<position3> p = make_normal_points(n, 1, 5.0f);
+		aabb3 ref = aabb3::none();
+		for (const position3& q : p) {
+			ref = aabb3::merge(ref, aabb3{q, q});
+		}
+		for (thread_pool *tp : {(thread_pool *)nullptr, &pool}) {
+			const aabb3 b = sharaku_aabb(p.data(), n, tp);
+			EXPECT_FALSE(b.empty());
+			EXPECT_EQ(b.lo.x, ref.lo.x); EXPECT_EQ(b.lo.y, ref.lo.y); EXPECT_EQ(b.lo.z, ref.lo.z);
+			EXPECT_EQ(b.hi.x, ref.hi.x); EXPECT_EQ(b.hi.y, ref.hi.y); EXPECT_EQ(b.hi.z, ref.hi.z);
+		}
+	}
+	EXPECT_TRUE(sharaku_aabb(nullptr, 0, &pool).empty());
+}
+
+// 原点から離れた点群でも倍精度の2パスと一致すること
+TEST(point_cloud, centroid_covariance) {
+	thread_pool pool(4);
+	for (float offset : {0.0f, 1000.0f}) {
+		for (size_t n : {1u, 5u, 1000u, 200003u}) {
+			std::vector<position3> p = make_normal_points(n, 2, offset);
+			double mean[3], ref[3][3];
+			reference_covariance(p, mean, ref);
+			for (thread_pool *tp : {(thread_pool *)nullptr, &pool}) {
+				const position3 c = sharaku_centroid(p.data(), n, tp);
+				EXPECT_NEAR(c.x, mean[0], 1.0e-5 * (offset + 1.0f));
+				EXPECT_NEAR(c.y, mean[1], 1.0e-5 * (offset + 1.0f));
+				EXPECT_NEAR(c.z, mean[2], 1.0e-5 * (offset + 1.0f));
+
+				position3 c2;
+				const matrix<3, 3> cov = sharaku_covariance(p.data(), n, tp, &c2);
+				EXPECT_NEAR(c2.x, mean[0], 1.0e-5 * (offset + 1.0f));
+				EXPECT_NEAR(c2.z, mean[2], 1.0e-5 * (offset + 1.0f));
+				for (size_t i = 0; i < 3; i++) {
+					for (size_t j = 0; j < 3; j++) {
+						EXPECT_NEAR(cov(i, j), ref[i][j], 1.0e-4);
+						EXPECT_EQ(cov(i, j), cov(j, i));
+					}
+				}
+			}
+		}
+	}
+	const matrix<3, 3> z = sharaku_covariance(nullptr, 0, &pool);
+	EXPECT_EQ(z(0, 0), 0.0f);
+	EXPECT_EQ(sharaku_centroid(nullptr, 0).x, 0.0f);
+}
+
+TEST(point_cloud, voxel_downsample) {
+	thread_pool pool(4);
+	const float leaf = 0.5f;
+	std::vector<position3> p = make_normal_points(100000, 3, -0.3f);
+	p[10](NAN, 0.0f, 0.0f);
+	p[20](0.0f, INFINITY, 0.0f);
+	p[30](1.0e12f, 0.0f, 0.0f);
+
+	// std::mapによる参照値
+	std::map<std::tuple<int, int, int>, std::tuple<double, double, double, int>> ref;
+	for (const position3& q : p) {
+		if (!std::isfinite(q.x) || !std::isfinite(q.y) || fabsf(q.x) > 1.0e6f) {
+			continue;
+		}
+		auto& e = ref[std::make_tuple((int)floorf(q.x / leaf), (int)floorf(q.y / leaf),
+					      (int)floorf(q.z / leaf))];
+		std::get<0>(e) += q.x; std::get<1>(e) += q.y; std::get<2>(e) += q.z;
+		std::get<3>(e)++;
+	}
+
+	std::vector<position3> serial, par;
+	EXPECT_EQ(sharaku_voxel_downsample(p.data(), p.size(), leaf, serial), ref.size());
+	EXPECT_EQ(sharaku_voxel_downsample(p.data(), p.size(), leaf, par, &pool), ref.size());
+	ASSERT_EQ(par.size(), serial.size());
+	for (size_t i = 0; i < serial.size(); i++) {
+		// 出力順は最初に現れた順で、スレッド数によらない
+		EXPECT_NEAR(par[i].x, serial[i].x, 1.0e-6f);
+		EXPECT_NEAR(par[i].y, serial[i].y, 1.0e-6f);
+		EXPECT_NEAR(par[i].z, serial[i].z, 1.0e-6f);
+
+		const position3& q = serial[i];
+		auto it = ref.find(std::make_tuple((int)floorf(q.x / leaf), (int)floorf(q.y / leaf),
+						   (int)floorf(q.z / leaf)));
+		ASSERT_NE(it, ref.end());
+		const double w = 1.0 / std::get<3>(it->second);
+		EXPECT_NEAR(q.x, std::get<0>(it->second) * w, 1.0e-5);
+		EXPECT_NEAR(q.y, std::get<1>(it->second) * w, 1.0e-5);
+		EXPECT_NEAR(q.z, std::get<2>(it->second) * w, 1.0e-5);
+	}
+	EXPECT_NEAR(serial[0].x, p[0].x, leaf);
+
+	// 負の座標はfloorで丸める
+	std::vector<position3> q = {position3{-0.1f, 0.0f, 0.0f}, position3{0.1f, 0.0f, 0.0f},
+				    position3{-0.2f, 0.0f, 0.0f}};
+	EXPECT_EQ(sharaku_voxel_downsample(q.data(), q.size(), leaf, serial), 2u);
+	EXPECT_FLOAT_EQ(serial[0].x, -0.15f);
+	EXPECT_FLOAT_EQ(serial[1].x, 0.1f);
+	EXPECT_EQ(sharaku_voxel_downsample(q.data(), 0, leaf, serial), 0u);
+	EXPECT_TRUE(serial.empty());
+}
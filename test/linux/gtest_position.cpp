@@ -35,3 +35,15 @@ TEST(position, position3) {
 	EXPECT_EQ(pos3.y, 0.0f);
 	EXPECT_EQ(pos3.z, 0.0f);
 }
+
+TEST(position, position3_arithmetic) {
+	constexpr position3 p{1.0f, 2.0f, 3.0f};
+	constexpr position3 q{0.5f, 0.5f, 0.5f};
+	constexpr position3 r = p - q + q;
+	static_assert(r.x == 1.0f && r.y == 2.0f && r.z == 3.0f, "");
+
+	position3 s = p;
+	s += q;
+	s -= p;
+	EXPECT_EQ(s.x, 0.5f);
+}
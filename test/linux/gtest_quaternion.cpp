@@ -0,0 +1,107 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/quaternion.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+static void
+expect_vector_near(const vector3& a, const vector3& b, float eps)
+{
+	EXPECT_NEAR(a.x, b.x, eps);
+	EXPECT_NEAR(a.y, b.y, eps);
+	EXPECT_NEAR(a.z, b.z, eps);
+}
+
+TEST(quaternion, rotation3) {
+	const rotation3 rots[] = {
+		{ 0.0f, 0.0f, 0.0f }, { 30.0f, 0.0f, 0.0f }, { 0.0f, -45.0f, 0.0f },
+		{ 0.0f, 0.0f, 170.0f }, { 10.0f, 20.0f, 30.0f }, { -120.0f, 60.0f, -15.0f },
+	};
+	for (const rotation3& r : rots) {
+		quaternion q = quaternion::from_rotation(r);
+		rotation3 back = q.to_rotation();
+		EXPECT_NEAR(q.norm2(), 1.0f, 1.0e-6f);
+		EXPECT_NEAR(back.x, r.x, 1.0e-3f);
+		EXPECT_NEAR(back.y, r.y, 1.0e-3f);
+		EXPECT_NEAR(back.z, r.z, 1.0e-3f);
+	}
+}
+
+TEST(quaternion, rotate) {
+	// z軸回りに90度回転するとx軸がy軸へ移る
+	quaternion qz = quaternion::from_rotation(rotation3{0.0f, 0.0f, 90.0f});
+	expect_vector_near(qz.rotate(vector3{1.0f, 0.0f, 0.0f}), vector3{0.0f, 1.0f, 0.0f}, 1.0e-6f);
+	// x軸回りに90度回転するとy軸がz軸へ移る
+	quaternion qx = quaternion::from_rotation(rotation3{90.0f, 0.0f, 0.0f});
+	expect_vector_near(qx.rotate(vector3{0.0f, 1.0f, 0.0f}), vector3{0.0f, 0.0f, 1.0f}, 1.0e-6f);
+
+	// 合成はrhs、lhsの順に回転する
+	const vector3 v{0.3f, -1.2f, 2.0f};
+	expect_vector_near((qz * qx).rotate(v), qz.rotate(qx.rotate(v)), 1.0e-5f);
+	expect_vector_near((qz * qz.conjugate()).rotate(v), v, 1.0e-6f);
+
+	// rotation3はx, y, z軸の順に回転する
+	quaternion qy = quaternion::from_rotation(rotation3{0.0f, 25.0f, 0.0f});
+	quaternion q = quaternion::from_rotation(rotation3{90.0f, 25.0f, 90.0f});
+	expect_vector_near(q.rotate(v), qz.rotate(qy.rotate(qx.rotate(v))), 1.0e-5f);
+
+	position3 p = q.rotate(position3{v.x, v.y, v.z});
+	expect_vector_near(vector3{p.x, p.y, p.z}, q.rotate(v), 0.0f);
+}
+
+TEST(quaternion, rotate_batch) {
+	const size_t n = 100;
+	quaternion q = quaternion::from_rotation(rotation3{-12.0f, 33.0f, 71.0f});
+	std::vector<vector3> in(n), out(n);
+	for (size_t i = 0; i < n; i++) {
+		in[i](i * 0.1f, 1.0f - i * 0.05f, (float)(i % 7));
+	}
+	q.rotate(in.data(), out.data(), n);
+	for (size_t i = 0; i < n; i++) {
+		expect_vector_near(out[i], q.rotate(in[i]), 1.0e-5f);
+	}
+}
+
+TEST(quaternion, interpolate) {
+	quaternion a = quaternion::identity();
+	quaternion b = quaternion::from_rotation(rotation3{0.0f, 0.0f, 90.0f});
+	const vector3 ex{1.0f, 0.0f, 0.0f};
+
+	quaternion s = quaternion::slerp(a, b, 0.5f);
+	quaternion n = quaternion::nlerp(a, b, 0.5f);
+	rotation3 rs = s.to_rotation();
+	EXPECT_NEAR(rs.z, 45.0f, 1.0e-3f);
+	EXPECT_NEAR(n.to_rotation().z, 45.0f, 1.0e-3f);
+	expect_vector_near(quaternion::slerp(a, b, 0.0f).rotate(ex), ex, 1.0e-6f);
+	expect_vector_near(quaternion::slerp(a, b, 1.0f).rotate(ex), b.rotate(ex), 1.0e-6f);
+
+	// 符号反転した同一姿勢に対しても最短経路で補間する
+	quaternion nb{-b.w, -b.x, -b.y, -b.z};
+	EXPECT_NEAR(quaternion::slerp(a, nb, 0.5f).to_rotation().z, 45.0f, 1.0e-3f);
+	// 1/3での補間角
+	EXPECT_NEAR(quaternion::slerp(a, b, 1.0f / 3.0f).to_rotation().z, 30.0f, 1.0e-3f);
+}
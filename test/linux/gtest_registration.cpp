@@ -0,0 +1,222 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/registration.hpp>
+#include <gtest/gtest.h>
+#include <math.h>
+#include <random>
+#include <vector>
+#include "gtest_helper.hpp"
+
+static double
+det3(const rotation_matrix3& r)
+{
+	const float (*m)[3] = r.m;
+	return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+	       m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+	       m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+
+static void
+expect_transform_near(const transform3& a, const transform3& b, float rot_tol, float trans_tol)
+{
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			EXPECT_NEAR(a.rot.m[i][j], b.rot.m[i][j], rot_tol);
+		}
+	}
+	EXPECT_NEAR(a.trans.x, b.trans.x, trans_tol);
+	EXPECT_NEAR(a.trans.y, b.trans.y, trans_tol);
+	EXPECT_NEAR(a.trans.z, b.trans.z, trans_tol);
+}
+
+TEST(registration, jacobi) {
+	std::mt19937 gen(1);
+	std::uniform_real_distribution<double> d(-5.0, 5.0);
+	for (int n = 0; n < 100; n++) {
+		double a[3][3], org[3][3], w[3], v[3][3];
+		for (int i = 0; i < 3; i++) {
+			for (int j = i; j < 3; j++) {
+				a[i][j] = a[j][i] = d(gen);
+			}
+		}
+		// 重複する固有値を含む場合
+		if (n == 0) {
+			for (int i = 0; i < 3; i++) {
+				for (int j = 0; j < 3; j++) {
+					a[i][j] = (i == j) ? 2.0 : 0.0;
+				}
+			}
+		}
+		std::copy(&a[0][0], &a[0][0] + 9, &org[0][0]);
+		sharaku_jacobi3(a, w, v);
+		EXPECT_GE(w[0], w[1]);
+		EXPECT_GE(w[1], w[2]);
+		for (int c = 0; c < 3; c++) {
+			for (int i = 0; i < 3; i++) {
+				// A * v = w * v
+				const double av = org[i][0] * v[0][c] + org[i][1] * v[1][c] + org[i][2] * v[2][c];
+				EXPECT_NEAR(av, w[c] * v[i][c], 1.0e-9);
+			}
+			for (int c2 = 0; c2 < 3; c2++) {
+				const double dot = v[0][c] * v[0][c2] + v[1][c] * v[1][c2] + v[2][c] * v[2][c2];
+				EXPECT_NEAR(dot, (c == c2) ? 1.0 : 0.0, 1.0e-12);
+			}
+		}
+	}
+}
+
+// 既知の変換を原点から離れた点群に適用し、正確に復元できること
+TEST(registration, kabsch) {
+	thread_pool pool(4);
+	const rotation3 rots[] = {rotation3{10.0f, -20.0f, 30.0f}, rotation3{0.0f, 0.0f, 175.0f},
+				  rotation3{-170.0f, 60.0f, 5.0f}, rotation3{0.0f, 0.0f, 0.0f}};
+	for (const rotation3& rot : rots) {
+		const transform3 ref = transform3::from_rotation(rot, vector3{100.0f, -250.0f, 3.0f});
+		for (size_t n : {3u, 4u, 1000u, 100003u}) {
+			std::vector<position3> src = make_uniform_points(n, 2, 20.0f, vector3{1.0f, 0.5f, 0.2f});
+			for (position3& p : src) {
+				p(p.x + 500.0f, p.y - 300.0f, p.z + 20.0f);
+			}
+			std::vector<position3> dst(n);
+			ref.apply(src.data(), dst.data(), n);
+			for (thread_pool *tp : {(thread_pool *)nullptr, &pool}) {
+				transform3 t;
+				ASSERT_TRUE(sharaku_kabsch(src.data(), dst.data(), n, t, tp));
+				// 3, 4点では入力の丸め誤差(約3e-5)が原点からの距離倍に拡大される
+				// (SIMD無効時は単精度の累積誤差により約1e-3)
+				expect_transform_near(t, ref, 1.0e-5f, (n < 100) ? 1.0e-2f : 2.0e-3f);
+				EXPECT_NEAR(det3(t.rot), 1.0, 1.0e-5);
+			}
+		}
+	}
+
+	// rotation3と平行移動で受け取る
+	std::vector<position3> src = make_uniform_points(100, 3, 5.0f, vector3{1.0f, 0.5f, 0.2f}), dst(100);
+	transform3::from_rotation(rotation3{5.0f, -15.0f, 45.0f}, vector3{1.0f, 2.0f, 3.0f})
+		.apply(src.data(), dst.data(), src.size());
+	rotation3 rot;
+	vector3 trans;
+	ASSERT_TRUE(sharaku_kabsch(src.data(), dst.data(), src.size(), rot, trans));
+	EXPECT_NEAR(rot.x, 5.0f, 1.0e-3f);
+	EXPECT_NEAR(rot.y, -15.0f, 1.0e-3f);
+	EXPECT_NEAR(rot.z, 45.0f, 1.0e-3f);
+	EXPECT_NEAR(trans.x, 1.0f, 1.0e-5f);
+	EXPECT_NEAR(trans.z, 3.0f, 1.0e-5f);
+	transform3 t = transform3::identity();
+	EXPECT_FALSE(sharaku_kabsch(src.data(), dst.data(), 0, t));
+}
+
+// 平面上、直線上、1点の場合も鏡映を含まない回転を返すこと
+TEST(registration, kabsch_degenerate) {
+	const transform3 ref = transform3::from_rotation(rotation3{20.0f, 30.0f, -40.0f},
+							 vector3{1.0f, -1.0f, 0.5f});
+	std::vector<position3> plane = make_uniform_points(200, 4, 3.0f, vector3{1.0f, 0.5f, 0.2f});
+	for (position3& p : plane) {
+		p.z = 0.0f;
+	}
+	std::vector<position3> dst(plane.size());
+	ref.apply(plane.data(), dst.data(), plane.size());
+	transform3 t;
+	ASSERT_TRUE(sharaku_kabsch(plane.data(), dst.data(), plane.size(), t));
+	expect_transform_near(t, ref, 1.0e-5f, 1.0e-5f);
+
+	// 直線上: 回転は不定だが、点は一致させる
+	std::vector<position3> line(50);
+	for (size_t i = 0; i < line.size(); i++) {
+		line[i]((float)i * 0.1f, (float)i * 0.2f, -(float)i * 0.05f);
+	}
+	dst.resize(line.size());
+	ref.apply(line.data(), dst.data(), line.size());
+	ASSERT_TRUE(sharaku_kabsch(line.data(), dst.data(), line.size(), t));
+	EXPECT_NEAR(det3(t.rot), 1.0, 1.0e-5);
+	for (size_t i = 0; i < line.size(); i++) {
+		const position3 p = t.apply(line[i]);
+		EXPECT_NEAR(p.x, dst[i].x, 1.0e-4f);
+		EXPECT_NEAR(p.y, dst[i].y, 1.0e-4f);
+		EXPECT_NEAR(p.z, dst[i].z, 1.0e-4f);
+	}
+
+	// 1点: 回転なしの平行移動
+	const position3 s{1.0f, 2.0f, 3.0f}, d{4.0f, 4.0f, 4.0f};
+	ASSERT_TRUE(sharaku_kabsch(&s, &d, 1, t));
+	expect_transform_near(t, transform3::from_rotation(rotation3{0.0f, 0.0f, 0.0f},
+							   vector3{3.0f, 2.0f, 1.0f}), 0.0f, 1.0e-6f);
+}
+
+TEST(registration, icp) {
+	thread_pool pool(4);
+	// 特徴のある形状(軸ごとに異なる波形の面)
+	std::vector<position3> target(20000);
+	std::mt19937 gen(5);
+	std::uniform_real_distribution<float> u(-10.0f, 10.0f);
+	for (position3& p : target) {
+		const float x = u(gen), y = u(gen);
+		p(x, y, 2.0f * sinf(0.5f * x) + cosf(0.3f * y) + 0.1f * x * y);
+	}
+	kd_tree tree(target.data(), target.size());
+
+	// targetの一部を既知の変換で動かしたものをsrcとする
+	const transform3 motion = transform3::from_rotation(rotation3{1.0f, -2.0f, 4.0f},
+							    vector3{0.3f, -0.2f, 0.1f});
+	std::vector<position3> src(5000);
+	for (size_t i = 0; i < src.size(); i++) {
+		src[i] = motion.apply(target[i * 4]);
+	}
+	icp_params params = icp_params::defaults();
+	params.max_iterations = 50;
+	params.epsilon_translation = 1.0e-5f;
+	params.epsilon_rotation = 1.0e-4f;
+
+	const transform3 ref = motion.inverse();
+	const icp_result serial = sharaku_icp(tree, src.data(), src.size(), transform3::identity(), params);
+	EXPECT_TRUE(serial.converged);
+	EXPECT_LT(serial.iterations, params.max_iterations);
+	EXPECT_EQ(serial.inliers, src.size());
+	EXPECT_LT(serial.rmse, 1.0e-3f);
+	expect_transform_near(serial.transform, ref, 1.0e-4f, 1.0e-3f);
+
+	const icp_result par = sharaku_icp(tree, src.data(), src.size(), transform3::identity(),
+					   params, &pool);
+	EXPECT_TRUE(par.converged);
+	expect_transform_near(par.transform, ref, 1.0e-4f, 1.0e-3f);
+
+	// 反復回数の上限
+	params.max_iterations = 2;
+	const icp_result limited = sharaku_icp(tree, src.data(), src.size(), transform3::identity(), params);
+	EXPECT_FALSE(limited.converged);
+	EXPECT_EQ(limited.iterations, 2u);
+
+	// 対応点が無い場合は初期値のまま
+	params.max_distance = 1.0e-6f;
+	const transform3 guess = transform3::from_rotation(rotation3{0.0f, 0.0f, 90.0f},
+							   vector3{100.0f, 0.0f, 0.0f});
+	const icp_result none = sharaku_icp(tree, src.data(), src.size(), guess, params);
+	EXPECT_FALSE(none.converged);
+	EXPECT_EQ(none.iterations, 0u);
+	EXPECT_EQ(none.inliers, 0u);
+	expect_transform_near(none.transform, guess, 0.0f, 0.0f);
+}
@@ -0,0 +1,125 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/ring-buffer.hpp>
+#include <libsharaku/type/vector.hpp>
+#include <libsharaku/type/position.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+TEST(ring_buffer, spsc_ring) {
+	spsc_ring<vector3> ring(5);
+	EXPECT_EQ(ring.capacity(), 8u);
+	EXPECT_TRUE(ring.empty());
+
+	vector3 v;
+	EXPECT_FALSE(ring.pop(v));
+	for (int i = 0; i < 8; i++) {
+		EXPECT_TRUE(ring.push(vector3{(float)i, 0.0f, -(float)i}));
+	}
+	EXPECT_FALSE(ring.push(vector3{9.0f, 9.0f, 9.0f}));
+	EXPECT_EQ(ring.size(), 8u);
+	for (int i = 0; i < 8; i++) {
+		ASSERT_TRUE(ring.pop(v));
+		EXPECT_EQ(v.x, (float)i);
+		EXPECT_EQ(v.z, -(float)i);
+	}
+	EXPECT_TRUE(ring.empty());
+}
+
+TEST(ring_buffer, batch) {
+	spsc_ring<position3> ring(16);
+	std::vector<position3> in(40), out(40);
+	for (size_t i = 0; i < in.size(); i++) {
+		in[i](i, i * 2.0f, i * 3.0f);
+	}
+
+	// 終端での折り返しと、空き・要素不足による部分的な転送
+	size_t wr = 0, rd = 0;
+	EXPECT_EQ(ring.push(in.data(), 11), 11u);
+	wr += 11;
+	EXPECT_EQ(ring.pop(out.data(), 7), 7u);
+	rd += 7;
+	EXPECT_EQ(ring.push(in.data() + wr, 20), 12u);
+	wr += 12;
+	EXPECT_EQ(ring.push(in.data() + wr, 1), 0u);
+	EXPECT_EQ(ring.pop(out.data() + rd, 30), 16u);
+	rd += 16;
+	EXPECT_EQ(ring.pop(out.data() + rd, 1), 0u);
+	EXPECT_EQ(ring.push(in.data() + wr, 17), 16u);
+	wr += 16;
+	EXPECT_EQ(ring.pop(out.data() + rd, 16), 16u);
+	rd += 16;
+	ASSERT_EQ(wr, rd);
+	for (size_t i = 0; i < rd; i++) {
+		EXPECT_EQ(out[i].x, in[i].x);
+		EXPECT_EQ(out[i].y, in[i].y);
+		EXPECT_EQ(out[i].z, in[i].z);
+	}
+}
+
+TEST(ring_buffer, threads) {
+	// 生産者と消費者の2スレッドで順序と値が保たれる
+	const size_t n = 200000;
+	spsc_ring<position3> ring(64);
+	std::thread producer([&] {
+		position3 buf[7];
+		size_t i = 0;
+		while (i < n) {
+			const size_t m = (n - i < 7) ? n - i : 1 + i % 7;
+			for (size_t k = 0; k < m; k++) {
+				buf[k]((float)(i + k), 1.0f, -1.0f);
+			}
+			size_t done = 0;
+			while (done < m) {
+				done += ring.push(buf + done, m - done);
+				if (done < m) {
+					std::this_thread::yield();
+				}
+			}
+			i += m;
+		}
+	});
+
+	size_t i = 0;
+	bool ok = true;
+	position3 buf[5];
+	while (i < n) {
+		const size_t m = ring.pop(buf, 1 + i % 5);
+		for (size_t k = 0; k < m; k++) {
+			ok = ok && buf[k].x == (float)(i + k) && buf[k].y == 1.0f;
+		}
+		i += m;
+		if (m == 0) {
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+	EXPECT_TRUE(ok);
+	EXPECT_EQ(i, n);
+	EXPECT_TRUE(ring.empty());
+}
@@ -26,6 +26,10 @@
 
 #include <libsharaku/type/rotation.hpp>
 #include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <string.h>
+#include <vector>
 
 TEST(rotation, rotation3) {
 	rotation3	rot3;
@@ -35,3 +39,165 @@ TEST(rotation, rotation3) {
 	EXPECT_EQ(rot3.y, 0.0f);
 	EXPECT_EQ(rot3.z, 0.0f);
 }
+
+// sharaku_atan_fastの誤差が定義域全体で1.1e-4度以下であること
+//  正の有限なfloatのビット列を一定間隔で調べ、誤差が最大となる
+//  x = 0.967, 1.818付近は全てのfloatを調べる。
+TEST(rotation, atan_fast_error) {
+	const double bound = 1.1e-4;
+	double max_err = 0.0;
+	auto check = [&](float x) {
+		for (float v : { x, -x }) {
+			const double ref = atan((double)v);
+			const double err = fabs((double)sharaku_atan_fast(v) - ref) * (180.0 / M_PI);
+			max_err = (err > max_err) ? err : max_err;
+			EXPECT_LE(err, bound) << "x=" << v;
+			float simd[sharaku_simd::width];
+			sharaku_simd::store(simd, sharaku_atan_fast_simd(sharaku_simd::set1(v)));
+			EXPECT_LE(fabs((double)simd[0] - ref) * (180.0 / M_PI), bound) << "x=" << v;
+		}
+	};
+	for (uint32_t b = 0; b < 0x7f800000u; b += 4099) {
+		float x;
+		memcpy(&x, &b, sizeof(x));
+		check(x);
+	}
+	for (float c : { 0.967f, 1.818f }) {
+		for (float x = c - 0.002f; x < c + 0.002f; x = nextafterf(x, 2.0f)) {
+			check(x);
+		}
+	}
+	check(std::numeric_limits<float>::infinity());
+	// 誤差の上限が過大でないこと
+	EXPECT_GT(max_err, 1.0e-4);
+}
+
+TEST(rotation, rho2steering_fast) {
+	const int32_t wheel_length[] = { 1, 150, 2000 };
+	int mismatch = 0;
+
+	for (int32_t wl : wheel_length) {
+		for (int32_t rho = -20000; rho <= 20000; rho++) {
+			if (rho == 0) {
+				continue;
+			}
+			float exact = sharaku_rho2steering(rho, wl);
+			float fast = sharaku_rho2steering_fast(rho, wl);
+			EXPECT_NEAR(fast, exact, 1.0f) << "rho=" << rho << " wl=" << wl;
+			mismatch += (fast != exact);
+		}
+	}
+	// 整数境界付近以外は一致すること
+	EXPECT_LT(mismatch, 3 * 40000 / 1000);
+
+	std::vector<int32_t> rho(1000);
+	std::vector<float> steering(rho.size());
+	for (size_t i = 0; i < rho.size(); i++) {
+		rho[i] = (int32_t)i * 7 - 3500;
+	}
+	rho[500] = 1;
+	sharaku_rho2steering_batch(rho.data(), steering.data(), rho.size(), 150);
+	for (size_t i = 0; i < rho.size(); i++) {
+		EXPECT_EQ(steering[i], sharaku_rho2steering_fast(rho[i], 150));
+	}
+}
+
+TEST(rotation, steering2rho_fast) {
+	std::vector<int32_t> steering;
+	std::vector<float> rho;
+
+	for (int32_t s = -720; s <= 720; s++) {
+		float fast = sharaku_steering2rho_fast(s, 150);
+		int32_t m = ((s % 180) + 180) % 180;
+		double exact = 150.0 * M_PI / tan(m * M_PI / 180.0);
+		if (m == 0) {
+			EXPECT_TRUE(std::isinf(fast));
+		} else if (m == 90) {
+			EXPECT_EQ(fast, 0.0f);
+		} else {
+			EXPECT_NEAR(fast, exact, fabs(exact) * 1.0e-6) << "steering=" << s;
+		}
+		if (-90 < s && s < 90 && s != 0) {
+			float current = sharaku_steering2rho(s, 150);
+			EXPECT_NEAR(fast, current, fabsf(current) * 2.0e-5f) << "steering=" << s;
+		}
+		steering.push_back(s);
+	}
+	rho.resize(steering.size());
+	sharaku_steering2rho_batch(steering.data(), rho.data(), steering.size(), 150);
+	for (size_t i = 0; i < steering.size(); i++) {
+		EXPECT_EQ(rho[i], sharaku_steering2rho_fast(steering[i], 150));
+	}
+}
+
+// 分岐版のsharaku_differ_degree(比較用)
+static int32_t
+differ_degree_reference(int32_t target, int32_t now, int leftright)
+{
+	int32_t result;
+	if (leftright > 0) {
+		int32_t diff = 360 + target - now;
+		if (diff >= 360) {
+			result = diff - 360;
+		} else {
+			result = diff;
+		}
+	} else if (leftright < 0) {
+		int32_t diff = -360 + target - now;
+		if (diff <= 360) {
+			result = diff + 360;
+		} else {
+			result = diff;
+		}
+	} else {
+		int32_t diff1 = differ_degree_reference(target, now, 1);
+		int32_t diff2 = differ_degree_reference(target, now, -1);
+		if (fabs(diff2) > diff1) {
+			result = diff1;
+		} else {
+			result = diff2;
+		}
+	}
+	return result;
+}
+
+TEST(rotation, differ_degree) {
+	EXPECT_EQ(sharaku_differ_degree(10, 350, 1), 20);
+	EXPECT_EQ(sharaku_differ_degree(350, 10, 1), 340);
+	EXPECT_EQ(sharaku_differ_degree(10, 350, 0), 20);
+	EXPECT_EQ(sharaku_differ_degree(90, 0, -1), 90);
+
+	// [-720, 720]^2の全組み合わせで分岐版と一致すること
+	const int leftright[] = { -2, -1, 0, 1, 2 };
+	int64_t mismatch = 0;
+	for (int lr : leftright) {
+		for (int32_t target = -720; target <= 720; target++) {
+			for (int32_t now = -720; now <= 720; now++) {
+				mismatch += sharaku_differ_degree(target, now, lr) !=
+					    differ_degree_reference(target, now, lr);
+			}
+		}
+	}
+	EXPECT_EQ(mismatch, 0);
+}
+
+TEST(rotation, differ_degree_batch) {
+	const int32_t n = 1441;
+	std::vector<int32_t> target(n), now(n), leftright(n), result(n);
+	int64_t mismatch = 0;
+
+	for (int32_t t = -720; t <= 720; t++) {
+		for (int32_t i = 0; i < n; i++) {
+			target[i] = t;
+			now[i] = i - 720;
+			leftright[i] = (i % 5) - 2;
+		}
+		sharaku_differ_degree_batch(target.data(), now.data(), leftright.data(),
+					    result.data(), n);
+		for (int32_t i = 0; i < n; i++) {
+			mismatch += result[i] !=
+				    differ_degree_reference(target[i], now[i], leftright[i]);
+		}
+	}
+	EXPECT_EQ(mismatch, 0);
+}
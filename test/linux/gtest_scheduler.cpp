@@ -0,0 +1,165 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/scheduler.hpp>
+#include <libsharaku/type/pid.hpp>
+#include <libsharaku/type/digital-filter.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+TEST(scheduler, rate_groups) {
+	simulated_clock clock;
+	basic_scheduler<simulated_clock> sched(clock);
+	std::string order;
+	std::vector<float> delta;
+	int fast = 0, slow = 0;
+
+	sched.add(10000000, [&](float dt) { slow++; order += 's'; delta.push_back(dt); });
+	sched.add(1000000, [&](float dt) { fast++; order += 'a'; EXPECT_EQ(dt, 1.0f); });
+	sched.add(1000000, [&](float) { order += 'b'; });
+	EXPECT_EQ(sched.groups(), 2u);
+
+	sched.run_until(99999999);
+	EXPECT_EQ(fast, 100);
+	EXPECT_EQ(slow, 10);
+	for (float dt : delta) {
+		EXPECT_EQ(dt, 10.0f);
+	}
+	// 同一周期は登録順に続けて実行し、同時刻の場合は短い周期が先
+	EXPECT_EQ(order.substr(0, 7), "abs" "abab");
+	EXPECT_EQ(clock.now_ns(), 99000000);
+
+	// 続きから実行する
+	sched.run_until(109999999);
+	EXPECT_EQ(fast, 110);
+	EXPECT_EQ(slow, 11);
+
+	const scheduler_stats s = sched.stats(1000000);
+	EXPECT_EQ(s.ticks, 110u);
+	EXPECT_EQ(s.overruns, 0u);
+	EXPECT_EQ(s.max_jitter_ns, 0);
+	EXPECT_EQ(s.jitter_hist[0], 110u);
+	EXPECT_EQ(sched.stats(12345).ticks, 0u);
+}
+
+TEST(scheduler, overrun) {
+	simulated_clock clock;
+	basic_scheduler<simulated_clock> sched(clock);
+	std::vector<float> delta;
+	int n = 0;
+
+	// 10周期目だけ2.5周期分の処理時間がかかる
+	sched.add(1000000, [&](float dt) {
+		delta.push_back(dt);
+		if (++n == 10) {
+			clock.advance(2500000);
+		}
+	});
+	sched.run_until(19999999);
+
+	const scheduler_stats s = sched.stats(1000000);
+	EXPECT_EQ(s.overruns, 1u);
+	EXPECT_EQ(s.skipped, 2u);
+	EXPECT_EQ(s.ticks, 18u);
+	EXPECT_EQ(s.max_overrun_ns, 1500000);
+	EXPECT_EQ(s.overrun_hist[scheduler_stats::bin(1500000)], 1u);
+	EXPECT_EQ(scheduler_stats::bin(1500000), 10u);
+	// 飛ばした周期の時間は次回のdelta_msに含まれる
+	ASSERT_EQ(delta.size(), 18u);
+	EXPECT_EQ(delta[9], 1.0f);
+	EXPECT_EQ(delta[10], 3.0f);
+	EXPECT_EQ(delta[11], 1.0f);
+}
+
+TEST(scheduler, jitter) {
+	simulated_clock clock(5000);
+	basic_scheduler<simulated_clock> sched(clock);
+	sched.add(500000, [](float) {});
+	clock.set_wakeup_latency(3000);
+	sched.run_until(5000 + 500000 * 99);
+
+	const scheduler_stats s = sched.stats(500000);
+	EXPECT_EQ(s.ticks, 100u);
+	EXPECT_EQ(s.max_jitter_ns, 3000);
+	EXPECT_EQ(s.jitter_hist[1], 100u);	// [2us, 4us)
+	EXPECT_EQ(s.overruns, 0u);
+
+	EXPECT_EQ(scheduler_stats::bin(0), 0u);
+	EXPECT_EQ(scheduler_stats::bin(1999), 0u);
+	EXPECT_EQ(scheduler_stats::bin(2000), 1u);
+	EXPECT_EQ(scheduler_stats::bin(1000000000000), (size_t)SHARAKU_SCHEDULER_HIST - 1);
+}
+
+TEST(scheduler, control_loop) {
+	// 1ms周期のPID制御と10ms周期のローパスフィルタ
+	simulated_clock clock;
+	basic_scheduler<simulated_clock> sched(clock);
+	pid p(1.0f, 0.0f, 0.0f);
+	low_pass_filter lpf(0.5f);
+	float x = 0.0f;
+
+	sched.add(1000000, [&](float dt) {
+		x += p(dt, x, 1000.0f) * dt * 0.01f;
+	});
+	sched.add(10000000, [&](float) { lpf += x; });
+	sched.run_until(2000000000);
+	EXPECT_NEAR(x, 1000.0f, 2.0f);
+	EXPECT_NEAR((float)lpf, 1000.0f, 2.0f);
+}
+
+TEST(scheduler, threads) {
+	monotonic_clock clock;
+	scheduler sched(clock);
+	std::atomic<int> n{0};
+	sched.add(1000000, [&](float dt) { n++; EXPECT_GT(dt, 0.0f); });
+	sched.set_affinity(1000000, 0);
+
+	EXPECT_TRUE(sched.start());
+	// 実行中の再度の開始は無視する
+	EXPECT_FALSE(sched.start());
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	sched.stop();
+	const int ticks = n.load();
+	EXPECT_GE(ticks, 10);
+	EXPECT_EQ(sched.stats(1000000).ticks, (uint64_t)ticks);
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	EXPECT_EQ(n.load(), ticks);
+
+	// 停止後は再度開始できる(最初の周期から固定したCPUで実行する)
+	std::atomic<int> cpu{-1};
+	sched.add(2000000, [&](float) {
+		if (cpu < 0) {
+			cpu = sched_getcpu();
+		}
+	});
+	sched.set_affinity(2000000, 0);
+	EXPECT_TRUE(sched.start());
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	sched.stop();
+	EXPECT_EQ(cpu.load(), 0);
+}
@@ -0,0 +1,272 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/spatial-index.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "gtest_helper.hpp"
+
+// 総当たりによるk近傍の距離の2乗(昇順)
+static std::vector<float>
+brute_nearest(const std::vector<position3>& pts, const std::vector<bool>& live,
+	      const position3& q, size_t k)
+{
+	std::vector<float> d;
+	for (size_t i = 0; i < pts.size(); i++) {
+		if (live.empty() || live[i]) {
+			d.push_back(sharaku_distance2(q, pts[i]));
+		}
+	}
+	std::sort(d.begin(), d.end());
+	d.resize(std::min(k, d.size()));
+	return d;
+}
+
+// 総当たりによる半径r以内の番号(昇順)
+static std::vector<uint32_t>
+brute_radius(const std::vector<position3>& pts, const std::vector<bool>& live,
+	     const position3& q, float r)
+{
+	std::vector<uint32_t> v;
+	for (size_t i = 0; i < pts.size(); i++) {
+		if ((live.empty() || live[i]) && sharaku_distance2(q, pts[i]) <= r * r) {
+			v.push_back((uint32_t)i);
+		}
+	}
+	return v;
+}
+
+// k近傍の結果が総当たりと一致すること(同距離の点があるため距離で比較する)
+template <class Index>
+static void
+check_nearest(const Index& index, const std::vector<position3>& pts,
+	      const std::vector<bool>& live, const std::vector<position3>& qs, size_t k)
+{
+	std::vector<uint32_t> idx(k);
+	std::vector<float> d2(k);
+	for (const position3& q : qs) {
+		const std::vector<float> ref = brute_nearest(pts, live, q, k);
+		EXPECT_EQ(index.nearest(q, k, idx.data(), d2.data()), ref.size());
+		for (size_t j = 0; j < k; j++) {
+			if (j < ref.size()) {
+				EXPECT_EQ(d2[j], ref[j]);
+				ASSERT_LT(idx[j], pts.size());
+				EXPECT_EQ(sharaku_distance2(q, pts[idx[j]]), d2[j]);
+			} else {
+				EXPECT_EQ(idx[j], SHARAKU_SPATIAL_NONE);
+				EXPECT_EQ(d2[j], INFINITY);
+			}
+		}
+	}
+}
+
+template <class Index>
+static void
+check_radius(const Index& index, const std::vector<position3>& pts,
+	     const std::vector<bool>& live, const std::vector<position3>& qs, float r)
+{
+	for (const position3& q : qs) {
+		std::vector<uint32_t> out;
+		const size_t found = index.radius(q, r, out);
+		EXPECT_EQ(found, out.size());
+		std::sort(out.begin(), out.end());
+		EXPECT_EQ(out, brute_radius(pts, live, q, r));
+	}
+}
+
+TEST(kd_tree, nearest_radius) {
+	for (size_t n : {0u, 1u, 15u, 16u, 17u, 1000u, 5000u}) {
+		std::vector<position3> pts = make_uniform_points(n, 1, 10.0f);
+		std::vector<position3> qs = make_uniform_points(50, 2, 12.0f);
+		kd_tree tree(pts.data(), pts.size());
+		EXPECT_EQ(tree.size(), n);
+		check_nearest(tree, pts, {}, qs, 1);
+		check_nearest(tree, pts, {}, qs, 8);
+		check_radius(tree, pts, {}, qs, 2.0f);
+	}
+}
+
+TEST(kd_tree, closest) {
+	std::vector<position3> pts = make_uniform_points(3000, 11, 10.0f);
+	std::vector<position3> qs = make_uniform_points(100, 12, 12.0f);
+	kd_tree tree(pts.data(), pts.size());
+	for (const position3& q : qs) {
+		const float ref = brute_nearest(pts, {}, q, 1)[0];
+		float d2 = INFINITY;
+		const spatial_item *it = tree.closest(q, d2);
+		ASSERT_NE(it, nullptr);
+		EXPECT_EQ(d2, ref);
+		EXPECT_EQ(sharaku_distance2(q, pts[it->id]), ref);
+
+		// 上限より遠い場合は見つからない
+		float limit = ref * 0.5f;
+		EXPECT_EQ(tree.closest(q, limit), nullptr);
+	}
+	float d2 = INFINITY;
+	EXPECT_EQ(kd_tree().closest(qs[0], d2), nullptr);
+}
+
+// 同じ座標の点が多数ある場合
+TEST(kd_tree, duplicates) {
+	std::vector<position3> pts(300, position3{1.0f, 2.0f, 3.0f});
+	for (size_t i = 0; i < 100; i++) {
+		pts[i](0.0f, 0.0f, (float)i);
+	}
+	std::vector<position3> qs = make_uniform_points(20, 3, 5.0f);
+	kd_tree tree(pts.data(), pts.size());
+	check_nearest(tree, pts, {}, qs, 4);
+	check_radius(tree, pts, {}, qs, 3.0f);
+}
+
+// 並列構築とバッチ探索の結果が逐次と一致すること
+TEST(kd_tree, parallel_batch) {
+	thread_pool pool(4);
+	std::vector<position3> pts = make_uniform_points(20000, 4, 100.0f);
+	std::vector<position3> qs = make_uniform_points(200, 5, 100.0f);
+	kd_tree serial(pts.data(), pts.size());
+	kd_tree par(pts.data(), pts.size(), &pool);
+	EXPECT_EQ(par.depth(), serial.depth());
+
+	const size_t k = 5;
+	std::vector<uint32_t> idx(qs.size() * k), ref(k);
+	std::vector<float> d2(qs.size() * k), refd(k);
+	par.nearest(qs.data(), qs.size(), k, idx.data(), d2.data(), &pool);
+	for (size_t i = 0; i < qs.size(); i++) {
+		serial.nearest(qs[i], k, ref.data(), refd.data());
+		for (size_t j = 0; j < k; j++) {
+			EXPECT_EQ(d2[i * k + j], refd[j]);
+		}
+	}
+
+	std::vector<uint32_t> offsets, found;
+	par.radius(qs.data(), qs.size(), 5.0f, offsets, found, &pool);
+	ASSERT_EQ(offsets.size(), qs.size() + 1);
+	EXPECT_EQ(offsets.back(), found.size());
+	for (size_t i = 0; i < qs.size(); i++) {
+		std::vector<uint32_t> a(found.begin() + offsets[i], found.begin() + offsets[i + 1]);
+		std::sort(a.begin(), a.end());
+		EXPECT_EQ(a, brute_radius(pts, {}, qs[i], 5.0f));
+	}
+}
+
+TEST(hash_grid, insert_erase_update) {
+	const size_t n = 3000;
+	std::vector<position3> pts = make_uniform_points(n, 6, 20.0f);
+	std::vector<bool> live(n, true);
+	std::vector<position3> qs = make_uniform_points(30, 7, 25.0f);
+	hash_grid grid(2.0f);
+	for (size_t i = 0; i < n; i++) {
+		grid.insert((uint32_t)i, pts[i]);
+	}
+	EXPECT_EQ(grid.size(), n);
+	check_nearest(grid, pts, live, qs, 1);
+	check_nearest(grid, pts, live, qs, 10);
+	check_radius(grid, pts, live, qs, 3.0f);
+
+	// 一部を削除、一部を移動(同一セル内と別セル)
+	std::mt19937 gen(8);
+	std::uniform_real_distribution<float> d(-0.3f, 0.3f);
+	for (size_t i = 0; i < n; i += 3) {
+		EXPECT_TRUE(grid.erase((uint32_t)i));
+		live[i] = false;
+	}
+	EXPECT_FALSE(grid.erase(0));
+	EXPECT_FALSE(grid.contains(0));
+	for (size_t i = 1; i < n; i += 3) {
+		pts[i](pts[i].x + d(gen), pts[i].y + d(gen), pts[i].z + d(gen));
+		grid.update((uint32_t)i, pts[i]);
+	}
+	for (size_t i = 2; i < n; i += 30) {
+		pts[i](pts[i].x + 15.0f, pts[i].y - 7.0f, pts[i].z);
+		grid.update((uint32_t)i, pts[i]);
+	}
+	EXPECT_EQ(grid.size(), n - (n + 2) / 3);
+	check_nearest(grid, pts, live, qs, 1);
+	check_nearest(grid, pts, live, qs, 10);
+	check_radius(grid, pts, live, qs, 3.0f);
+
+	// 点数より多いk、空の格子
+	check_nearest(grid, pts, live, qs, grid.size() + 5);
+	grid.clear();
+	EXPECT_EQ(grid.size(), 0u);
+	check_nearest(grid, std::vector<position3>(), {}, qs, 3);
+}
+
+// 疎な点群や点から離れた位置でも全セルの直接探索に切り替えて終了すること
+TEST(hash_grid, sparse) {
+	hash_grid grid(0.1f);
+	std::vector<position3> pts{position3{20.0f, 0.0f, 0.0f}};
+	grid.insert(0, pts[0]);
+	const std::vector<position3> qs{position3{0.0f, 0.0f, 0.0f},
+					position3{-3.0f, 40.0f, 1.0e4f},
+					position3{19.95f, 0.05f, 0.0f}};
+	check_nearest(grid, pts, {}, qs, 1);
+	check_nearest(grid, pts, {}, qs, 4);
+
+	// 離れたクラスタが2つある場合
+	std::vector<position3> a = make_uniform_points(200, 11, 1.0f);
+	for (size_t i = 0; i < 100; i++) {
+		a[i](a[i].x + 30.0f, a[i].y, a[i].z - 50.0f);
+	}
+	grid.clear();
+	for (size_t i = 0; i < a.size(); i++) {
+		grid.insert((uint32_t)i, a[i]);
+	}
+	std::vector<position3> qa = make_uniform_points(20, 12, 60.0f);
+	qa.push_back(position3{15.0f, 0.0f, -25.0f});
+	check_nearest(grid, a, {}, qa, 1);
+	check_nearest(grid, a, {}, qa, 8);
+	check_nearest(grid, a, {}, qa, 250);
+}
+
+TEST(hash_grid, batch) {
+	thread_pool pool(4);
+	std::vector<position3> pts = make_uniform_points(5000, 9, 50.0f);
+	std::vector<position3> qs = make_uniform_points(100, 10, 50.0f);
+	hash_grid grid(4.0f);
+	for (size_t i = 0; i < pts.size(); i++) {
+		grid.insert((uint32_t)i, pts[i]);
+	}
+	const size_t k = 3;
+	std::vector<uint32_t> idx(qs.size() * k);
+	std::vector<float> d2(qs.size() * k);
+	grid.nearest(qs.data(), qs.size(), k, idx.data(), d2.data(), &pool);
+	for (size_t i = 0; i < qs.size(); i++) {
+		const std::vector<float> ref = brute_nearest(pts, {}, qs[i], k);
+		for (size_t j = 0; j < k; j++) {
+			EXPECT_EQ(d2[i * k + j], ref[j]);
+		}
+	}
+	std::vector<uint32_t> offsets, found;
+	grid.radius(qs.data(), qs.size(), 4.0f, offsets, found, &pool);
+	for (size_t i = 0; i < qs.size(); i++) {
+		std::vector<uint32_t> a(found.begin() + offsets[i], found.begin() + offsets[i + 1]);
+		std::sort(a.begin(), a.end());
+		EXPECT_EQ(a, brute_radius(pts, {}, qs[i], 4.0f));
+	}
+}
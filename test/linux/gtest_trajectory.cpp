@@ -0,0 +1,184 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/trajectory.hpp>
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <string>
+#include <vector>
+
+static std::string
+trajectory_path(const char *name)
+{
+	return ::testing::TempDir() + name;
+}
+
+TEST(trajectory, pose3) {
+	const std::string path = trajectory_path("sharaku_pose.traj");
+	const size_t n = 100000;
+	std::vector<pose3> poses(n);
+	for (size_t i = 0; i < n; i++) {
+		poses[i].position(i * 0.5f, -(float)i, 1.0f);
+		poses[i].rotation((float)(i % 360), 0.25f, -(float)(i % 90));
+	}
+
+	trajectory_writer<pose3> w;
+	ASSERT_TRUE(w.open(path.c_str(), 1000000, 5000));
+	// 1レコードずつの追記とまとめての追記
+	for (size_t i = 0; i < 1000; i++) {
+		ASSERT_TRUE(w.append(poses[i]));
+	}
+	ASSERT_TRUE(w.append(poses.data() + 1000, n - 1000));
+	EXPECT_EQ(w.size(), n);
+	ASSERT_TRUE(w.close());
+
+	trajectory_reader<pose3> r;
+	ASSERT_TRUE(r.open(path.c_str()));
+	EXPECT_EQ(r.size(), n);
+	EXPECT_EQ(r.header().timestep_ns, 1000000);
+	EXPECT_EQ(r.header().t0_ns, 5000);
+	EXPECT_EQ(r.header().type, trajectory_type<pose3>::id);
+	EXPECT_EQ(r.time_ns(10), 5000 + 10 * 1000000);
+	EXPECT_EQ(memcmp(r.data(), poses.data(), sizeof(pose3) * n), 0);
+	size_t i = 0;
+	for (const pose3& p : r) {
+		EXPECT_EQ(p.position.x, poses[i].position.x);
+		EXPECT_EQ(p.rotation.z, poses[i].rotation.z);
+		i++;
+	}
+	EXPECT_EQ(i, n);
+
+	// 型が異なるファイルは開けない
+	trajectory_reader<position3> rp;
+	EXPECT_FALSE(rp.open(path.c_str()));
+	EXPECT_FALSE(rp.is_open());
+	EXPECT_FALSE(rp.open(trajectory_path("sharaku_none.traj").c_str()));
+	remove(path.c_str());
+}
+
+TEST(trajectory, types) {
+	const std::string path = trajectory_path("sharaku_types.traj");
+	{
+		trajectory_writer<vector3> w;
+		ASSERT_TRUE(w.open(path.c_str(), 100));
+		ASSERT_TRUE(w.append(vector3{1.0f, 2.0f, 3.0f}));
+	}
+	trajectory_reader<vector3> rv;
+	ASSERT_TRUE(rv.open(path.c_str()));
+	ASSERT_EQ(rv.size(), 1u);
+	EXPECT_EQ(rv[0].y, 2.0f);
+
+	{
+		trajectory_writer<rotation3> w;
+		ASSERT_TRUE(w.open(path.c_str(), 100));
+	}
+	trajectory_reader<rotation3> rr;
+	ASSERT_TRUE(rr.open(path.c_str()));
+	EXPECT_EQ(rr.size(), 0u);
+	remove(path.c_str());
+}
+
+TEST(trajectory, streaming) {
+	// 書き込み中のファイルはflush()済みの範囲を読み込める
+	const std::string path = trajectory_path("sharaku_stream.traj");
+	trajectory_writer<position3> w;
+	ASSERT_TRUE(w.open(path.c_str(), 1000000));
+	for (int i = 0; i < 10; i++) {
+		ASSERT_TRUE(w.append(position3{(float)i, 0.0f, 0.0f}));
+	}
+	trajectory_reader<position3> r;
+	ASSERT_TRUE(r.open(path.c_str()));
+	EXPECT_EQ(r.size(), 0u);
+	ASSERT_TRUE(w.flush());
+	ASSERT_TRUE(w.append(position3{10.0f, 0.0f, 0.0f}));
+	ASSERT_TRUE(r.open(path.c_str()));
+	ASSERT_EQ(r.size(), 10u);
+	EXPECT_EQ(r[9].x, 9.0f);
+	ASSERT_TRUE(w.close());
+	ASSERT_TRUE(r.open(path.c_str()));
+	EXPECT_EQ(r.size(), 11u);
+	r.close();
+
+	// 途中で切れたファイルはファイルサイズの範囲のみ読み込む
+	ASSERT_EQ(truncate(path.c_str(), sizeof(trajectory_header) + sizeof(position3) * 4 + 5), 0);
+	ASSERT_TRUE(r.open(path.c_str()));
+	EXPECT_EQ(r.size(), 4u);
+	r.close();
+
+	// バイト順が異なるファイルは開けない
+	FILE *fp = fopen(path.c_str(), "r+b");
+	ASSERT_NE(fp, nullptr);
+	const uint32_t swapped = 0x04030201;
+	fseek(fp, offsetof(trajectory_header, endian), SEEK_SET);
+	fwrite(&swapped, sizeof(swapped), 1, fp);
+	fclose(fp);
+	EXPECT_FALSE(r.open(path.c_str()));
+	remove(path.c_str());
+}
+
+TEST(trajectory, retry) {
+	const std::string path = trajectory_path("sharaku_retry.traj");
+	std::vector<position3> v(200);
+	for (size_t i = 0; i < v.size(); i++) {
+		v[i](float(i), 0.0f, 0.0f);
+	}
+
+	// 開いていない場合は追記できない
+	trajectory_writer<position3> w;
+	EXPECT_FALSE(w.append(v[0]));
+	EXPECT_FALSE(w.append(v.data(), 2));
+	EXPECT_FALSE(w.flush());
+	EXPECT_EQ(w.size(), 0u);
+
+	ASSERT_TRUE(w.open(path.c_str(), 1000));
+	ASSERT_TRUE(w.append(v.data(), 100));
+	ASSERT_TRUE(w.flush());
+	ASSERT_TRUE(w.append(v.data() + 100, 100));
+
+	// ファイルサイズの上限により150レコード目の途中で書き込みに失敗させる
+	struct rlimit org, lim;
+	ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &org), 0);
+	lim = org;
+	lim.rlim_cur = sizeof(trajectory_header) + sizeof(position3) * 150 + 5;
+	void (*sig)(int) = signal(SIGXFSZ, SIG_IGN);
+	ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &lim), 0);
+	const bool ok = w.flush();
+	ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &org), 0);
+	signal(SIGXFSZ, sig);
+	EXPECT_FALSE(ok);
+
+	// 再試行では書き込み済みの部分を重複させない
+	EXPECT_EQ(w.size(), 200u);
+	ASSERT_TRUE(w.close());
+	trajectory_reader<position3> r;
+	ASSERT_TRUE(r.open(path.c_str()));
+	ASSERT_EQ(r.size(), 200u);
+	EXPECT_EQ(memcmp(r.data(), v.data(), sizeof(position3) * v.size()), 0);
+	r.close();
+	remove(path.c_str());
+}
@@ -0,0 +1,114 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/transform.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+static void
+expect_position_near(const position3& a, const position3& b, float eps)
+{
+	EXPECT_NEAR(a.x, b.x, eps);
+	EXPECT_NEAR(a.y, b.y, eps);
+	EXPECT_NEAR(a.z, b.z, eps);
+}
+
+TEST(transform, rotation_matrix3) {
+	const rotation3 r{-40.0f, 25.0f, 130.0f};
+	rotation_matrix3 m = rotation_matrix3::from_rotation(r);
+	quaternion q = quaternion::from_rotation(r);
+	rotation_matrix3 mq = rotation_matrix3::from_quaternion(q);
+	const vector3 v{1.5f, -2.0f, 0.25f};
+
+	vector3 a = m.apply(v);
+	vector3 b = q.rotate(v);
+	vector3 c = mq.apply(v);
+	EXPECT_NEAR(a.x, b.x, 1.0e-5f);
+	EXPECT_NEAR(a.y, b.y, 1.0e-5f);
+	EXPECT_NEAR(a.z, b.z, 1.0e-5f);
+	EXPECT_NEAR(c.x, b.x, 1.0e-5f);
+
+	rotation3 back = m.to_rotation();
+	EXPECT_NEAR(back.x, r.x, 1.0e-3f);
+	EXPECT_NEAR(back.y, r.y, 1.0e-3f);
+	EXPECT_NEAR(back.z, r.z, 1.0e-3f);
+
+	rotation_matrix3 id = m * m.inverse();
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			EXPECT_NEAR(id.m[i][j], (i == j) ? 1.0f : 0.0f, 1.0e-6f);
+		}
+	}
+}
+
+TEST(transform, transform3) {
+	transform3 t1 = transform3::from_rotation(rotation3{0.0f, 0.0f, 90.0f},
+						  vector3{1.0f, 2.0f, 3.0f});
+	transform3 t2 = transform3::from_rotation(rotation3{10.0f, -20.0f, 30.0f},
+						  vector3{-4.0f, 0.5f, 0.0f});
+	const position3 p{1.0f, 0.0f, 0.0f};
+
+	expect_position_near(t1.apply(p), position3{1.0f, 3.0f, 3.0f}, 1.0e-6f);
+	// vector3(移動量)は平行移動しない
+	vector3 v = t1.apply(vector3{1.0f, 0.0f, 0.0f});
+	EXPECT_NEAR(v.y, 1.0f, 1.0e-6f);
+	EXPECT_NEAR(v.x, 0.0f, 1.0e-6f);
+
+	expect_position_near((t1 * t2).apply(p), t1.apply(t2.apply(p)), 1.0e-5f);
+	expect_position_near(t2.inverse().apply(t2.apply(p)), p, 1.0e-5f);
+	expect_position_near(transform3::identity().apply(p), p, 0.0f);
+}
+
+TEST(transform, transform3_batch) {
+	const size_t n = 1003;
+	transform3 t = transform3::from_rotation(rotation3{10.0f, -20.0f, 30.0f},
+						 vector3{-4.0f, 0.5f, 7.0f});
+	std::vector<position3> in(n), out(n);
+	std::vector<vector3> vin(n), vout(n);
+	for (size_t i = 0; i < n; i++) {
+		in[i](i * 0.01f, (float)(i % 17) - 8.0f, 100.0f - i * 0.1f);
+		vin[i](in[i].z, in[i].x, in[i].y);
+	}
+
+	t.apply(in.data(), out.data(), n);
+	t.apply(vin.data(), vout.data(), n);
+	for (size_t i = 0; i < n; i++) {
+		expect_position_near(out[i], t.apply(in[i]), 1.0e-4f);
+		vector3 r = t.apply(vin[i]);
+		EXPECT_NEAR(vout[i].x, r.x, 1.0e-4f);
+		EXPECT_NEAR(vout[i].y, r.y, 1.0e-4f);
+		EXPECT_NEAR(vout[i].z, r.z, 1.0e-4f);
+	}
+
+	// 同一配列上での変換
+	std::vector<position3> inplace(in);
+	t.apply(inplace.data(), inplace.data(), n);
+	for (size_t i = 0; i < n; i++) {
+		EXPECT_EQ(inplace[i].x, out[i].x);
+		EXPECT_EQ(inplace[i].y, out[i].y);
+		EXPECT_EQ(inplace[i].z, out[i].z);
+	}
+}
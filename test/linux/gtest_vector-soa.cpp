@@ -0,0 +1,110 @@
+﻿/* --
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2018 Abe Takafumi
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <libsharaku/type/vector-soa.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+#include "gtest_helper.hpp"
+
+TEST(vector_soa, load_store) {
+	std::vector<vector3> src = make_vectors(37, 1.5f);
+	std::vector<vector3> dst(37);
+	vector3_soa soa(src.data(), src.size());
+
+	EXPECT_EQ(soa.size(), 37u);
+	EXPECT_EQ((uintptr_t)soa.x() % SHARAKU_SIMD_ALIGN, 0u);
+	EXPECT_EQ((uintptr_t)soa.y() % SHARAKU_SIMD_ALIGN, 0u);
+	EXPECT_EQ((uintptr_t)soa.z() % SHARAKU_SIMD_ALIGN, 0u);
+
+	soa.store(dst.data());
+	for (size_t i = 0; i < src.size(); i++) {
+		EXPECT_EQ(dst[i].x, src[i].x);
+		EXPECT_EQ(dst[i].y, src[i].y);
+		EXPECT_EQ(dst[i].z, src[i].z);
+	}
+}
+
+TEST(vector_soa, add_sub) {
+	const size_t n = 1001;
+	std::vector<vector3> a = make_vectors(n, 3.0f);
+	std::vector<vector3> b = make_vectors(n, -7.0f);
+	vector3_soa sa(a.data(), n);
+	vector3_soa sb(b.data(), n);
+	vector3_soa sum(n);
+	vector3_soa diff(n);
+
+	vector3_soa::add(sum, sa, sb);
+	vector3_soa::sub(diff, sa, sb);
+	sa += sb;
+	for (size_t i = 0; i < n; i++) {
+		vector3 s = a[i] + b[i];
+		vector3 d = a[i] - b[i];
+		EXPECT_EQ(sum.get(i).x, s.x);
+		EXPECT_EQ(sum.get(i).y, s.y);
+		EXPECT_EQ(sum.get(i).z, s.z);
+		EXPECT_EQ(diff.get(i).x, d.x);
+		EXPECT_EQ(diff.get(i).y, d.y);
+		EXPECT_EQ(diff.get(i).z, d.z);
+		EXPECT_EQ(sa.get(i).x, s.x);
+	}
+	sa -= sb;
+	for (size_t i = 0; i < n; i++) {
+		vector3 r = (a[i] + b[i]) - b[i];
+		EXPECT_EQ(sa.get(i).y, r.y);
+	}
+}
+
+TEST(vector_soa, scale_accumulate) {
+	const size_t n = 515;
+	const float dt = 0.01f;
+	std::vector<vector3> p = make_vectors(n, 2.0f);
+	std::vector<vector3> v = make_vectors(n, 0.5f);
+	vector3_soa sp(p.data(), n);
+	vector3_soa sv(v.data(), n);
+
+	sp.accumulate(sv, dt);
+	sv *= 2.0f;
+	for (size_t i = 0; i < n; i++) {
+		float vx = v[i].x * dt;
+		EXPECT_EQ(sp.get(i).x, p[i].x + vx);
+		EXPECT_EQ(sv.get(i).z, v[i].z * 2.0f);
+	}
+}
+
+#ifndef NDEBUG
+// 要素数の異なるvector3_soa同士は演算できない
+TEST(vector_soa, size_mismatch) {
+	vector3_soa a(64);
+	vector3_soa b(8);
+
+	EXPECT_DEATH(a += b, "");
+	EXPECT_DEATH(a -= b, "");
+	EXPECT_DEATH(a.accumulate(b, 0.5f), "");
+	EXPECT_DEATH(vector3_soa::add(a, a, b), "");
+	EXPECT_DEATH(vector3_soa::sub(a, b, a), "");
+	EXPECT_DEATH(vector3_soa::scale(b, a, 2.0f), "");
+}
+#endif
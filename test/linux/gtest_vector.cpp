@@ -25,7 +25,12 @@
  */
 
 #include <libsharaku/type/vector.hpp>
+#include <libsharaku/type/position.hpp>
+#include <libsharaku/type/rotation.hpp>
 #include <gtest/gtest.h>
+#include <string.h>
+#include <type_traits>
+#include <vector>
 
 TEST(vector, vector3) {
 	vector3	vec3;
@@ -35,3 +40,46 @@ TEST(vector, vector3) {
 	EXPECT_EQ(vec3.y, 0.0f);
 	EXPECT_EQ(vec3.z, 0.0f);
 }
+
+// vector3, position3, rotation3は同じレイアウトと定数式の演算を持つ
+template <class T>
+class xyz_type : public ::testing::Test {};
+typedef ::testing::Types<vector3, position3, rotation3> xyz_types;
+TYPED_TEST_SUITE(xyz_type, xyz_types);
+
+TYPED_TEST(xyz_type, layout) {
+	typedef TypeParam T;
+	static_assert(std::is_trivially_copyable<T>::value, "");
+	static_assert(std::is_standard_layout<T>::value, "");
+	EXPECT_EQ(sizeof(T), 12u);
+	EXPECT_EQ(offsetof(T, x), 0u);
+	EXPECT_EQ(offsetof(T, y), 4u);
+	EXPECT_EQ(offsetof(T, z), 8u);
+
+	// リングバッファ上のバイト列と相互に変換できること
+	const float raw[6] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f };
+	T buf[2];
+	memcpy(buf, raw, sizeof(raw));
+	EXPECT_EQ(buf[1].x, 4.0f);
+	EXPECT_EQ(buf[1].z, 6.0f);
+
+	std::vector<T> v(3, T{7.0f, 8.0f, 9.0f});
+	v.insert(v.begin(), T{0.0f, 0.0f, 0.0f});
+	EXPECT_EQ(v[3].y, 8.0f);
+}
+
+TYPED_TEST(xyz_type, constexpr_arithmetic) {
+	typedef TypeParam T;
+	constexpr T a{1.0f, 2.0f, 3.0f};
+	constexpr T d{0.5f, 0.25f, 0.125f};
+	constexpr T table[] = { a + d, a - d, (T{} += d) };
+	static_assert(table[0].x == 1.5f && table[0].z == 3.125f, "");
+	static_assert(table[1].y == 1.75f, "");
+	static_assert(table[2].x == 0.5f, "");
+
+	T b = a;
+	b -= d;
+	EXPECT_EQ(b.x, table[1].x);
+	EXPECT_EQ(b.y, table[1].y);
+	EXPECT_EQ(b.z, table[1].z);
+}